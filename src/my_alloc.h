@@ -1,14 +1,115 @@
 #ifndef __MY_ALLOC_H
 #define __MY_ALLOC_H
 
-#include <cstring>  // for memcpy
+#include <algorithm>   // for sort
+#include <cstddef>     // for max_align_t
+#include <cstdlib>     // for malloc, free, realloc
+#include <cstring>     // for memcpy
+#include <functional>  // for less
+#include <mutex>       // for mutex, lock_guard
+#include <type_traits>  // for integral_constant, is_empty
 #include "my_construct.h"
+#if defined(__linux__)
+#include <sys/mman.h>  // for mmap, mremap, munmap
+#endif
 
 namespace gd {
 
+template <typename...>
+struct __alloc_void {
+  typedef void type;
+};
+
+// 检测 Alloc 中是否定义了某个 typedef，定义了就用 Alloc 的，否则使用 Default
+#define __ALLOC_TRAIT(NAME, DEFAULT)                                                    \
+  template <typename A, typename = void>                                                \
+  struct __alloc_##NAME {                                                               \
+    typedef DEFAULT type;                                                               \
+  };                                                                                    \
+  template <typename A>                                                                 \
+  struct __alloc_##NAME<A, typename __alloc_void<typename A::NAME>::type> {             \
+    typedef typename A::NAME type;                                                      \
+  };
+
+__ALLOC_TRAIT(propagate_on_container_copy_assignment, std::false_type)
+__ALLOC_TRAIT(propagate_on_container_move_assignment, std::false_type)
+__ALLOC_TRAIT(propagate_on_container_swap, std::false_type)
+__ALLOC_TRAIT(is_always_equal, typename std::is_empty<A>::type)
+
+#undef __ALLOC_TRAIT
+
+template <typename A, typename = void>
+struct __alloc_has_select : std::false_type {};
+
+// Alloc 是否提供 reallocate(p, old_sz, new_sz)
+template <typename A, typename = void>
+struct __alloc_has_reallocate : std::false_type {};
+
+template <typename A>
+struct __alloc_has_reallocate<
+    A, typename __alloc_void<decltype(std::declval<A&>().reallocate((void*)0, size_t(), size_t()))>::type>
+    : std::true_type {};
+
+// Alloc 是否提供 deallocate_all(n, sz)：n 个大小为 sz 的区块正好是 Alloc 中所有未归还的区块时，
+// 一次整块释放并返回 true，否则什么也不做，返回 false
+template <typename A, typename = void>
+struct __alloc_has_deallocate_all : std::false_type {};
+
+template <typename A>
+struct __alloc_has_deallocate_all<
+    A, typename __alloc_void<decltype(std::declval<A&>().deallocate_all(size_t(), size_t()))>::type>
+    : std::true_type {};
+
+template <typename A>
+struct __alloc_has_select<
+    A, typename __alloc_void<decltype(std::declval<const A&>().select_on_container_copy_construction())>::type>
+    : std::true_type {};
+
+// 配置器在容器拷贝、移动、交换时的传播特性，参照标准库的 allocator_traits：
+//   1. propagate_on_container_copy_assignment/move_assignment/swap 为 true 时，
+//      容器在拷贝赋值、移动赋值、交换时连同配置器一起拷贝/移动/交换，默认为 false
+//   2. is_always_equal 为 true 时，任意两个配置器都可以释放对方分配的内存，默认无状态（空类）的配置器总是相等
+//   3. 拷贝构造容器时，新容器的配置器由 select_on_container_copy_construction() 决定，默认就是原配置器的拷贝
+// 以上成员都可以在 Alloc 中自定义
+template <typename Alloc>
+struct __alloc_traits {
+  typedef typename __alloc_propagate_on_container_copy_assignment<Alloc>::type propagate_on_container_copy_assignment;
+  typedef typename __alloc_propagate_on_container_move_assignment<Alloc>::type propagate_on_container_move_assignment;
+  typedef typename __alloc_propagate_on_container_swap<Alloc>::type            propagate_on_container_swap;
+  typedef typename __alloc_is_always_equal<Alloc>::type                        is_always_equal;
+
+  static Alloc select_on_container_copy_construction(const Alloc& a) {
+    return __select(a, __alloc_has_select<Alloc>());
+  }
+
+  // 两个配置器是否相等，即一个配置器分配的内存能否由另一个释放
+  static bool equal(const Alloc& lhs, const Alloc& rhs) {
+    return __equal(lhs, rhs, is_always_equal());
+  }
+
+ private:
+  static Alloc __select(const Alloc& a, std::true_type) {
+    return a.select_on_container_copy_construction();
+  }
+
+  static Alloc __select(const Alloc& a, std::false_type) {
+    return a;
+  }
+
+  static bool __equal(const Alloc&, const Alloc&, std::true_type) {
+    return true;
+  }
+
+  static bool __equal(const Alloc& lhs, const Alloc& rhs, std::false_type) {
+    return lhs == rhs;
+  }
+};
+
 // 将一级或二级配置器包装起来，使其符合 STL 规格
+// simple_alloc 继承自 Alloc，Alloc 可以带有状态（例如 arena_alloc），此时每个容器实例保存自己的 Alloc；
+// 像 alloc 这样只有静态成员的 Alloc 是空类，容器通过继承 simple_alloc 利用空基类优化，不增加任何开销
 template <typename T, typename Alloc>
-class simple_alloc {
+class simple_alloc : public Alloc {
  public:
   typedef T         value_type;
   typedef T*        pointer;
@@ -24,24 +125,116 @@ class simple_alloc {
     typedef simple_alloc<U, Alloc> other;
   };
 
-  static pointer allocate(size_t n) {
+  simple_alloc() = default;
+
+  simple_alloc(const Alloc& a) : Alloc(a) {}
+
+  // 同一个 Alloc 的不同 value_type 之间可以互相转换，共享同一份状态
+  template <typename U>
+  simple_alloc(const simple_alloc<U, Alloc>& rhs) : Alloc(rhs) {}
+
+  // 传播特性，见 __alloc_traits
+  typedef typename __alloc_traits<Alloc>::propagate_on_container_copy_assignment propagate_on_container_copy_assignment;
+  typedef typename __alloc_traits<Alloc>::propagate_on_container_move_assignment propagate_on_container_move_assignment;
+  typedef typename __alloc_traits<Alloc>::propagate_on_container_swap            propagate_on_container_swap;
+  typedef typename __alloc_traits<Alloc>::is_always_equal                        is_always_equal;
+
+  simple_alloc select_on_container_copy_construction() const {
+    return simple_alloc(__alloc_traits<Alloc>::select_on_container_copy_construction(*this));
+  }
+
+  // Alloc 提供 reallocate 时为 true_type，此时可以调用下面的 reallocate
+  typedef typename __alloc_has_reallocate<Alloc>::type has_reallocate;
+
+  // Alloc 提供 deallocate_all 时为 true_type，此时可以调用下面的 deallocate_all
+  typedef typename __alloc_has_deallocate_all<Alloc>::type has_deallocate_all;
+
+  pointer allocate(size_t n) {
     return 0 == n ? 0 : static_cast<pointer>(Alloc::allocate(n * sizeof(value_type)));
   }
 
-  static pointer allocate(void) {
+  pointer allocate(void) {
     return static_cast<pointer>(Alloc::allocate(sizeof(value_type)));
   }
 
-  static void deallocate(pointer p, size_t n) {
+  void deallocate(pointer p, size_t n) {
     if (0 != n)
       Alloc::deallocate(p, n * sizeof(value_type));
   }
 
-  static void deallocate(pointer p) {
+  void deallocate(pointer p) {
     Alloc::deallocate(p, sizeof(value_type));
   }
+
+  // 已分配的 n 个 value_type 就是 Alloc 中全部未归还的区块时整块释放，返回 false 时需要逐个 deallocate
+  bool deallocate_all(size_t n) {
+    return Alloc::deallocate_all(n, sizeof(value_type));
+  }
+
+  // 按字节搬移到新空间（可能原地扩展），只能用于可平凡搬移的类型
+  pointer reallocate(pointer p, size_t old_n, size_t new_n) {
+    if (0 == old_n)
+      return allocate(new_n);
+    return static_cast<pointer>(Alloc::reallocate(p, old_n * sizeof(value_type), new_n * sizeof(value_type)));
+  }
 };
 
+template <typename T, typename U, typename Alloc>
+inline bool operator==(const simple_alloc<T, Alloc>& lhs, const simple_alloc<U, Alloc>& rhs) {
+  return __alloc_traits<Alloc>::equal(lhs, rhs);
+}
+
+template <typename T, typename U, typename Alloc>
+inline bool operator!=(const simple_alloc<T, Alloc>& lhs, const simple_alloc<U, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+// 以下几个函数供容器使用，按照配置器的传播特性决定拷贝赋值、移动赋值、交换时是否要处理配置器
+template <typename A>
+inline void __alloc_on_copy(A& lhs, const A& rhs, std::true_type) {
+  lhs = rhs;
+}
+
+template <typename A>
+inline void __alloc_on_copy(A&, const A&, std::false_type) {}
+
+template <typename A>
+inline void __alloc_on_copy(A& lhs, const A& rhs) {
+  __alloc_on_copy(lhs, rhs, typename A::propagate_on_container_copy_assignment());
+}
+
+template <typename A>
+inline void __alloc_on_move(A& lhs, A& rhs, std::true_type) {
+  lhs = std::move(rhs);
+}
+
+template <typename A>
+inline void __alloc_on_move(A&, A&, std::false_type) {}
+
+template <typename A>
+inline void __alloc_on_move(A& lhs, A& rhs) {
+  __alloc_on_move(lhs, rhs, typename A::propagate_on_container_move_assignment());
+}
+
+template <typename A>
+inline void __alloc_on_swap(A& lhs, A& rhs, std::true_type) {
+  std::swap(lhs, rhs);
+}
+
+// 不传播时两个配置器必须相等（标准中不相等是未定义行为），什么也不做
+template <typename A>
+inline void __alloc_on_swap(A&, A&, std::false_type) {}
+
+template <typename A>
+inline void __alloc_on_swap(A& lhs, A& rhs) {
+  __alloc_on_swap(lhs, rhs, typename A::propagate_on_container_swap());
+}
+
+// 移动赋值时能否直接接管 rhs 的内存：配置器会传播，或者总是相等
+template <typename A>
+struct __alloc_move_steals
+    : std::integral_constant<bool, A::propagate_on_container_move_assignment::value || A::is_always_equal::value> {};
+
 // 无 template 型别参数，inst 没有用到
 template <int inst>
 class __malloc_alloc_template {
@@ -124,139 +317,464 @@ void* __malloc_alloc_template<inst>::oom_realloc(void* p, size_t n) {
 // 将参数 inst 指定为 0
 typedef __malloc_alloc_template<0> malloc_alloc;
 
-// 二级配置器，用于处理小区快，当区块小于 __MAX_BYTES
+#if defined(__linux__)
+enum { __MMAP_THRESHOLD = 1 << 20 };  // 不小于这个大小的区块使用 __mmap_alloc
+enum { __MMAP_ALIGN = 4096 };         // mmap 返回的地址按页对齐
+
+// 直接用 mmap 向系统申请整页的内存，只用于很大的区块
+// 扩容时用 mremap 重新映射页表：能原地扩展就原地扩展，否则换一个地址，但都不需要复制数据，
+// 也不需要同时持有新旧两块内存
+class __mmap_alloc {
+ public:
+  static void* allocate(size_t n) {
+    void* result = mmap(0, page_round(n), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == result)
+      throw std::bad_alloc();
+    return result;
+  }
+
+  static void deallocate(void* p, size_t n) {
+    munmap(p, page_round(n));
+  }
+
+  static void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+    old_sz = page_round(old_sz);
+    new_sz = page_round(new_sz);
+    if (old_sz == new_sz)
+      return p;
+    void* result = mremap(p, old_sz, new_sz, MREMAP_MAYMOVE);
+    if (MAP_FAILED == result)
+      throw std::bad_alloc();
+    return result;
+  }
+
+ private:
+  static size_t page_round(size_t n) {
+    return (n + __MMAP_ALIGN - 1) & ~((size_t)__MMAP_ALIGN - 1);
+  }
+};
+#else
+// 其他平台没有 mremap，不使用 __mmap_alloc
+enum { __MMAP_THRESHOLD = 0 };
+enum { __MMAP_ALIGN = 0 };
+typedef malloc_alloc __mmap_alloc;
+#endif
+
+// 二级配置器所用的 size class
+// 128 bytes 以内按 Align 等距划分；128 bytes 以上按几何级数划分，
+// 每个 [2^k, 2^(k+1)) 区间再等分为 4 个 class（间距至少为 Align），这样内部碎片不超过 25%
+enum { __SIZE_CLASS_LINEAR_BYTES = 128 };  // 等距划分的上限
+
+// 紧接在 bytes 之后的 class，bytes 必须是 0 或者某个 class
+template <size_t Align>
+constexpr size_t __next_size_class(size_t bytes) {
+  if (bytes < (size_t)__SIZE_CLASS_LINEAR_BYTES)
+    return bytes + Align;
+  size_t base = __SIZE_CLASS_LINEAR_BYTES;
+  while (base * 2 <= bytes)
+    base *= 2;
+  return bytes + (base / 4 < Align ? Align : base / 4);
+}
+
+// class 的个数，最后一个 class 是第一个不小于 MaxBytes 的 class
+template <size_t MaxBytes, size_t Align>
+constexpr size_t __size_class_count() {
+  size_t n = 0;
+  for (size_t s = 0; s < MaxBytes; s = __next_size_class<Align>(s))
+    ++n;
+  return n;
+}
+
+// 最大的 class
+template <size_t MaxBytes, size_t Align>
+constexpr size_t __max_size_class() {
+  size_t s = 0;
+  while (s < MaxBytes)
+    s = __next_size_class<Align>(s);
+  return s;
+}
+
+// 编译期生成的查找表，bytes 所属的 class 编号为 slot_to_class[(bytes + Align - 1) / Align]
+template <size_t MaxBytes, size_t Align>
+struct __size_class_table {
+  enum : size_t { __NCLASSES = __size_class_count<MaxBytes, Align>() };
+  enum : size_t { __NSLOTS = __max_size_class<MaxBytes, Align>() / Align + 1 };
+
+  unsigned short slot_to_class[__NSLOTS];
+  size_t         class_bytes[__NCLASSES];  // 每个 class 的字节数
+
+  constexpr __size_class_table() : slot_to_class(), class_bytes() {
+    size_t slot = 0;
+    size_t bytes = __next_size_class<Align>(0);
+    for (size_t c = 0; c < __NCLASSES; ++c, bytes = __next_size_class<Align>(bytes)) {
+      class_bytes[c] = bytes;
+      for (; slot * Align <= bytes; ++slot)
+        slot_to_class[slot] = static_cast<unsigned short>(c);
+    }
+  }
+};
+
+// 二级配置器，用于处理小区快，当区块不大于 MaxBytes
 // 时使用内存池管理，否则直接用一级配置器分配
-template <int inst>
+// 区块大小按 size class 向上取整，所有区块的起始地址都按 Align 对齐（Align 可以是 8/16/32/64/128）
+//
+// 为了能在多线程下使用，内存池分为两层：
+//   1. 每个线程有自己的 free list 缓存（thread cache），allocate/deallocate 只操作本线程的缓存，不需要加锁
+//   2. 所有线程共享一个中心池（central pool），包括每个 class 一个的中心 free list 以及 start_free/end_free 内存块，
+//      由互斥锁保护
+// 线程缓存为空时，从中心池一次搬运一批节点过来；线程缓存中的节点过多时，一次归还一批给中心池；
+// 线程退出时，其缓存中的所有节点都会归还给中心池
+//
+// 内存池向系统申请的每一大块内存（chunk）都记录在 chunk_list 中，
+// 调用 trim() 或者中心池的空闲字节数超过水位线（set_trim_threshold()）时，
+// 会找出所有区块都已空闲的 chunk，将其从 free list 中摘除并 free 掉，归还给系统
+//
+// 参数不同的实例各自拥有独立的内存池
+template <int inst, size_t MaxBytes = 512, size_t Align = 8>
 class __default_alloc_template {
+  static_assert(Align >= sizeof(void*) && (Align & (Align - 1)) == 0 && Align <= __SIZE_CLASS_LINEAR_BYTES,
+                "Align must be a power of 2 between sizeof(void*) and 128");
+  static_assert(MaxBytes > 0, "MaxBytes must be positive");
+
  private:
-  enum { __ALIGN = 8 };                           // 小型区块的上调边界
-  enum { __MAX_BYTES = 128 };                     // 小型区块的上限
-  enum { __NFREELISTS = __MAX_BYTES / __ALIGN };  // free list 个数
+  typedef __size_class_table<MaxBytes, Align> size_class_table;
+
+  enum { __ALIGN = Align };                                   // 小型区块的上调边界
+  enum { __MAX_BYTES = MaxBytes };                            // 小型区块的上限
+  enum { __NFREELISTS = size_class_table::__NCLASSES };  // free list 个数，每个 class 一个
+  enum { __BATCH_BYTES = 4096 };  // 线程缓存与中心池之间每批搬运的字节数（大约）
+  enum { __MIN_BATCH = 8 };       // 每批最少搬运的节点数
+  enum { __MAX_BATCH = 64 };      // 每批最多搬运的节点数
 
   static size_t round_up(size_t bytes) {
-    // & ~(__ALIGN - 1) 将低三位置 0
+    // & ~(__ALIGN - 1) 将低位置 0
     return ((bytes + __ALIGN - 1) & ~(__ALIGN - 1));
   }
 
+  static char* round_up(char* p) {
+    return (char*)round_up((size_t)p);
+  }
+
   // free-lists 结点的构造
   union obj {
     union obj* next_free;
     char       client_data[1];
   };
 
-  // 16 个 free lists，free list 数组存的是每个 free list 的头结点的地址
-  static obj* volatile free_list[__NFREELISTS];
+  // 常量初始化，不需要在运行时构造
+  static const size_class_table& size_classes() {
+    static constexpr size_class_table table;
+    return table;
+  }
 
-  // 决定用哪个 free-list
+  // 决定用哪个 free-list，bytes 不能超过最大的 class
   static size_t freelist_index(size_t bytes) {
-    return ((bytes + __ALIGN - 1) / __ALIGN - 1);
+    return size_classes().slot_to_class[(bytes + __ALIGN - 1) / __ALIGN];
+  }
+
+  // 第 index 个 free list 上区块的大小
+  static size_t class_size(size_t index) {
+    return size_classes().class_bytes[index];
+  }
+
+  // 每批搬运的节点数，区块越小，一批搬运的越多
+  static int batch_count(size_t bytes) {
+    size_t n = __BATCH_BYTES / bytes;
+    if (n < __MIN_BATCH)
+      return __MIN_BATCH;
+    if (n > __MAX_BATCH)
+      return __MAX_BATCH;
+    return static_cast<int>(n);
+  }
+
+  // 每个 chunk 的头部，紧挨在 chunk 可用部分的前面
+  struct chunk_header {
+    chunk_header* next;  // 下一个 chunk
+    size_t        size;  // 本 chunk 可用的字节数
+    void*         raw;   // malloc 返回的地址，为了让可用部分按 Align 对齐，二者之间可能有空隙
+  };
+
+  // 线程本地的 free list 缓存
+  struct thread_cache {
+    obj*   free_list[__NFREELISTS];
+    size_t count[__NFREELISTS];  // 每个 free list 上的节点数
+
+    thread_cache() {
+      for (int i = 0; i < __NFREELISTS; ++i) {
+        free_list[i] = 0;
+        count[i] = 0;
+      }
+    }
+
+    // 线程退出时，把缓存的节点全部还给中心池，否则这些节点就永远丢失了
+    ~thread_cache() {
+      flush();
+    }
+
+    // 把缓存的节点全部还给中心池
+    void flush() {
+      for (int i = 0; i < __NFREELISTS; ++i) {
+        if (free_list[i] != 0) {
+          obj* last = free_list[i];
+          while (last->next_free != 0)
+            last = last->next_free;
+          central_push(i, free_list[i], last, count[i] * class_size(i));
+          free_list[i] = 0;
+          count[i] = 0;
+        }
+      }
+    }
+  };
+
+  // 第一次调用时构造，线程退出时析构
+  static thread_cache& local_cache() {
+    static thread_local thread_cache cache;
+    return cache;
+  }
+
+  // 将 [first, last] 这一串节点（共 bytes 字节）接到中心 free list 的头部
+  static void central_push(size_t index, obj* first, obj* last, size_t bytes) {
+    std::lock_guard<std::mutex> guard(central_lock);
+    last->next_free = central_free_list[index];
+    central_free_list[index] = first;
+    central_free_bytes += bytes;
+    // 超过水位线则自动 trim，之后把水位线抬高，避免碎片化时每次归还都要扫描一遍
+    if (trim_threshold != 0 && central_free_bytes >= trim_trigger) {
+      trim_locked();
+      trim_trigger = central_free_bytes + trim_threshold;
+    }
+  }
+
+  // 很大的区块使用 __mmap_alloc
+  static bool use_mmap(size_t n) {
+    return __ALIGN <= (size_t)__MMAP_ALIGN && n >= (size_t)__MMAP_THRESHOLD;
+  }
+
+  // 大于 MaxBytes 的区块直接交给一级配置器
+  // malloc 本身的对齐不够 Align 时多申请一些再手动对齐，malloc 返回的地址保存在对齐后地址的前面
+  static void* large_allocate(size_t n) {
+    if (use_mmap(n))
+      return __mmap_alloc::allocate(n);
+    if (__ALIGN <= alignof(std::max_align_t))
+      return malloc_alloc::allocate(n);
+    char*  raw = (char*)malloc_alloc::allocate(n + __ALIGN);
+    void** result = (void**)round_up(raw + sizeof(void*));
+    result[-1] = raw;
+    return result;
   }
 
-  // 返回大小为 n 的对象，并可能加入大小为 n 的其他区块到 free list
+  static void large_deallocate(void* p, size_t n) {
+    if (use_mmap(n))
+      __mmap_alloc::deallocate(p, n);
+    else if (__ALIGN <= alignof(std::max_align_t))
+      malloc_alloc::deallocate(p, n);
+    else
+      malloc_alloc::deallocate(((void**)p)[-1], n);
+  }
+
+  // 返回大小为 n 的对象，并可能从中心池搬运一批大小为 n 的区块到本线程的 free list
   static void* refill(size_t n);
   // 配置一大块空间，可容纳 nobjs 个大小为 'size' 的区块
-  // 若配置 nobjs 个区块有所不便，nobjs 会减小
+  // 若配置 nobjs 个区块有所不便，nobjs 会减小，调用者必须持有 central_lock
   static char* chunk_alloc(size_t size, int& nobjs);
+  // 线程缓存过多时，将一批节点还给中心池
+  static void release_batch(thread_cache& cache, size_t index, size_t n);
+  // 向系统申请一个可用大小为 bytes 的 chunk，返回可用部分的起点，调用者必须持有 central_lock
+  // use_oom_handler 为 true 时，失败会调用一级配置器的 out-of-memory 处理机制
+  static char* chunk_malloc(size_t bytes, bool use_oom_handler);
+  // 归还所有完全空闲的 chunk，返回归还的字节数，调用者必须持有 central_lock
+  static size_t trim_locked();
+
+  // 中心池，以下成员都由 central_lock 保护
+  static std::mutex central_lock;
+  // 每个 class 一个中心 free list，free list 数组存的是每个 free list 的头结点的地址
+  static obj* central_free_list[__NFREELISTS];
 
   // chunk allocation state
-  static char*  start_free;  // 内存池起始位置，只在 chunk_alloc() 中变化
-  static char*  end_free;    // 内存池结束位置，只在 chunk_alloc() 中变化
-  static size_t heap_size;
+  static char*  start_free;  // 内存池起始位置，只在 chunk_alloc() 和 trim 时变化
+  static char*  end_free;    // 内存池结束位置，只在 chunk_alloc() 和 trim 时变化
+  static size_t heap_size;   // 所有 chunk 的总字节数
+
+  static chunk_header* chunk_list;          // 所有 chunk 组成的链表
+  static size_t        central_free_bytes;  // 中心 free list 上的空闲字节数
+  static size_t        trim_threshold;      // 自动 trim 的水位线，0 表示关闭
+  static size_t        trim_trigger;        // 下一次自动 trim 的触发点
 
  public:
   // 分配 n bytes
   static void* allocate(size_t n) {
-    obj* volatile* my_free_list;  // 一个指针，指向 free_list 数组 (obj*)
-    obj*           result;
+    obj* result;
 
-    // 大于 128 bytes 直接调用一级配置器
+    // 大于 MaxBytes 直接调用一级配置器
     if (n > (size_t)__MAX_BYTES) {
-      return malloc_alloc::allocate(n);
+      return large_allocate(n);
     }
 
-    // 确定 16 个 free list 中的哪一个
-    my_free_list = free_list + freelist_index(n);
-    // 取出对应的 free list 的头结点
-    result = *my_free_list;
+    // 确定是哪一个 free list，只操作本线程的缓存，不需要加锁
+    thread_cache& cache = local_cache();
+    size_t        index = freelist_index(n);
+    result = cache.free_list[index];
     if (0 == result) {
-      // 对应的 free list 已经用完了，重新填充这个 free list
-      void* r = refill(round_up(n));
+      // 对应的 free list 已经用完了，从中心池搬运一批过来
+      void* r = refill(class_size(index));
       return r;
     }
 
-    // 解引用获得头结点，调整对应的 free list 的头结点位置，将之前的头结点返回
-    *my_free_list = result->next_free;
+    // 调整对应的 free list 的头结点位置，将之前的头结点返回
+    cache.free_list[index] = result->next_free;
+    --cache.count[index];
     return result;
   }
 
   static void deallocate(void* p, size_t n) {
-    obj*           q = (obj*)p;
-    obj* volatile* my_free_list;
+    obj* q = (obj*)p;
 
     if (n > (size_t)__MAX_BYTES) {
-      malloc_alloc::deallocate(p, n);
+      large_deallocate(p, n);
       return;
     }
 
-    my_free_list = free_list + freelist_index(n);
-    // 将区块重新放到对应的 free_list 中，调整头结点位置
-    q->next_free = *my_free_list;
-    *my_free_list = q;
+    thread_cache& cache = local_cache();
+    size_t        index = freelist_index(n);
+    // 将区块重新放到本线程对应的 free_list 中，调整头结点位置
+    q->next_free = cache.free_list[index];
+    cache.free_list[index] = q;
+    // 缓存超过两批时归还一批，避免一个线程分配、另一个线程释放时，节点全部堆积在释放线程中
+    int batch = batch_count(class_size(index));
+    if (++cache.count[index] > 2 * (size_t)batch)
+      release_batch(cache, index, batch);
   }
 
   static void* reallocate(void* p, size_t old_sz, size_t new_sz);
-};
 
-template <int inst>
-char* __default_alloc_template<inst>::start_free = 0;
+  // 将完全空闲的 chunk 归还给系统，返回归还的字节数
+  // 调用线程缓存中的区块会先还给中心池，但其他线程缓存中的区块仍会使其所在的 chunk 无法归还
+  static size_t trim() {
+    local_cache().flush();
+    std::lock_guard<std::mutex> guard(central_lock);
+    return trim_locked();
+  }
 
-template <int inst>
-char* __default_alloc_template<inst>::end_free = 0;
+  // 设置自动 trim 的水位线：中心池的空闲字节数达到 bytes 时自动 trim，0 表示关闭（默认）
+  // 返回之前的水位线
+  static size_t set_trim_threshold(size_t bytes) {
+    std::lock_guard<std::mutex> guard(central_lock);
+    size_t old = trim_threshold;
+    trim_threshold = bytes;
+    trim_trigger = bytes;
+    return old;
+  }
 
-template <int inst>
-size_t __default_alloc_template<inst>::heap_size = 0;
+  // 内存池当前从系统申请的总字节数
+  static size_t heap_bytes() {
+    std::lock_guard<std::mutex> guard(central_lock);
+    return heap_size;
+  }
 
-template <int inst>
-typename __default_alloc_template<inst>::obj* volatile __default_alloc_template<inst>::free_list[__NFREELISTS] = {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  // 大小为 n 的区块实际占用的字节数，大于 MaxBytes 时返回 n 本身
+  static size_t block_size(size_t n) {
+    return n > (size_t)__MAX_BYTES ? n : class_size(freelist_index(n));
+  }
 };
 
-// 返回大小为 n 的对象，并且会为适当的 free list 增加结点
-// 假设 n 已经对齐
-template <int inst>
-void* __default_alloc_template<inst>::refill(size_t n) {
-  int nobjs = 20;  // 默认取得 20 个节点
-  // 调用 chunk_alloc() 尝试取得 nobjs 个区块作为 free list 的新节点
-  // nobjs 是引用传参
-  char*          chunk = chunk_alloc(n, nobjs);
-  obj* volatile* my_free_list;
-  obj*           result;
-  obj *          current_obj, *next_obj;
-  int            i;
-
-  // 若只获得了 1 个区块，这个区块就直接给调用者，free list 无新节点
-  if (1 == nobjs)
-    return chunk;
-
-  my_free_list = free_list + freelist_index(n);
-  result = (obj*)chunk;                          // 第一块返回给调用者
-  *my_free_list = next_obj = (obj*)(chunk + n);  // 指向下一个区块
-  for (i = 1;; ++i) {
-    current_obj = next_obj;
-    next_obj = (obj*)((char*)next_obj + n);
-    if (nobjs - 1 == i) {
-      current_obj->next_free = 0;
-      break;
+template <int inst, size_t MaxBytes, size_t Align>
+std::mutex __default_alloc_template<inst, MaxBytes, Align>::central_lock;
+
+template <int inst, size_t MaxBytes, size_t Align>
+char* __default_alloc_template<inst, MaxBytes, Align>::start_free = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+char* __default_alloc_template<inst, MaxBytes, Align>::end_free = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+size_t __default_alloc_template<inst, MaxBytes, Align>::heap_size = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+typename __default_alloc_template<inst, MaxBytes, Align>::chunk_header*
+    __default_alloc_template<inst, MaxBytes, Align>::chunk_list = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+size_t __default_alloc_template<inst, MaxBytes, Align>::central_free_bytes = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+size_t __default_alloc_template<inst, MaxBytes, Align>::trim_threshold = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+size_t __default_alloc_template<inst, MaxBytes, Align>::trim_trigger = 0;
+
+template <int inst, size_t MaxBytes, size_t Align>
+typename __default_alloc_template<inst, MaxBytes, Align>::obj*
+    __default_alloc_template<inst, MaxBytes, Align>::central_free_list[__NFREELISTS] = {};
+
+// 返回大小为 n 的对象，并且会为本线程适当的 free list 增加结点
+// 假设 n 已经是某个 class 的大小
+template <int inst, size_t MaxBytes, size_t Align>
+void* __default_alloc_template<inst, MaxBytes, Align>::refill(size_t n) {
+  int    nobjs = batch_count(n);
+  size_t index = freelist_index(n);
+  obj*   result;
+  obj*   first = 0;  // 搬运到线程缓存的第一个节点
+  int    got = 0;    // 搬运到线程缓存的节点数
+
+  {
+    std::lock_guard<std::mutex> guard(central_lock);
+    result = central_free_list[index];
+    if (0 != result) {
+      // 中心 free list 还有节点，第一块返回给调用者，之后再取最多 nobjs - 1 块
+      first = result->next_free;
+      obj* last = result;
+      while (got < nobjs - 1 && last->next_free != 0) {
+        last = last->next_free;
+        ++got;
+      }
+      central_free_list[index] = last->next_free;
+      last->next_free = 0;
+      central_free_bytes -= (got + 1) * n;
     } else {
-      current_obj->next_free = next_obj;
+      // 调用 chunk_alloc() 尝试取得 nobjs 个区块作为 free list 的新节点
+      // nobjs 是引用传参
+      char* chunk = chunk_alloc(n, nobjs);
+      result = (obj*)chunk;  // 第一块返回给调用者
+      // 若只获得了 1 个区块，这个区块就直接给调用者，free list 无新节点
+      if (nobjs > 1) {
+        first = (obj*)(chunk + n);  // 指向下一个区块
+        obj* current_obj = first;
+        for (int i = 1; i < nobjs - 1; ++i) {
+          obj* next_obj = (obj*)((char*)current_obj + n);
+          current_obj->next_free = next_obj;
+          current_obj = next_obj;
+        }
+        current_obj->next_free = 0;
+        got = nobjs - 1;
+      }
     }
   }
+
+  // 线程缓存此时一定为空，直接把这一批节点挂上去
+  if (got > 0) {
+    thread_cache& cache = local_cache();
+    cache.free_list[index] = first;
+    cache.count[index] = got;
+  }
   return result;
 }
 
-// 假设 size 已经对齐
-template <int inst>
-char* __default_alloc_template<inst>::chunk_alloc(size_t size, int& nobjs) {
+
+template <int inst, size_t MaxBytes, size_t Align>
+void __default_alloc_template<inst, MaxBytes, Align>::release_batch(thread_cache& cache, size_t index, size_t n) {
+  // 先在锁外把前 n 个节点摘下来，持锁时只做一次拼接
+  obj* first = cache.free_list[index];
+  obj* last = first;
+  for (size_t i = 1; i < n; ++i)
+    last = last->next_free;
+  cache.free_list[index] = last->next_free;
+  cache.count[index] -= n;
+  central_push(index, first, last, n * class_size(index));
+}
+
+// 假设 size 已经是某个 class 的大小，调用者持有 central_lock
+template <int inst, size_t MaxBytes, size_t Align>
+char* __default_alloc_template<inst, MaxBytes, Align>::chunk_alloc(size_t size, int& nobjs) {
   char*  result;
   size_t total_bytes = size * nobjs;
   size_t bytes_left = end_free - start_free;
@@ -276,29 +794,38 @@ char* __default_alloc_template<inst>::chunk_alloc(size_t size, int& nobjs) {
   } else {
     // 内存池连一个区块都不够分了
     size_t bytes_to_get = 2 * total_bytes + round_up(heap_size >> 4);
-    if (bytes_left > 0) {
-      // 若内存池中还有内存，则先把它分配给合适的 free list
-      obj* volatile* my_free_list = free_list + freelist_index(bytes_left);
-      ((obj*)start_free)->next_free = *my_free_list;
-      *my_free_list = (obj*)start_free;
+    // 若内存池中还有内存，则先把它分配给合适的中心 free list
+    // 128 bytes 以上的 class 不是等距的，剩余的字节数不一定刚好是一个 class，
+    // 所以每次切下不超过剩余字节数的最大 class，剩余的字节数总是 Align 的倍数，最后一定能切完
+    while (bytes_left > 0) {
+      size_t index = freelist_index(bytes_left);
+      if (class_size(index) > bytes_left)
+        --index;
+      size_t bytes = class_size(index);
+      ((obj*)start_free)->next_free = central_free_list[index];
+      central_free_list[index] = (obj*)start_free;
+      central_free_bytes += bytes;
+      start_free += bytes;
+      bytes_left -= bytes;
     }
     // 调用 malloc，补充内存池
-    start_free = (char*)malloc(bytes_to_get);
+    start_free = chunk_malloc(bytes_to_get, false);
     if (0 == start_free) {
       // heap 空间不足，malloc 失败
-      int            i;
-      obj* volatile* my_free_list;
-      obj*           p;
-      // 看看我们还有什么，搜寻适当的 free list(只往大的搜)，
+      size_t i;
+      obj**  my_free_list;
+      obj*   p;
+      // 看看我们还有什么，搜寻适当的中心 free list(只往大的搜)，
       // 看看 free list 上还有没有没用且足够大的区块
-      for (i = size; i <= __MAX_BYTES; i += __ALIGN) {
-        my_free_list = free_list + freelist_index(i);
+      for (i = freelist_index(size); i < __NFREELISTS; ++i) {
+        my_free_list = central_free_list + i;
         p = *my_free_list;
         if (0 != p) {
           // 摘取当前区块
           *my_free_list = p->next_free;
+          central_free_bytes -= class_size(i);
           start_free = (char*)p;
-          end_free = start_free + i;
+          end_free = start_free + class_size(i);
           // 递归调用自己，为了修正 nobjs
           return chunk_alloc(size, nobjs);
           // 任何残余的内存终将被放进适当的 free list
@@ -309,7 +836,7 @@ char* __default_alloc_template<inst>::chunk_alloc(size_t size, int& nobjs) {
       end_free = 0;
       // 调用一级配置器，看看 out-of-memory 的机制能否有用
       // 要么抛异常，要么内存不足的情况得以改善
-      start_free = (char*)(malloc_alloc::allocate(bytes_to_get));
+      start_free = chunk_malloc(bytes_to_get, true);
     }
     heap_size += bytes_to_get;
     end_free = start_free + bytes_to_get;
@@ -318,16 +845,128 @@ char* __default_alloc_template<inst>::chunk_alloc(size_t size, int& nobjs) {
   }
 }
 
-template <int inst>
-void* __default_alloc_template<inst>::reallocate(void* p, size_t old_sz, size_t new_sz) {
+template <int inst, size_t MaxBytes, size_t Align>
+char* __default_alloc_template<inst, MaxBytes, Align>::chunk_malloc(size_t bytes, bool use_oom_handler) {
+  // 多申请 __ALIGN - 1 字节，保证头部之后的可用部分能按 Align 对齐
+  size_t total = sizeof(chunk_header) + __ALIGN - 1 + bytes;
+  char*  raw = (char*)(use_oom_handler ? malloc_alloc::allocate(total) : malloc(total));
+  if (0 == raw)
+    return 0;
+  char*         result = round_up(raw + sizeof(chunk_header));
+  chunk_header* chunk = (chunk_header*)result - 1;
+  chunk->size = bytes;
+  chunk->raw = raw;
+  chunk->next = chunk_list;
+  chunk_list = chunk;
+  return result;
+}
+
+// 找出所有区块都在中心 free list 上（或者还没切分出去）的 chunk，将其归还给系统
+template <int inst, size_t MaxBytes, size_t Align>
+size_t __default_alloc_template<inst, MaxBytes, Align>::trim_locked() {
+  size_t nchunk = 0;
+  for (chunk_header* c = chunk_list; c != 0; c = c->next)
+    ++nchunk;
+  if (0 == nchunk)
+    return 0;
+
+  // 这里不能用内存池本身分配，直接 malloc 临时数组
+  chunk_header** chunks = (chunk_header**)malloc(nchunk * sizeof(chunk_header*));
+  size_t*        free_bytes = (size_t*)malloc(nchunk * sizeof(size_t));
+  if (0 == chunks || 0 == free_bytes) {
+    free(chunks);
+    free(free_bytes);
+    return 0;
+  }
+
+  size_t k = 0;
+  for (chunk_header* c = chunk_list; c != 0; c = c->next, ++k) {
+    chunks[k] = c;
+    free_bytes[k] = 0;
+  }
+  // 按地址排序，之后用二分查找确定某个区块属于哪个 chunk
+  std::sort(chunks, chunks + nchunk, std::less<chunk_header*>());
+
+  auto owner = [chunks, nchunk](void* p) -> size_t {
+    // 找到最后一个起始地址不大于 p 的 chunk
+    size_t lo = 0, hi = nchunk;
+    while (hi - lo > 1) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (std::less<void*>()(p, chunks[mid]))
+        hi = mid;
+      else
+        lo = mid;
+    }
+    return lo;
+  };
+
+  // 统计每个 chunk 中空闲的字节数，内存池中还没切分出去的部分也算空闲
+  for (int i = 0; i < __NFREELISTS; ++i) {
+    for (obj* p = central_free_list[i]; p != 0; p = p->next_free)
+      free_bytes[owner(p)] += class_size(i);
+  }
+  if (start_free != end_free)
+    free_bytes[owner(start_free)] += end_free - start_free;
+
+  // 复用 free_bytes 作为标记：1 表示整个 chunk 都是空闲的，可以归还
+  size_t nrelease = 0;
+  for (k = 0; k < nchunk; ++k) {
+    free_bytes[k] = free_bytes[k] == chunks[k]->size ? 1 : 0;
+    nrelease += free_bytes[k];
+  }
+
+  size_t released = 0;
+  if (nrelease > 0) {
+    // 将属于这些 chunk 的区块从 free list 中摘除
+    for (int i = 0; i < __NFREELISTS; ++i) {
+      obj** link = &central_free_list[i];
+      while (*link != 0) {
+        if (free_bytes[owner(*link)]) {
+          *link = (*link)->next_free;
+          central_free_bytes -= class_size(i);
+        } else {
+          link = &(*link)->next_free;
+        }
+      }
+    }
+    if (start_free != end_free && free_bytes[owner(start_free)])
+      start_free = end_free = 0;
+
+    // 重建 chunk 链表，并将空闲的 chunk 归还给系统
+    chunk_list = 0;
+    for (k = 0; k < nchunk; ++k) {
+      if (free_bytes[k]) {
+        released += chunks[k]->size;
+        heap_size -= chunks[k]->size;
+        free(chunks[k]->raw);
+      } else {
+        chunks[k]->next = chunk_list;
+        chunk_list = chunks[k];
+      }
+    }
+  }
+
+  free(chunks);
+  free(free_bytes);
+  return released;
+}
+template <int inst, size_t MaxBytes, size_t Align>
+void* __default_alloc_template<inst, MaxBytes, Align>::reallocate(void* p, size_t old_sz, size_t new_sz) {
   void*  result;
   size_t copy_sz;
 
-  if (old_sz > (size_t)__MAX_BYTES && new_sz > (size_t)__MAX_BYTES) {
-    return realloc(p, new_sz);
+  // 新旧区块都由 mmap 分配时用 mremap，数据不需要复制
+  if (use_mmap(old_sz) && use_mmap(new_sz))
+    return __mmap_alloc::reallocate(p, old_sz, new_sz);
+
+  // realloc 只保证 malloc 本身的对齐
+  if (old_sz > (size_t)__MAX_BYTES && new_sz > (size_t)__MAX_BYTES && !use_mmap(old_sz) && !use_mmap(new_sz) &&
+      __ALIGN <= alignof(std::max_align_t)) {
+    return malloc_alloc::reallocate(p, old_sz, new_sz);
   }
 
-  if (round_up(old_sz) == round_up(new_sz))
+  if (old_sz <= (size_t)__MAX_BYTES && new_sz <= (size_t)__MAX_BYTES &&
+      freelist_index(old_sz) == freelist_index(new_sz))
     return p;
 
   result = allocate(new_sz);
@@ -339,6 +978,10 @@ void* __default_alloc_template<inst>::reallocate(void* p, size_t old_sz, size_t
 
 typedef __default_alloc_template<0> alloc;
 
+// 指定 size class 上限和对齐的内存池，例如 pool_alloc<1024, 32>
+template <size_t MaxBytes, size_t Align = 8>
+using pool_alloc = __default_alloc_template<0, MaxBytes, Align>;
+
 }  // namespace gd
 
-#endif  // !__MY_ALLOC_H
\ No newline at end of file
+#endif  // !__MY_ALLOC_H
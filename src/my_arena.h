@@ -0,0 +1,162 @@
+#ifndef __MY_ARENA_H
+#define __MY_ARENA_H
+
+#include <cstddef>  // for max_align_t
+#include <cstdint>  // for uintptr_t
+#include <cstring>  // for memcpy
+#include "my_alloc.h"
+
+namespace gd {
+
+// 单调增长的内存区域（monotonic arena）
+// 分配只是移动指针，释放单个区块什么也不做，arena 析构或调用 release() 时一次性归还所有内存，
+// 适合生命周期相同的一批对象，例如处理一个请求时用到的临时容器
+// arena 不是线程安全的
+class arena {
+ public:
+  enum { __DEFAULT_BLOCK = 4096 };    // 第一次向系统申请的大小
+  enum { __MAX_BLOCK = 1 << 20 };     // 每次申请的大小翻倍，直到这个上限
+  enum { __MAX_ALIGN = alignof(std::max_align_t) };
+
+  explicit arena(size_t block_size = __DEFAULT_BLOCK)
+      : _cur(0), _end(0), _blocks(0), _first_block(block_size), _next_block(block_size), _buffer(0),
+        _buffer_size(0), _reserved(0) {}
+
+  // 先使用调用者提供的 buffer（例如栈上的数组），用完后再向系统申请
+  arena(void* buffer, size_t bytes, size_t block_size = __DEFAULT_BLOCK)
+      : _cur((char*)buffer), _end((char*)buffer + bytes), _blocks(0), _first_block(block_size),
+        _next_block(block_size), _buffer((char*)buffer), _buffer_size(bytes), _reserved(0) {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() {
+    release();
+  }
+
+  // 分配 bytes 字节，起始地址按 align 对齐，align 必须是 2 的幂
+  void* allocate(size_t bytes, size_t align = __MAX_ALIGN) {
+    char* p = __align_up(_cur, align);
+    if (p > _end || (size_t)(_end - p) < bytes)
+      return __allocate_slow(bytes, align);
+    _cur = p + bytes;
+    return p;
+  }
+
+  // 单个区块的释放什么也不做
+  void deallocate(void* /* p */, size_t /* bytes */) {}
+
+  // p 是最近一次分配的区块并且当前内存块还有空间时原地扩展（或缩小），否则重新分配并复制
+  void* reallocate(void* p, size_t old_bytes, size_t new_bytes, size_t align = __MAX_ALIGN) {
+    if ((char*)p + old_bytes == _cur && (size_t)(_end - (char*)p) >= new_bytes) {
+      _cur = (char*)p + new_bytes;
+      return p;
+    }
+    void* result = allocate(new_bytes, align);
+    memcpy(result, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+    return result;
+  }
+
+  // 归还所有向系统申请的内存，之后 arena 可以重新使用，调用者提供的 buffer 也会被重新使用
+  void release() {
+    while (_blocks != 0) {
+      block_header* prev = _blocks->prev;
+      malloc_alloc::deallocate(_blocks, _blocks->size);
+      _blocks = prev;
+    }
+    _cur = _buffer;
+    _end = _buffer + _buffer_size;
+    _next_block = _first_block;
+    _reserved = 0;
+  }
+
+  // 当前向系统申请的总字节数，不包括调用者提供的 buffer
+  size_t bytes_reserved() const {
+    return _reserved;
+  }
+
+ private:
+  // 每次向系统申请的内存块的头部，所有内存块串成一个链表
+  struct block_header {
+    block_header* prev;
+    size_t        size;
+  };
+
+  static char* __align_up(char* p, size_t align) {
+    return (char*)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+  }
+
+  // 当前内存块不够用时，向系统申请一块新的
+  void* __allocate_slow(size_t bytes, size_t align) {
+    size_t need = sizeof(block_header) + align - 1 + bytes;
+    size_t size = _next_block > need ? _next_block : need;
+    block_header* block = (block_header*)malloc_alloc::allocate(size);
+    block->prev = _blocks;
+    block->size = size;
+    _blocks = block;
+    _reserved += size;
+    if (_next_block < (size_t)__MAX_BLOCK)
+      _next_block *= 2;
+
+    char* p = __align_up((char*)(block + 1), align);
+    _cur = p + bytes;
+    _end = (char*)block + size;
+    return p;
+  }
+
+  char*         _cur;          // 当前内存块中下一次分配的位置
+  char*         _end;          // 当前内存块的结尾
+  block_header* _blocks;       // 最近一次申请的内存块
+  size_t        _first_block;  // 第一次申请的大小
+  size_t        _next_block;   // 下一次申请的大小
+  char*         _buffer;       // 调用者提供的 buffer
+  size_t        _buffer_size;
+  size_t        _reserved;     // 向系统申请的总字节数
+};
+
+// 以 arena 为底层的配置器，可以作为各个容器的 Alloc 参数
+// 与 alloc 不同，arena_alloc 带有状态（所用的 arena），没有默认构造函数，需要在构造容器时传入，例如：
+//   gd::arena                               a;
+//   gd::arena_alloc                         aa(a);
+//   gd::map<int, int, std::less<int>, gd::arena_alloc> m(aa);
+// deallocate 什么也不做，内存在 arena 销毁时统一归还，所以 arena 必须比使用它的容器活得久
+class arena_alloc {
+ public:
+  arena_alloc(arena& a) noexcept : _arena(&a) {}
+
+  void* allocate(size_t n) {
+    return _arena->allocate(n, __align_of_size(n));
+  }
+
+  void deallocate(void* /* p */, size_t /* n */) {}
+
+  void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+    return _arena->reallocate(p, old_sz, new_sz, __align_of_size(new_sz));
+  }
+
+  arena* resource() const noexcept {
+    return _arena;
+  }
+
+ private:
+  // 这一层没有类型信息，只能根据大小推断对齐：对象的大小一定是其对齐的整数倍，
+  // 所以取 n 最低位的 1 作为对齐，且不超过 max_align_t 的对齐
+  static size_t __align_of_size(size_t n) {
+    size_t align = n & (~n + 1);
+    return align == 0 || align > (size_t)arena::__MAX_ALIGN ? (size_t)arena::__MAX_ALIGN : align;
+  }
+
+  arena* _arena;
+};
+
+inline bool operator==(const arena_alloc& lhs, const arena_alloc& rhs) {
+  return lhs.resource() == rhs.resource();
+}
+
+inline bool operator!=(const arena_alloc& lhs, const arena_alloc& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_ARENA_H
@@ -0,0 +1,1038 @@
+#ifndef __MY_BTREE__H
+#define __MY_BTREE__H
+
+#include <algorithm>  // for lexicographical_compare
+#include <cstddef>
+#include <tuple>
+#include <type_traits>  // for aligned_storage
+#include <utility>
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_iterator.h"
+#include "my_tree.h"  // for sorted_unique_t, sorted_equivalent_t
+
+namespace gd {
+
+// B 树：每个节点连续存放多个有序的元素，查找时一个节点只有一两次 cache miss，
+// 比红黑树每比较一次就换一个节点要少得多的 cache miss，节点也没有每个元素三个指针的开销
+// 叶节点和内部节点的头部相同，内部节点在元素之后多一个孩子指针数组，
+// 内部节点的第 i 个元素介于第 i 个和第 i + 1 个孩子之间
+enum { __BTREE_NODE_BYTES = 256 };  // 叶节点的目标大小，四个 cache line
+
+template <typename Value>
+struct _btree_node {
+  enum { __FIT = (__BTREE_NODE_BYTES - 2 * sizeof(void*)) / sizeof(Value) };
+  enum { max_count = __FIT < 3 ? 3 : (__FIT > 1024 ? 1024 : __FIT) };  // 节点内最多的元素个数
+  enum { min_count = max_count / 2 };  // 删除后元素少于这个数时向兄弟节点借或者合并
+
+  _btree_node*   parent;
+  unsigned short position;  // 在父节点中是第几个孩子
+  unsigned short count;     // 元素个数
+  bool           leaf;
+  typename std::aligned_storage<sizeof(Value), alignof(Value)>::type storage[max_count];
+
+  Value* values() {
+    return reinterpret_cast<Value*>(storage);
+  }
+
+  Value& value(size_t i) {
+    return values()[i];
+  }
+};
+
+template <typename Value>
+struct _btree_internal_node : public _btree_node<Value> {
+  _btree_node<Value>* children[_btree_node<Value>::max_count + 1];
+};
+
+template <typename Value>
+inline _btree_node<Value>*& _btree_child(_btree_node<Value>* x, size_t i) {
+  return static_cast<_btree_internal_node<Value>*>(x)->children[i];
+}
+
+// 迭代器为 (节点, 下标)，end() 是最右边叶节点的最后一个元素之后
+template <typename Value, typename Ref, typename Ptr>
+struct _btree_iterator {
+  typedef Value                      value_type;
+  typedef Ref                        reference;
+  typedef Ptr                        pointer;
+  typedef ptrdiff_t                  difference_type;
+  typedef bidirectional_iterator_tag iterator_category;
+
+  typedef _btree_iterator                                    self;
+  typedef _btree_iterator<Value, Value&, Value*>             iterator;
+  typedef _btree_iterator<Value, const Value&, const Value*> const_iterator;
+  typedef _btree_node<Value>*                                node_ptr;
+
+  node_ptr node;
+  int      pos;
+
+  _btree_iterator() : node(0), pos(0) {}
+  _btree_iterator(node_ptr x, int i) : node(x), pos(i) {}
+  _btree_iterator(const iterator& rhs) : node(rhs.node), pos(rhs.pos) {}
+
+  reference operator*() const {
+    return node->value(pos);
+  }
+
+  pointer operator->() const {
+    return &(operator*());
+  }
+
+  self& operator++() {
+    if (node->leaf && ++pos < node->count)
+      return *this;
+    __increment_slow();
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  self& operator--() {
+    if (node->leaf && --pos >= 0)
+      return *this;
+    __decrement_slow();
+    return *this;
+  }
+
+  self operator--(int) {
+    self tmp(*this);
+    --*this;
+    return tmp;
+  }
+
+  bool operator==(const iterator& rhs) const {
+    return node == rhs.node && pos == rhs.pos;
+  }
+
+  bool operator==(const const_iterator& rhs) const {
+    return node == rhs.node && pos == rhs.pos;
+  }
+
+  bool operator!=(const iterator& rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator!=(const const_iterator& rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  void __increment_slow() {
+    if (node->leaf) {
+      // 叶节点走完了，回到第一个还有下一个元素的祖先，没有这样的祖先时停在 end()
+      self save = *this;
+      while (pos == node->count && node->parent != 0) {
+        pos = node->position;
+        node = node->parent;
+      }
+      if (pos == node->count)
+        *this = save;
+    } else {
+      // 内部节点的下一个元素是右边子树最左边的元素
+      node = _btree_child(node, pos + 1);
+      while (!node->leaf)
+        node = _btree_child(node, 0);
+      pos = 0;
+    }
+  }
+
+  void __decrement_slow() {
+    if (node->leaf) {
+      self save = *this;
+      while (pos < 0 && node->parent != 0) {
+        pos = node->position - 1;
+        node = node->parent;
+      }
+      if (pos < 0)
+        *this = save;
+    } else {
+      node = _btree_child(node, pos);
+      while (!node->leaf)
+        node = _btree_child(node, node->count);
+      pos = node->count - 1;
+    }
+  }
+};
+
+// 插入和删除会在节点内、节点间移动元素，所有迭代器和元素的引用都会失效，
+// 移动元素时假设 value_type 的移动构造不抛出异常；插入和删除返回的迭代器是有效的
+// 私有继承 simple_alloc<char, Alloc>，Alloc 有状态时每棵树保存自己的配置器
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc>
+class btree : private simple_alloc<char, Alloc> {
+ public:
+  typedef Key               key_type;
+  typedef Value             value_type;
+  typedef value_type*       pointer;
+  typedef const value_type* const_pointer;
+  typedef value_type&       reference;
+  typedef const value_type& const_reference;
+  typedef size_t            size_type;
+  typedef ptrdiff_t         difference_type;
+
+  typedef _btree_iterator<value_type, reference, pointer>             iterator;
+  typedef _btree_iterator<value_type, const_reference, const_pointer> const_iterator;
+
+  typedef simple_alloc<Value, Alloc> allocator_type;
+  typedef simple_alloc<char, Alloc>  byte_allocator;
+
+  allocator_type get_allocator() const {
+    return _get_alloc();
+  }
+
+ protected:
+  typedef _btree_node<Value>          node_type;
+  typedef _btree_internal_node<Value> internal_type;
+  typedef node_type*                  node_ptr;
+
+  enum { __MAX = node_type::max_count, __MIN = node_type::min_count };
+
+  node_ptr  _root;
+  node_ptr  _leftmost;   // 最左边的叶节点
+  node_ptr  _rightmost;  // 最右边的叶节点
+  size_type _size;
+  Compare   _key_compare;
+
+  byte_allocator& _get_alloc() noexcept {
+    return *this;
+  }
+
+  const byte_allocator& _get_alloc() const noexcept {
+    return *this;
+  }
+
+  static node_ptr& _child(node_ptr x, size_type i) {
+    return _btree_child(x, i);
+  }
+
+  static const key_type& _key(node_ptr x, size_type i) {
+    return KeyOfValue()(x->value(i));
+  }
+
+ private:  // node helpers
+  node_ptr __new_node(bool leaf, node_ptr parent) {
+    node_ptr x = (node_ptr)byte_allocator::allocate(leaf ? sizeof(node_type) : sizeof(internal_type));
+    x->parent = parent;
+    x->position = 0;
+    x->count = 0;
+    x->leaf = leaf;
+    return x;
+  }
+
+  void __delete_node(node_ptr x) {
+    byte_allocator::deallocate((char*)x, x->leaf ? sizeof(node_type) : sizeof(internal_type));
+  }
+
+  static void __relocate(value_type* dst, value_type* src) {
+    gd::construct(dst, std::move(*src));
+    gd::destroy(src);
+  }
+
+  static void __set_child(node_ptr x, size_type i, node_ptr c) {
+    _child(x, i) = c;
+    c->parent = x;
+    c->position = (unsigned short)i;
+  }
+
+  // 空出 x 的第 i 个元素位置，内部节点同时空出第 i + 1 个孩子的位置，count 不变
+  static void __open_slot(node_ptr x, size_type i) {
+    for (size_type j = x->count; j > i; --j)
+      __relocate(&x->value(j), &x->value(j - 1));
+    if (!x->leaf) {
+      for (size_type j = x->count + 1; j > i + 1; --j)
+        __set_child(x, j, _child(x, j - 1));
+    }
+  }
+
+  // 去掉 x 的第 i 个元素位置（已经析构或搬走），内部节点同时去掉第 i + 1 个孩子，count 不变
+  static void __close_slot(node_ptr x, size_type i) {
+    for (size_type j = i + 1; j < x->count; ++j)
+      __relocate(&x->value(j - 1), &x->value(j));
+    if (!x->leaf) {
+      for (size_type j = i + 2; j <= x->count; ++j)
+        __set_child(x, j - 1, _child(x, j));
+    }
+  }
+
+  // 节点内第一个不小于 k 的位置
+  size_type __lower_in_node(node_ptr x, const key_type& k) const {
+    size_type lo = 0;
+    size_type hi = x->count;
+    while (lo < hi) {
+      size_type mid = (lo + hi) / 2;
+      if (_key_compare(_key(x, mid), k))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  // 节点内第一个大于 k 的位置
+  size_type __upper_in_node(node_ptr x, const key_type& k) const {
+    size_type lo = 0;
+    size_type hi = x->count;
+    while (lo < hi) {
+      size_type mid = (lo + hi) / 2;
+      if (_key_compare(k, _key(x, mid)))
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    return lo;
+  }
+
+  // 叶节点中的位置 (x, i) 可能在最后一个元素之后，这时真正的元素在第一个还有后续元素的祖先中，都没有时为 end()
+  iterator __normalize(node_ptr x, size_type i) const {
+    while (i == x->count && x->parent != 0) {
+      i = x->position;
+      x = x->parent;
+    }
+    if (i == x->count)
+      return iterator(_rightmost, _rightmost->count);
+    return iterator(x, (int)i);
+  }
+
+  static node_ptr __leftmost_leaf(node_ptr x) {
+    while (!x->leaf)
+      x = _child(x, 0);
+    return x;
+  }
+
+  static node_ptr __rightmost_leaf(node_ptr x) {
+    while (!x->leaf)
+      x = _child(x, x->count);
+    return x;
+  }
+
+  // 新元素放在 it 所指元素之前时，它在叶节点中的位置
+  static iterator __leaf_position(iterator it) {
+    if (it.node->leaf)
+      return it;
+    node_ptr x = __rightmost_leaf(_child(it.node, it.pos));
+    return iterator(x, x->count);
+  }
+
+ private:  // insert helpers
+  // 保证 x 中还能再放一个元素，x 已满时分裂 x，(x, i) 随之更新为原来的位置 i 现在所在的节点和下标
+  // 分裂前先保证父节点不满，所以从上往下分裂，每一步分裂后树都是完整的，分配节点失败时已经完成的分裂不用回滚
+  void __make_room(node_ptr& x, size_type& i) {
+    if (x->count < __MAX)
+      return;
+    node_ptr r = __new_node(x->leaf, 0);
+    if (x->parent == 0) {
+      node_ptr root;
+      try {
+        root = __new_node(false, 0);
+      } catch (...) {
+        __delete_node(r);
+        throw;
+      }
+      __set_child(root, 0, x);
+      _root = root;
+    } else {
+      node_ptr  p = x->parent;
+      size_type pi = x->position;
+      try {
+        __make_room(p, pi);  // 父节点分裂后 x 的 parent 和 position 已经更新
+      } catch (...) {
+        __delete_node(r);
+        throw;
+      }
+    }
+
+    // 在末尾插入时左边留满，在开头插入时右边留满，顺序插入时节点几乎都是满的
+    size_type split = i == __MAX ? __MAX - 1 : (i == 0 ? 0 : __MAX / 2);
+    for (size_type j = split + 1; j < __MAX; ++j)
+      __relocate(&r->value(j - split - 1), &x->value(j));
+    r->count = (unsigned short)(__MAX - split - 1);
+    if (!x->leaf) {
+      for (size_type j = split + 1; j <= __MAX; ++j)
+        __set_child(r, j - split - 1, _child(x, j));
+    }
+
+    // 中间的元素放进父节点，r 作为它右边的孩子
+    node_ptr  p = x->parent;
+    size_type pi = x->position;
+    __open_slot(p, pi);
+    __relocate(&p->value(pi), &x->value(split));
+    __set_child(p, pi + 1, r);
+    ++p->count;
+    x->count = (unsigned short)split;
+    if (x == _rightmost)
+      _rightmost = r;
+
+    if (i > split) {
+      x = r;
+      i -= split + 1;
+    }
+  }
+
+  // 在叶节点的位置 it 上构造新元素
+  template <typename... Args>
+  iterator __insert_at(iterator it, Args&&... args) {
+    node_ptr  x = it.node;
+    size_type i = it.pos;
+    __make_room(x, i);
+    __open_slot(x, i);
+    ++x->count;  // 空出的位置计入 count，与 __close_slot 的约定相同
+    try {
+      gd::construct(&x->value(i), std::forward<Args>(args)...);
+    } catch (...) {
+      __close_slot(x, i);
+      --x->count;
+      // x 可能是刚刚分裂出来、只等着放新元素的空节点，也可能是刚建立的根节点
+      if (x->count == 0) {
+        iterator track;
+        __rebalance(x, track);
+      }
+      throw;
+    }
+    ++_size;
+    return iterator(x, (int)i);
+  }
+
+  void __init_root() {
+    _root = __new_node(true, 0);
+    _leftmost = _root;
+    _rightmost = _root;
+  }
+
+ private:  // erase helpers
+  // 删除后 x 的元素可能太少，向兄弟节点借一个或者与兄弟节点合并，合并后父节点少一个元素，继续向上调整
+  // track 指向删除元素的下一个元素（node 为空时表示 end()），调整时元素在节点间移动，track 随之更新
+  void __rebalance(node_ptr x, iterator& track) {
+    while (x != _root && x->count < __MIN) {
+      node_ptr  p = x->parent;
+      size_type px = x->position;
+      node_ptr  l = px > 0 ? _child(p, px - 1) : 0;
+      node_ptr  r = px < p->count ? _child(p, px + 1) : 0;
+      if (l != 0 && l->count > __MIN) {
+        __rotate_right(l, x, px - 1, track);
+        return;
+      }
+      if (r != 0 && r->count > __MIN) {
+        __rotate_left(x, r, px, track);
+        return;
+      }
+      if (l != 0)
+        __merge(l, x, px - 1, track);
+      else
+        __merge(x, r, px, track);
+      x = p;
+    }
+    if (_root->count == 0) {
+      node_ptr old = _root;
+      if (old->leaf) {
+        _root = _leftmost = _rightmost = 0;
+      } else {
+        _root = _child(old, 0);
+        _root->parent = 0;
+        _root->position = 0;
+      }
+      __delete_node(old);
+    }
+  }
+
+  // 父节点的第 s 个元素移到 x 的开头，左兄弟 l 的最后一个元素移到父节点
+  void __rotate_right(node_ptr l, node_ptr x, size_type s, iterator& track) {
+    node_ptr p = x->parent;
+    __open_slot(x, 0);
+    if (!x->leaf) {
+      __set_child(x, 1, _child(x, 0));
+      __set_child(x, 0, _child(l, l->count));
+    }
+    __relocate(&x->value(0), &p->value(s));
+    __relocate(&p->value(s), &l->value(l->count - 1));
+    ++x->count;
+    --l->count;
+
+    if (track.node == x)
+      ++track.pos;
+    else if (track.node == p && track.pos == (int)s)
+      track = iterator(x, 0);
+    else if (track.node == l && track.pos == (int)l->count)
+      track = iterator(p, (int)s);
+  }
+
+  // 父节点的第 s 个元素移到 x 的末尾，右兄弟 r 的第一个元素移到父节点
+  void __rotate_left(node_ptr x, node_ptr r, size_type s, iterator& track) {
+    node_ptr  p = x->parent;
+    size_type n = x->count;
+    __relocate(&x->value(n), &p->value(s));
+    __relocate(&p->value(s), &r->value(0));
+    if (!r->leaf) {
+      __set_child(x, n + 1, _child(r, 0));
+      __set_child(r, 0, _child(r, 1));
+    }
+    __close_slot(r, 0);
+    ++x->count;
+    --r->count;
+
+    if (track.node == p && track.pos == (int)s)
+      track = iterator(x, (int)n);
+    else if (track.node == r)
+      track = track.pos == 0 ? iterator(p, (int)s) : iterator(r, track.pos - 1);
+  }
+
+  // 父节点的第 s 个元素和右兄弟 r 的所有元素都并入 l，释放 r
+  void __merge(node_ptr l, node_ptr r, size_type s, iterator& track) {
+    node_ptr  p = l->parent;
+    size_type n = l->count;
+    __relocate(&l->value(n), &p->value(s));
+    for (size_type j = 0; j < r->count; ++j)
+      __relocate(&l->value(n + 1 + j), &r->value(j));
+    if (!l->leaf) {
+      for (size_type j = 0; j <= r->count; ++j)
+        __set_child(l, n + 1 + j, _child(r, j));
+    }
+    l->count = (unsigned short)(n + 1 + r->count);
+    __close_slot(p, s);
+    --p->count;
+    if (r == _rightmost)
+      _rightmost = l;
+
+    if (track.node == r)
+      track = iterator(l, (int)(n + 1) + track.pos);
+    else if (track.node == p && track.pos == (int)s)
+      track = iterator(l, (int)n);
+    else if (track.node == p && track.pos > (int)s)
+      --track.pos;
+    __delete_node(r);
+  }
+
+ private:  // copy and destroy helpers
+  void __destroy(node_ptr x) {
+    if (!x->leaf) {
+      for (size_type j = 0; j <= x->count; ++j)
+        __destroy(_child(x, j));
+    }
+    gd::destroy(x->values(), x->values() + x->count);
+    __delete_node(x);
+  }
+
+  // 深度只有 log(n) / log(__MAX)，递归拷贝
+  node_ptr __copy(node_ptr x, node_ptr parent) {
+    node_ptr  y = __new_node(x->leaf, parent);
+    size_type copied = 0;  // 已经拷贝的孩子个数
+    y->position = x->position;
+    try {
+      for (; y->count < x->count; ++y->count)
+        gd::construct(&y->value(y->count), x->value(y->count));
+      if (!x->leaf) {
+        for (; copied <= x->count; ++copied)
+          _child(y, copied) = __copy(_child(x, copied), y);
+      }
+    } catch (...) {
+      for (size_type j = 0; j < copied; ++j)
+        __destroy(_child(y, j));
+      gd::destroy(y->values(), y->values() + y->count);
+      __delete_node(y);
+      throw;
+    }
+    return y;
+  }
+
+  void __copy_from(const btree& rhs) {
+    if (rhs._root != 0) {
+      _root = __copy(rhs._root, 0);
+      _leftmost = __leftmost_leaf(_root);
+      _rightmost = __rightmost_leaf(_root);
+      _size = rhs._size;
+    }
+  }
+
+  void __empty_init() {
+    _root = _leftmost = _rightmost = 0;
+    _size = 0;
+  }
+
+  void __steal(btree& rhs) noexcept {
+    _root = rhs._root;
+    _leftmost = rhs._leftmost;
+    _rightmost = rhs._rightmost;
+    _size = rhs._size;
+    rhs.__empty_init();
+  }
+
+  // 配置器不相等时，rhs 的节点不能由本树释放，只能逐个移动元素，调用前本树为空
+  void __move_elements(btree& rhs) {
+    if (rhs._size == 0)
+      return;
+    __init_root();
+    for (iterator it = rhs.begin(); it != rhs.end(); ++it)
+      __insert_at(end(), std::move(*it));
+  }
+
+  void __move_assign(btree& rhs, std::true_type) {
+    clear();
+    gd::__alloc_on_move(_get_alloc(), rhs._get_alloc());
+    _key_compare = rhs._key_compare;
+    __steal(rhs);
+  }
+
+  void __move_assign(btree& rhs, std::false_type) {
+    if (_get_alloc() == rhs._get_alloc()) {
+      __move_assign(rhs, std::true_type());
+    } else {
+      clear();
+      _key_compare = rhs._key_compare;
+      __move_elements(rhs);
+    }
+  }
+
+ public:  // constructors, copy, destructors
+  btree() : _key_compare() {
+    __empty_init();
+  }
+
+  explicit btree(const Compare& comp, const allocator_type& a = allocator_type())
+      : byte_allocator(a), _key_compare(comp) {
+    __empty_init();
+  }
+
+  // 拷贝时配置器由 select_on_container_copy_construction() 决定
+  btree(const btree& rhs)
+      : byte_allocator(rhs._get_alloc().select_on_container_copy_construction()), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  btree(const btree& rhs, const allocator_type& a) : byte_allocator(a), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  // 移动时配置器随节点一起转移
+  btree(btree&& rhs) noexcept : byte_allocator(std::move(rhs._get_alloc())), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __steal(rhs);
+  }
+
+  btree(btree&& rhs, const allocator_type& a) : byte_allocator(a), _key_compare(rhs._key_compare) {
+    __empty_init();
+    if (_get_alloc() == rhs._get_alloc()) {
+      __steal(rhs);
+    } else {
+      try {
+        __move_elements(rhs);
+      } catch (...) {
+        clear();
+        throw;
+      }
+    }
+  }
+
+  btree& operator=(const btree& rhs) {
+    if (this != &rhs) {
+      // 先用旧的配置器释放所有节点，再按需要换成 rhs 的配置器
+      clear();
+      gd::__alloc_on_copy(_get_alloc(), rhs._get_alloc());
+      _key_compare = rhs._key_compare;
+      __copy_from(rhs);
+    }
+    return *this;
+  }
+
+  btree& operator=(btree&& rhs) {
+    if (this != &rhs)
+      __move_assign(rhs, __alloc_move_steals<byte_allocator>());
+    return *this;
+  }
+
+  ~btree() {
+    clear();
+  }
+
+ public:  // iterator
+  iterator begin() noexcept {
+    return iterator(_leftmost, 0);
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(_leftmost, 0);
+  }
+
+  iterator end() noexcept {
+    return iterator(_rightmost, _rightmost ? _rightmost->count : 0);
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator(_rightmost, _rightmost ? _rightmost->count : 0);
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  size_type size() const noexcept {
+    return _size;
+  }
+
+  size_type max_size() const noexcept {
+    return size_type(-1) / sizeof(value_type);
+  }
+
+  Compare key_comp() const {
+    return _key_compare;
+  }
+
+ public:  // insert
+  // k 为新元素的 key，不存在时用 args 构造新元素
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_unique_key(const key_type& k, Args&&... args) {
+    if (_root == 0) {
+      __init_root();
+      return std::make_pair(__insert_at(begin(), std::forward<Args>(args)...), true);
+    }
+    node_ptr x = _root;
+    for (;;) {
+      size_type i = __lower_in_node(x, k);
+      if (i < x->count && !_key_compare(k, _key(x, i)))
+        return std::make_pair(iterator(x, (int)i), false);
+      if (x->leaf)
+        return std::make_pair(__insert_at(iterator(x, (int)i), std::forward<Args>(args)...), true);
+      x = _child(x, i);
+    }
+  }
+
+  // value_type 为 pair 时使用，key 不存在时才构造 mapped 值
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& k, Args&&... args) {
+    return emplace_unique_key(k, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  std::pair<iterator, bool> insert_unique(const value_type& v) {
+    return emplace_unique_key(KeyOfValue()(v), v);
+  }
+
+  std::pair<iterator, bool> insert_unique(value_type&& v) {
+    return emplace_unique_key(KeyOfValue()(v), std::move(v));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_unique(Args&&... args) {
+    value_type v(std::forward<Args>(args)...);
+    return emplace_unique_key(KeyOfValue()(v), std::move(v));
+  }
+
+  // hint 正确时（新元素恰好应该在 hint 之前）不需要从根节点查找，在 end() 处顺序插入为均摊常数时间
+  iterator insert_unique(iterator hint, const value_type& v) {
+    return __insert_unique_hint(hint, v);
+  }
+
+  iterator insert_unique(iterator hint, value_type&& v) {
+    return __insert_unique_hint(hint, std::move(v));
+  }
+
+  template <typename... Args>
+  iterator emplace_hint_unique(iterator hint, Args&&... args) {
+    return __insert_unique_hint(hint, value_type(std::forward<Args>(args)...));
+  }
+
+  template <typename InputIterator>
+  void insert_unique(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert_unique(end(), *first);
+  }
+
+  // 相等的元素插在最后
+  iterator insert_equal(const value_type& v) {
+    return __insert_equal(v);
+  }
+
+  iterator insert_equal(value_type&& v) {
+    return __insert_equal(std::move(v));
+  }
+
+  iterator insert_equal(iterator hint, const value_type& v) {
+    return __insert_equal_hint(hint, v);
+  }
+
+  iterator insert_equal(iterator hint, value_type&& v) {
+    return __insert_equal_hint(hint, std::move(v));
+  }
+
+  template <typename... Args>
+  iterator emplace_equal(Args&&... args) {
+    return __insert_equal(value_type(std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  iterator emplace_hint_equal(iterator hint, Args&&... args) {
+    return __insert_equal_hint(hint, value_type(std::forward<Args>(args)...));
+  }
+
+  template <typename InputIterator>
+  void insert_equal(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert_equal(end(), *first);
+  }
+
+ private:
+  template <typename V>
+  iterator __insert_unique_hint(iterator hint, V&& v) {
+    const key_type& k = KeyOfValue()(v);
+    if (_size != 0) {
+      if (hint == end()) {
+        if (_key_compare(_key(_rightmost, _rightmost->count - 1), k))
+          return __insert_at(hint, std::forward<V>(v));
+      } else if (_key_compare(k, KeyOfValue()(*hint))) {
+        iterator before = hint;
+        if (hint == begin() || _key_compare(KeyOfValue()(*--before), k))
+          return __insert_at(__leaf_position(hint), std::forward<V>(v));
+      } else if (!_key_compare(KeyOfValue()(*hint), k)) {
+        return hint;
+      }
+    }
+    return insert_unique(std::forward<V>(v)).first;
+  }
+
+  template <typename V>
+  iterator __insert_equal(V&& v) {
+    const key_type& k = KeyOfValue()(v);
+    if (_root == 0) {
+      __init_root();
+      return __insert_at(begin(), std::forward<V>(v));
+    }
+    node_ptr x = _root;
+    for (;;) {
+      size_type i = __upper_in_node(x, k);
+      if (x->leaf)
+        return __insert_at(iterator(x, (int)i), std::forward<V>(v));
+      x = _child(x, i);
+    }
+  }
+
+  template <typename V>
+  iterator __insert_equal_hint(iterator hint, V&& v) {
+    const key_type& k = KeyOfValue()(v);
+    if (_size != 0) {
+      iterator before = hint;
+      if ((hint == end() || !_key_compare(KeyOfValue()(*hint), k)) &&
+          (hint == begin() || !_key_compare(k, KeyOfValue()(*--before))))
+        return __insert_at(hint == end() ? hint : __leaf_position(hint), std::forward<V>(v));
+    }
+    return __insert_equal(std::forward<V>(v));
+  }
+
+ public:
+  // 清空后用按 key 升序排列的 [first, last) 重建，每个元素都追加在最右边的叶节点，
+  // 节点从左往右依次填满，均摊常数时间；遇到无序的元素时剩下的元素逐个插入
+  template <typename InputIterator>
+  void assign_sorted_unique(InputIterator first, InputIterator last) {
+    clear();
+    for (; first != last; ++first) {
+      if (_size != 0 && !_key_compare(_key(_rightmost, _rightmost->count - 1), KeyOfValue()(*first))) {
+        if (_key_compare(KeyOfValue()(*first), _key(_rightmost, _rightmost->count - 1)))
+          break;
+        continue;  // 跳过重复的 key
+      }
+      if (_root == 0)
+        __init_root();
+      __insert_at(end(), *first);
+    }
+    insert_unique(first, last);
+  }
+
+  template <typename InputIterator>
+  void assign_sorted_equal(InputIterator first, InputIterator last) {
+    clear();
+    for (; first != last; ++first) {
+      if (_size != 0 && _key_compare(KeyOfValue()(*first), _key(_rightmost, _rightmost->count - 1)))
+        break;
+      if (_root == 0)
+        __init_root();
+      __insert_at(end(), *first);
+    }
+    insert_equal(first, last);
+  }
+
+ public:  // erase
+  // 返回被删除元素的下一个元素
+  iterator erase(iterator pos) {
+    node_ptr  x = pos.node;
+    size_type i = pos.pos;
+    iterator  next;
+    gd::destroy(&x->value(i));
+    if (x->leaf) {
+      __close_slot(x, i);
+      --x->count;
+      next = __normalize(x, i);
+      if (next == end())
+        next = iterator();
+    } else {
+      // 内部节点的元素用前驱（左子树最大的元素）代替，实际从叶节点中删除
+      node_ptr l = __rightmost_leaf(_child(x, i));
+      __relocate(&x->value(i), &l->value(l->count - 1));
+      --l->count;
+      next = iterator(__leftmost_leaf(_child(x, i + 1)), 0);
+      x = l;
+    }
+    --_size;
+    __rebalance(x, next);
+    return next.node == 0 ? end() : next;
+  }
+
+  size_type erase(const key_type& k) {
+    iterator  it = lower_bound(k);
+    size_type n = gd::distance(it, upper_bound(k));
+    for (size_type j = 0; j < n; ++j)
+      it = erase(it);
+    return n;
+  }
+
+  // 删除会使迭代器失效，先数出个数，再用 erase 返回的迭代器逐个删除
+  iterator erase(iterator first, iterator last) {
+    if (first == begin() && last == end()) {
+      clear();
+      return end();
+    }
+    size_type n = gd::distance(first, last);
+    for (size_type j = 0; j < n; ++j)
+      first = erase(first);
+    return first;
+  }
+
+  void clear() {
+    if (_root != 0) {
+      __destroy(_root);
+      __empty_init();
+    }
+  }
+
+  void swap(btree& rhs) {
+    std::swap(_root, rhs._root);
+    std::swap(_leftmost, rhs._leftmost);
+    std::swap(_rightmost, rhs._rightmost);
+    std::swap(_size, rhs._size);
+    std::swap(_key_compare, rhs._key_compare);
+    gd::__alloc_on_swap(_get_alloc(), rhs._get_alloc());
+  }
+
+ public:  // lookup
+  iterator lower_bound(const key_type& k) {
+    return __lower_bound(k);
+  }
+
+  const_iterator lower_bound(const key_type& k) const {
+    return __lower_bound(k);
+  }
+
+  iterator upper_bound(const key_type& k) {
+    return __upper_bound(k);
+  }
+
+  const_iterator upper_bound(const key_type& k) const {
+    return __upper_bound(k);
+  }
+
+  iterator find(const key_type& k) {
+    iterator it = __lower_bound(k);
+    return it == end() || _key_compare(k, KeyOfValue()(*it)) ? end() : it;
+  }
+
+  const_iterator find(const key_type& k) const {
+    const_iterator it = __lower_bound(k);
+    return it == end() || _key_compare(k, KeyOfValue()(*it)) ? end() : it;
+  }
+
+  size_type count(const key_type& k) const {
+    return gd::distance(lower_bound(k), upper_bound(k));
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+ private:
+  iterator __lower_bound(const key_type& k) const {
+    if (_root == 0)
+      return iterator();
+    node_ptr x = _root;
+    for (;;) {
+      size_type i = __lower_in_node(x, k);
+      if (x->leaf)
+        return __normalize(x, i);
+      x = _child(x, i);
+    }
+  }
+
+  iterator __upper_bound(const key_type& k) const {
+    if (_root == 0)
+      return iterator();
+    node_ptr x = _root;
+    for (;;) {
+      size_type i = __upper_in_node(x, k);
+      if (x->leaf)
+        return __normalize(x, i);
+      x = _child(x, i);
+    }
+  }
+
+ public:  // debug
+  // 检查 B 树的结构：节点内有序、父子链接正确、所有叶节点深度相同、元素个数正确，供测试使用
+  bool __verify() const {
+    if (_root == 0)
+      return _size == 0 && _leftmost == 0 && _rightmost == 0;
+    if (_root->parent != 0 || __leftmost_leaf(_root) != _leftmost || __rightmost_leaf(_root) != _rightmost)
+      return false;
+    int       depth = -1;
+    size_type n = 0;
+    return __verify(_root, 0, 0, 0, depth, n) && n == _size;
+  }
+
+ private:
+  // lo、hi 为子树中元素的上下界，为空时没有限制
+  bool __verify(node_ptr x, const value_type* lo, const value_type* hi, int d, int& depth, size_type& n) const {
+    if (x->count > __MAX || (x != _root && x->count == 0))
+      return false;
+    for (size_type j = 0; j < x->count; ++j) {
+      if (j > 0 && _key_compare(_key(x, j), _key(x, j - 1)))
+        return false;
+      if ((lo && _key_compare(_key(x, j), KeyOfValue()(*lo))) || (hi && _key_compare(KeyOfValue()(*hi), _key(x, j))))
+        return false;
+    }
+    n += x->count;
+    if (x->leaf) {
+      if (depth == -1)
+        depth = d;
+      return depth == d;
+    }
+    for (size_type j = 0; j <= x->count; ++j) {
+      node_ptr c = _child(x, j);
+      if (c->parent != x || c->position != j)
+        return false;
+      if (!__verify(c, j == 0 ? lo : &x->value(j - 1), j == x->count ? hi : &x->value(j), d + 1, depth, n))
+        return false;
+    }
+    return true;
+  }
+};
+
+// operators
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+inline bool operator==(const btree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
+                       const btree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+inline bool operator<(const btree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
+                      const btree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+}  // namespace gd
+
+#endif  // !__MY_BTREE__H
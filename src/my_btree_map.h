@@ -0,0 +1,347 @@
+#ifndef __MY_BTREE_MAP__H
+#define __MY_BTREE_MAP__H
+
+#include <functional>
+#include <initializer_list>
+#include "exceptdef.h"
+#include "my_btree.h"
+#include "my_map.h"  // for select1st
+
+namespace gd {
+
+// 以 B 树为底层数据结构的 map，接口与 map 相同，可以直接替换
+// 每个节点连续存放多个元素，查找的 cache miss 比 map 少得多，每个元素也没有三个指针的额外开销；
+// 代价是插入和删除会移动元素，所有迭代器和元素的引用都会失效，需要使用 insert、erase 返回的迭代器
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class btree_map {
+ public:
+  typedef Key                     key_type;
+  typedef T                       mapped_type;
+  typedef std::pair<const Key, T> value_type;
+  typedef Compare                 key_compare;
+
+  // 比较元素 key 的大小
+  class value_compare {
+    friend class btree_map;
+
+   protected:
+    Compare comp;
+    value_compare(Compare c) : comp(c) {}
+
+   public:
+    typedef bool       result_type;
+    typedef value_type first_argument_type;
+    typedef value_type second_argument_type;
+
+    bool operator()(const value_type& lhs, const value_type& rhs) const {
+      return comp(lhs.first, rhs.first);
+    }
+  };
+
+ private:
+  typedef btree<key_type, value_type, select1st<value_type>, key_compare, Alloc> __rep_type;
+  // 底层数据结构
+  __rep_type __tree;
+
+ public:
+  typedef typename __rep_type::pointer         pointer;
+  typedef typename __rep_type::const_pointer   const_pointer;
+  typedef typename __rep_type::reference       reference;
+  typedef typename __rep_type::const_reference const_reference;
+  typedef typename __rep_type::iterator        iterator;
+  typedef typename __rep_type::const_iterator  const_iterator;
+  typedef typename __rep_type::size_type       size_type;
+  typedef typename __rep_type::difference_type difference_type;
+  typedef typename __rep_type::allocator_type  allocator_type;
+
+ public:  // constructor, copy, destructor
+  btree_map() = default;
+
+  explicit btree_map(const Compare& comp, const allocator_type& a = allocator_type()) : __tree(comp, a) {}
+
+  explicit btree_map(const allocator_type& a) : __tree(Compare(), a) {}
+
+  template <typename InputIterator>
+  btree_map(InputIterator first, InputIterator last) : __tree() {
+    __tree.insert_unique(first, last);
+  }
+
+  template <typename InputIterator>
+  btree_map(InputIterator first, InputIterator last, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(first, last);
+  }
+
+  btree_map(std::initializer_list<value_type> il) : __tree() {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  btree_map(std::initializer_list<value_type> il, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时逐个追加到最右边的叶节点，线性时间建树且节点几乎全满，
+  // 重复的 key 只保留第一个，输入无序时退化为逐个插入
+  template <typename InputIterator>
+  btree_map(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+            const allocator_type& a = allocator_type())
+      : __tree(comp, a) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
+  btree_map(const btree_map& rhs) : __tree(rhs.__tree) {}
+
+  btree_map(btree_map&& rhs) noexcept : __tree(std::move(rhs.__tree)) {}
+
+  btree_map(const btree_map& rhs, const allocator_type& a) : __tree(rhs.__tree, a) {}
+
+  btree_map(btree_map&& rhs, const allocator_type& a) : __tree(std::move(rhs.__tree), a) {}
+
+  btree_map& operator=(const btree_map& rhs) {
+    __tree = rhs.__tree;
+    return *this;
+  }
+
+  btree_map& operator=(btree_map&& rhs) {
+    __tree = std::move(rhs.__tree);
+    return *this;
+  }
+
+  btree_map& operator=(std::initializer_list<value_type> il) {
+    __tree.clear();
+    __tree.insert_unique(il.begin(), il.end());
+    return *this;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __tree.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() noexcept {
+    return __tree.begin();
+  }
+
+  const_iterator begin() const noexcept {
+    return __tree.begin();
+  }
+
+  iterator end() noexcept {
+    return __tree.end();
+  }
+
+  const_iterator end() const noexcept {
+    return __tree.end();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return __tree.begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return __tree.end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __tree.empty();
+  }
+
+  size_type size() const noexcept {
+    return __tree.size();
+  }
+
+  size_type max_size() const noexcept {
+    return __tree.max_size();
+  }
+
+ public:  // element access
+  mapped_type& operator[](const key_type& k) {
+    return __tree.try_emplace(k).first->second;
+  }
+
+  mapped_type& operator[](key_type&& k) {
+    return __tree.try_emplace(std::move(k)).first->second;
+  }
+
+  mapped_type& at(const key_type& k) {
+    iterator it = __tree.find(k);
+    THROW_OUT_OF_RANGE_IF(it == end(), "btree_map<Key, T>::at() key not found");
+    return it->second;
+  }
+
+  const mapped_type& at(const key_type& k) const {
+    const_iterator it = __tree.find(k);
+    THROW_OUT_OF_RANGE_IF(it == end(), "btree_map<Key, T>::at() key not found");
+    return it->second;
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return __tree.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  // pos 是新元素应该插入的位置之后的迭代器，位置正确时不需要从根节点查找
+  template <typename... Args>
+  iterator emplace_hint(iterator pos, Args&&... args) {
+    return __tree.emplace_hint_unique(pos, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args) {
+    return __tree.try_emplace(k, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args) {
+    return __tree.try_emplace(std::move(k), std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& v) {
+    return __tree.insert_unique(v);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& v) {
+    return __tree.insert_unique(std::move(v));
+  }
+
+  iterator insert(iterator pos, const value_type& v) {
+    return __tree.insert_unique(pos, v);
+  }
+
+  iterator insert(iterator pos, value_type&& v) {
+    return __tree.insert_unique(pos, std::move(v));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    __tree.insert_unique(first, last);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  // 清空后用有序区间 [first, last) 重建，见有序区间的构造函数
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
+  // 删除会移动元素，返回被删除元素的下一个元素，边遍历边删除时必须使用返回值
+  iterator erase(iterator pos) {
+    return __tree.erase(pos);
+  }
+
+  size_type erase(const key_type& k) {
+    return __tree.erase(k);
+  }
+
+  iterator erase(iterator first, iterator last) {
+    return __tree.erase(first, last);
+  }
+
+  void clear() {
+    __tree.clear();
+  }
+
+  void swap(btree_map& rhs) {
+    __tree.swap(rhs.__tree);
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return __tree.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return value_compare(__tree.key_comp());
+  }
+
+ public:  // map operations
+  iterator find(const key_type& k) {
+    return __tree.find(k);
+  }
+
+  const_iterator find(const key_type& k) const {
+    return __tree.find(k);
+  }
+
+  size_type count(const key_type& k) const {
+    return __tree.count(k);
+  }
+
+  iterator lower_bound(const key_type& k) {
+    return __tree.lower_bound(k);
+  }
+
+  const_iterator lower_bound(const key_type& k) const {
+    return __tree.lower_bound(k);
+  }
+
+  iterator upper_bound(const key_type& k) {
+    return __tree.upper_bound(k);
+  }
+
+  const_iterator upper_bound(const key_type& k) const {
+    return __tree.upper_bound(k);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) {
+    return __tree.equal_range(k);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return __tree.equal_range(k);
+  }
+
+ public:  // operators
+  bool operator==(const btree_map& rhs) const {
+    return __tree == rhs.__tree;
+  }
+
+  bool operator<(const btree_map& rhs) const {
+    return __tree < rhs.__tree;
+  }
+};
+
+// operators:
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator==(const btree_map<Key, T, Compare, Alloc>& lhs, const btree_map<Key, T, Compare, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator!=(const btree_map<Key, T, Compare, Alloc>& lhs, const btree_map<Key, T, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator<(const btree_map<Key, T, Compare, Alloc>& lhs, const btree_map<Key, T, Compare, Alloc>& rhs) {
+  return lhs.operator<(rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator>=(const btree_map<Key, T, Compare, Alloc>& lhs, const btree_map<Key, T, Compare, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator>(const btree_map<Key, T, Compare, Alloc>& lhs, const btree_map<Key, T, Compare, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator<=(const btree_map<Key, T, Compare, Alloc>& lhs, const btree_map<Key, T, Compare, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+void swap(btree_map<Key, T, Compare, Alloc>& lhs, btree_map<Key, T, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_BTREE_MAP__H
@@ -0,0 +1,276 @@
+#ifndef __MY_BTREE_SET__H
+#define __MY_BTREE_SET__H
+
+#include <functional>
+#include <initializer_list>
+#include "my_btree.h"
+#include "my_set.h"  // for identity
+
+namespace gd {
+
+// 以 B 树为底层数据结构的 set，接口与 set 相同，可以直接替换
+// 插入和删除会移动元素，所有迭代器都会失效，需要使用 insert、erase 返回的迭代器
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class btree_set {
+ public:
+  typedef Key     key_type;
+  typedef Key     value_type;
+  typedef Compare key_compare;
+  typedef Compare value_compare;
+
+ private:
+  typedef btree<key_type, value_type, identity<value_type>, key_compare, Alloc> __rep_type;
+  // btree_set 的 iterator 是 btree 的 const_iterator，传给 btree 时需要转换回 btree 的 iterator
+  typedef typename __rep_type::iterator __rep_iterator;
+
+  __rep_type __tree;
+
+  static __rep_iterator __to_rep(const typename __rep_type::const_iterator& it) {
+    return __rep_iterator(it.node, it.pos);
+  }
+
+ public:
+  typedef typename __rep_type::const_pointer   pointer;
+  typedef typename __rep_type::const_pointer   const_pointer;
+  typedef typename __rep_type::const_reference reference;
+  typedef typename __rep_type::const_reference const_reference;
+  typedef typename __rep_type::const_iterator  iterator;
+  typedef typename __rep_type::const_iterator  const_iterator;
+  typedef typename __rep_type::size_type       size_type;
+  typedef typename __rep_type::difference_type difference_type;
+  typedef typename __rep_type::allocator_type  allocator_type;
+
+ public:  // constructor, copy, destructor
+  btree_set() = default;
+
+  explicit btree_set(const Compare& comp, const allocator_type& a = allocator_type()) : __tree(comp, a) {}
+
+  explicit btree_set(const allocator_type& a) : __tree(Compare(), a) {}
+
+  template <typename InputIterator>
+  btree_set(InputIterator first, InputIterator last) : __tree() {
+    __tree.insert_unique(first, last);
+  }
+
+  template <typename InputIterator>
+  btree_set(InputIterator first, InputIterator last, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(first, last);
+  }
+
+  btree_set(std::initializer_list<value_type> il) : __tree() {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  btree_set(std::initializer_list<value_type> il, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时线性时间建树，重复的元素只保留第一个，输入无序时退化为逐个插入
+  template <typename InputIterator>
+  btree_set(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+            const allocator_type& a = allocator_type())
+      : __tree(comp, a) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
+  btree_set(const btree_set& rhs) : __tree(rhs.__tree) {}
+
+  btree_set(btree_set&& rhs) noexcept : __tree(std::move(rhs.__tree)) {}
+
+  btree_set(const btree_set& rhs, const allocator_type& a) : __tree(rhs.__tree, a) {}
+
+  btree_set(btree_set&& rhs, const allocator_type& a) : __tree(std::move(rhs.__tree), a) {}
+
+  btree_set& operator=(const btree_set& rhs) {
+    __tree = rhs.__tree;
+    return *this;
+  }
+
+  btree_set& operator=(btree_set&& rhs) {
+    __tree = std::move(rhs.__tree);
+    return *this;
+  }
+
+  btree_set& operator=(std::initializer_list<value_type> il) {
+    __tree.clear();
+    __tree.insert_unique(il.begin(), il.end());
+    return *this;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __tree.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() const noexcept {
+    return __tree.begin();
+  }
+
+  iterator end() const noexcept {
+    return __tree.end();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return __tree.begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return __tree.end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __tree.empty();
+  }
+
+  size_type size() const noexcept {
+    return __tree.size();
+  }
+
+  size_type max_size() const noexcept {
+    return __tree.max_size();
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return __tree.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  iterator emplace_hint(iterator pos, Args&&... args) {
+    return __tree.emplace_hint_unique(__to_rep(pos), std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return __tree.insert_unique(value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return __tree.insert_unique(std::move(value));
+  }
+
+  iterator insert(iterator pos, const value_type& value) {
+    return __tree.insert_unique(__to_rep(pos), value);
+  }
+
+  iterator insert(iterator pos, value_type&& value) {
+    return __tree.insert_unique(__to_rep(pos), std::move(value));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    __tree.insert_unique(first, last);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  // 清空后用有序区间 [first, last) 重建，见有序区间的构造函数
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
+  // 返回被删除元素的下一个元素
+  iterator erase(iterator pos) {
+    return __tree.erase(__to_rep(pos));
+  }
+
+  size_type erase(const key_type& k) {
+    return __tree.erase(k);
+  }
+
+  iterator erase(iterator first, iterator last) {
+    return __tree.erase(__to_rep(first), __to_rep(last));
+  }
+
+  void swap(btree_set& rhs) {
+    __tree.swap(rhs.__tree);
+  }
+
+  void clear() noexcept {
+    __tree.clear();
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return __tree.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return __tree.key_comp();
+  }
+
+ public:  // set operations
+  iterator find(const key_type& k) const {
+    return __tree.find(k);
+  }
+
+  size_type count(const key_type& k) const {
+    return __tree.count(k);
+  }
+
+  iterator lower_bound(const key_type& k) const {
+    return __tree.lower_bound(k);
+  }
+
+  iterator upper_bound(const key_type& k) const {
+    return __tree.upper_bound(k);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) const {
+    return __tree.equal_range(k);
+  }
+
+ public:
+  bool operator==(const btree_set& rhs) const {
+    return __tree == rhs.__tree;
+  }
+
+  bool operator<(const btree_set& rhs) const {
+    return __tree < rhs.__tree;
+  }
+};
+
+// operators
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator==(const btree_set<Key, Compare, Alloc>& lhs, const btree_set<Key, Compare, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator!=(const btree_set<Key, Compare, Alloc>& lhs, const btree_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator<(const btree_set<Key, Compare, Alloc>& lhs, const btree_set<Key, Compare, Alloc>& rhs) {
+  return lhs.operator<(rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator>=(const btree_set<Key, Compare, Alloc>& lhs, const btree_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator>(const btree_set<Key, Compare, Alloc>& lhs, const btree_set<Key, Compare, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator<=(const btree_set<Key, Compare, Alloc>& lhs, const btree_set<Key, Compare, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+void swap(btree_set<Key, Compare, Alloc>& lhs, btree_set<Key, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_BTREE_SET__H
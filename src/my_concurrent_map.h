@@ -0,0 +1,214 @@
+#ifndef __MY_CONCURRENT_MAP__H
+#define __MY_CONCURRENT_MAP__H
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <utility>
+#include "exceptdef.h"
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_epoch.h"
+#include "my_persistent_map.h"
+
+namespace gd {
+
+// 读多写少的并发有序 map，读者不加锁
+// 读者看到的是一个不可变的版本（persistent_map 的快照），进入 epoch 临界区后读出当前版本的指针直接查找，
+// 不加锁、不写任何共享的内存，读者之间没有 cache line 的争用；
+// 写者之间用一把锁串行化，在自己的 persistent_map 上修改（只复制被共享的那条路径，O(log n)），
+// 之后用一次原子交换发布新版本，旧版本交给 epoch_domain，等读者都离开之后再释放
+// 需要一次做多个修改时用 update()，只发布一次，读者要么看到全部修改，要么都看不到
+// 节点可能在任何线程中释放，Alloc 必须是线程安全的（默认的 alloc 是）
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class concurrent_map {
+ public:
+  typedef Key                                    key_type;
+  typedef T                                      mapped_type;
+  typedef std::pair<const Key, T>                value_type;
+  typedef Compare                                key_compare;
+  typedef size_t                                 size_type;
+  typedef persistent_map<Key, T, Compare, Alloc> snapshot_type;
+  typedef typename snapshot_type::allocator_type allocator_type;
+
+ private:
+  typedef snapshot_type                     version_type;
+  typedef typename version_type::node_ptr   node_ptr;
+  typedef simple_alloc<version_type, Alloc> version_allocator;
+
+  mutable epoch_domain       __epoch;
+  std::atomic<version_type*> __current;  // 读者看到的版本，发布之后不再修改
+  version_type               __master;   // 写者修改的版本，由 __write_lock 保护
+  std::mutex                 __write_lock;
+
+ public:  // constructor, destructor
+  concurrent_map() : __current(nullptr), __master() {
+    __current.store(__new_version(), std::memory_order_release);
+  }
+
+  explicit concurrent_map(const Compare& comp, const allocator_type& a = allocator_type())
+      : __current(nullptr), __master(comp, a) {
+    __current.store(__new_version(), std::memory_order_release);
+  }
+
+  concurrent_map(std::initializer_list<value_type> il) : __current(nullptr), __master(il) {
+    __current.store(__new_version(), std::memory_order_release);
+  }
+
+  concurrent_map(const concurrent_map&) = delete;
+  concurrent_map& operator=(const concurrent_map&) = delete;
+
+  // 调用者保证没有其他线程还在使用本对象
+  ~concurrent_map() {
+    __epoch.drain();
+    __reclaim_version(this, __current.load(std::memory_order_relaxed));
+  }
+
+ public:  // 读者，不加锁，可以与写者和其他读者同时调用
+  // 找到时把 mapped 值拷贝到 out 中，返回值表示是否找到
+  bool find(const key_type& k, mapped_type& out) const {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            x = __version()->__find(k);
+    if (x == nullptr)
+      return false;
+    out = x->value.second;
+    return true;
+  }
+
+  mapped_type at(const key_type& k) const {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            x = __version()->__find(k);
+    THROW_OUT_OF_RANGE_IF(x == nullptr, "concurrent_map<Key, T>::at() key not found");
+    return x->value.second;
+  }
+
+  size_type count(const key_type& k) const {
+    epoch_domain::guard g = __epoch.pin();
+    return __version()->__find(k) == nullptr ? 0 : 1;
+  }
+
+  // 对 k 所在的元素调用 f(const value_type&)，f 在临界区中执行，要尽快返回，不能保存元素的引用
+  template <typename F>
+  bool visit(const key_type& k, F f) const {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            x = __version()->__find(k);
+    if (x == nullptr)
+      return false;
+    f(static_cast<const value_type&>(x->value));
+    return true;
+  }
+
+  // 对第一个 key 不小于 k 的元素调用 f(const value_type&)，没有这样的元素时返回 false
+  template <typename F>
+  bool visit_lower_bound(const key_type& k, F f) const {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            x = __version()->__lower_bound(k);
+    if (x == nullptr)
+      return false;
+    f(static_cast<const value_type&>(x->value));
+    return true;
+  }
+
+  size_type size() const {
+    epoch_domain::guard g = __epoch.pin();
+    return __version()->size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  // 当前版本的快照，O(1)，可以在临界区之外随意遍历；持有快照会让写者多复制一些节点
+  snapshot_type snapshot() const {
+    epoch_domain::guard g = __epoch.pin();
+    return snapshot_type(*__version());
+  }
+
+ public:  // 写者，彼此串行化
+  bool insert(const value_type& v) {
+    std::lock_guard<std::mutex> lock(__write_lock);
+    if (__master.__find(v.first) != nullptr)
+      return false;
+    __apply([&](version_type& w) { w.__insert_new(v.first, v); });
+    return true;
+  }
+
+  template <typename M>
+  bool insert_or_assign(const key_type& k, M&& obj) {
+    std::lock_guard<std::mutex> lock(__write_lock);
+    bool                        inserted = false;
+    __apply([&](version_type& w) { inserted = w.insert_or_assign(k, std::forward<M>(obj)).second; });
+    return inserted;
+  }
+
+  size_type erase(const key_type& k) {
+    std::lock_guard<std::mutex> lock(__write_lock);
+    if (__master.__find(k) == nullptr)
+      return 0;
+    __apply([&](version_type& w) { w.erase(k); });
+    return 1;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(__write_lock);
+    __apply([](version_type& w) { w.clear(); });
+  }
+
+  // f(snapshot_type&) 中可以做任意多的修改，之后作为一个版本整体发布；f 抛出异常时所有修改都被丢弃
+  template <typename F>
+  void update(F f) {
+    std::lock_guard<std::mutex> lock(__write_lock);
+    __apply(f);
+  }
+
+ private:
+  const version_type* __version() const {
+    return __current.load(std::memory_order_acquire);
+  }
+
+  // 新版本与 __master 共享全部节点，之后 __master 的修改都会复制路径，不会改动新版本看到的节点
+  version_type* __new_version() {
+    version_allocator a(__master.get_allocator());
+    version_type*     v = a.allocate();
+    try {
+      gd::construct(v, __master);
+    } catch (...) {
+      a.deallocate(v);
+      throw;
+    }
+    return v;
+  }
+
+  // 在 __master 上执行 f(__master) 并发布新版本；f 或者创建新版本时抛出异常，__master 恢复原样，
+  // 否则残留的修改会随下一个写者一起发布。备份只是共享根节点，O(1)
+  template <typename F>
+  void __apply(F&& f) {
+    version_type  backup(__master);
+    version_type* v;
+    try {
+      f(__master);
+      v = __new_version();
+    } catch (...) {
+      __master.swap(backup);
+      throw;
+    }
+    __publish(v);
+  }
+
+  void __publish(version_type* v) {
+    version_type* old = __current.exchange(v, std::memory_order_acq_rel);
+    __epoch.retire(old, &concurrent_map::__reclaim_version, this);
+  }
+
+  static void __reclaim_version(void* ctx, void* p) {
+    version_type*     v = static_cast<version_type*>(p);
+    version_allocator a(static_cast<concurrent_map*>(ctx)->__master.get_allocator());
+    gd::destroy(v);
+    a.deallocate(v);
+  }
+};
+
+}  // namespace gd
+
+#endif  // !__MY_CONCURRENT_MAP__H
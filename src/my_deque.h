@@ -1,6 +1,7 @@
 #ifndef __MY_DEQUE_H
 #define __MY_DEQUE_H
 
+#include <algorithm>
 #include "exceptdef.h"
 #include "my_alloc.h"
 #include "my_iterator.h"
@@ -171,8 +172,77 @@ struct deque_iterator : public iterator<random_access_iterator_tag, T> {
   }
 };
 
+// 按缓冲区分段复制 deque 中的元素：每一段都是连续内存，交给 std::copy，平凡可复制的类型会变成 memmove
+// 与 std::copy 相同，区间可以重叠，但 result 不能位于 [first, last) 之内
+template <typename T, size_t BufSize>
+deque_iterator<T, T&, T*, BufSize> __deque_copy(deque_iterator<T, T&, T*, BufSize> first,
+                                               deque_iterator<T, T&, T*, BufSize> last,
+                                               deque_iterator<T, T&, T*, BufSize> result) {
+  ptrdiff_t n = last - first;
+  while (n > 0) {
+    ptrdiff_t len = std::min(n, std::min(first.last - first.cur, result.last - result.cur));
+    if (len <= 0)  // 迭代器有效时不会发生，编译器无法证明，不检查时 memmove 的长度可能被当成负数
+      break;
+    std::copy(first.cur, first.cur + len, result.cur);
+    first += len;
+    result += len;
+    n -= len;
+  }
+  return result;
+}
+
+// 从后向前分段复制，与 std::copy_backward 相同，区间可以重叠，但 result 不能位于 (first, last] 之内
+template <typename T, size_t BufSize>
+deque_iterator<T, T&, T*, BufSize> __deque_copy_backward(deque_iterator<T, T&, T*, BufSize> first,
+                                                        deque_iterator<T, T&, T*, BufSize> last,
+                                                        deque_iterator<T, T&, T*, BufSize> result) {
+  typedef deque_iterator<T, T&, T*, BufSize> iterator;
+  const ptrdiff_t buf = (ptrdiff_t)iterator::buffer_size();
+  ptrdiff_t       n = last - first;
+  while (n > 0) {
+    // 位于缓冲区开头时，这一段在前一个缓冲区的末尾
+    T*        lend = last.cur == last.first ? *(last.node - 1) + buf : last.cur;
+    ptrdiff_t llen = last.cur == last.first ? buf : last.cur - last.first;
+    T*        rend = result.cur == result.first ? *(result.node - 1) + buf : result.cur;
+    ptrdiff_t rlen = result.cur == result.first ? buf : result.cur - result.first;
+    ptrdiff_t len = std::min(n, std::min(llen, rlen));
+    if (len <= 0)  // 同 __deque_copy
+      break;
+    std::copy_backward(lend - len, lend, rend);
+    last -= len;
+    result -= len;
+    n -= len;
+  }
+  return result;
+}
+
+template <typename T, size_t BufSize>
+inline deque_iterator<T, T&, T*, BufSize> __deque_uninitialized_copy(deque_iterator<T, T&, T*, BufSize> first,
+                                                                     deque_iterator<T, T&, T*, BufSize> last,
+                                                                     deque_iterator<T, T&, T*, BufSize> result,
+                                                                     __true_type) {
+  return __deque_copy(first, last, result);
+}
+
+template <typename T, size_t BufSize>
+inline deque_iterator<T, T&, T*, BufSize> __deque_uninitialized_copy(deque_iterator<T, T&, T*, BufSize> first,
+                                                                     deque_iterator<T, T&, T*, BufSize> last,
+                                                                     deque_iterator<T, T&, T*, BufSize> result,
+                                                                     __false_type) {
+  return gd::uninitialized_copy(first, last, result);
+}
+
+// deque 内部元素复制到未初始化空间，POD 类型按缓冲区分段复制
+template <typename T, size_t BufSize>
+inline deque_iterator<T, T&, T*, BufSize> __deque_uninitialized_copy(deque_iterator<T, T&, T*, BufSize> first,
+                                                                     deque_iterator<T, T&, T*, BufSize> last,
+                                                                     deque_iterator<T, T&, T*, BufSize> result) {
+  return __deque_uninitialized_copy(first, last, result, typename __type_traits<T>::is_POD_type());
+}
+
+// 私有继承 data_allocator，缓冲区和中控器的配置器都由它转换得到
 template <typename T, typename Alloc = alloc, size_t BufSize = 0>
-class deque {
+class deque : private simple_alloc<T, Alloc> {
  public:  // 内嵌型别
   typedef T                 value_type;
   typedef value_type*       pointer;
@@ -304,7 +374,7 @@ class deque {
       pos = _start + elem_before;
       iterator pos1 = pos;
       ++pos1;
-      std::copy(front2, pos1, front1);
+      __deque_copy(front2, pos1, front1);
     } else {
       emplace_back(back());
       iterator back1 = _finish;
@@ -313,7 +383,7 @@ class deque {
       --back2;
       // 经过 emplace 过后，pos 可能已经实效
       pos = _start + elem_before;
-      std::copy_backward(pos, back2, back1);
+      __deque_copy_backward(pos, back2, back1);
     }
     *pos = std::move(value_copy);
     return pos;
@@ -330,14 +400,14 @@ class deque {
       try {
         if (elem_before >= n) {
           iterator start_n = _start + difference_type(n);
-          uninitialized_copy(_start, start_n, new_start);
+          __deque_uninitialized_copy(_start, start_n, new_start);
           _start = new_start;
-          std::copy(start_n, pos, old_start);
-          std::fill_n(pos - difference_type(n), n, value);
+          __deque_copy(start_n, pos, old_start);
+          std::fill(pos - difference_type(n), pos, value);
         } else {
-          uninitialized_fill_n(uninitialized_copy(_start, pos, new_start), n - elem_before, value);
+          uninitialized_fill_n(__deque_uninitialized_copy(_start, pos, new_start), n - elem_before, value);
           _start = new_start;
-          std::fill_n(old_start, elem_before, value);
+          std::fill(old_start, old_start + difference_type(elem_before), value);
         }
       } catch (...) {
         __destroy_buffer(new_start.node, _start.node);
@@ -352,14 +422,14 @@ class deque {
       try {
         if (elem_after > n) {
           iterator finish_n = _finish - difference_type(n);
-          uninitialized_copy(finish_n, _finish, _finish);
+          __deque_uninitialized_copy(finish_n, _finish, _finish);
           _finish = new_finish;
-          std::copy_backward(pos, finish_n, old_finish);
-          std::fill_n(pos, n, value);
+          __deque_copy_backward(pos, finish_n, old_finish);
+          std::fill(pos, pos + difference_type(n), value);
         } else {
-          uninitialized_copy(pos, _finish, uninitialized_fill_n(_finish, n - elem_after, value));
+          __deque_uninitialized_copy(pos, _finish, uninitialized_fill_n(_finish, n - elem_after, value));
           _finish = new_finish;
-          std::fill_n(pos, elem_after, value);
+          std::fill(pos, pos + difference_type(elem_after), value);
         }
       } catch (...) {
         __destroy_buffer(_finish.node + 1, new_finish.node + 1);
@@ -397,14 +467,14 @@ class deque {
       try {
         if (elem_before >= n) {
           iterator start_n = _start + difference_type(n);
-          uninitialized_copy(_start, start_n, new_start);
+          __deque_uninitialized_copy(_start, start_n, new_start);
           _start = new_start;
-          std::copy(start_n, pos, old_start);
+          __deque_copy(start_n, pos, old_start);
           std::copy(first, last, pos - difference_type(n));
         } else {
           ForwardIterator mid = first;
           advance(mid, n - elem_before);
-          uninitialized_copy(first, mid, uninitialized_copy(_start, pos, new_start));
+          uninitialized_copy(first, mid, __deque_uninitialized_copy(_start, pos, new_start));
           _start = new_start;
           std::copy(mid, last, old_start);
         }
@@ -420,14 +490,14 @@ class deque {
       try {
         if (elem_after > n) {
           iterator finish_n = _finish - difference_type(n);
-          uninitialized_copy(finish_n, _finish, _finish);
+          __deque_uninitialized_copy(finish_n, _finish, _finish);
           _finish = new_finish;
-          std::copy_backward(pos, finish_n, old_finish);
+          __deque_copy_backward(pos, finish_n, old_finish);
           std::copy(first, last, pos);
         } else {
           ForwardIterator mid = first;
           advance(mid, n - elem_after);
-          uninitialized_copy(pos, _finish, uninitialized_copy(mid, last, _finish));
+          __deque_uninitialized_copy(pos, _finish, uninitialized_copy(mid, last, _finish));
           _finish = new_finish;
           std::copy(first, mid, pos);
         }
@@ -569,6 +639,14 @@ class deque {
     }
   }
 
+  data_allocator& __get_alloc() noexcept {
+    return *this;
+  }
+
+  const data_allocator& __get_alloc() const noexcept {
+    return *this;
+  }
+
   pointer __allocate_data() {
     return data_allocator::allocate(_buffer_size());
   }
@@ -579,7 +657,7 @@ class deque {
   }
 
   map_pointer __allocate_map(size_type n) {
-    map_pointer mp = map_allocator::allocate(n);
+    map_pointer mp = map_allocator(__get_alloc()).allocate(n);
     // 这里一定要把 *(mp+i) 初始化为空！！！太坑了！！！以后一定要养成初始化指针的良好习惯！
     for (size_type i = 0; i < n; ++i) {
       *(mp + i) = 0;
@@ -589,7 +667,7 @@ class deque {
 
   void __deallocate_map(map_pointer p, size_type n) {
     if (p)
-      map_allocator::deallocate(p, n);
+      map_allocator(__get_alloc()).deallocate(p, n);
   }
 
  public:  // constructors, copy and destructor
@@ -597,42 +675,138 @@ class deque {
     __fill_init(0, value_type());
   }
 
+  explicit deque(const allocator_type& a) : data_allocator(a) {
+    __fill_init(0, value_type());
+  }
+
   explicit deque(size_type n) {
     __fill_init(n, value_type());
   }
 
+  deque(size_type n, const allocator_type& a) : data_allocator(a) {
+    __fill_init(n, value_type());
+  }
+
   deque(size_type n, const_reference value) {
     __fill_init(n, value);
   }
 
+  deque(size_type n, const_reference value, const allocator_type& a) : data_allocator(a) {
+    __fill_init(n, value);
+  }
+
   template <typename InputIterator>
   deque(InputIterator first, InputIterator last) {
     __copy_init(first, last, iterator_category(first));
   }
 
-  deque(const deque& rhs) {
+  template <typename InputIterator>
+  deque(InputIterator first, InputIterator last, const allocator_type& a) : data_allocator(a) {
+    __copy_init(first, last, iterator_category(first));
+  }
+
+  // 拷贝时配置器由 select_on_container_copy_construction() 决定
+  deque(const deque& rhs) : data_allocator(rhs.__get_alloc().select_on_container_copy_construction()) {
+    __copy_init(rhs._start, rhs._finish, forward_iterator_tag());
+  }
+
+  deque(const deque& rhs, const allocator_type& a) : data_allocator(a) {
     __copy_init(rhs._start, rhs._finish, forward_iterator_tag());
   }
 
-  deque(deque&& rhs) : _start(rhs._start), _finish(rhs._finish), _map(rhs._map), _map_size(rhs._map_size) {
+  // 移动时配置器随内存一起转移
+  deque(deque&& rhs)
+      : data_allocator(std::move(rhs.__get_alloc())),
+        _start(rhs._start),
+        _finish(rhs._finish),
+        _map(rhs._map),
+        _map_size(rhs._map_size) {
     rhs._map = 0;
     rhs._map_size = 0;
   }
 
+  deque(deque&& rhs, const allocator_type& a) : data_allocator(a), _map(0), _map_size(0) {
+    if (__get_alloc() == rhs.__get_alloc())
+      __steal(rhs);
+    else
+      __move_elements(rhs);
+  }
+
   deque(std::initializer_list<value_type> il) {
     __copy_init(il.begin(), il.end(), forward_iterator_tag());
   }
 
+  deque(std::initializer_list<value_type> il, const allocator_type& a) : data_allocator(a) {
+    __copy_init(il.begin(), il.end(), forward_iterator_tag());
+  }
+
   ~deque() {
+    __release();
+  }
+
+ private:  // move helpers
+  // 析构所有元素，释放所有缓冲区和中控器
+  void __release() {
     if (_map) {
       clear();
       __deallocate_data(*(_start.node));
       __deallocate_map(_map, _map_size);
+      _map = 0;
+      _map_size = 0;
+    }
+  }
+
+  // 直接接管 rhs 的中控器和缓冲区，调用前本 deque 不能持有内存
+  void __steal(deque& rhs) noexcept {
+    _start = rhs._start;
+    _finish = rhs._finish;
+    _map = rhs._map;
+    _map_size = rhs._map_size;
+    rhs._map = 0;
+    rhs._map_size = 0;
+  }
+
+  // 配置器不相等时，rhs 的内存不能由本 deque 释放，只能用自己的配置器重建，再逐个移动元素
+  // 调用前本 deque 不能持有内存
+  void __move_elements(deque& rhs) {
+    __map_nodes_init(0);
+    try {
+      for (iterator it = rhs._start; it != rhs._finish; ++it)
+        emplace_back(std::move(*it));
+    } catch (...) {
+      __release();
+      throw;
     }
   }
 
+  // 配置器会传播或者总是相等，直接接管 rhs 的内存
+  void __move_assign(deque& rhs, std::true_type) {
+    __release();
+    gd::__alloc_on_move(__get_alloc(), rhs.__get_alloc());
+    __steal(rhs);
+  }
+
+  void __move_assign(deque& rhs, std::false_type) {
+    if (__get_alloc() == rhs.__get_alloc()) {
+      __move_assign(rhs, std::true_type());
+    } else {
+      __release();
+      __move_elements(rhs);
+    }
+  }
+
+ public:
+
   deque& operator=(const deque& rhs) {
     if (this != &rhs) {
+      if (data_allocator::propagate_on_container_copy_assignment::value && __get_alloc() != rhs.__get_alloc()) {
+        // 新的配置器不能释放旧的内存，先用旧的配置器全部释放掉，再用新的配置器重建中控器
+        __release();
+        gd::__alloc_on_copy(__get_alloc(), rhs.__get_alloc());
+        __map_nodes_init(0);
+      } else {
+        gd::__alloc_on_copy(__get_alloc(), rhs.__get_alloc());
+      }
       size_type sz = size();
       if (sz > rhs.size()) {
         erase(std::copy(rhs.begin(), rhs.end(), _start), _finish);
@@ -646,23 +820,13 @@ class deque {
   }
 
   deque& operator=(deque&& rhs) {
-    clear();
-    __deallocate_data(*(_start.node));
-    __deallocate_map(_map, _map_size);
-
-    _start = std::move(rhs._start);
-    _finish = std::move(rhs._finish);
-    _map = rhs._map;
-    _map_size = rhs._map_size;
-
-    rhs._map = 0;
-    rhs._map_size = 0;
-
+    if (this != &rhs)
+      __move_assign(rhs, __alloc_move_steals<data_allocator>());
     return *this;
   }
 
   deque& operator=(std::initializer_list<T> il) {
-    deque tmp(il.begin(), il.end());
+    deque tmp(il.begin(), il.end(), get_allocator());
     swap(tmp);
     return *this;
   }
@@ -677,7 +841,8 @@ class deque {
       std::fill(begin(), end(), value);
       insert(end(), n - size(), value);
     } else {
-      erase(std::fill_n(begin(), n, value), end());
+      std::fill(begin(), begin() + n, value);
+      erase(begin() + n, end());
     }
   }
 
@@ -686,7 +851,7 @@ class deque {
   }
 
   allocator_type get_allocator() const noexcept {
-    return allocator_type();
+    return __get_alloc();
   }
 
  public:  // iterators
@@ -935,10 +1100,10 @@ class deque {
     ++next;
     const size_type elem_before = pos - _start;
     if (elem_before < size() / 2) {
-      std::copy_backward(_start, pos, next);
+      __deque_copy_backward(_start, pos, next);
       pop_front();
     } else {
-      std::copy(next, _finish, pos);
+      __deque_copy(next, _finish, pos);
       pop_back();
     }
     return _start + elem_before;
@@ -953,12 +1118,12 @@ class deque {
     const size_type len = last - first;
     const size_type elem_before = first - _start;
     if (elem_before < ((size() - len) / 2)) {
-      std::copy_backward(_start, first, last);
+      __deque_copy_backward(_start, first, last);
       iterator new_start = _start + len;
       destroy(_start, new_start);
       _start = new_start;
     } else {
-      std::copy(last, _finish, first);
+      __deque_copy(last, _finish, first);
       iterator new_finish = _finish - len;
       destroy(new_finish, _finish);
       _finish = new_finish;
@@ -972,6 +1137,7 @@ class deque {
       std::swap(_finish, rhs._finish);
       std::swap(_map, rhs._map);
       std::swap(_map_size, rhs._map_size);
+      gd::__alloc_on_swap(__get_alloc(), rhs.__get_alloc());
     }
   }
 
@@ -0,0 +1,194 @@
+#ifndef __MY_EPOCH__H
+#define __MY_EPOCH__H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_vector.h"
+
+namespace gd {
+
+// 等待回收的对象，reclaim(ctx, p) 负责释放 p，epoch 为 retire 时的全局 epoch
+struct _epoch_retired {
+  void*    ptr;
+  void     (*reclaim)(void*, void*);
+  void*    ctx;
+  uint64_t epoch;
+};
+
+// 每个线程在每个 epoch_domain 中有一条记录，线程退出后记录留给以后 id 相同的线程使用
+struct _epoch_record {
+  std::atomic<uint64_t>  epoch;    // 0 表示不在临界区，否则为进入临界区时看到的全局 epoch
+  std::thread::id        owner;    // 加入链表之后不再改变
+  _epoch_record*         next;     // 加入链表之后不再改变
+  int                    nesting;  // 以下成员只有 owner 访问
+  vector<_epoch_retired> retired;
+  size_t                 reclaim_at;  // retired 达到这个数目时尝试回收
+
+  _epoch_record(size_t n)
+      : epoch(0), owner(std::this_thread::get_id()), next(nullptr), nesting(0), reclaim_at(n) {}
+};
+
+// 基于 epoch 的内存回收（epoch-based reclamation），用于无锁的数据结构
+// 读者在临界区（pin() 返回的 guard 存在期间）中可以访问共享的节点，不需要加锁，也不修改节点上的计数；
+// 写者把节点从数据结构上摘下来之后 retire，等到所有线程都离开了 retire 之前进入的临界区，节点才真正释放：
+// 全局 epoch 只有在所有处于临界区的线程都已经看到当前值时才能加一，所以 retire 于 e 的节点在全局 epoch
+// 达到 e + 2 时已经不可能被任何读者引用
+// 临界区要短，某个线程长时间停在临界区中会让所有线程的回收都停下来
+class epoch_domain {
+ public:
+  // RAII 的临界区，可以嵌套，拷贝时嵌套计数加一；只能在进入临界区的线程中拷贝和析构
+  class guard {
+   public:
+    guard() noexcept : __rec(nullptr) {}
+
+    guard(const guard& rhs) noexcept : __rec(rhs.__rec) {
+      if (__rec != nullptr)
+        ++__rec->nesting;
+    }
+
+    guard(guard&& rhs) noexcept : __rec(rhs.__rec) {
+      rhs.__rec = nullptr;
+    }
+
+    guard& operator=(guard rhs) noexcept {
+      std::swap(__rec, rhs.__rec);
+      return *this;
+    }
+
+    ~guard() {
+      if (__rec != nullptr && --__rec->nesting == 0)
+        __rec->epoch.store(0, std::memory_order_release);
+    }
+
+   private:
+    friend class epoch_domain;
+
+    explicit guard(_epoch_record* rec) : __rec(rec) {}
+
+    _epoch_record* __rec;
+  };
+
+ private:
+  typedef simple_alloc<_epoch_record, alloc> record_allocator;
+
+  enum { __RECLAIM_THRESHOLD = 64 };  // 本线程等待回收的对象达到这个数目时尝试推进 epoch
+
+  std::atomic<uint64_t>       __global;
+  std::atomic<_epoch_record*> __records;
+  uint64_t                    __id;  // 区分先后分配在同一地址上的不同 domain
+
+ public:
+  epoch_domain() : __global(1), __records(nullptr), __id(__next_id()) {}
+
+  epoch_domain(const epoch_domain&) = delete;
+  epoch_domain& operator=(const epoch_domain&) = delete;
+
+  // 调用者保证已经没有线程在使用本 domain
+  ~epoch_domain() {
+    drain();
+    for (_epoch_record* r = __records.load(std::memory_order_acquire); r != nullptr;) {
+      _epoch_record* next = r->next;
+      gd::destroy(r);
+      record_allocator().deallocate(r);
+      r = next;
+    }
+  }
+
+  // 进入临界区
+  guard pin() {
+    _epoch_record* rec = __local();
+    if (rec->nesting++ == 0) {
+      rec->epoch.store(__global.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      // 先公布自己进入了临界区，之后才能读共享的指针
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    return guard(rec);
+  }
+
+  // p 已经从数据结构上摘下来，不会再被新的读者看到，等到安全时调用 reclaim(ctx, p)
+  // reclaim 在某个之后调用 retire 的线程中执行，其中不能再调用 retire
+  void retire(void* p, void (*reclaim)(void*, void*), void* ctx) {
+    _epoch_record* rec = __local();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _epoch_retired r = {p, reclaim, ctx, __global.load(std::memory_order_relaxed)};
+    rec->retired.push_back(r);
+    if (rec->retired.size() >= rec->reclaim_at) {
+      __try_advance();
+      __reclaim(rec, false);
+      // 有线程长时间停在临界区时回收不了多少，下一次等列表再翻一倍，均摊下来仍是 O(1)
+      rec->reclaim_at = rec->retired.size() * 2 > __RECLAIM_THRESHOLD ? rec->retired.size() * 2
+                                                                        : (size_t)__RECLAIM_THRESHOLD;
+    }
+  }
+
+  // 释放所有等待回收的对象，调用者保证没有线程处于临界区，用于容器析构
+  void drain() {
+    for (_epoch_record* r = __records.load(std::memory_order_acquire); r != nullptr; r = r->next)
+      __reclaim(r, true);
+  }
+
+ private:
+  static uint64_t __next_id() {
+    static std::atomic<uint64_t> id(0);
+    return ++id;
+  }
+
+  // 本线程的记录，最近使用的 domain 缓存在线程本地，没有时加到链表头部
+  _epoch_record* __local() {
+    struct cache {
+      uint64_t       id;
+      _epoch_record* rec;
+    };
+    static thread_local cache c = {0, nullptr};
+    if (c.id == __id)
+      return c.rec;
+
+    std::thread::id me = std::this_thread::get_id();
+    _epoch_record*  rec = __records.load(std::memory_order_acquire);
+    while (rec != nullptr && rec->owner != me)
+      rec = rec->next;
+    if (rec == nullptr) {
+      rec = record_allocator().allocate();
+      gd::construct(rec, (size_t)__RECLAIM_THRESHOLD);
+      rec->next = __records.load(std::memory_order_relaxed);
+      while (!__records.compare_exchange_weak(rec->next, rec, std::memory_order_release, std::memory_order_relaxed)) {
+      }
+    }
+    c.id = __id;
+    c.rec = rec;
+    return rec;
+  }
+
+  // 所有处于临界区的线程都已经看到当前的全局 epoch 时把它加一
+  void __try_advance() {
+    uint64_t e = __global.load(std::memory_order_seq_cst);
+    for (_epoch_record* r = __records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+      uint64_t local = r->epoch.load(std::memory_order_seq_cst);
+      if (local != 0 && local != e)
+        return;
+    }
+    __global.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+  }
+
+  // 释放 rec 中已经安全的对象，all 为 true 时全部释放
+  void __reclaim(_epoch_record* rec, bool all) {
+    uint64_t                g = __global.load(std::memory_order_acquire);
+    vector<_epoch_retired>& list = rec->retired;
+    size_t                  kept = 0;
+    for (size_t i = 0; i < list.size(); ++i) {
+      if (all || list[i].epoch + 2 <= g)
+        list[i].reclaim(list[i].ctx, list[i].ptr);
+      else
+        list[kept++] = list[i];
+    }
+    list.erase(list.begin() + kept, list.end());
+  }
+};
+
+}  // namespace gd
+
+#endif  // !__MY_EPOCH__H
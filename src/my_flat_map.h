@@ -0,0 +1,649 @@
+#ifndef __MY_FLAT_MAP__H
+#define __MY_FLAT_MAP__H
+
+#include <algorithm>  // for stable_sort
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "exceptdef.h"
+#include "my_iterator.h"
+#include "my_tree.h"  // for sorted_unique_t
+#include "my_vector.h"
+
+namespace gd {
+
+// 在有序区间 [first, first + n) 中找第一个不小于 k 的位置
+// 每一步都把区间缩小一半，用条件传送代替分支，比较结果随机时不会因为分支预测失败而停顿
+template <typename Key, typename K, typename Compare>
+inline const Key* __flat_lower_bound(const Key* first, size_t n, const K& k, Compare& comp) {
+  if (n == 0)
+    return first;
+  while (n > 1) {
+    size_t half = n / 2;
+    first = comp(first[half], k) ? first + half : first;
+    n -= half;
+  }
+  return first + comp(*first, k);
+}
+
+// 第一个大于 k 的位置
+template <typename Key, typename K, typename Compare>
+inline const Key* __flat_upper_bound(const Key* first, size_t n, const K& k, Compare& comp) {
+  if (n == 0)
+    return first;
+  while (n > 1) {
+    size_t half = n / 2;
+    first = comp(k, first[half]) ? first : first + half;
+    n -= half;
+  }
+  return first + !comp(k, *first);
+}
+
+// flat_map 的迭代器同时指向 key 数组和 mapped 数组中下标相同的元素，解引用得到 pair<const Key&, V&>，
+// 不是真正的引用，遍历时要写 for (auto p : m) 或者 for (const auto& p : m)
+template <typename Key, typename V>  // V 为 T 或 const T
+struct _flat_map_iterator {
+  typedef random_access_iterator_tag                          iterator_category;
+  typedef std::pair<Key, typename std::remove_const<V>::type> value_type;
+  typedef std::pair<const Key&, V&>                           reference;
+  typedef ptrdiff_t                                           difference_type;
+
+  // operator-> 需要返回指针，把 reference 存在一个临时对象里
+  struct pointer {
+    reference ref;
+
+    const reference* operator->() const {
+      return &ref;
+    }
+  };
+
+  typedef _flat_map_iterator self;
+
+  const Key* key;
+  V*         val;
+
+  _flat_map_iterator() : key(0), val(0) {}
+  _flat_map_iterator(const Key* k, V* v) : key(k), val(v) {}
+
+  // iterator 可以转换为 const_iterator
+  template <typename U, typename = typename std::enable_if<std::is_same<const U, V>::value>::type>
+  _flat_map_iterator(const _flat_map_iterator<Key, U>& rhs) : key(rhs.key), val(rhs.val) {}
+
+  reference operator*() const {
+    return reference(*key, *val);
+  }
+
+  pointer operator->() const {
+    return pointer{**this};
+  }
+
+  reference operator[](difference_type n) const {
+    return reference(key[n], val[n]);
+  }
+
+  self& operator++() {
+    ++key;
+    ++val;
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  self& operator--() {
+    --key;
+    --val;
+    return *this;
+  }
+
+  self operator--(int) {
+    self tmp(*this);
+    --*this;
+    return tmp;
+  }
+
+  self& operator+=(difference_type n) {
+    key += n;
+    val += n;
+    return *this;
+  }
+
+  self& operator-=(difference_type n) {
+    return *this += -n;
+  }
+
+  self operator+(difference_type n) const {
+    return self(key + n, val + n);
+  }
+
+  self operator-(difference_type n) const {
+    return self(key - n, val - n);
+  }
+
+  template <typename U>
+  difference_type operator-(const _flat_map_iterator<Key, U>& rhs) const {
+    return key - rhs.key;
+  }
+
+  template <typename U>
+  bool operator==(const _flat_map_iterator<Key, U>& rhs) const {
+    return key == rhs.key;
+  }
+
+  template <typename U>
+  bool operator!=(const _flat_map_iterator<Key, U>& rhs) const {
+    return key != rhs.key;
+  }
+
+  template <typename U>
+  bool operator<(const _flat_map_iterator<Key, U>& rhs) const {
+    return key < rhs.key;
+  }
+
+  template <typename U>
+  bool operator>(const _flat_map_iterator<Key, U>& rhs) const {
+    return key > rhs.key;
+  }
+
+  template <typename U>
+  bool operator<=(const _flat_map_iterator<Key, U>& rhs) const {
+    return key <= rhs.key;
+  }
+
+  template <typename U>
+  bool operator>=(const _flat_map_iterator<Key, U>& rhs) const {
+    return key >= rhs.key;
+  }
+};
+
+// 用两个有序的 vector 分别存放 key 和 mapped 值的 map，适合一次建好、之后大量查找的表
+// 查找只在连续的 key 数组上二分，比 map 逐个节点比较少得多的 cache miss，也没有每个节点的指针和配置开销；
+// 插入和删除要移动后面所有的元素，为 O(n)，并且会使所有迭代器失效，大量插入时应该用区间插入或有序区间的构造函数
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_map {
+ public:
+  typedef Key                key_type;
+  typedef T                  mapped_type;
+  typedef std::pair<Key, T>  value_type;
+  typedef Compare            key_compare;
+  typedef vector<Key, Alloc> key_container_type;
+  typedef vector<T, Alloc>   mapped_container_type;
+  typedef size_t             size_type;
+  typedef ptrdiff_t          difference_type;
+
+  typedef _flat_map_iterator<Key, T>         iterator;
+  typedef _flat_map_iterator<Key, const T>   const_iterator;
+  typedef typename iterator::reference       reference;
+  typedef typename const_iterator::reference const_reference;
+
+  typedef typename key_container_type::allocator_type allocator_type;
+
+  // 比较元素 key 的大小
+  class value_compare {
+    friend class flat_map;
+
+   protected:
+    Compare comp;
+    value_compare(Compare c) : comp(c) {}
+
+   public:
+    typedef bool result_type;
+
+    template <typename L, typename R>
+    bool operator()(const L& lhs, const R& rhs) const {
+      return comp(lhs.first, rhs.first);
+    }
+  };
+
+ private:
+  key_container_type    __keys;
+  mapped_container_type __values;
+  key_compare           __key_compare;
+
+ public:  // constructor, copy, destructor
+  flat_map() = default;
+
+  explicit flat_map(const Compare& comp, const allocator_type& a = allocator_type())
+      : __keys(a), __values(a), __key_compare(comp) {}
+
+  explicit flat_map(const allocator_type& a) : __keys(a), __values(a), __key_compare() {}
+
+  // 无序的 [first, last) 先整体排序、去重，再一次建好，O(n log n)
+  template <typename InputIterator>
+  flat_map(InputIterator first, InputIterator last) : __keys(), __values(), __key_compare() {
+    insert(first, last);
+  }
+
+  template <typename InputIterator>
+  flat_map(InputIterator first, InputIterator last, const allocator_type& a)
+      : __keys(a), __values(a), __key_compare() {
+    insert(first, last);
+  }
+
+  flat_map(std::initializer_list<value_type> il) : __keys(), __values(), __key_compare() {
+    insert(il.begin(), il.end());
+  }
+
+  flat_map(std::initializer_list<value_type> il, const allocator_type& a) : __keys(a), __values(a), __key_compare() {
+    insert(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时不需要排序，直接依次追加，重复的 key 只保留第一个
+  template <typename InputIterator>
+  flat_map(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+           const allocator_type& a = allocator_type())
+      : __keys(a), __values(a), __key_compare(comp) {
+    assign_sorted(first, last);
+  }
+
+  flat_map(const flat_map& rhs) = default;
+
+  flat_map(flat_map&& rhs) noexcept
+      : __keys(std::move(rhs.__keys)), __values(std::move(rhs.__values)), __key_compare(rhs.__key_compare) {}
+
+  flat_map(const flat_map& rhs, const allocator_type& a)
+      : __keys(rhs.__keys, a), __values(rhs.__values, a), __key_compare(rhs.__key_compare) {}
+
+  flat_map(flat_map&& rhs, const allocator_type& a)
+      : __keys(std::move(rhs.__keys), a), __values(std::move(rhs.__values), a), __key_compare(rhs.__key_compare) {}
+
+  flat_map& operator=(const flat_map& rhs) = default;
+
+  flat_map& operator=(flat_map&& rhs) {
+    __keys = std::move(rhs.__keys);
+    __values = std::move(rhs.__values);
+    __key_compare = rhs.__key_compare;
+    return *this;
+  }
+
+  flat_map& operator=(std::initializer_list<value_type> il) {
+    clear();
+    insert(il.begin(), il.end());
+    return *this;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __keys.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() noexcept {
+    return iterator(__keys.data(), __values.data());
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(__keys.data(), __values.data());
+  }
+
+  iterator end() noexcept {
+    return begin() + size();
+  }
+
+  const_iterator end() const noexcept {
+    return begin() + size();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __keys.empty();
+  }
+
+  size_type size() const noexcept {
+    return __keys.size();
+  }
+
+  size_type max_size() const noexcept {
+    return __keys.max_size();
+  }
+
+  size_type capacity() const noexcept {
+    return __keys.capacity();
+  }
+
+  void reserve(size_type n) {
+    __keys.reserve(n);
+    __values.reserve(n);
+  }
+
+  // 建好之后释放多余的容量
+  void shrink_to_fit() {
+    __keys.shrink_to_fit();
+    __values.shrink_to_fit();
+  }
+
+ public:  // element access
+  mapped_type& operator[](const key_type& k) {
+    return try_emplace(k).first->second;
+  }
+
+  mapped_type& operator[](key_type&& k) {
+    return try_emplace(std::move(k)).first->second;
+  }
+
+  mapped_type& at(const key_type& k) {
+    iterator it = find(k);
+    THROW_OUT_OF_RANGE_IF(it == end(), "flat_map<Key, T>::at() key not found");
+    return it->second;
+  }
+
+  const mapped_type& at(const key_type& k) const {
+    const_iterator it = find(k);
+    THROW_OUT_OF_RANGE_IF(it == end(), "flat_map<Key, T>::at() key not found");
+    return it->second;
+  }
+
+  // 底层的 key 数组和 mapped 数组，下标相同的元素是一对
+  const key_container_type& keys() const noexcept {
+    return __keys;
+  }
+
+  const mapped_container_type& values() const noexcept {
+    return __values;
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type v(std::forward<Args>(args)...);
+    return try_emplace(std::move(v.first), std::move(v.second));
+  }
+
+  // pos 是新元素应该插入的位置，位置正确时不需要二分查找
+  template <typename... Args>
+  iterator emplace_hint(const_iterator pos, Args&&... args) {
+    value_type v(std::forward<Args>(args)...);
+    return __insert_hint(pos, std::move(v.first), std::move(v.second));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args) {
+    return __try_emplace(k, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args) {
+    return __try_emplace(std::move(k), std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& v) {
+    return try_emplace(v.first, v.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& v) {
+    return try_emplace(std::move(v.first), std::move(v.second));
+  }
+
+  iterator insert(const_iterator pos, const value_type& v) {
+    return __insert_hint(pos, v.first, v.second);
+  }
+
+  iterator insert(const_iterator pos, value_type&& v) {
+    return __insert_hint(pos, std::move(v.first), std::move(v.second));
+  }
+
+  // 新元素先收集起来排序去重，再与已有的元素归并，O(m log m + n)，而不是逐个插入的 O(m * n)
+  // 与 map 一样，已有的 key 不会被覆盖，重复的 key 只保留第一个；插入失败时 flat_map 保持不变
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    vector<value_type, Alloc> buf(get_allocator());
+    for (; first != last; ++first)
+      buf.push_back(value_type(*first));
+    auto comp = value_comp();
+    std::stable_sort(buf.begin(), buf.end(), comp);
+    __merge(buf.begin(), buf.end());
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    insert(il.begin(), il.end());
+  }
+
+  // 清空后用有序区间 [first, last) 重建，输入无序时退化为排序后建立
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    clear();
+    for (; first != last; ++first) {
+      const value_type& v = *first;
+      if (!empty() && !__key_compare(__keys.back(), v.first)) {
+        if (__key_compare(v.first, __keys.back()))
+          break;
+        continue;  // 跳过重复的 key
+      }
+      __append(v.first, v.second);
+    }
+    insert(first, last);
+  }
+
+  // 返回被删除元素的下一个元素
+  iterator erase(const_iterator pos) {
+    size_type i = pos.key - __keys.data();
+    __keys.erase(__keys.begin() + i);
+    __values.erase(__values.begin() + i);
+    return begin() + i;
+  }
+
+  size_type erase(const key_type& k) {
+    const_iterator it = find(k);
+    if (it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_type i = first.key - __keys.data();
+    size_type j = last.key - __keys.data();
+    __keys.erase(__keys.begin() + i, __keys.begin() + j);
+    __values.erase(__values.begin() + i, __values.begin() + j);
+    return begin() + i;
+  }
+
+  void clear() {
+    __keys.clear();
+    __values.clear();
+  }
+
+  void swap(flat_map& rhs) {
+    __keys.swap(rhs.__keys);
+    __values.swap(rhs.__values);
+    std::swap(__key_compare, rhs.__key_compare);
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return __key_compare;
+  }
+
+  value_compare value_comp() const {
+    return value_compare(__key_compare);
+  }
+
+ public:  // map operations
+  iterator find(const key_type& k) {
+    iterator it = lower_bound(k);
+    return it == end() || __key_compare(k, *it.key) ? end() : it;
+  }
+
+  const_iterator find(const key_type& k) const {
+    const_iterator it = lower_bound(k);
+    return it == end() || __key_compare(k, *it.key) ? end() : it;
+  }
+
+  size_type count(const key_type& k) const {
+    return find(k) == end() ? 0 : 1;
+  }
+
+  iterator lower_bound(const key_type& k) {
+    return begin() + (__lower_bound(k) - __keys.data());
+  }
+
+  const_iterator lower_bound(const key_type& k) const {
+    return begin() + (__lower_bound(k) - __keys.data());
+  }
+
+  iterator upper_bound(const key_type& k) {
+    return begin() + (__upper_bound(k) - __keys.data());
+  }
+
+  const_iterator upper_bound(const key_type& k) const {
+    return begin() + (__upper_bound(k) - __keys.data());
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) {
+    iterator it = lower_bound(k);
+    return std::make_pair(it, it == end() || __key_compare(k, *it.key) ? it : it + 1);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    const_iterator it = lower_bound(k);
+    return std::make_pair(it, it == end() || __key_compare(k, *it.key) ? it : it + 1);
+  }
+
+ public:  // operators
+  bool operator==(const flat_map& rhs) const {
+    return __keys == rhs.__keys && __values == rhs.__values;
+  }
+
+  bool operator<(const flat_map& rhs) const {
+    return std::lexicographical_compare(begin(), end(), rhs.begin(), rhs.end(), __pair_less());
+  }
+
+ private:
+  struct __pair_less {
+    bool operator()(const_reference lhs, const_reference rhs) const {
+      return lhs.first < rhs.first || (!(rhs.first < lhs.first) && lhs.second < rhs.second);
+    }
+  };
+
+  const Key* __lower_bound(const key_type& k) const {
+    return __flat_lower_bound(__keys.data(), __keys.size(), k, __key_compare);
+  }
+
+  const Key* __upper_bound(const key_type& k) const {
+    return __flat_upper_bound(__keys.data(), __keys.size(), k, __key_compare);
+  }
+
+  // 在下标 i 处插入一对元素，mapped 值构造失败时撤销已经插入的 key
+  template <typename K, typename... Args>
+  iterator __emplace_at(size_type i, K&& k, Args&&... args) {
+    __keys.emplace(__keys.begin() + i, std::forward<K>(k));
+    try {
+      __values.emplace(__values.begin() + i, std::forward<Args>(args)...);
+    } catch (...) {
+      __keys.erase(__keys.begin() + i);
+      throw;
+    }
+    return begin() + i;
+  }
+
+  template <typename K, typename V>
+  void __append(K&& k, V&& v) {
+    __emplace_at(size(), std::forward<K>(k), std::forward<V>(v));
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> __try_emplace(K&& k, Args&&... args) {
+    size_type i = __lower_bound(k) - __keys.data();
+    if (i != size() && !__key_compare(k, __keys[i]))
+      return std::make_pair(begin() + i, false);
+    return std::make_pair(__emplace_at(i, std::forward<K>(k), std::forward<Args>(args)...), true);
+  }
+
+  template <typename K, typename V>
+  iterator __insert_hint(const_iterator pos, K&& k, V&& v) {
+    size_type i = pos.key - __keys.data();
+    if ((i == size() || __key_compare(k, __keys[i])) && (i == 0 || __key_compare(__keys[i - 1], k)))
+      return __emplace_at(i, std::forward<K>(k), std::forward<V>(v));
+    return __try_emplace(std::forward<K>(k), std::forward<V>(v)).first;
+  }
+
+  // key 和 mapped 值的移动都不抛出异常时移动已有的元素，否则拷贝，归并失败时已有的元素保持不变
+  typedef std::integral_constant<bool, std::is_nothrow_move_constructible<Key>::value &&
+                                           std::is_nothrow_move_constructible<T>::value>
+      __nothrow_move;
+
+  template <typename U>
+  static typename std::conditional<__nothrow_move::value, U&&, const U&>::type __move_if_nothrow(U& x) {
+    return static_cast<typename std::conditional<__nothrow_move::value, U&&, const U&>::type>(x);
+  }
+
+  // 把已经按 key 排好序的 [first, last) 与已有的元素归并到新的数组中，空间预先分配好，之后只有元素的构造可能失败
+  void __merge(value_type* first, value_type* last) {
+    if (first == last)
+      return;
+    key_container_type    keys(__keys.get_allocator());
+    mapped_container_type values(__values.get_allocator());
+    keys.reserve(size() + (last - first));
+    values.reserve(size() + (last - first));
+    size_type i = 0;
+    while (i != size() || first != last) {
+      if (first == last || (i != size() && !__key_compare(first->first, __keys[i]))) {
+        // 已有的元素优先，新元素中与它相同的 key 在下一轮被跳过
+        keys.push_back(__move_if_nothrow(__keys[i]));
+        values.push_back(__move_if_nothrow(__values[i]));
+        ++i;
+      } else if (!keys.empty() && !__key_compare(keys.back(), first->first)) {
+        ++first;
+      } else {
+        keys.push_back(std::move(first->first));
+        values.push_back(std::move(first->second));
+        ++first;
+      }
+    }
+    __keys.swap(keys);
+    __values.swap(values);
+  }
+};
+
+// operators:
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator==(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator!=(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator<(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs) {
+  return lhs.operator<(rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator>=(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator>(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator<=(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+void swap(flat_map<Key, T, Compare, Alloc>& lhs, flat_map<Key, T, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_FLAT_MAP__H
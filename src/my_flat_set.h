@@ -0,0 +1,339 @@
+#ifndef __MY_FLAT_SET__H
+#define __MY_FLAT_SET__H
+
+#include <algorithm>  // for stable_sort, inplace_merge, unique
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include "my_flat_map.h"  // for __flat_lower_bound, __flat_upper_bound
+#include "my_vector.h"
+
+namespace gd {
+
+// 用一个有序的 vector 存放元素的 set，适合一次建好、之后大量查找的集合，见 flat_map
+// 迭代器就是 vector 的 const_iterator，插入和删除会使所有迭代器失效
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_set {
+ public:
+  typedef Key                key_type;
+  typedef Key                value_type;
+  typedef Compare            key_compare;
+  typedef Compare            value_compare;
+  typedef vector<Key, Alloc> container_type;
+
+  typedef typename container_type::const_pointer   pointer;
+  typedef typename container_type::const_pointer   const_pointer;
+  typedef typename container_type::const_reference reference;
+  typedef typename container_type::const_reference const_reference;
+  typedef typename container_type::const_iterator  iterator;
+  typedef typename container_type::const_iterator  const_iterator;
+  typedef typename container_type::size_type       size_type;
+  typedef typename container_type::difference_type difference_type;
+  typedef typename container_type::allocator_type  allocator_type;
+
+ private:
+  container_type __keys;
+  key_compare    __key_compare;
+
+ public:  // constructor, copy, destructor
+  flat_set() = default;
+
+  explicit flat_set(const Compare& comp, const allocator_type& a = allocator_type()) : __keys(a), __key_compare(comp) {}
+
+  explicit flat_set(const allocator_type& a) : __keys(a), __key_compare() {}
+
+  // 无序的 [first, last) 先整体排序、去重，再一次建好，O(n log n)
+  template <typename InputIterator>
+  flat_set(InputIterator first, InputIterator last) : __keys(), __key_compare() {
+    insert(first, last);
+  }
+
+  template <typename InputIterator>
+  flat_set(InputIterator first, InputIterator last, const allocator_type& a) : __keys(a), __key_compare() {
+    insert(first, last);
+  }
+
+  flat_set(std::initializer_list<value_type> il) : __keys(), __key_compare() {
+    insert(il.begin(), il.end());
+  }
+
+  flat_set(std::initializer_list<value_type> il, const allocator_type& a) : __keys(a), __key_compare() {
+    insert(il.begin(), il.end());
+  }
+
+  // [first, last) 已经升序排列时不需要排序，直接依次追加，重复的元素只保留第一个
+  template <typename InputIterator>
+  flat_set(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+           const allocator_type& a = allocator_type())
+      : __keys(a), __key_compare(comp) {
+    assign_sorted(first, last);
+  }
+
+  flat_set(const flat_set& rhs) = default;
+
+  flat_set(flat_set&& rhs) noexcept : __keys(std::move(rhs.__keys)), __key_compare(rhs.__key_compare) {}
+
+  flat_set(const flat_set& rhs, const allocator_type& a) : __keys(rhs.__keys, a), __key_compare(rhs.__key_compare) {}
+
+  flat_set(flat_set&& rhs, const allocator_type& a)
+      : __keys(std::move(rhs.__keys), a), __key_compare(rhs.__key_compare) {}
+
+  flat_set& operator=(const flat_set& rhs) = default;
+
+  flat_set& operator=(flat_set&& rhs) {
+    __keys = std::move(rhs.__keys);
+    __key_compare = rhs.__key_compare;
+    return *this;
+  }
+
+  flat_set& operator=(std::initializer_list<value_type> il) {
+    clear();
+    insert(il.begin(), il.end());
+    return *this;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __keys.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() const noexcept {
+    return __keys.begin();
+  }
+
+  iterator end() const noexcept {
+    return __keys.end();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return __keys.begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return __keys.end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __keys.empty();
+  }
+
+  size_type size() const noexcept {
+    return __keys.size();
+  }
+
+  size_type max_size() const noexcept {
+    return __keys.max_size();
+  }
+
+  size_type capacity() const noexcept {
+    return __keys.capacity();
+  }
+
+  void reserve(size_type n) {
+    __keys.reserve(n);
+  }
+
+  // 建好之后释放多余的容量
+  void shrink_to_fit() {
+    __keys.shrink_to_fit();
+  }
+
+  // 底层的有序数组
+  const container_type& keys() const noexcept {
+    return __keys;
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  iterator emplace_hint(iterator pos, Args&&... args) {
+    return insert(pos, value_type(std::forward<Args>(args)...));
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return __insert(value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return __insert(std::move(value));
+  }
+
+  // pos 是新元素应该插入的位置，位置正确时不需要二分查找
+  iterator insert(iterator pos, const value_type& value) {
+    return __insert_hint(pos, value);
+  }
+
+  iterator insert(iterator pos, value_type&& value) {
+    return __insert_hint(pos, std::move(value));
+  }
+
+  // 新元素追加到末尾后整体排序，再与原来的元素归并、去重，已有的元素优先
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    size_type n = size();
+    try {
+      for (; first != last; ++first)
+        __keys.push_back(*first);
+    } catch (...) {
+      __keys.erase(__keys.begin() + n, __keys.end());
+      throw;
+    }
+    Key* base = __keys.data();
+    std::stable_sort(base + n, base + size(), __key_compare);
+    std::inplace_merge(base, base + n, base + size(), __key_compare);
+    // 相同的元素中稳定排序和稳定归并都把原来的元素排在前面，去重时保留第一个
+    Key* last_unique = std::unique(base, base + size(), [this](const Key& lhs, const Key& rhs) {
+      return !__key_compare(lhs, rhs);
+    });
+    __keys.erase(last_unique, __keys.end());
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    insert(il.begin(), il.end());
+  }
+
+  // 清空后用有序区间 [first, last) 重建，输入无序时退化为排序后建立
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    clear();
+    for (; first != last; ++first) {
+      if (!empty() && !__key_compare(__keys.back(), *first)) {
+        if (__key_compare(*first, __keys.back()))
+          break;
+        continue;  // 跳过重复的元素
+      }
+      __keys.push_back(*first);
+    }
+    insert(first, last);
+  }
+
+  // 返回被删除元素的下一个元素
+  iterator erase(iterator pos) {
+    return __keys.erase(pos);
+  }
+
+  size_type erase(const key_type& k) {
+    iterator it = find(k);
+    if (it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  iterator erase(iterator first, iterator last) {
+    return __keys.erase(const_cast<Key*>(first), const_cast<Key*>(last));
+  }
+
+  void swap(flat_set& rhs) {
+    __keys.swap(rhs.__keys);
+    std::swap(__key_compare, rhs.__key_compare);
+  }
+
+  void clear() noexcept {
+    __keys.clear();
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return __key_compare;
+  }
+
+  value_compare value_comp() const {
+    return __key_compare;
+  }
+
+ public:  // set operations
+  iterator find(const key_type& k) const {
+    iterator it = lower_bound(k);
+    return it == end() || __key_compare(k, *it) ? end() : it;
+  }
+
+  size_type count(const key_type& k) const {
+    return find(k) == end() ? 0 : 1;
+  }
+
+  iterator lower_bound(const key_type& k) const {
+    return __flat_lower_bound(__keys.data(), __keys.size(), k, __key_compare);
+  }
+
+  iterator upper_bound(const key_type& k) const {
+    return __flat_upper_bound(__keys.data(), __keys.size(), k, __key_compare);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) const {
+    iterator it = lower_bound(k);
+    return std::make_pair(it, it == end() || __key_compare(k, *it) ? it : it + 1);
+  }
+
+ public:
+  bool operator==(const flat_set& rhs) const {
+    return __keys == rhs.__keys;
+  }
+
+  bool operator<(const flat_set& rhs) const {
+    return __keys < rhs.__keys;
+  }
+
+ private:
+  template <typename V>
+  std::pair<iterator, bool> __insert(V&& v) {
+    iterator it = lower_bound(v);
+    if (it != end() && !__key_compare(v, *it))
+      return std::make_pair(it, false);
+    return std::make_pair(__keys.emplace(it, std::forward<V>(v)), true);
+  }
+
+  template <typename V>
+  iterator __insert_hint(iterator pos, V&& v) {
+    if ((pos == end() || __key_compare(v, *pos)) && (pos == begin() || __key_compare(*(pos - 1), v)))
+      return __keys.emplace(pos, std::forward<V>(v));
+    return __insert(std::forward<V>(v)).first;
+  }
+};
+
+// operators
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator==(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator!=(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator<(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs) {
+  return lhs.operator<(rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator>=(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator>(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator<=(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+void swap(flat_set<Key, Compare, Alloc>& lhs, flat_set<Key, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_FLAT_SET__H
@@ -0,0 +1,521 @@
+#ifndef __MY_FROZEN_SET__H
+#define __MY_FROZEN_SET__H
+
+#include <algorithm>  // for stable_sort, unique, lexicographical_compare
+#include <cstdint>    // for uintptr_t
+#include <functional>
+#include <initializer_list>
+#include <utility>
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_iterator.h"
+#include "my_set.h"
+#include "my_uninitialized.h"
+#include "my_vector.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace gd {
+
+// 预取 p 所在的 cache line，只是提示，p 不需要是有效的地址
+inline void __frozen_prefetch(const void* p) {
+#ifdef _MSC_VER
+  _mm_prefetch((const char*)p, _MM_HINT_T0);
+#else
+  __builtin_prefetch(p);
+#endif
+}
+
+// x 末尾连续的 1 的个数
+inline unsigned __frozen_trailing_ones(size_t x) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, ~(unsigned long long)x);
+  return (unsigned)index;
+#else
+  return (unsigned)__builtin_ctzll(~(unsigned long long)x);
+#endif
+}
+
+// Eytzinger 布局：把一棵完全二叉搜索树按层序存放在数组中，下标从 1 开始，i 的左右孩子为 2i、2i + 1
+// 中序遍历的顺序就是元素的升序，后继和前驱都可以由下标算出，均摊常数时间
+inline size_t __eytzinger_first(size_t n) {
+  size_t i = 0;
+  if (n != 0)
+    for (i = 1; 2 * i <= n; i *= 2) {
+    }
+  return i;
+}
+
+inline size_t __eytzinger_last(size_t n) {
+  size_t i = 0;
+  if (n != 0)
+    for (i = 1; 2 * i + 1 <= n; i = 2 * i + 1) {
+    }
+  return i;
+}
+
+// i 的中序后继，没有后继时为 0
+inline size_t __eytzinger_next(size_t i, size_t n) {
+  if (2 * i + 1 <= n) {
+    // 右子树最左边的节点
+    for (i = 2 * i + 1; 2 * i <= n; i *= 2) {
+    }
+    return i;
+  }
+  // 向上走到第一个从左孩子上来的祖先
+  return i >> (__frozen_trailing_ones(i) + 1);
+}
+
+// i 的中序前驱，i 为 0 时为最后一个节点
+inline size_t __eytzinger_prev(size_t i, size_t n) {
+  if (i == 0)
+    return __eytzinger_last(n);
+  if (2 * i <= n) {
+    for (i = 2 * i; 2 * i + 1 <= n; i = 2 * i + 1) {
+    }
+    return i;
+  }
+  while (!(i & 1))
+    i >>= 1;
+  return i >> 1;
+}
+
+template <typename Key>
+struct _frozen_set_iterator {
+  typedef Key                        value_type;
+  typedef const Key&                 reference;
+  typedef const Key*                 pointer;
+  typedef ptrdiff_t                  difference_type;
+  typedef bidirectional_iterator_tag iterator_category;
+
+  typedef _frozen_set_iterator self;
+
+  const Key* data;
+  size_t     index;  // 0 表示 end()
+  size_t     count;
+
+  _frozen_set_iterator() : data(0), index(0), count(0) {}
+  _frozen_set_iterator(const Key* d, size_t i, size_t n) : data(d), index(i), count(n) {}
+
+  reference operator*() const {
+    return data[index];
+  }
+
+  pointer operator->() const {
+    return &(operator*());
+  }
+
+  self& operator++() {
+    index = __eytzinger_next(index, count);
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  self& operator--() {
+    index = __eytzinger_prev(index, count);
+    return *this;
+  }
+
+  self operator--(int) {
+    self tmp(*this);
+    --*this;
+    return tmp;
+  }
+
+  bool operator==(const self& rhs) const {
+    return index == rhs.index && data == rhs.data;
+  }
+
+  bool operator!=(const self& rhs) const {
+    return !(*this == rhs);
+  }
+};
+
+// 建好之后不再修改的有序集合，元素按 Eytzinger 布局存放在一块连续的数组中
+// 查找从根往下走，每一步只是把下标乘 2 再加上比较结果，没有分支；树的前几层总在 cache 中，
+// 数组按 cache line 对齐，i 往下 log2(B) 层的后代正好是同一个 cache line 中连续的 B 个元素，
+// 所以每一步都预取几层之后要访问的 cache line，访存和比较重叠进行，比二分查找和红黑树少得多的等待
+// 仍然可以按升序遍历，但遍历的访存是跳跃的，比 flat_set 慢；没有插入和删除，需要修改时重新建立
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class frozen_set : private simple_alloc<char, Alloc> {
+ public:
+  typedef Key       key_type;
+  typedef Key       value_type;
+  typedef Compare   key_compare;
+  typedef Compare   value_compare;
+  typedef size_t    size_type;
+  typedef ptrdiff_t difference_type;
+
+  typedef const Key* pointer;
+  typedef const Key* const_pointer;
+  typedef const Key& reference;
+  typedef const Key& const_reference;
+
+  typedef _frozen_set_iterator<Key> iterator;
+  typedef _frozen_set_iterator<Key> const_iterator;
+
+  typedef simple_alloc<Key, Alloc>  allocator_type;
+  typedef simple_alloc<char, Alloc> byte_allocator;
+
+ private:
+  enum { __LINE = 64 };  // cache line 的大小
+  enum { __BLOCK = sizeof(Key) < __LINE ? __LINE / sizeof(Key) : 1 };  // 一个 cache line 中的元素个数
+  enum { __ALIGN = alignof(Key) > (size_t)__LINE ? alignof(Key) : (size_t)__LINE };
+
+  char*     _raw;    // 分配到的内存，对齐之前
+  size_type _bytes;  // _raw 的大小
+  Key*      _data;   // 对齐后的数组，_data[0] 不使用，元素在 _data[1..n]
+  size_type _size;
+  Compare   _key_compare;
+
+  byte_allocator& __get_alloc() noexcept {
+    return *this;
+  }
+
+  const byte_allocator& __get_alloc() const noexcept {
+    return *this;
+  }
+
+ private:  // helpers
+  void __empty_init() noexcept {
+    _raw = 0;
+    _bytes = 0;
+    _data = 0;
+    _size = 0;
+  }
+
+  // 分配 n + 1 个元素的空间，_data 按 __ALIGN 对齐
+  void __allocate(size_type n) {
+    _bytes = (n + 1) * sizeof(Key) + __ALIGN;
+    _raw = byte_allocator::allocate(_bytes);
+    _data = (Key*)(((uintptr_t)_raw + __ALIGN - 1) / __ALIGN * __ALIGN);
+    _size = n;
+  }
+
+  void __deallocate() noexcept {
+    if (_raw)
+      byte_allocator::deallocate(_raw, _bytes);
+    __empty_init();
+  }
+
+  void __release() noexcept {
+    if (_size != 0)
+      gd::destroy(_data + 1, _data + _size + 1);
+    __deallocate();
+  }
+
+  // 用严格升序的 [first, first + n) 按中序依次填入数组
+  template <typename ForwardIterator>
+  void __build(ForwardIterator first, size_type n) {
+    if (n == 0)
+      return;
+    __allocate(n);
+    size_type built = 0;
+    size_type i = __eytzinger_first(n);
+    try {
+      for (; built < n; ++built, ++first) {
+        gd::construct(_data + i, *first);
+        i = __eytzinger_next(i, n);
+      }
+    } catch (...) {
+      for (i = __eytzinger_first(n); built > 0; --built) {
+        gd::destroy(_data + i);
+        i = __eytzinger_next(i, n);
+      }
+      __deallocate();
+      throw;
+    }
+  }
+
+  // 无序的输入先整体排序、去重
+  template <typename InputIterator>
+  void __build_unsorted(InputIterator first, InputIterator last) {
+    vector<Key, Alloc> buf(get_allocator());
+    for (; first != last; ++first)
+      buf.push_back(*first);
+    std::stable_sort(buf.begin(), buf.end(), _key_compare);
+    Key* end = std::unique(buf.begin(), buf.end(), [this](const Key& lhs, const Key& rhs) {
+      return !_key_compare(lhs, rhs);
+    });
+    __build(buf.begin(), end - buf.begin());
+  }
+
+  template <typename ForwardIterator>
+  bool __strictly_sorted(ForwardIterator first, ForwardIterator last) const {
+    if (first == last)
+      return true;
+    for (ForwardIterator next = first; ++next != last; first = next)
+      if (!_key_compare(*first, *next))
+        return false;
+    return true;
+  }
+
+  void __copy_from(const frozen_set& rhs) {
+    if (rhs._size == 0)
+      return;
+    __allocate(rhs._size);
+    try {
+      gd::uninitialized_copy(rhs._data + 1, rhs._data + rhs._size + 1, _data + 1);
+    } catch (...) {
+      __deallocate();
+      throw;
+    }
+  }
+
+  void __steal(frozen_set& rhs) noexcept {
+    _raw = rhs._raw;
+    _bytes = rhs._bytes;
+    _data = rhs._data;
+    _size = rhs._size;
+    rhs.__empty_init();
+  }
+
+  void __move_assign(frozen_set& rhs, std::true_type) {
+    __release();
+    gd::__alloc_on_move(__get_alloc(), rhs.__get_alloc());
+    _key_compare = rhs._key_compare;
+    __steal(rhs);
+  }
+
+  void __move_assign(frozen_set& rhs, std::false_type) {
+    if (__get_alloc() == rhs.__get_alloc()) {
+      __move_assign(rhs, std::true_type());
+    } else {
+      __release();
+      _key_compare = rhs._key_compare;
+      __copy_from(rhs);
+    }
+  }
+
+  // 第一个不小于 k 的元素的下标，没有时为 0
+  size_type __lower_index(const key_type& k) const {
+    size_type i = 1;
+    while (i <= _size) {
+      __frozen_prefetch((const void*)((uintptr_t)_data + i * __BLOCK * sizeof(Key)));
+      i = 2 * i + _key_compare(_data[i], k);
+    }
+    // 最后一次向左走的位置就是答案，去掉末尾的向右走和那一次向左走
+    return i >> (__frozen_trailing_ones(i) + 1);
+  }
+
+  size_type __upper_index(const key_type& k) const {
+    size_type i = 1;
+    while (i <= _size) {
+      __frozen_prefetch((const void*)((uintptr_t)_data + i * __BLOCK * sizeof(Key)));
+      i = 2 * i + !_key_compare(k, _data[i]);
+    }
+    return i >> (__frozen_trailing_ones(i) + 1);
+  }
+
+  iterator __make_iter(size_type i) const {
+    return iterator(_data, i, _size);
+  }
+
+ public:  // constructor, copy, destructor
+  frozen_set() : _key_compare() {
+    __empty_init();
+  }
+
+  explicit frozen_set(const Compare& comp, const allocator_type& a = allocator_type())
+      : byte_allocator(a), _key_compare(comp) {
+    __empty_init();
+  }
+
+  // 无序的 [first, last) 先排序、去重，重复的元素只保留第一个
+  template <typename InputIterator>
+  frozen_set(InputIterator first, InputIterator last, const Compare& comp = Compare(),
+             const allocator_type& a = allocator_type())
+      : byte_allocator(a), _key_compare(comp) {
+    __empty_init();
+    __build_unsorted(first, last);
+  }
+
+  frozen_set(std::initializer_list<value_type> il, const Compare& comp = Compare(),
+             const allocator_type& a = allocator_type())
+      : byte_allocator(a), _key_compare(comp) {
+    __empty_init();
+    __build_unsorted(il.begin(), il.end());
+  }
+
+  // [first, last) 严格升序时直接按中序填入，不需要额外的缓冲区，否则退化为排序后建立
+  template <typename ForwardIterator>
+  frozen_set(sorted_unique_t, ForwardIterator first, ForwardIterator last, const Compare& comp = Compare(),
+             const allocator_type& a = allocator_type())
+      : byte_allocator(a), _key_compare(comp) {
+    __empty_init();
+    if (__strictly_sorted(first, last))
+      __build(first, gd::distance(first, last));
+    else
+      __build_unsorted(first, last);
+  }
+
+  frozen_set(const frozen_set& rhs)
+      : byte_allocator(rhs.__get_alloc().select_on_container_copy_construction()), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  frozen_set(frozen_set&& rhs) noexcept
+      : byte_allocator(std::move(rhs.__get_alloc())), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __steal(rhs);
+  }
+
+  frozen_set& operator=(const frozen_set& rhs) {
+    if (this != &rhs) {
+      __release();
+      gd::__alloc_on_copy(__get_alloc(), rhs.__get_alloc());
+      _key_compare = rhs._key_compare;
+      __copy_from(rhs);
+    }
+    return *this;
+  }
+
+  frozen_set& operator=(frozen_set&& rhs) {
+    if (this != &rhs)
+      __move_assign(rhs, __alloc_move_steals<byte_allocator>());
+    return *this;
+  }
+
+  ~frozen_set() {
+    __release();
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __get_alloc();
+  }
+
+ public:  // iterators
+  iterator begin() const noexcept {
+    return __make_iter(__eytzinger_first(_size));
+  }
+
+  iterator end() const noexcept {
+    return __make_iter(0);
+  }
+
+  const_iterator cbegin() const noexcept {
+    return begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  size_type size() const noexcept {
+    return _size;
+  }
+
+  size_type max_size() const noexcept {
+    return size_type(-1) / sizeof(Key);
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return _key_compare;
+  }
+
+  value_compare value_comp() const {
+    return _key_compare;
+  }
+
+ public:  // set operations
+  iterator find(const key_type& k) const {
+    size_type i = __lower_index(k);
+    return __make_iter(i != 0 && !_key_compare(k, _data[i]) ? i : 0);
+  }
+
+  size_type count(const key_type& k) const {
+    return find(k) == end() ? 0 : 1;
+  }
+
+  iterator lower_bound(const key_type& k) const {
+    return __make_iter(__lower_index(k));
+  }
+
+  iterator upper_bound(const key_type& k) const {
+    return __make_iter(__upper_index(k));
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) const {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+  void swap(frozen_set& rhs) {
+    std::swap(_raw, rhs._raw);
+    std::swap(_bytes, rhs._bytes);
+    std::swap(_data, rhs._data);
+    std::swap(_size, rhs._size);
+    std::swap(_key_compare, rhs._key_compare);
+    gd::__alloc_on_swap(__get_alloc(), rhs.__get_alloc());
+  }
+
+ public:
+  bool operator==(const frozen_set& rhs) const {
+    return _size == rhs._size && std::equal(_data + 1, _data + _size + 1, rhs._data + 1);
+  }
+
+  bool operator<(const frozen_set& rhs) const {
+    return std::lexicographical_compare(begin(), end(), rhs.begin(), rhs.end());
+  }
+};
+
+// operators
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator==(const frozen_set<Key, Compare, Alloc>& lhs, const frozen_set<Key, Compare, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator!=(const frozen_set<Key, Compare, Alloc>& lhs, const frozen_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator<(const frozen_set<Key, Compare, Alloc>& lhs, const frozen_set<Key, Compare, Alloc>& rhs) {
+  return lhs.operator<(rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator>=(const frozen_set<Key, Compare, Alloc>& lhs, const frozen_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator>(const frozen_set<Key, Compare, Alloc>& lhs, const frozen_set<Key, Compare, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+bool operator<=(const frozen_set<Key, Compare, Alloc>& lhs, const frozen_set<Key, Compare, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+void swap(frozen_set<Key, Compare, Alloc>& lhs, frozen_set<Key, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+// 把 set 冻结为 frozen_set，set 的元素已经严格升序，只需要遍历一次，O(n)
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+frozen_set<Key, Compare, Alloc> freeze(const set<Key, Compare, Alloc, Augment>& s) {
+  return frozen_set<Key, Compare, Alloc>(sorted_unique, s.begin(), s.end(), s.key_comp(), s.get_allocator());
+}
+
+}  // namespace gd
+
+#endif  // !__MY_FROZEN_SET__H
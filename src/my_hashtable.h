@@ -0,0 +1,772 @@
+#ifndef __MY_HASHTABLE__H
+#define __MY_HASHTABLE__H
+
+#include <cstddef>  // for max_align_t
+#include <cstdint>  // for int8_t, uint32_t, uint64_t
+#include <cstring>  // for memset, memcpy
+#include <tuple>
+#include <utility>
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_iterator.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace gd {
+
+// 开放寻址哈希表（swiss table）
+// 所有元素放在一块连续的 slot 数组中，另有一个控制字节数组，每个 slot 对应一个控制字节：
+//   空位为 __ctrl_empty，删除后留下的墓碑为 __ctrl_deleted，
+//   有元素时为哈希值的低 7 位（H2，0~127），控制字节数组最后额外有一个 __ctrl_sentinel 供迭代器停下
+// 每 16 个 slot 为一组，查找时用 SSE2 一次比较一整组的控制字节，只有 H2 相同的 slot 才需要真正比较 key，
+// 组内出现空位就说明 key 不存在，所以绝大多数查找只访问一组控制字节和一个 slot
+typedef int8_t ctrl_t;
+
+enum : ctrl_t { __ctrl_empty = -128, __ctrl_deleted = -2, __ctrl_sentinel = -1 };
+
+enum { __HASH_GROUP_WIDTH = 16 };  // 每组 slot 的个数
+
+inline bool __ctrl_is_full(ctrl_t c) {
+  return c >= 0;
+}
+
+// 最低位的 1 的位置，mask 不能为 0
+inline unsigned __hash_ctz(uint32_t mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (unsigned)index;
+#else
+  return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// 一组控制字节，match 系列函数返回位掩码，第 i 位为 1 表示组内第 i 个 slot 符合条件
+struct __hash_group {
+#ifdef __SSE2__
+  __m128i ctrl;
+
+  explicit __hash_group(const ctrl_t* p) : ctrl(_mm_loadu_si128((const __m128i*)p)) {}
+
+  uint32_t match(ctrl_t h2) const {
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+  }
+
+  uint32_t match_empty() const {
+    return match(__ctrl_empty);
+  }
+
+  // 空位和墓碑都小于 __ctrl_sentinel
+  uint32_t match_empty_or_deleted() const {
+    return (uint32_t)_mm_movemask_epi8(_mm_cmplt_epi8(ctrl, _mm_set1_epi8(__ctrl_sentinel)));
+  }
+#else
+  // 没有 SSE2 时逐个字节比较
+  const ctrl_t* ctrl;
+
+  explicit __hash_group(const ctrl_t* p) : ctrl(p) {}
+
+  uint32_t match(ctrl_t h2) const {
+    uint32_t mask = 0;
+    for (int i = 0; i < __HASH_GROUP_WIDTH; ++i)
+      if (ctrl[i] == h2)
+        mask |= 1u << i;
+    return mask;
+  }
+
+  uint32_t match_empty() const {
+    return match(__ctrl_empty);
+  }
+
+  uint32_t match_empty_or_deleted() const {
+    uint32_t mask = 0;
+    for (int i = 0; i < __HASH_GROUP_WIDTH; ++i)
+      if (ctrl[i] < __ctrl_sentinel)
+        mask |= 1u << i;
+    return mask;
+  }
+#endif
+};
+
+// 空表共用的控制字节，只有一个哨兵，这样空表不需要申请内存，begin() 也能直接停在 end()
+inline ctrl_t* __hash_empty_ctrl() {
+  static ctrl_t ctrl[1] = {__ctrl_sentinel};
+  return ctrl;
+}
+
+// 对用户的哈希值再做一次混合，std::hash<int> 这类恒等哈希的低位和高位都会变得足够随机
+inline size_t __hash_mix(size_t h) {
+  uint64_t x = h;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+template <typename Value, typename Ref, typename Ptr>
+struct _hashtable_iterator {
+  typedef Value                value_type;
+  typedef Ref                  reference;
+  typedef Ptr                  pointer;
+  typedef ptrdiff_t            difference_type;
+  typedef forward_iterator_tag iterator_category;
+
+  typedef _hashtable_iterator                                    self;
+  typedef _hashtable_iterator<Value, Value&, Value*>             iterator;
+  typedef _hashtable_iterator<Value, const Value&, const Value*> const_iterator;
+
+  const ctrl_t* ctrl;  // 所指 slot 的控制字节
+  Value*        slot;  // 所指 slot
+
+  _hashtable_iterator() : ctrl(0), slot(0) {}
+  _hashtable_iterator(const ctrl_t* c, Value* s) : ctrl(c), slot(s) {}
+  _hashtable_iterator(const iterator& rhs) : ctrl(rhs.ctrl), slot(rhs.slot) {}
+
+  reference operator*() const {
+    return *slot;
+  }
+
+  pointer operator->() const {
+    return slot;
+  }
+
+  // 跳过空位和墓碑，停在下一个元素或者末尾的哨兵上
+  void skip_empty_or_deleted() {
+    while (*ctrl < __ctrl_sentinel) {
+      ++ctrl;
+      ++slot;
+    }
+  }
+
+  self& operator++() {
+    ++ctrl;
+    ++slot;
+    skip_empty_or_deleted();
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const iterator& rhs) const {
+    return ctrl == rhs.ctrl;
+  }
+
+  bool operator==(const const_iterator& rhs) const {
+    return ctrl == rhs.ctrl;
+  }
+
+  bool operator!=(const iterator& rhs) const {
+    return ctrl != rhs.ctrl;
+  }
+
+  bool operator!=(const const_iterator& rhs) const {
+    return ctrl != rhs.ctrl;
+  }
+};
+
+// slot 数组和控制字节数组放在同一块内存中：前面是 _capacity 个 slot，后面是 _capacity + 1 个控制字节
+// _capacity 为 0 或者 16 以上的 2 的幂，最大负载为 7/8
+// 私有继承 simple_alloc<char, Alloc>，Alloc 有状态时每个哈希表保存自己的配置器
+template <typename Key, typename Value, typename KeyOfValue, typename Hash, typename KeyEqual, typename Alloc = alloc>
+class hashtable : private simple_alloc<char, Alloc> {
+ public:
+  typedef Key               key_type;
+  typedef Value             value_type;
+  typedef Hash              hasher;
+  typedef KeyEqual          key_equal;
+  typedef value_type*       pointer;
+  typedef const value_type* const_pointer;
+  typedef value_type&       reference;
+  typedef const value_type& const_reference;
+  typedef size_t            size_type;
+  typedef ptrdiff_t         difference_type;
+
+  typedef _hashtable_iterator<value_type, reference, pointer>             iterator;
+  typedef _hashtable_iterator<value_type, const_reference, const_pointer> const_iterator;
+
+  typedef simple_alloc<Value, Alloc> allocator_type;
+  typedef simple_alloc<char, Alloc>  byte_allocator;
+
+  allocator_type get_allocator() const {
+    return _get_alloc();
+  }
+
+ protected:
+  ctrl_t*   _ctrl;
+  pointer   _slots;
+  size_type _capacity;
+  size_type _size;
+  size_type _growth_left;  // 不超过最大负载的前提下还能占用的空位数，墓碑不算空位
+  Hash      _hash;
+  KeyEqual  _key_equal;
+
+  byte_allocator& _get_alloc() noexcept {
+    return *this;
+  }
+
+  const byte_allocator& _get_alloc() const noexcept {
+    return *this;
+  }
+
+  static size_type _max_load(size_type cap) {
+    return cap - cap / 8;
+  }
+
+  // 容纳 n 个元素所需的最小容量
+  static size_type _capacity_for(size_type n) {
+    if (n == 0)
+      return 0;
+    size_type cap = __HASH_GROUP_WIDTH;
+    while (_max_load(cap) < n)
+      cap *= 2;
+    return cap;
+  }
+
+  // slot 数组之后紧跟控制字节，总大小按 max_align_t 取整，arena_alloc 这类根据大小推断对齐的配置器也能正确对齐
+  static size_type _alloc_size(size_type cap) {
+    size_type bytes = cap * sizeof(value_type) + cap + 1;
+    return (bytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+  }
+
+  static const key_type& _key(const value_type& v) {
+    return KeyOfValue()(v);
+  }
+
+  size_type _hash_of(const key_type& k) const {
+    return __hash_mix(_hash(k));
+  }
+
+  // 高位决定从哪一组开始探测，低 7 位存进控制字节
+  static size_type _h1(size_type h) {
+    return h >> 7;
+  }
+
+  static ctrl_t _h2(size_type h) {
+    return (ctrl_t)(h & 0x7f);
+  }
+
+ private:  // helper functions
+  void __empty_init() {
+    _ctrl = __hash_empty_ctrl();
+    _slots = 0;
+    _capacity = 0;
+    _size = 0;
+    _growth_left = 0;
+  }
+
+  // 申请容量为 cap 的空表，cap 不能为 0，原来的内存需要调用者处理
+  void __init_storage(size_type cap) {
+    char* p = _get_alloc().allocate(_alloc_size(cap));
+    _slots = (pointer)p;
+    _ctrl = (ctrl_t*)(p + cap * sizeof(value_type));
+    memset(_ctrl, __ctrl_empty, cap);
+    _ctrl[cap] = __ctrl_sentinel;
+    _capacity = cap;
+    _size = 0;
+    _growth_left = _max_load(cap);
+  }
+
+  void __deallocate() {
+    if (_capacity != 0)
+      _get_alloc().deallocate((char*)_slots, _alloc_size(_capacity));
+  }
+
+  void __destroy_slots() {
+    for (size_type i = 0; i != _capacity; ++i)
+      if (__ctrl_is_full(_ctrl[i]))
+        gd::destroy(_slots + i);
+  }
+
+  // 按组三角探测：第 i 次探测的组号为 start + i * (i + 1) / 2，组数为 2 的幂时能遍历所有组
+  // 返回 key 所在的下标，不存在时返回 _capacity
+  template <typename K>
+  size_type __find_index(const K& k, size_type h) const {
+    if (_capacity == 0)
+      return 0;
+    size_type mask = _capacity / __HASH_GROUP_WIDTH - 1;
+    size_type group = _h1(h) & mask;
+    ctrl_t    h2 = _h2(h);
+    for (size_type step = 1;; ++step) {
+      size_type    base = group * __HASH_GROUP_WIDTH;
+      __hash_group g(_ctrl + base);
+      for (uint32_t m = g.match(h2); m != 0; m &= m - 1) {
+        size_type i = base + __hash_ctz(m);
+        if (_key_equal(_key(_slots[i]), k))
+          return i;
+      }
+      if (g.match_empty() != 0)
+        return _capacity;
+      group = (group + step) & mask;
+    }
+  }
+
+  // 沿探测序列找到第一个空位或墓碑，调用前表中必须有空位
+  size_type __find_insert_index(size_type h) const {
+    size_type mask = _capacity / __HASH_GROUP_WIDTH - 1;
+    size_type group = _h1(h) & mask;
+    for (size_type step = 1;; ++step) {
+      size_type base = group * __HASH_GROUP_WIDTH;
+      uint32_t  m = __hash_group(_ctrl + base).match_empty_or_deleted();
+      if (m != 0)
+        return base + __hash_ctz(m);
+      group = (group + step) & mask;
+    }
+  }
+
+  // 不扩容时哈希值为 h 的新元素的位置，需要扩容时返回 _capacity
+  size_type __insert_index(size_type h) const {
+    if (_capacity == 0)
+      return _capacity;
+    size_type i = __find_insert_index(h);
+    return _growth_left != 0 || _ctrl[i] == __ctrl_deleted ? i : _capacity;
+  }
+
+  // 扩容后返回哈希值为 h 的新元素的位置，所有元素都会搬移，调用者不能再持有元素的引用
+  size_type __grow(size_type h) {
+    if (_capacity == 0)
+      __rehash(__HASH_GROUP_WIDTH);
+    else  // 墓碑太多时按原容量重建即可，否则容量翻倍
+      __rehash(_size + 1 <= _max_load(_capacity) / 2 ? _capacity : _capacity * 2);
+    return __find_insert_index(h);
+  }
+
+  // 元素已经在下标 i 处构造好，登记到控制字节中
+  void __commit_insert(size_type i, size_type h) {
+    if (_ctrl[i] == __ctrl_empty)
+      --_growth_left;
+    _ctrl[i] = _h2(h);
+    ++_size;
+  }
+
+  // 删除下标 i 处的元素，所在组有空位时说明没有探测经过这一组，可以直接置为空位，否则留下墓碑
+  void __erase_index(size_type i) {
+    gd::destroy(_slots + i);
+    --_size;
+    size_type base = i / __HASH_GROUP_WIDTH * __HASH_GROUP_WIDTH;
+    if (__hash_group(_ctrl + base).match_empty() != 0) {
+      _ctrl[i] = __ctrl_empty;
+      ++_growth_left;
+    } else {
+      _ctrl[i] = __ctrl_deleted;
+    }
+  }
+
+  // 搬到容量为 new_cap 的新空间，同时清掉所有墓碑
+  // 元素的移动构造不抛异常时才移动，否则复制，复制失败时原表保持不变
+  void __rehash(size_type new_cap) {
+    ctrl_t*   old_ctrl = _ctrl;
+    pointer   old_slots = _slots;
+    size_type old_cap = _capacity;
+    size_type old_size = _size;
+    size_type old_growth_left = _growth_left;
+
+    __init_storage(new_cap);
+    size_type i = 0;
+    try {
+      for (; i != old_cap; ++i) {
+        if (__ctrl_is_full(old_ctrl[i])) {
+          size_type h = _hash_of(_key(old_slots[i]));
+          size_type j = __find_insert_index(h);
+          gd::construct(_slots + j, std::move_if_noexcept(old_slots[i]));
+          __commit_insert(j, h);
+        }
+      }
+    } catch (...) {
+      __destroy_slots();
+      __deallocate();
+      _ctrl = old_ctrl;
+      _slots = old_slots;
+      _capacity = old_cap;
+      _size = old_size;
+      _growth_left = old_growth_left;
+      throw;
+    }
+
+    for (i = 0; i != old_cap; ++i)
+      if (__ctrl_is_full(old_ctrl[i]))
+        gd::destroy(old_slots + i);
+    if (old_cap != 0)
+      _get_alloc().deallocate((char*)old_slots, _alloc_size(old_cap));
+  }
+
+  // 拷贝 rhs 的所有元素，每个元素放在与 rhs 相同的下标处，不需要重新计算哈希值，调用前本表不持有内存
+  void __copy_from(const hashtable& rhs) {
+    if (rhs._size == 0)
+      return;
+    __init_storage(rhs._capacity);
+    size_type i = 0;
+    try {
+      for (; i != _capacity; ++i)
+        if (__ctrl_is_full(rhs._ctrl[i]))
+          gd::construct(_slots + i, rhs._slots[i]);
+    } catch (...) {
+      for (size_type j = 0; j != i; ++j)
+        if (__ctrl_is_full(rhs._ctrl[j]))
+          gd::destroy(_slots + j);
+      __deallocate();
+      __empty_init();
+      throw;
+    }
+    memcpy(_ctrl, rhs._ctrl, _capacity);
+    _size = rhs._size;
+    _growth_left = rhs._growth_left;
+  }
+
+  // 接管 rhs 的内存，调用前本表不持有内存
+  void __steal(hashtable& rhs) noexcept {
+    _ctrl = rhs._ctrl;
+    _slots = rhs._slots;
+    _capacity = rhs._capacity;
+    _size = rhs._size;
+    _growth_left = rhs._growth_left;
+    rhs.__empty_init();
+  }
+
+  // 配置器不相等时，rhs 的内存不能由本表释放，只能逐个移动元素，调用前本表为空
+  void __move_elements(hashtable& rhs) {
+    reserve(rhs._size);
+    for (iterator it = rhs.begin(); it != rhs.end(); ++it)
+      insert_unique(std::move(*it));
+  }
+
+  void __release() {
+    __destroy_slots();
+    __deallocate();
+    __empty_init();
+  }
+
+  void __move_assign(hashtable& rhs, std::true_type) {
+    __release();
+    gd::__alloc_on_move(_get_alloc(), rhs._get_alloc());
+    _hash = rhs._hash;
+    _key_equal = rhs._key_equal;
+    __steal(rhs);
+  }
+
+  void __move_assign(hashtable& rhs, std::false_type) {
+    if (_get_alloc() == rhs._get_alloc()) {
+      __move_assign(rhs, std::true_type());
+    } else {
+      clear();
+      _hash = rhs._hash;
+      _key_equal = rhs._key_equal;
+      __move_elements(rhs);
+    }
+  }
+
+ public:  // constructors, copy, destructors
+  hashtable() : _hash(), _key_equal() {
+    __empty_init();
+  }
+
+  explicit hashtable(size_type n, const Hash& hf = Hash(), const KeyEqual& eql = KeyEqual(),
+                     const allocator_type& a = allocator_type())
+      : byte_allocator(a), _hash(hf), _key_equal(eql) {
+    __empty_init();
+    reserve(n);
+  }
+
+  // 拷贝时配置器由 select_on_container_copy_construction() 决定
+  hashtable(const hashtable& rhs)
+      : byte_allocator(rhs._get_alloc().select_on_container_copy_construction()), _hash(rhs._hash),
+        _key_equal(rhs._key_equal) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  hashtable(const hashtable& rhs, const allocator_type& a)
+      : byte_allocator(a), _hash(rhs._hash), _key_equal(rhs._key_equal) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  // 移动时配置器随内存一起转移
+  hashtable(hashtable&& rhs) noexcept
+      : byte_allocator(std::move(rhs._get_alloc())), _hash(rhs._hash), _key_equal(rhs._key_equal) {
+    __empty_init();
+    __steal(rhs);
+  }
+
+  hashtable(hashtable&& rhs, const allocator_type& a) : byte_allocator(a), _hash(rhs._hash), _key_equal(rhs._key_equal) {
+    __empty_init();
+    if (_get_alloc() == rhs._get_alloc()) {
+      __steal(rhs);
+    } else {
+      try {
+        __move_elements(rhs);
+      } catch (...) {
+        __release();
+        throw;
+      }
+    }
+  }
+
+  hashtable& operator=(const hashtable& rhs) {
+    if (this != &rhs) {
+      // 先用旧的配置器释放所有内存，再按需要换成 rhs 的配置器
+      __release();
+      gd::__alloc_on_copy(_get_alloc(), rhs._get_alloc());
+      _hash = rhs._hash;
+      _key_equal = rhs._key_equal;
+      __copy_from(rhs);
+    }
+    return *this;
+  }
+
+  hashtable& operator=(hashtable&& rhs) {
+    if (this != &rhs)
+      __move_assign(rhs, __alloc_move_steals<byte_allocator>());
+    return *this;
+  }
+
+  ~hashtable() {
+    __destroy_slots();
+    __deallocate();
+  }
+
+ public:  // iterator
+  iterator begin() noexcept {
+    iterator it(_ctrl, _slots);
+    it.skip_empty_or_deleted();
+    return it;
+  }
+
+  const_iterator begin() const noexcept {
+    const_iterator it(_ctrl, _slots);
+    it.skip_empty_or_deleted();
+    return it;
+  }
+
+  iterator end() noexcept {
+    return iterator(_ctrl + _capacity, _slots + _capacity);
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator(_ctrl + _capacity, _slots + _capacity);
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  size_type size() const noexcept {
+    return _size;
+  }
+
+  size_type max_size() const noexcept {
+    return size_type(-1) / (sizeof(value_type) + 1);
+  }
+
+  // 不扩容时最多能容纳的元素个数
+  size_type capacity() const noexcept {
+    return _max_load(_capacity);
+  }
+
+ public:  // hash policy
+  float load_factor() const noexcept {
+    return _capacity == 0 ? 0.0f : (float)_size / (float)_capacity;
+  }
+
+  float max_load_factor() const noexcept {
+    return 0.875f;
+  }
+
+  // 容量调整为能容纳 max(n, size()) 个元素的最小值，同时清掉所有墓碑
+  void rehash(size_type n) {
+    size_type cap = _capacity_for(n > _size ? n : _size);
+    if (cap == 0)
+      __release();
+    else
+      __rehash(cap);
+  }
+
+  // 保证插入 n 个元素之前不会扩容
+  void reserve(size_type n) {
+    if (n > _size + _growth_left)
+      __rehash(_capacity_for(n));
+  }
+
+ public:  // modify
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_unique(Args&&... args) {
+    // 需要先构造出元素才能拿到 key
+    value_type v(std::forward<Args>(args)...);
+    return insert_unique(std::move(v));
+  }
+
+  std::pair<iterator, bool> insert_unique(const value_type& value) {
+    return __insert_unique(value);
+  }
+
+  std::pair<iterator, bool> insert_unique(value_type&& value) {
+    return __insert_unique(std::move(value));
+  }
+
+  template <typename InputIterator>
+  void insert_unique(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert_unique(*first);
+  }
+
+  // key 不存在时用 k 和 args 构造新元素，operator[] 使用
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& k, Args&&... args) {
+    size_type h = _hash_of(k);
+    size_type i = __find_index(k, h);
+    if (i != _capacity)
+      return std::make_pair(iterator(_ctrl + i, _slots + i), false);
+    i = __insert_index(h);
+    if (i == _capacity) {
+      // 参数可能引用表中的元素，扩容会搬移它们，所以先构造出新元素
+      value_type v(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+      i = __grow(h);
+      gd::construct(_slots + i, std::move(v));
+    } else {
+      gd::construct(_slots + i, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    __commit_insert(i, h);
+    return std::make_pair(iterator(_ctrl + i, _slots + i), true);
+  }
+
+  void erase(const_iterator pos) {
+    __erase_index(pos.slot - _slots);
+  }
+
+  size_type erase(const key_type& k) {
+    size_type i = __find_index(k, _hash_of(k));
+    if (i == _capacity)
+      return 0;
+    __erase_index(i);
+    return 1;
+  }
+
+  void erase(const_iterator first, const_iterator last) {
+    while (first != last)
+      erase(first++);
+  }
+
+  // 只销毁元素，保留内存
+  void clear() {
+    if (_size == 0)
+      return;
+    __destroy_slots();
+    memset(_ctrl, __ctrl_empty, _capacity);
+    _size = 0;
+    _growth_left = _max_load(_capacity);
+  }
+
+  void swap(hashtable& rhs) {
+    std::swap(_ctrl, rhs._ctrl);
+    std::swap(_slots, rhs._slots);
+    std::swap(_capacity, rhs._capacity);
+    std::swap(_size, rhs._size);
+    std::swap(_growth_left, rhs._growth_left);
+    std::swap(_hash, rhs._hash);
+    std::swap(_key_equal, rhs._key_equal);
+    gd::__alloc_on_swap(_get_alloc(), rhs._get_alloc());
+  }
+
+ private:
+  template <typename V>
+  std::pair<iterator, bool> __insert_unique(V&& value) {
+    const key_type& k = _key(value);
+    size_type       h = _hash_of(k);
+    size_type       i = __find_index(k, h);
+    if (i != _capacity)
+      return std::make_pair(iterator(_ctrl + i, _slots + i), false);
+    i = __insert_index(h);
+    if (i == _capacity) {
+      // value 可能引用表中的元素，扩容会搬移它们，所以先构造出新元素
+      value_type v(std::forward<V>(value));
+      i = __grow(h);
+      gd::construct(_slots + i, std::move(v));
+    } else {
+      gd::construct(_slots + i, std::forward<V>(value));
+    }
+    __commit_insert(i, h);
+    return std::make_pair(iterator(_ctrl + i, _slots + i), true);
+  }
+
+ public:  // observers
+  hasher hash_function() const {
+    return _hash;
+  }
+
+  key_equal key_eq() const {
+    return _key_equal;
+  }
+
+ public:  // lookup
+  iterator find(const key_type& k) {
+    size_type i = __find_index(k, _hash_of(k));
+    return iterator(_ctrl + i, _slots + i);
+  }
+
+  const_iterator find(const key_type& k) const {
+    size_type i = __find_index(k, _hash_of(k));
+    return const_iterator(_ctrl + i, _slots + i);
+  }
+
+  size_type count(const key_type& k) const {
+    return __find_index(k, _hash_of(k)) == _capacity ? 0 : 1;
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) {
+    iterator first = find(k);
+    if (first == end())
+      return std::make_pair(first, first);
+    iterator last = first;
+    return std::make_pair(first, ++last);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    const_iterator first = find(k);
+    if (first == end())
+      return std::make_pair(first, first);
+    const_iterator last = first;
+    return std::make_pair(first, ++last);
+  }
+};
+
+// 元素个数相同，并且 lhs 的每个元素都能在 rhs 中找到相等的元素
+template <typename Key, typename Value, typename KeyOfValue, typename Hash, typename KeyEqual, typename Alloc>
+inline bool operator==(const hashtable<Key, Value, KeyOfValue, Hash, KeyEqual, Alloc>& lhs,
+                       const hashtable<Key, Value, KeyOfValue, Hash, KeyEqual, Alloc>& rhs) {
+  if (lhs.size() != rhs.size())
+    return false;
+  for (auto it = lhs.begin(); it != lhs.end(); ++it) {
+    auto jt = rhs.find(KeyOfValue()(*it));
+    if (jt == rhs.end() || !(*it == *jt))
+      return false;
+  }
+  return true;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Hash, typename KeyEqual, typename Alloc>
+inline bool operator!=(const hashtable<Key, Value, KeyOfValue, Hash, KeyEqual, Alloc>& lhs,
+                       const hashtable<Key, Value, KeyOfValue, Hash, KeyEqual, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Hash, typename KeyEqual, typename Alloc>
+inline void swap(hashtable<Key, Value, KeyOfValue, Hash, KeyEqual, Alloc>& lhs,
+                 hashtable<Key, Value, KeyOfValue, Hash, KeyEqual, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_HASHTABLE__H
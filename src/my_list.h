@@ -2,7 +2,9 @@
 #define __MY_LIST_H
 
 #include <algorithm>
+#include <functional>
 #include <initializer_list>
+#include <type_traits>
 #include "my_alloc.h"
 #include "my_iterator.h"
 
@@ -141,8 +143,9 @@ struct list_const_iterator : public iterator<bidirectional_iterator_tag, T> {
   }
 };
 
+// 私有继承 node_allocator，Alloc 有状态时每个 list 保存自己的配置器
 template <typename T, typename Alloc = alloc>
-class list {
+class list : private simple_alloc<list_node<T>, Alloc> {
  public:  // 内嵌性别定义
   typedef T                 value_type;
   typedef value_type*       pointer;
@@ -157,14 +160,23 @@ class list {
   typedef list_node<T>           l_node;
   typedef l_node*                link_type;
 
+  typedef simple_alloc<T, Alloc> allocator_type;
+
  protected:
-  typedef simple_alloc<T, Alloc>      allocator_type;
   typedef simple_alloc<T, Alloc>      data_allocator;
   typedef simple_alloc<l_node, Alloc> node_allocator;
 
   link_type _node;  // 指向双向环状链表的头节点
   size_type _size;  // 大小
 
+  node_allocator& _get_alloc() noexcept {
+    return *this;
+  }
+
+  const node_allocator& _get_alloc() const noexcept {
+    return *this;
+  }
+
   link_type _get_node() {
     return node_allocator::allocate();
   }
@@ -375,34 +387,83 @@ class list {
     __fill_init(0, value_type());
   }
 
+  explicit list(const allocator_type& a) : node_allocator(a) {
+    __fill_init(0, value_type());
+  }
+
   explicit list(size_type n) {
     __fill_init(n, value_type());
   }
 
+  list(size_type n, const allocator_type& a) : node_allocator(a) {
+    __fill_init(n, value_type());
+  }
+
   list(size_type n, const_reference value) {
     __fill_init(n, value);
   }
 
+  list(size_type n, const_reference value, const allocator_type& a) : node_allocator(a) {
+    __fill_init(n, value);
+  }
+
   // TODO(dong): 下面这个模板初始化函数和上面的函数冲突了！e.g., list(6, 8) 会调用下面这个，而非上面的
   template <typename InputIterator>
   list(InputIterator first, InputIterator last) {
     __copy_init(first, last);
   }
 
+  template <typename InputIterator>
+  list(InputIterator first, InputIterator last, const allocator_type& a) : node_allocator(a) {
+    __copy_init(first, last);
+  }
+
   list(std::initializer_list<value_type> il) {
     __copy_init(il.begin(), il.end());
   }
 
-  list(const list& rhs) {
+  list(std::initializer_list<value_type> il, const allocator_type& a) : node_allocator(a) {
+    __copy_init(il.begin(), il.end());
+  }
+
+  // 拷贝时配置器由 select_on_container_copy_construction() 决定
+  list(const list& rhs) : node_allocator(rhs._get_alloc().select_on_container_copy_construction()) {
+    __copy_init(rhs.cbegin(), rhs.cend());
+  }
+
+  list(const list& rhs, const allocator_type& a) : node_allocator(a) {
     __copy_init(rhs.cbegin(), rhs.cend());
   }
 
-  list(list&& rhs) noexcept : _node(rhs._node), _size(rhs._size) {
+  // 移动时配置器随节点一起转移
+  list(list&& rhs) noexcept : node_allocator(std::move(rhs._get_alloc())), _node(rhs._node), _size(rhs._size) {
     // 一定要记得将 rhs._node 置为空！不然 rhs 析构的时候会 deallocate 已经被移走的资源
     rhs._node = 0;
     rhs._size = 0;
   }
 
+  list(list&& rhs, const allocator_type& a) : node_allocator(a) {
+    if (_get_alloc() == rhs._get_alloc()) {
+      _node = rhs._node;
+      _size = rhs._size;
+      rhs._node = 0;
+      rhs._size = 0;
+    } else {
+      // 配置器不相等，节点不能由本 list 释放，只能逐个移动元素
+      _node = _get_node();
+      _node->_next = _node->_prev = _node;
+      _size = 0;
+      try {
+        for (iterator it = rhs.begin(); it != rhs.end(); ++it)
+          emplace_back(std::move(*it));
+      } catch (...) {
+        clear();
+        _put_node(_node);
+        throw;
+      }
+    }
+  }
+
   void assign(size_type n, const_reference value) {
     __fill_assign(n, value);
   }
@@ -419,14 +480,24 @@ class list {
 
   list& operator=(const list& rhs) {
     if (this != &rhs) {
+      if (node_allocator::propagate_on_container_copy_assignment::value && _get_alloc() != rhs._get_alloc()) {
+        // 新的配置器不能释放旧的节点，先用旧的配置器全部释放掉，头节点也要换成新配置器分配的
+        node_allocator a(rhs._get_alloc());
+        link_type      node = a.allocate();
+        clear();
+        _put_node(_node);
+        _node = node;
+        _node->_next = _node->_prev = _node;
+      }
+      gd::__alloc_on_copy(_get_alloc(), rhs._get_alloc());
       assign(rhs.begin(), rhs.end());
     }
     return *this;
   }
 
   list& operator=(list&& rhs) {
-    clear();
-    splice(end(), rhs);
+    if (this != &rhs)
+      __move_assign(rhs, __alloc_move_steals<node_allocator>());
     return *this;
   }
 
@@ -441,7 +512,38 @@ class list {
   }
 
   allocator_type get_allocator() const {
-    return node_allocator();
+    return _get_alloc();
+  }
+
+ private:  // move helpers
+  // 配置器会传播或者总是相等，节点直接交换过来，rhs 留下本 list 已经清空的头节点，
+  // 配置器传播时也要一起交换，这样头节点仍由分配它的配置器释放
+  void __move_assign(list& rhs, std::true_type) {
+    clear();
+    std::swap(_node, rhs._node);
+    std::swap(_size, rhs._size);
+    gd::__alloc_on_swap(_get_alloc(), rhs._get_alloc(),
+                    typename node_allocator::propagate_on_container_move_assignment());
+  }
+
+  // 配置器不相等时节点不能在两个 list 间转移，只能逐个移动元素
+  void __move_assign(list& rhs, std::false_type) {
+    if (_get_alloc() == rhs._get_alloc()) {
+      __move_assign(rhs, std::true_type());
+      return;
+    }
+    iterator f_it = begin();
+    iterator l_it = end();
+    iterator first = rhs.begin();
+    iterator last = rhs.end();
+    for (; f_it != l_it && first != last; ++f_it, ++first)
+      *f_it = std::move(*first);
+    if (f_it == l_it) {
+      for (; first != last; ++first)
+        emplace_back(std::move(*first));
+    } else {
+      erase(f_it, l_it);
+    }
   }
 
  public:  // iterators
@@ -622,6 +724,7 @@ class list {
   void swap(list& rhs) {
     std::swap(_node, rhs._node);
     std::swap(_size, rhs._size);
+    gd::__alloc_on_swap(_get_alloc(), rhs._get_alloc());
   }
 
   void clear() noexcept {
@@ -772,33 +875,7 @@ class list {
   }
 
   void sort() {
-    // 归并排序
-    if (_size <= 1)
-      return;
-
-    list<T, Alloc> carry;
-    list<T, Alloc> counter[64];
-    int            fill = 0;
-    while (!empty()) {
-      carry.splice(carry.begin(), *this, begin());
-      int i = 0;
-      while (i < fill && !counter[i].empty()) {
-        // 将 carry 合并到第 i 个 counter 上
-        counter[i].merge(carry);
-        // 再将合并后的链表放到 carry 当中，并把 i 加一
-        // 直到合并到填充过的 counter, 或者当前 counter 空为止，有点像网络编程中的 select, poll
-        carry.swap(counter[i++]);
-        // CPRINT(carry, display_int);
-      }
-      carry.swap(counter[i]);
-      // 如果 i == fill，就代表又多用了一个 counter，所以要把 fill 加一
-      if (i == fill)
-        ++fill;
-    }
-    for (int i = 1; i < fill; ++i) {
-      counter[i].merge(counter[i - 1]);
-    }
-    swap(counter[fill - 1]);
+    sort(std::less<value_type>());
   }
 
   template <typename Compare>
@@ -807,28 +884,39 @@ class list {
     if (_size <= 1)
       return;
 
-    list<T, Alloc> carry;
-    list<T, Alloc> counter[64];
-    int            fill = 0;
-    while (!empty()) {
-      carry.splice(carry.begin(), *this, begin());
-      int i = 0;
-      while (i < fill && !counter[i].empty()) {
-        // 将 carry 合并到第 i 个 counter 上
-        counter[i].merge(carry, comp);
-        // 再将合并后的链表放到 carry 当中，并把 i 加一
-        // 直到合并到填充过的 counter, 或者当前 counter 空为止，有点像网络编程中的 select, poll
-        carry.swap(counter[i++]);
+    // carry 和 counter 都要用本 list 的配置器构造，所以 counter 不能是普通的数组，
+    // 这里在一块原始内存上用到第几个才构造第几个
+    list carry(get_allocator());
+    typename std::aligned_storage<sizeof(list), alignof(list)>::type buf[64];
+    list* counter = reinterpret_cast<list*>(buf);
+    int   fill = 0;
+    try {
+      while (!empty()) {
+        carry.splice(carry.begin(), *this, begin());
+        int i = 0;
+        while (i < fill && !counter[i].empty()) {
+          // 将 carry 合并到第 i 个 counter 上
+          counter[i].merge(carry, comp);
+          // 再将合并后的链表放到 carry 当中，并把 i 加一
+          // 直到合并到填充过的 counter, 或者当前 counter 空为止，有点像网络编程中的 select, poll
+          carry.swap(counter[i++]);
+        }
+        // 如果 i == fill，就代表又多用了一个 counter，所以要把 fill 加一
+        if (i == fill) {
+          construct(counter + fill, get_allocator());
+          ++fill;
+        }
+        carry.swap(counter[i]);
       }
-      carry.swap(counter[i]);
-      // 如果 i == fill，就代表又多用了一个 counter，所以要把 fill 加一
-      if (i == fill)
-        ++fill;
-    }
-    for (int i = 1; i < fill; ++i) {
-      counter[i].merge(counter[i - 1], comp);
+      for (int i = 1; i < fill; ++i) {
+        counter[i].merge(counter[i - 1], comp);
+      }
+      swap(counter[fill - 1]);
+    } catch (...) {
+      destroy(counter, counter + fill);
+      throw;
     }
-    swap(counter[fill - 1]);
+    destroy(counter, counter + fill);
   }
 
   void reverse() noexcept {
@@ -17,7 +17,11 @@ struct select1st {
   }
 };
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+class multimap;
+
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc,
+          typename Augment = _rb_tree_no_augment>
 class map {
  public:
   typedef Key                     key_type;
@@ -44,10 +48,15 @@ class map {
   };
 
  private:
-  typedef rb_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc> __rep_type;
+  typedef rb_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc, Augment> __rep_type;
   // 底层数据结构
   __rep_type __tree;
 
+  template <typename, typename, typename, typename, typename>
+  friend class map;
+  template <typename, typename, typename, typename, typename>
+  friend class multimap;
+
  public:
   typedef typename __rep_type::pointer         pointer;
   typedef typename __rep_type::const_pointer   const_pointer;
@@ -59,22 +68,50 @@ class map {
   typedef typename __rep_type::difference_type difference_type;
   typedef typename __rep_type::allocator_type  allocator_type;
 
+  typedef _rb_tree_map_node_handle<Key, T, typename __rep_type::node_type, Alloc> node_type;
+  typedef _rb_tree_insert_return<iterator, node_type>                             insert_return_type;
+
  public:  // constructor, copy, destructor
   map() = default;
 
+  explicit map(const Compare& comp, const allocator_type& a = allocator_type()) : __tree(comp, a) {}
+
+  explicit map(const allocator_type& a) : __tree(Compare(), a) {}
+
   template <typename InputIterator>
   map(InputIterator first, InputIterator last) : __tree() {
     __tree.insert_unique(first, last);
   }
 
+  template <typename InputIterator>
+  map(InputIterator first, InputIterator last, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(first, last);
+  }
+
   map(std::initializer_list<value_type> il) : __tree() {
     __tree.insert_unique(il.begin(), il.end());
   }
 
+  map(std::initializer_list<value_type> il, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时线性时间建树，重复的 key 只保留第一个，输入无序时退化为逐个插入
+  template <typename InputIterator>
+  map(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+      const allocator_type& a = allocator_type())
+      : __tree(comp, a) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
   map(const map& rhs) : __tree(rhs.__tree) {}
 
   map(map&& rhs) noexcept : __tree(std::move(rhs.__tree)) {}
 
+  map(const map& rhs, const allocator_type& a) : __tree(rhs.__tree, a) {}
+
+  map(map&& rhs, const allocator_type& a) : __tree(std::move(rhs.__tree), a) {}
+
   map& operator=(const map& rhs) {
     __tree = rhs.__tree;
     return *this;
@@ -91,6 +128,10 @@ class map {
     return *this;
   }
 
+  allocator_type get_allocator() const noexcept {
+    return __tree.get_allocator();
+  }
+
  public:  // iterators
   iterator begin() noexcept {
     return __tree.begin();
@@ -168,6 +209,10 @@ class map {
   }
 
   iterator insert(iterator pos, const value_type& v) {
+    return __tree.insert_unique(pos, v);
+  }
+
+  iterator insert(iterator pos, value_type&& v) {
     return __tree.insert_unique(pos, std::move(v));
   }
 
@@ -176,6 +221,12 @@ class map {
     __tree.insert_unique(first, last);
   }
 
+  // 清空后用有序区间 [first, last) 重建，见有序区间的构造函数
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
   void insert(std::initializer_list<value_type> il) {
     __tree.insert_unique(il.begin(), il.end());
   }
@@ -198,6 +249,75 @@ class map {
     __tree.clear();
   }
 
+ public:  // node handles
+  // 摘下的节点可以改掉 key 再插回来，或者插入到另一个配置器相同的 map、multimap 中，
+  // 整个过程不分配内存，也不拷贝元素
+  node_type extract(iterator pos) {
+    return __tree.template extract<node_type>(pos);
+  }
+
+  node_type extract(const key_type& k) {
+    return __tree.template extract<node_type>(k);
+  }
+
+  // key 已经存在时不插入，节点留在返回值的 node 中
+  insert_return_type insert(node_type&& nh) {
+    std::pair<iterator, bool> res = __tree.insert_node_unique(nh);
+    return insert_return_type{res.first, res.second, std::move(nh)};
+  }
+
+  iterator insert(iterator pos, node_type&& nh) {
+    return __tree.insert_node_unique(pos, nh);
+  }
+
+  // 把 src 中本容器还没有的 key 的节点直接链接过来，src 中只留下 key 重复的元素
+  template <typename Compare2>
+  void merge(map<Key, T, Compare2, Alloc, Augment>& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(map<Key, T, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(multimap<Key, T, Compare2, Alloc, Augment>& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(multimap<Key, T, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+ public:  // join, split and set operations，只移动节点，不分配内存也不拷贝元素，见 rb_tree
+  // 把 key 不小于 k 的元素切下来作为一个新的 map 返回，O(log n)
+  map split(const key_type& k) {
+    return map(__tree.split(k));
+  }
+
+  // rhs 的key都不能排在本容器的前面，连接后 rhs 变为空，O(log n)
+  void join(map& rhs) {
+    __tree.join(rhs.__tree);
+  }
+
+  // 集合运算的结果留在本容器中，rhs 变为空；threads 为最多使用的线程数，为 0 时使用硬件的线程数
+  void set_union(map& rhs, unsigned threads = 0) {
+    __tree.set_union(rhs.__tree, threads);
+  }
+
+  void set_intersection(map& rhs, unsigned threads = 0) {
+    __tree.set_intersection(rhs.__tree, threads);
+  }
+
+  void set_difference(map& rhs, unsigned threads = 0) {
+    __tree.set_difference(rhs.__tree, threads);
+  }
+
+ private:
+  explicit map(__rep_type&& t) : __tree(std::move(t)) {}
+
  public:  // observers
   key_compare key_comp() const {
     return __tree._key_compare();
@@ -207,43 +327,118 @@ class map {
     return value_compare(__tree._key_compare());
   }
 
- public:  // map operations
+ public:  // map operations，Compare 声明了 is_transparent 时也接受能与 key 比较的其他类型，见 rb_tree
   iterator find(const key_type& k) {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& k) {
+    return __tree.find(k);
+  }
+
   const_iterator find(const key_type& k) const {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& k) const {
+    return __tree.find(k);
+  }
+
   size_type count(const key_type& k) const {
     return __tree.count(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count(const K& k) const {
+    return __tree.count(k);
+  }
+
   iterator lower_bound(const key_type& k) {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& k) {
+    return __tree.lower_bound(k);
+  }
+
   const_iterator lower_bound(const key_type& k) const {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& k) const {
+    return __tree.lower_bound(k);
+  }
+
   iterator upper_bound(const key_type& k) {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& k) {
+    return __tree.upper_bound(k);
+  }
+
   const_iterator upper_bound(const key_type& k) const {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& k) const {
+    return __tree.upper_bound(k);
+  }
+
   std::pair<iterator, iterator> equal_range(const key_type& k) {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& k) {
+    return __tree.equal_range(k);
+  }
+
   std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+    return __tree.equal_range(k);
+  }
+
+ public:  // order statistics，只有 Augment 为 order_statistic 时可用
+  // 按 key 的顺序排第 k 个（从 0 开始）的元素，k >= size() 时返回 end()
+  iterator nth(size_type k) {
+    return __tree.nth(k);
+  }
+
+  const_iterator nth(size_type k) const {
+    return __tree.nth(k);
+  }
+
+  // key 小于 k 的元素个数
+  size_type rank(const key_type& k) const {
+    return __tree.rank(k);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type rank(const K& k) const {
+    return __tree.rank(k);
+  }
+
+  // key 在 [lo, hi) 中的元素个数
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count_range(const K& lo, const K& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
   void swap(map& rhs) noexcept {
     __tree.swap(rhs.__tree);
   }
@@ -260,42 +455,43 @@ class map {
 
 // operators:
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator==(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator==(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   return lhs.operator==(rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator!=(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator!=(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator<(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   return lhs.operator<(rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>=(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator>=(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   return !(lhs < rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator>(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   return rhs.operator<(lhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<=(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator<=(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   return !(lhs > rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-void swap(const map<Key, T, Compare, Alloc>& lhs, const map<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+void swap(const map<Key, T, Compare, Alloc, Augment>& lhs, const map<Key, T, Compare, Alloc, Augment>& rhs) {
   lhs.swap(rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc,
+          typename Augment = _rb_tree_no_augment>
 class multimap {
  public:
   typedef Key                     key_type;
@@ -322,10 +518,15 @@ class multimap {
   };
 
  private:
-  typedef rb_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc> __rep_type;
+  typedef rb_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc, Augment> __rep_type;
   // 底层数据结构
   __rep_type __tree;
 
+  template <typename, typename, typename, typename, typename>
+  friend class map;
+  template <typename, typename, typename, typename, typename>
+  friend class multimap;
+
  public:
   typedef typename __rep_type::pointer         pointer;
   typedef typename __rep_type::const_pointer   const_pointer;
@@ -337,22 +538,49 @@ class multimap {
   typedef typename __rep_type::difference_type difference_type;
   typedef typename __rep_type::allocator_type  allocator_type;
 
+  typedef _rb_tree_map_node_handle<Key, T, typename __rep_type::node_type, Alloc> node_type;
+
  public:  // constructor, copy, destructor
   multimap() = default;
 
+  explicit multimap(const Compare& comp, const allocator_type& a = allocator_type()) : __tree(comp, a) {}
+
+  explicit multimap(const allocator_type& a) : __tree(Compare(), a) {}
+
   template <typename InputIterator>
   multimap(InputIterator first, InputIterator last) : __tree() {
     __tree.insert_equal(first, last);
   }
 
+  template <typename InputIterator>
+  multimap(InputIterator first, InputIterator last, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_equal(first, last);
+  }
+
   multimap(std::initializer_list<value_type> il) : __tree() {
     __tree.insert_equal(il.begin(), il.end());
   }
 
+  multimap(std::initializer_list<value_type> il, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_equal(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时线性时间建树，输入无序时退化为逐个插入
+  template <typename InputIterator>
+  multimap(sorted_equivalent_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+           const allocator_type& a = allocator_type())
+      : __tree(comp, a) {
+    __tree.assign_sorted_equal(first, last);
+  }
+
   multimap(const multimap& rhs) : __tree(rhs.__tree) {}
 
   multimap(multimap&& rhs) noexcept : __tree(std::move(rhs.__tree)) {}
 
+  multimap(const multimap& rhs, const allocator_type& a) : __tree(rhs.__tree, a) {}
+
+  multimap(multimap&& rhs, const allocator_type& a) : __tree(std::move(rhs.__tree), a) {}
+
   multimap& operator=(const multimap& rhs) {
     __tree = rhs.__tree;
     return *this;
@@ -369,6 +597,10 @@ class multimap {
     return *this;
   }
 
+  allocator_type get_allocator() const noexcept {
+    return __tree.get_allocator();
+  }
+
  public:  // iterators
   iterator begin() noexcept {
     return __tree.begin();
@@ -427,6 +659,10 @@ class multimap {
   }
 
   iterator insert(iterator pos, const value_type& v) {
+    return __tree.insert_equal(pos, v);
+  }
+
+  iterator insert(iterator pos, value_type&& v) {
     return __tree.insert_equal(pos, std::move(v));
   }
 
@@ -435,6 +671,12 @@ class multimap {
     __tree.insert_equal(first, last);
   }
 
+  // 清空后用有序区间 [first, last) 重建，见有序区间的构造函数
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    __tree.assign_sorted_equal(first, last);
+  }
+
   void insert(std::initializer_list<value_type> il) {
     __tree.insert_equal(il.begin(), il.end());
   }
@@ -457,6 +699,44 @@ class multimap {
     __tree.clear();
   }
 
+ public:  // node handles，见 map
+  node_type extract(iterator pos) {
+    return __tree.template extract<node_type>(pos);
+  }
+
+  node_type extract(const key_type& k) {
+    return __tree.template extract<node_type>(k);
+  }
+
+  iterator insert(node_type&& nh) {
+    return __tree.insert_node_equal(nh);
+  }
+
+  iterator insert(iterator pos, node_type&& nh) {
+    return __tree.insert_node_equal(pos, nh);
+  }
+
+  // src 中的节点全部链接过来，src 变为空
+  template <typename Compare2>
+  void merge(multimap<Key, T, Compare2, Alloc, Augment>& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(multimap<Key, T, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(map<Key, T, Compare2, Alloc, Augment>& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(map<Key, T, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
  public:  // observers
   key_compare key_comp() const {
     return __tree._key_compare();
@@ -466,43 +746,118 @@ class multimap {
     return value_compare(__tree._key_compare());
   }
 
- public:  // map operations
+ public:  // map operations，Compare 声明了 is_transparent 时也接受能与 key 比较的其他类型，见 rb_tree
   iterator find(const key_type& k) {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& k) {
+    return __tree.find(k);
+  }
+
   const_iterator find(const key_type& k) const {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& k) const {
+    return __tree.find(k);
+  }
+
   size_type count(const key_type& k) const {
     return __tree.count(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count(const K& k) const {
+    return __tree.count(k);
+  }
+
   iterator lower_bound(const key_type& k) {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& k) {
+    return __tree.lower_bound(k);
+  }
+
   const_iterator lower_bound(const key_type& k) const {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& k) const {
+    return __tree.lower_bound(k);
+  }
+
   iterator upper_bound(const key_type& k) {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& k) {
+    return __tree.upper_bound(k);
+  }
+
   const_iterator upper_bound(const key_type& k) const {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& k) const {
+    return __tree.upper_bound(k);
+  }
+
   std::pair<iterator, iterator> equal_range(const key_type& k) {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& k) {
+    return __tree.equal_range(k);
+  }
+
   std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+    return __tree.equal_range(k);
+  }
+
+ public:  // order statistics，只有 Augment 为 order_statistic 时可用
+  // 按 key 的顺序排第 k 个（从 0 开始）的元素，k >= size() 时返回 end()
+  iterator nth(size_type k) {
+    return __tree.nth(k);
+  }
+
+  const_iterator nth(size_type k) const {
+    return __tree.nth(k);
+  }
+
+  // key 小于 k 的元素个数
+  size_type rank(const key_type& k) const {
+    return __tree.rank(k);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type rank(const K& k) const {
+    return __tree.rank(k);
+  }
+
+  // key 在 [lo, hi) 中的元素个数
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count_range(const K& lo, const K& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
   void swap(multimap& rhs) noexcept {
     __tree.swap(rhs.__tree);
   }
@@ -519,38 +874,44 @@ class multimap {
 
 // operators:
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator==(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator==(const multimap<Key, T, Compare, Alloc, Augment>& lhs,
+                const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   return lhs.operator==(rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator!=(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator!=(const multimap<Key, T, Compare, Alloc, Augment>& lhs,
+                const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator<(const multimap<Key, T, Compare, Alloc, Augment>& lhs,
+               const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   return lhs.operator<(rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>=(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator>=(const multimap<Key, T, Compare, Alloc, Augment>& lhs,
+                const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   return !(lhs < rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator>(const multimap<Key, T, Compare, Alloc, Augment>& lhs,
+               const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   return rhs.operator<(lhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<=(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+bool operator<=(const multimap<Key, T, Compare, Alloc, Augment>& lhs,
+                const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   return !(lhs > rhs);
 }
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
-void swap(const multimap<Key, T, Compare, Alloc>& lhs, const multimap<Key, T, Compare, Alloc>& rhs) {
+template <typename Key, typename T, typename Compare, typename Alloc, typename Augment>
+void swap(const multimap<Key, T, Compare, Alloc, Augment>& lhs, const multimap<Key, T, Compare, Alloc, Augment>& rhs) {
   lhs.swap(rhs);
 }
 
@@ -0,0 +1,219 @@
+#ifndef __MY_NODE_POOL_H
+#define __MY_NODE_POOL_H
+
+#include <cstddef>  // for max_align_t
+#include <new>      // for placement new
+#include <type_traits>
+#include "my_alloc.h"
+
+namespace gd {
+
+// 只分配一种大小的内存块的池，用于 rb_tree、list 这类逐个分配节点的容器
+// 节点从连续的大块内存（slab）中依次切出，相邻分配的节点在内存中也相邻，释放的节点放进自由链表供下次分配，
+// 所有节点都归还之后（例如容器析构时）整块归还 slab，不再逐个释放
+// 第一次分配的大小就是节点大小，其他大小的分配直接交给 Alloc
+// Alloc 为 alloc、malloc_alloc 这类只有静态成员的配置器；node_pool 不是线程安全的
+template <typename Alloc = alloc>
+class node_pool {
+ public:
+  enum { __FIRST_SLAB = 4096 };    // 第一块 slab 的大小
+  enum { __MAX_SLAB = 1 << 20 };   // 每次申请的大小翻倍，直到这个上限
+  enum { __ALIGN = alignof(std::max_align_t) };
+
+  node_pool() : _node_size(0), _free_list(0), _slabs(0), _cur(0), _end(0), _next_slab(__FIRST_SLAB), _live(0) {}
+
+  node_pool(const node_pool&) = delete;
+  node_pool& operator=(const node_pool&) = delete;
+
+  ~node_pool() {
+    release();
+  }
+
+  void* allocate(size_t n) {
+    if (n != _node_size) {
+      if (_node_size != 0 || n < sizeof(free_node))
+        return Alloc::allocate(n);
+      _node_size = n;  // 对象的大小是其对齐的整数倍，紧挨着切出的节点仍然是对齐的
+    }
+    ++_live;
+    if (_free_list) {
+      free_node* p = _free_list;
+      _free_list = p->next;
+      return p;
+    }
+    if ((size_t)(_end - _cur) < _node_size)
+      __new_slab();
+    void* p = _cur;
+    _cur += _node_size;
+    return p;
+  }
+
+  void deallocate(void* p, size_t n) {
+    if (n != _node_size || _node_size == 0) {
+      Alloc::deallocate(p, n);
+      return;
+    }
+    free_node* q = (free_node*)p;
+    q->next = _free_list;
+    _free_list = q;
+    if (--_live == 0)
+      release();
+  }
+
+  // 正在使用的节点恰好是调用者手上的 n 个时，不必逐个放回自由链表，直接整块归还所有 slab
+  bool deallocate_all(size_t n, size_t size) {
+    if (n == 0 || size != _node_size || n != _live)
+      return false;
+    release();
+    return true;
+  }
+
+  // 整块归还所有 slab，之前分配的节点全部失效
+  void release() {
+    while (_slabs != 0) {
+      slab_header* prev = _slabs->prev;
+      Alloc::deallocate(_slabs, _slabs->size);
+      _slabs = prev;
+    }
+    _free_list = 0;
+    _cur = 0;
+    _end = 0;
+    _next_slab = __FIRST_SLAB;
+    _live = 0;
+  }
+
+  // 正在使用的节点个数
+  size_t live() const {
+    return _live;
+  }
+
+  // 当前持有的 slab 个数
+  size_t slab_count() const {
+    size_t n = 0;
+    for (slab_header* s = _slabs; s != 0; s = s->prev)
+      ++n;
+    return n;
+  }
+
+ private:
+  struct free_node {
+    free_node* next;
+  };
+
+  // 每块 slab 的头部，所有 slab 串成一个链表
+  struct slab_header {
+    slab_header* prev;
+    size_t       size;
+  };
+
+  enum { __HEADER_SIZE = (sizeof(slab_header) + __ALIGN - 1) / __ALIGN * __ALIGN };
+
+  void __new_slab() {
+    size_t need = __HEADER_SIZE + _node_size;
+    size_t size = _next_slab > need ? _next_slab : need;
+    slab_header* s = (slab_header*)Alloc::allocate(size);
+    s->prev = _slabs;
+    s->size = size;
+    _slabs = s;
+    if (_next_slab < (size_t)__MAX_SLAB)
+      _next_slab *= 2;
+    _cur = (char*)s + __HEADER_SIZE;
+    _end = (char*)s + size;
+  }
+
+  size_t       _node_size;  // 为 0 时还没有分配过
+  free_node*   _free_list;
+  slab_header* _slabs;      // 最近申请的 slab
+  char*        _cur;        // 当前 slab 中下一个节点的位置
+  char*        _end;        // 当前 slab 的结尾
+  size_t       _next_slab;  // 下一块 slab 的大小
+  size_t       _live;       // 正在使用的节点个数
+};
+
+// 每个容器实例一个 node_pool 的配置器，可以作为 list、map、set 等的 Alloc 参数，例如：
+//   gd::map<int, int, std::less<int>, gd::node_pool_alloc<>> m;
+// 同一个容器内的配置器拷贝共享同一个池（引用计数），池在第一次分配时创建，最后一个拷贝析构时销毁；
+// 拷贝构造容器时新容器使用新的池，移动赋值和交换时池随节点一起转移
+template <typename Alloc = alloc>
+class node_pool_alloc {
+ public:
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::true_type  propagate_on_container_move_assignment;
+  typedef std::true_type  propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  node_pool_alloc() noexcept : _pool(0) {}
+
+  node_pool_alloc(const node_pool_alloc& rhs) noexcept : _pool(rhs._pool) {
+    if (_pool)
+      ++_pool->refs;
+  }
+
+  node_pool_alloc& operator=(const node_pool_alloc& rhs) noexcept {
+    if (rhs._pool)
+      ++rhs._pool->refs;
+    __unref();
+    _pool = rhs._pool;
+    return *this;
+  }
+
+  ~node_pool_alloc() {
+    __unref();
+  }
+
+  void* allocate(size_t n) {
+    if (!_pool) {
+      _pool = (shared_pool*)Alloc::allocate(sizeof(shared_pool));
+      new (_pool) shared_pool();
+    }
+    return _pool->pool.allocate(n);
+  }
+
+  void deallocate(void* p, size_t n) {
+    _pool->pool.deallocate(p, n);
+  }
+
+  // 池中只剩下调用者的 n 个节点时整块释放，同一个池可能被显式共享给多个容器，所以要核对个数
+  bool deallocate_all(size_t n, size_t size) {
+    return _pool && _pool->pool.deallocate_all(n, size);
+  }
+
+  node_pool_alloc select_on_container_copy_construction() const {
+    return node_pool_alloc();
+  }
+
+  node_pool<Alloc>* resource() const noexcept {
+    return _pool ? &_pool->pool : 0;
+  }
+
+ private:
+  struct shared_pool {
+    node_pool<Alloc> pool;
+    size_t           refs;
+
+    shared_pool() : pool(), refs(1) {}
+  };
+
+  void __unref() {
+    if (_pool && --_pool->refs == 0) {
+      _pool->~shared_pool();
+      Alloc::deallocate(_pool, sizeof(shared_pool));
+    }
+  }
+
+  shared_pool* _pool;
+};
+
+template <typename Alloc>
+inline bool operator==(const node_pool_alloc<Alloc>& lhs, const node_pool_alloc<Alloc>& rhs) {
+  return lhs.resource() == rhs.resource();
+}
+
+template <typename Alloc>
+inline bool operator!=(const node_pool_alloc<Alloc>& lhs, const node_pool_alloc<Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_NODE_POOL_H
@@ -0,0 +1,650 @@
+#ifndef __MY_PERSISTENT_MAP__H
+#define __MY_PERSISTENT_MAP__H
+
+#include <algorithm>  // for equal
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+#include "exceptdef.h"
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_iterator.h"
+#include "my_map.h"  // for select1st
+
+namespace gd {
+
+// 可以被多个 persistent_map 共享的 AVL 树节点，refs 为指向它的指针个数（父节点或者 persistent_map 的根）
+// 不同线程中的快照可能同时释放同一个节点，所以引用计数是原子的
+template <typename Value>
+struct _persistent_node {
+  typedef _persistent_node* node_ptr;
+
+  Value               value;
+  node_ptr            left;
+  node_ptr            right;
+  std::atomic<size_t> refs;
+  int                 height;  // 叶节点为 1
+};
+
+// AVL 树的高度不超过 1.44 log(n + 2)，n < 2^64 时不超过 92
+enum { __PERSISTENT_MAX_HEIGHT = 96 };
+
+// 节点没有 parent，迭代器保存从根节点到当前节点的路径，depth 为 0 时为 end()
+// 迭代器只能读，修改元素要通过 persistent_map 的接口，这样共享的节点不会被改动
+template <typename Value>
+struct _persistent_iterator {
+  typedef Value                      value_type;
+  typedef const Value&               reference;
+  typedef const Value*               pointer;
+  typedef ptrdiff_t                  difference_type;
+  typedef bidirectional_iterator_tag iterator_category;
+
+  typedef _persistent_iterator    self;
+  typedef _persistent_node<Value> node_type;
+
+  const node_type* root;
+  const node_type* path[__PERSISTENT_MAX_HEIGHT];
+  int              depth;
+
+  _persistent_iterator() : root(nullptr), depth(0) {}
+  explicit _persistent_iterator(const node_type* r) : root(r), depth(0) {}
+
+  // 只复制用到的那一段路径
+  _persistent_iterator(const self& rhs) : root(rhs.root), depth(rhs.depth) {
+    for (int i = 0; i < depth; ++i)
+      path[i] = rhs.path[i];
+  }
+
+  self& operator=(const self& rhs) {
+    root = rhs.root;
+    depth = rhs.depth;
+    for (int i = 0; i < depth; ++i)
+      path[i] = rhs.path[i];
+    return *this;
+  }
+
+  reference operator*() const {
+    return path[depth - 1]->value;
+  }
+
+  pointer operator->() const {
+    return &(operator*());
+  }
+
+  // 有右子树时走到右子树的最左边，否则往上走到第一个从左边上来的祖先
+  self& operator++() {
+    const node_type* x = path[depth - 1];
+    if (x->right) {
+      __push_leftmost(x->right);
+    } else {
+      --depth;
+      while (depth > 0 && path[depth - 1]->right == x)
+        x = path[--depth];
+    }
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  // end() 的前一个是最右边的节点
+  self& operator--() {
+    if (depth == 0) {
+      __push_rightmost(root);
+      return *this;
+    }
+    const node_type* x = path[depth - 1];
+    if (x->left) {
+      __push_rightmost(x->left);
+    } else {
+      --depth;
+      while (depth > 0 && path[depth - 1]->left == x)
+        x = path[--depth];
+    }
+    return *this;
+  }
+
+  self operator--(int) {
+    self tmp(*this);
+    --*this;
+    return tmp;
+  }
+
+  bool operator==(const self& rhs) const {
+    return depth == rhs.depth && (depth == 0 || path[depth - 1] == rhs.path[depth - 1]);
+  }
+
+  bool operator!=(const self& rhs) const {
+    return !(*this == rhs);
+  }
+
+  void __push_leftmost(const node_type* x) {
+    for (; x != nullptr; x = x->left)
+      path[depth++] = x;
+  }
+
+  void __push_rightmost(const node_type* x) {
+    for (; x != nullptr; x = x->right)
+      path[depth++] = x;
+  }
+};
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+class concurrent_map;
+
+// 持久化的 map：拷贝只是共享根节点，O(1)，之后两边各自修改互不影响
+// 插入、删除时只复制从根节点到修改位置的路径上被共享的节点（path copying），其余节点继续共享，O(log n)；
+// 没有快照时节点都不共享，原地修改，不会多分配内存
+// rb_tree 的节点有 parent 指针，一个节点不能同时挂在两棵树上，所以这里用没有 parent 的 AVL 树
+// 快照可以交给其他线程读取，但同一个 persistent_map 对象不能同时被多个线程使用；
+// 快照和原来的对象共享节点和配置器，任何一个线程都可能释放节点，所以 Alloc 必须是线程安全的（默认的 alloc 是）
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class persistent_map : private simple_alloc<_persistent_node<std::pair<const Key, T>>, Alloc> {
+ public:
+  typedef Key                     key_type;
+  typedef T                       mapped_type;
+  typedef std::pair<const Key, T> value_type;
+  typedef Compare                 key_compare;
+
+  typedef const value_type*                pointer;
+  typedef const value_type*                const_pointer;
+  typedef const value_type&                reference;
+  typedef const value_type&                const_reference;
+  typedef _persistent_iterator<value_type> iterator;
+  typedef _persistent_iterator<value_type> const_iterator;
+  typedef size_t                           size_type;
+  typedef ptrdiff_t                        difference_type;
+  typedef simple_alloc<value_type, Alloc>  allocator_type;
+
+ private:
+  typedef _persistent_node<value_type>   node_type;
+  typedef node_type*                     node_ptr;
+  typedef simple_alloc<node_type, Alloc> node_allocator;
+  typedef select1st<value_type>          key_of_value;
+
+  node_ptr    __root;
+  size_type   __size;
+  key_compare __key_compare;
+
+  // concurrent_map 的读者直接在节点上查找，不构造迭代器
+  template <typename, typename, typename, typename>
+  friend class concurrent_map;
+
+ public:  // constructor, copy, destructor
+  persistent_map() : __root(nullptr), __size(0), __key_compare() {}
+
+  explicit persistent_map(const Compare& comp, const allocator_type& a = allocator_type())
+      : node_allocator(a), __root(nullptr), __size(0), __key_compare(comp) {}
+
+  template <typename InputIterator>
+  persistent_map(InputIterator first, InputIterator last) : __root(nullptr), __size(0), __key_compare() {
+    insert(first, last);
+  }
+
+  persistent_map(std::initializer_list<value_type> il) : __root(nullptr), __size(0), __key_compare() {
+    insert(il.begin(), il.end());
+  }
+
+  // 快照：共享 rhs 的全部节点，配置器也一起拷贝，O(1)
+  persistent_map(const persistent_map& rhs)
+      : node_allocator(rhs), __root(__retain(rhs.__root)), __size(rhs.__size), __key_compare(rhs.__key_compare) {}
+
+  persistent_map(persistent_map&& rhs) noexcept
+      : node_allocator(rhs), __root(rhs.__root), __size(rhs.__size), __key_compare(rhs.__key_compare) {
+    rhs.__root = nullptr;
+    rhs.__size = 0;
+  }
+
+  // 节点是共享的，配置器总是随节点一起赋值
+  persistent_map& operator=(const persistent_map& rhs) {
+    if (this != &rhs) {
+      node_ptr old = __root;
+      __root = __retain(rhs.__root);
+      __release(old);
+      __size = rhs.__size;
+      __key_compare = rhs.__key_compare;
+      __get_alloc() = rhs.__get_alloc();
+    }
+    return *this;
+  }
+
+  persistent_map& operator=(persistent_map&& rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      swap(rhs);
+    }
+    return *this;
+  }
+
+  persistent_map& operator=(std::initializer_list<value_type> il) {
+    clear();
+    insert(il.begin(), il.end());
+    return *this;
+  }
+
+  ~persistent_map() {
+    __release(__root);
+  }
+
+  allocator_type get_allocator() const {
+    return allocator_type(__get_alloc());
+  }
+
+  // 当前内容的只读快照，与拷贝构造相同
+  persistent_map snapshot() const {
+    return *this;
+  }
+
+ public:  // iterators
+  const_iterator begin() const {
+    const_iterator it(__root);
+    it.__push_leftmost(__root);
+    return it;
+  }
+
+  const_iterator end() const {
+    return const_iterator(__root);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __size == 0;
+  }
+
+  size_type size() const noexcept {
+    return __size;
+  }
+
+ public:  // element access
+  // 返回的引用指向本对象独占的节点，下一次修改之前有效
+  mapped_type& operator[](const key_type& k) {
+    if (__find(k) == nullptr)
+      __insert_new(k, value_type(k, T()));
+    return __unshare_path(k)->value.second;
+  }
+
+  const mapped_type& at(const key_type& k) const {
+    node_ptr x = __find(k);
+    THROW_OUT_OF_RANGE_IF(x == nullptr, "persistent_map<Key, T>::at() key not found");
+    return x->value.second;
+  }
+
+ public:  // modifiers
+  // key 已经存在时不插入，不复制任何节点
+  std::pair<iterator, bool> insert(const value_type& v) {
+    bool inserted = __find(v.first) == nullptr;
+    if (inserted)
+      __insert_new(v.first, v);
+    return std::make_pair(find(v.first), inserted);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& v) {
+    bool inserted = __find(v.first) == nullptr;
+    if (inserted)
+      __insert_new(v.first, std::move(v));
+    return std::make_pair(find(v.first), inserted);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    insert(il.begin(), il.end());
+  }
+
+  // key 已经存在时只复制通往它的路径并修改 mapped 值
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj) {
+    bool inserted = __find(k) == nullptr;
+    if (inserted)
+      __insert_new(k, value_type(k, std::forward<M>(obj)));
+    else
+      __unshare_path(k)->value.second = std::forward<M>(obj);
+    return std::make_pair(find(k), inserted);
+  }
+
+  size_type erase(const key_type& k) {
+    if (__find(k) == nullptr)
+      return 0;
+    __erase(__root, k);
+    --__size;
+    return 1;
+  }
+
+  void swap(persistent_map& rhs) noexcept {
+    std::swap(__root, rhs.__root);
+    std::swap(__size, rhs.__size);
+    std::swap(__key_compare, rhs.__key_compare);
+    std::swap(__get_alloc(), rhs.__get_alloc());
+  }
+
+  // 只释放本对象独占的节点，与快照共享的节点留给快照
+  void clear() noexcept {
+    __release(__root);
+    __root = nullptr;
+    __size = 0;
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return __key_compare;
+  }
+
+  // 两个对象共享同一个根节点时内容一定相同
+  bool shares_with(const persistent_map& rhs) const noexcept {
+    return __root == rhs.__root;
+  }
+
+ public:  // map operations
+  const_iterator find(const key_type& k) const {
+    const_iterator it = lower_bound(k);
+    return it == end() || __key_compare(k, it->first) ? end() : it;
+  }
+
+  size_type count(const key_type& k) const {
+    return __find(k) == nullptr ? 0 : 1;
+  }
+
+  // 沿途记下路径，最后一个往左走的节点就是结果
+  const_iterator lower_bound(const key_type& k) const {
+    const_iterator it(__root);
+    int            found = 0;
+    for (node_ptr x = __root; x != nullptr;) {
+      it.path[it.depth++] = x;
+      if (!__key_compare(_key(x), k)) {
+        found = it.depth;
+        x = x->left;
+      } else {
+        x = x->right;
+      }
+    }
+    it.depth = found;
+    return it;
+  }
+
+  const_iterator upper_bound(const key_type& k) const {
+    const_iterator it(__root);
+    int            found = 0;
+    for (node_ptr x = __root; x != nullptr;) {
+      it.path[it.depth++] = x;
+      if (__key_compare(k, _key(x))) {
+        found = it.depth;
+        x = x->left;
+      } else {
+        x = x->right;
+      }
+    }
+    it.depth = found;
+    return it;
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+ public:
+  bool operator==(const persistent_map& rhs) const {
+    return __size == rhs.__size && (__root == rhs.__root || std::equal(begin(), end(), rhs.begin()));
+  }
+
+ private:  // 节点的分配与共享
+  node_allocator& __get_alloc() noexcept {
+    return *static_cast<node_allocator*>(this);
+  }
+
+  const node_allocator& __get_alloc() const noexcept {
+    return *static_cast<const node_allocator*>(this);
+  }
+
+  static const key_type& _key(node_ptr x) {
+    return key_of_value()(x->value);
+  }
+
+  static int _height(node_ptr x) {
+    return x ? x->height : 0;
+  }
+
+  template <typename... Args>
+  node_ptr __create_node(node_ptr left, node_ptr right, int height, Args&&... args) {
+    node_ptr x = node_allocator::allocate();
+    try {
+      gd::construct(&x->value, std::forward<Args>(args)...);
+    } catch (...) {
+      node_allocator::deallocate(x);
+      throw;
+    }
+    x->left = left;
+    x->right = right;
+    ::new (&x->refs) std::atomic<size_t>(1);
+    x->height = height;
+    return x;
+  }
+
+  // 只销毁 x 这一个节点，x 必须是独占的
+  void __destroy_node(node_ptr x) {
+    gd::destroy(&x->value);
+    node_allocator::deallocate(x);
+  }
+
+  static node_ptr __retain(node_ptr x) {
+    if (x)
+      x->refs.fetch_add(1, std::memory_order_relaxed);
+    return x;
+  }
+
+  // 去掉一个指向 x 的引用，最后一个引用去掉时释放 x，再依次处理它的孩子
+  void __release(node_ptr x) {
+    while (x != nullptr && x->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      node_ptr l = x->left;
+      node_ptr r = x->right;
+      __destroy_node(x);
+      __release(l);
+      x = r;
+    }
+  }
+
+  // 让 link 指向的节点变为独占的：共享时复制一份换上去，孩子由两份共享，原来的节点少一个引用
+  // 路径上的祖先都是独占的时，节点的引用只来自 link，所以 refs 为 1 就说明没有快照共享它
+  // 复制可能抛出异常，先换上新节点再释放旧的引用，这样任何时候树都是完整的
+  node_ptr __own(node_ptr& link) {
+    node_ptr x = link;
+    if (x->refs.load(std::memory_order_acquire) == 1)
+      return x;
+    node_ptr y = __create_node(x->left, x->right, x->height, x->value);
+    __retain(x->left);
+    __retain(x->right);
+    link = y;
+    __release(x);
+    return y;
+  }
+
+ private:  // AVL 树，下面的函数接管传入的引用，返回新子树的根节点
+  node_ptr __find(const key_type& k) const {
+    node_ptr x = __root;
+    while (x != nullptr) {
+      if (__key_compare(k, _key(x)))
+        x = x->left;
+      else if (__key_compare(_key(x), k))
+        x = x->right;
+      else
+        return x;
+    }
+    return nullptr;
+  }
+
+  // 第一个不小于 k 的节点，没有时返回空
+  node_ptr __lower_bound(const key_type& k) const {
+    node_ptr y = nullptr;
+    for (node_ptr x = __root; x != nullptr;) {
+      if (!__key_compare(_key(x), k)) {
+        y = x;
+        x = x->left;
+      } else {
+        x = x->right;
+      }
+    }
+    return y;
+  }
+
+  static void __update(node_ptr x) {
+    int lh = _height(x->left);
+    int rh = _height(x->right);
+    x->height = (lh > rh ? lh : rh) + 1;
+  }
+
+  // x 是独占的，它的右孩子转上来
+  node_ptr __rotate_left(node_ptr x) {
+    node_ptr y = __own(x->right);
+    x->right = y->left;
+    y->left = x;
+    __update(x);
+    __update(y);
+    return y;
+  }
+
+  node_ptr __rotate_right(node_ptr x) {
+    node_ptr y = __own(x->left);
+    x->left = y->right;
+    y->right = x;
+    __update(x);
+    __update(y);
+    return y;
+  }
+
+  // x 是独占的，两棵子树的高度差不超过 2
+  node_ptr __balance(node_ptr x) {
+    int diff = _height(x->left) - _height(x->right);
+    if (diff > 1) {
+      if (_height(x->left->left) < _height(x->left->right))
+        x->left = __rotate_left(__own(x->left));
+      return __rotate_right(x);
+    }
+    if (diff < -1) {
+      if (_height(x->right->right) < _height(x->right->left))
+        x->right = __rotate_right(__own(x->right));
+      return __rotate_left(x);
+    }
+    __update(x);
+    return x;
+  }
+
+  // 调用前已经确认 k 不存在；z 挂上去之后的旋转抛出异常时 z 已经在树中
+  template <typename V>
+  void __insert_new(const key_type& k, V&& v) {
+    node_ptr z = __create_node(nullptr, nullptr, 1, std::forward<V>(v));
+    try {
+      __insert(__root, k, z);
+    } catch (...) {
+      if (__find(k) != z) {
+        __destroy_node(z);
+        throw;
+      }
+      ++__size;
+      throw;
+    }
+    ++__size;
+  }
+
+  void __insert(node_ptr& link, const key_type& k, node_ptr z) {
+    if (link == nullptr) {
+      link = z;
+      return;
+    }
+    node_ptr x = __own(link);
+    if (__key_compare(k, _key(x)))
+      __insert(x->left, k, z);
+    else
+      __insert(x->right, k, z);
+    link = __balance(x);
+  }
+
+  // 摘下子树中最小的节点并返回，它是独占的
+  node_ptr __erase_min(node_ptr& link) {
+    node_ptr x = __own(link);
+    if (x->left == nullptr) {
+      link = x->right;
+      return x;
+    }
+    node_ptr min = __erase_min(x->left);
+    link = __balance(x);
+    return min;
+  }
+
+  // 调用前已经确认 k 存在
+  void __erase(node_ptr& link, const key_type& k) {
+    node_ptr x = __own(link);
+    if (__key_compare(k, _key(x))) {
+      __erase(x->left, k);
+    } else if (__key_compare(_key(x), k)) {
+      __erase(x->right, k);
+    } else if (x->left == nullptr || x->right == nullptr) {
+      link = x->left ? x->left : x->right;
+      __destroy_node(x);
+      return;
+    } else {
+      // 右子树中最小的节点代替 x
+      node_ptr m = __erase_min(x->right);
+      m->left = x->left;
+      m->right = x->right;
+      link = m;
+      __destroy_node(x);
+      x = m;
+    }
+    link = __balance(x);
+  }
+
+  // 复制通往 k 的路径上被共享的节点，返回 k 所在的独占节点，调用前已经确认 k 存在
+  node_ptr __unshare_path(const key_type& k) {
+    node_ptr* link = &__root;
+    for (;;) {
+      node_ptr x = __own(*link);
+      if (__key_compare(k, _key(x)))
+        link = &x->left;
+      else if (__key_compare(_key(x), k))
+        link = &x->right;
+      else
+        return x;
+    }
+  }
+};
+
+// operators
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator==(const persistent_map<Key, T, Compare, Alloc>& lhs, const persistent_map<Key, T, Compare, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+bool operator!=(const persistent_map<Key, T, Compare, Alloc>& lhs, const persistent_map<Key, T, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+void swap(persistent_map<Key, T, Compare, Alloc>& lhs, persistent_map<Key, T, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_PERSISTENT_MAP__H
@@ -1,6 +1,8 @@
 #ifndef __MY_QUEUE__H
 #define __MY_QUEUE__H
 
+#include <memory>       // for uses_allocator
+#include <type_traits>  // for enable_if
 #include "my_deque.h"
 #include "my_heap.h"
 #include "my_vector.h"
@@ -31,7 +33,24 @@ class queue {
 
   queue(const queue& rhs) : _c(rhs._c) {}
 
-  queue(queue&& rhs) : _c(rhs._c) {}
+  queue(queue&& rhs) : _c(std::move(rhs._c)) {}
+
+  // 以下构造函数用指定的配置器构造底层容器，仅当底层容器支持该配置器时可用
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  explicit queue(const Alloc& a) : _c(a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  queue(const Container& c, const Alloc& a) : _c(c, a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  queue(Container&& c, const Alloc& a) : _c(std::move(c), a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  queue(const queue& rhs, const Alloc& a) : _c(rhs._c, a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  queue(queue&& rhs, const Alloc& a) : _c(std::move(rhs._c), a) {}
 
   queue& operator=(const queue& rhs) {
     _c = rhs._c;
@@ -181,6 +200,19 @@ class priority_queue {
     gd::make_heap(_c.begin(), _c.end(), _comp);
   }
 
+  // 以下构造函数用指定的配置器构造底层容器，仅当底层容器支持该配置器时可用
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  explicit priority_queue(const Alloc& a) : _c(a), _comp() {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  priority_queue(const Compare& comp, const Alloc& a) : _c(a), _comp(comp) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  priority_queue(const priority_queue& rhs, const Alloc& a) : _c(rhs._c, a), _comp(rhs._comp) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  priority_queue(priority_queue&& rhs, const Alloc& a) : _c(std::move(rhs._c), a), _comp(rhs._comp) {}
+
   priority_queue& operator=(const priority_queue& rhs) {
     _c = rhs._c;
     _comp = rhs._comp;
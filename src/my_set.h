@@ -19,7 +19,11 @@ struct identity {
   }
 };
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+class multiset;
+
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc,
+          typename Augment = _rb_tree_no_augment>
 class set {
  public:
   typedef Key     key_type;
@@ -28,10 +32,17 @@ class set {
   typedef Compare value_compare;
 
  private:  // 以红黑树为底层数据结构
-  typedef rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc> __rep_type;
+  typedef rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc, Augment> __rep_type;
+  // set 的 iterator 是 rb_tree 的 const_iterator，带 hint 的插入需要转换回 rb_tree 的 iterator
+  typedef typename __rep_type::iterator __rep_iterator;
 
   __rep_type __tree;
 
+  template <typename, typename, typename, typename>
+  friend class set;
+  template <typename, typename, typename, typename>
+  friend class multiset;
+
  public:
   typedef typename __rep_type::const_pointer   pointer;
   typedef typename __rep_type::const_pointer   const_pointer;
@@ -43,22 +54,50 @@ class set {
   typedef typename __rep_type::difference_type difference_type;
   typedef typename __rep_type::allocator_type  allocator_type;
 
+  typedef _rb_tree_set_node_handle<Key, typename __rep_type::node_type, Alloc> node_type;
+  typedef _rb_tree_insert_return<iterator, node_type>                          insert_return_type;
+
  public:  // constructor, copy, destructor
   set() = default;
 
+  explicit set(const Compare& comp, const allocator_type& a = allocator_type()) : __tree(comp, a) {}
+
+  explicit set(const allocator_type& a) : __tree(Compare(), a) {}
+
   template <typename InputIterator>
   set(InputIterator first, InputIterator last) : __tree() {
     __tree.insert_unique(first, last);
   }
 
+  template <typename InputIterator>
+  set(InputIterator first, InputIterator last, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(first, last);
+  }
+
   set(std::initializer_list<value_type> il) : __tree() {
     __tree.insert_unique(il.begin(), il.end());
   }
 
+  set(std::initializer_list<value_type> il, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_unique(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时线性时间建树，重复的元素只保留第一个，输入无序时退化为逐个插入
+  template <typename InputIterator>
+  set(sorted_unique_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+      const allocator_type& a = allocator_type())
+      : __tree(comp, a) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
   set(const set& rhs) : __tree(rhs.__tree) {}
 
   set(set&& rhs) noexcept : __tree(std::move(rhs.__tree)) {}
 
+  set(const set& rhs, const allocator_type& a) : __tree(rhs.__tree, a) {}
+
+  set(set&& rhs, const allocator_type& a) : __tree(std::move(rhs.__tree), a) {}
+
   set& operator=(const set& rhs) {
     __tree = rhs.__tree;
     return *this;
@@ -76,7 +115,7 @@ class set {
   }
 
   allocator_type get_allocator() const noexcept {
-    return allocator_type();
+    return __tree.get_allocator();
   }
 
  public:  // iterators
@@ -123,7 +162,11 @@ class set {
     return __tree.emplace_unique(std::forward<Args>(args)...);
   }
 
-  // TODO(dong) iterator emplace_hint(iterator pos, Args&&... args);
+  // pos 是新元素应该插入的位置附近的迭代器，位置正确时插入只需要均摊常数时间
+  template <typename... Args>
+  iterator emplace_hint(iterator pos, Args&&... args) {
+    return __tree.emplace_unique(__rep_iterator(pos.node), std::forward<Args>(args)...);
+  }
 
   std::pair<iterator, bool> insert(const value_type& value) {
     return __tree.insert_unique(value);
@@ -133,15 +176,25 @@ class set {
     return __tree.insert_unique(std::move(value));
   }
 
-  // TODO(dong) iterator insert(iterator pos, const value_type& value);
+  iterator insert(iterator pos, const value_type& value) {
+    return __tree.insert_unique(__rep_iterator(pos.node), value);
+  }
 
-  // TODO(dong) iterator insert(iterator pos, value_type&& value);
+  iterator insert(iterator pos, value_type&& value) {
+    return __tree.insert_unique(__rep_iterator(pos.node), std::move(value));
+  }
 
   template <typename InputIterator>
   void insert(InputIterator first, InputIterator last) {
     __tree.insert_unique(first, last);
   }
 
+  // 清空后用有序区间 [first, last) 重建，见有序区间的构造函数
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    __tree.assign_sorted_unique(first, last);
+  }
+
   // TODO(dong) not c++11 yet
   void erase(iterator pos) {
     __tree.erase(pos.node);
@@ -164,6 +217,75 @@ class set {
     __tree.clear();
   }
 
+ public:  // node handles
+  // 摘下的节点可以修改元素再插回来，或者插入到另一个配置器相同的 set、multiset 中，
+  // 整个过程不分配内存，也不拷贝元素
+  node_type extract(iterator pos) {
+    return __tree.template extract<node_type>(__rep_iterator(pos.node));
+  }
+
+  node_type extract(const key_type& k) {
+    return __tree.template extract<node_type>(k);
+  }
+
+  // 元素已经存在时不插入，节点留在返回值的 node 中
+  insert_return_type insert(node_type&& nh) {
+    std::pair<__rep_iterator, bool> res = __tree.insert_node_unique(nh);
+    return insert_return_type{res.first, res.second, std::move(nh)};
+  }
+
+  iterator insert(iterator pos, node_type&& nh) {
+    return __tree.insert_node_unique(__rep_iterator(pos.node), nh);
+  }
+
+  // 把 src 中本容器还没有的元素的节点直接链接过来，src 中只留下重复的元素
+  template <typename Compare2>
+  void merge(set<Key, Compare2, Alloc, Augment>& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(set<Key, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(multiset<Key, Compare2, Alloc, Augment>& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(multiset<Key, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_unique(src.__tree);
+  }
+
+ public:  // join, split and set operations，只移动节点，不分配内存也不拷贝元素，见 rb_tree
+  // 把 key 不小于 k 的元素切下来作为一个新的 set 返回，O(log n)
+  set split(const key_type& k) {
+    return set(__tree.split(k));
+  }
+
+  // rhs 的元素都不能排在本容器的前面，连接后 rhs 变为空，O(log n)
+  void join(set& rhs) {
+    __tree.join(rhs.__tree);
+  }
+
+  // 集合运算的结果留在本容器中，rhs 变为空；threads 为最多使用的线程数，为 0 时使用硬件的线程数
+  void set_union(set& rhs, unsigned threads = 0) {
+    __tree.set_union(rhs.__tree, threads);
+  }
+
+  void set_intersection(set& rhs, unsigned threads = 0) {
+    __tree.set_intersection(rhs.__tree, threads);
+  }
+
+  void set_difference(set& rhs, unsigned threads = 0) {
+    __tree.set_difference(rhs.__tree, threads);
+  }
+
+ private:
+  explicit set(__rep_type&& t) : __tree(std::move(t)) {}
+
  public:  // observers
   key_compare key_comp() const {
     return key_compare();
@@ -173,43 +295,118 @@ class set {
     return value_compare();
   }
 
- public:  // set operations
+ public:  // set operations，Compare 声明了 is_transparent 时也接受能与 key 比较的其他类型，见 rb_tree
   iterator find(const key_type& k) {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& k) {
+    return __tree.find(k);
+  }
+
   const_iterator find(const key_type& k) const {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& k) const {
+    return __tree.find(k);
+  }
+
   size_type count(const key_type& k) const {
     return __tree.count(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count(const K& k) const {
+    return __tree.count(k);
+  }
+
   iterator lower_bound(const key_type& k) {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& k) {
+    return __tree.lower_bound(k);
+  }
+
   const_iterator lower_bound(const key_type& k) const {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& k) const {
+    return __tree.lower_bound(k);
+  }
+
   iterator upper_bound(const key_type& k) {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& k) {
+    return __tree.upper_bound(k);
+  }
+
   const_iterator upper_bound(const key_type& k) const {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& k) const {
+    return __tree.upper_bound(k);
+  }
+
   std::pair<iterator, iterator> equal_range(const key_type& k) {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& k) {
+    return __tree.equal_range(k);
+  }
+
   std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+    return __tree.equal_range(k);
+  }
+
+ public:  // order statistics，只有 Augment 为 order_statistic 时可用
+  // 按 key 的顺序排第 k 个（从 0 开始）的元素，k >= size() 时返回 end()
+  iterator nth(size_type k) {
+    return __tree.nth(k);
+  }
+
+  const_iterator nth(size_type k) const {
+    return __tree.nth(k);
+  }
+
+  // key 小于 k 的元素个数
+  size_type rank(const key_type& k) const {
+    return __tree.rank(k);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type rank(const K& k) const {
+    return __tree.rank(k);
+  }
+
+  // key 在 [lo, hi) 中的元素个数
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count_range(const K& lo, const K& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
  public:
   bool operator==(const set& rhs) const {
     return __tree == rhs.__tree;
@@ -222,43 +419,44 @@ class set {
 
 // operators
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator==(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator==(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   return lhs.operator==(rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator!=(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator!=(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator<(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   return lhs.operator<(rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>=(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator>=(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   return !(lhs < rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator>(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   return rhs < lhs;
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<=(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator<=(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   return !(rhs < lhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-void swap(const set<Key, Compare, Alloc>& lhs, const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+void swap(const set<Key, Compare, Alloc, Augment>& lhs, const set<Key, Compare, Alloc, Augment>& rhs) {
   lhs.swap(rhs);
 }
 
 // multiset
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc,
+          typename Augment = _rb_tree_no_augment>
 class multiset {
  public:
   typedef Key     key_type;
@@ -267,10 +465,17 @@ class multiset {
   typedef Compare value_compare;
 
  private:  // 以红黑树为底层数据结构
-  typedef rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc> __rep_type;
+  typedef rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc, Augment> __rep_type;
+  // set 的 iterator 是 rb_tree 的 const_iterator，带 hint 的插入需要转换回 rb_tree 的 iterator
+  typedef typename __rep_type::iterator __rep_iterator;
 
   __rep_type __tree;
 
+  template <typename, typename, typename, typename>
+  friend class set;
+  template <typename, typename, typename, typename>
+  friend class multiset;
+
  public:
   typedef typename __rep_type::const_pointer   pointer;
   typedef typename __rep_type::const_pointer   const_pointer;
@@ -282,22 +487,49 @@ class multiset {
   typedef typename __rep_type::difference_type difference_type;
   typedef typename __rep_type::allocator_type  allocator_type;
 
+  typedef _rb_tree_set_node_handle<Key, typename __rep_type::node_type, Alloc> node_type;
+
  public:  // constructor, copy, destructor
   multiset() = default;
 
+  explicit multiset(const Compare& comp, const allocator_type& a = allocator_type()) : __tree(comp, a) {}
+
+  explicit multiset(const allocator_type& a) : __tree(Compare(), a) {}
+
   template <typename InputIterator>
   multiset(InputIterator first, InputIterator last) : __tree() {
     __tree.insert_equal(first, last);
   }
 
+  template <typename InputIterator>
+  multiset(InputIterator first, InputIterator last, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_equal(first, last);
+  }
+
   multiset(std::initializer_list<value_type> il) : __tree() {
     __tree.insert_equal(il.begin(), il.end());
   }
 
+  multiset(std::initializer_list<value_type> il, const allocator_type& a) : __tree(Compare(), a) {
+    __tree.insert_equal(il.begin(), il.end());
+  }
+
+  // [first, last) 已经按 key 升序排列时线性时间建树，输入无序时退化为逐个插入
+  template <typename InputIterator>
+  multiset(sorted_equivalent_t, InputIterator first, InputIterator last, const Compare& comp = Compare(),
+           const allocator_type& a = allocator_type())
+      : __tree(comp, a) {
+    __tree.assign_sorted_equal(first, last);
+  }
+
   multiset(const multiset& rhs) : __tree(rhs.__tree) {}
 
   multiset(multiset&& rhs) noexcept : __tree(std::move(rhs.__tree)) {}
 
+  multiset(const multiset& rhs, const allocator_type& a) : __tree(rhs.__tree, a) {}
+
+  multiset(multiset&& rhs, const allocator_type& a) : __tree(std::move(rhs.__tree), a) {}
+
   multiset& operator=(const multiset& rhs) {
     __tree = rhs.__tree;
     return *this;
@@ -315,7 +547,7 @@ class multiset {
   }
 
   allocator_type get_allocator() const noexcept {
-    return allocator_type();
+    return __tree.get_allocator();
   }
 
  public:  // iterators
@@ -362,7 +594,11 @@ class multiset {
     return __tree.emplace_equal(std::forward<Args>(args)...);
   }
 
-  // TODO(dong) iterator emplace_hint(iterator pos, Args&&... args);
+  // pos 是新元素应该插入的位置附近的迭代器，位置正确时插入只需要均摊常数时间
+  template <typename... Args>
+  iterator emplace_hint(iterator pos, Args&&... args) {
+    return __tree.emplace_equal(__rep_iterator(pos.node), std::forward<Args>(args)...);
+  }
 
   iterator insert(const value_type& value) {
     return __tree.insert_equal(value);
@@ -372,15 +608,25 @@ class multiset {
     return __tree.insert_equal(std::move(value));
   }
 
-  // TODO(dong) iterator insert(iterator pos, const value_type& value);
+  iterator insert(iterator pos, const value_type& value) {
+    return __tree.insert_equal(__rep_iterator(pos.node), value);
+  }
 
-  // TODO(dong) iterator insert(iterator pos, value_type&& value);
+  iterator insert(iterator pos, value_type&& value) {
+    return __tree.insert_equal(__rep_iterator(pos.node), std::move(value));
+  }
 
   template <typename InputIterator>
   void insert(InputIterator first, InputIterator last) {
     __tree.insert_equal(first, last);
   }
 
+  // 清空后用有序区间 [first, last) 重建，见有序区间的构造函数
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last) {
+    __tree.assign_sorted_equal(first, last);
+  }
+
   // TODO(dong) not c++11 yet
   void erase(iterator pos) {
     __tree.erase(pos.node);
@@ -403,6 +649,44 @@ class multiset {
     __tree.clear();
   }
 
+ public:  // node handles，见 set
+  node_type extract(iterator pos) {
+    return __tree.template extract<node_type>(__rep_iterator(pos.node));
+  }
+
+  node_type extract(const key_type& k) {
+    return __tree.template extract<node_type>(k);
+  }
+
+  iterator insert(node_type&& nh) {
+    return __tree.insert_node_equal(nh);
+  }
+
+  iterator insert(iterator pos, node_type&& nh) {
+    return __tree.insert_node_equal(__rep_iterator(pos.node), nh);
+  }
+
+  // src 中的节点全部链接过来，src 变为空
+  template <typename Compare2>
+  void merge(multiset<Key, Compare2, Alloc, Augment>& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(multiset<Key, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(set<Key, Compare2, Alloc, Augment>& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
+  template <typename Compare2>
+  void merge(set<Key, Compare2, Alloc, Augment>&& src) {
+    __tree.merge_equal(src.__tree);
+  }
+
  public:  // observers
   key_compare key_comp() const {
     return key_compare();
@@ -412,43 +696,118 @@ class multiset {
     return value_compare();
   }
 
- public:  // set operations
+ public:  // set operations，Compare 声明了 is_transparent 时也接受能与 key 比较的其他类型，见 rb_tree
   iterator find(const key_type& k) {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& k) {
+    return __tree.find(k);
+  }
+
   const_iterator find(const key_type& k) const {
     return __tree.find(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& k) const {
+    return __tree.find(k);
+  }
+
   size_type count(const key_type& k) const {
     return __tree.count(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count(const K& k) const {
+    return __tree.count(k);
+  }
+
   iterator lower_bound(const key_type& k) {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& k) {
+    return __tree.lower_bound(k);
+  }
+
   const_iterator lower_bound(const key_type& k) const {
     return __tree.lower_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& k) const {
+    return __tree.lower_bound(k);
+  }
+
   iterator upper_bound(const key_type& k) {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& k) {
+    return __tree.upper_bound(k);
+  }
+
   const_iterator upper_bound(const key_type& k) const {
     return __tree.upper_bound(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& k) const {
+    return __tree.upper_bound(k);
+  }
+
   std::pair<iterator, iterator> equal_range(const key_type& k) {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& k) {
+    return __tree.equal_range(k);
+  }
+
   std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
     return __tree.equal_range(k);
   }
 
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+    return __tree.equal_range(k);
+  }
+
+ public:  // order statistics，只有 Augment 为 order_statistic 时可用
+  // 按 key 的顺序排第 k 个（从 0 开始）的元素，k >= size() 时返回 end()
+  iterator nth(size_type k) {
+    return __tree.nth(k);
+  }
+
+  const_iterator nth(size_type k) const {
+    return __tree.nth(k);
+  }
+
+  // key 小于 k 的元素个数
+  size_type rank(const key_type& k) const {
+    return __tree.rank(k);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type rank(const K& k) const {
+    return __tree.rank(k);
+  }
+
+  // key 在 [lo, hi) 中的元素个数
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count_range(const K& lo, const K& hi) const {
+    return __tree.count_range(lo, hi);
+  }
+
  public:
   bool operator==(const multiset& rhs) const {
     return __tree == rhs.__tree;
@@ -461,38 +820,38 @@ class multiset {
 
 // operators
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator==(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator==(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   return lhs.operator==(rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator!=(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator!=(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator<(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   return lhs.operator<(rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>=(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator>=(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   return !(lhs < rhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator>(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator>(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   return rhs < lhs;
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-bool operator<=(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+bool operator<=(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   return !(rhs < lhs);
 }
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
-void swap(const multiset<Key, Compare, Alloc>& lhs, const multiset<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename Augment>
+void swap(const multiset<Key, Compare, Alloc, Augment>& lhs, const multiset<Key, Compare, Alloc, Augment>& rhs) {
   lhs.swap(rhs);
 }
 
@@ -0,0 +1,449 @@
+#ifndef __MY_SKIPLIST__H
+#define __MY_SKIPLIST__H
+
+#include <atomic>
+#include <cstdint>  // for uintptr_t
+#include <functional>
+#include <new>
+#include <utility>
+#include "my_alloc.h"
+#include "my_construct.h"
+#include "my_epoch.h"
+#include "my_iterator.h"
+
+namespace gd {
+
+// 跳表节点，next 数组紧跟在节点后面，长度为 height，节点按 next 的元素对齐
+// next 的最低位是删除标记：标记之后这一层的 next 不再改变，任何线程看到标记都可以帮忙把节点从这一层摘下
+template <typename Value>
+struct alignas(std::atomic<uintptr_t>) _skiplist_node {
+  typedef _skiplist_node* node_ptr;
+
+  Value            value;
+  int              height;
+  std::atomic<int> owners;  // 插入者和删除者，最后离开的一方负责回收，见 skiplist
+
+  std::atomic<uintptr_t>* next() {
+    return reinterpret_cast<std::atomic<uintptr_t>*>(this + 1);
+  }
+
+  static node_ptr ptr(uintptr_t w) {
+    return reinterpret_cast<node_ptr>(w & ~(uintptr_t)1);
+  }
+
+  static bool marked(uintptr_t w) {
+    return (w & 1) != 0;
+  }
+
+  // 第 0 层上的下一个没有被删除的节点
+  node_ptr successor() {
+    node_ptr x = ptr(next()[0].load(std::memory_order_acquire));
+    while (x != nullptr) {
+      uintptr_t w = x->next()[0].load(std::memory_order_acquire);
+      if (!marked(w))
+        break;
+      x = ptr(w);
+    }
+    return x;
+  }
+};
+
+// 只读的前向迭代器，持有 epoch 临界区，所以指向的节点即使被删除也不会被释放
+// 遍历是弱一致的：看不到遍历开始后插入在当前位置之前的元素，已经删除的元素会被跳过
+// 迭代器存在期间本线程停在临界区中，会拖住所有线程的回收，不要长期持有，也不能交给其他线程
+template <typename Value>
+struct _skiplist_iterator {
+  typedef Value                value_type;
+  typedef const Value&         reference;
+  typedef const Value*         pointer;
+  typedef ptrdiff_t            difference_type;
+  typedef forward_iterator_tag iterator_category;
+
+  typedef _skiplist_iterator    self;
+  typedef _skiplist_node<Value> node_type;
+
+  node_type*          node;
+  epoch_domain::guard pin;
+
+  _skiplist_iterator() : node(nullptr) {}
+  _skiplist_iterator(node_type* x, const epoch_domain::guard& g) : node(x), pin(g) {}
+
+  reference operator*() const {
+    return node->value;
+  }
+
+  pointer operator->() const {
+    return &(operator*());
+  }
+
+  self& operator++() {
+    node = node->successor();
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const self& rhs) const {
+    return node == rhs.node;
+  }
+
+  bool operator!=(const self& rhs) const {
+    return node != rhs.node;
+  }
+};
+
+// 无锁的跳表（Herlihy、Shavit 的 lock-free skip list），只存放不重复的 key
+// 插入：先用 CAS 把节点链到第 0 层，这一步成功就算插入完成，再逐层往上链接
+// 删除：从上往下给节点每一层的 next 打上删除标记，打上第 0 层标记的线程就是删除者，之后由查找把它从各层摘下；
+// 查找（find、lower_bound、upper_bound）只是跳过有标记的节点，不写任何共享的内存
+// 往上链接和删除可能同时进行，链接晚到的一层可能把已经摘下的节点又挂上去，所以节点的回收交给插入者和删除者中
+// 后完成的一方：它再查找一次，把节点从所有层摘下，然后交给 epoch_domain，等所有读者离开后释放
+// 元素插入后不能修改；Alloc 必须是线程安全的（默认的 alloc 是）
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc>
+class skiplist : private simple_alloc<char, Alloc> {
+ public:
+  typedef Key                        key_type;
+  typedef Value                      value_type;
+  typedef const value_type*          pointer;
+  typedef const value_type*          const_pointer;
+  typedef const value_type&          reference;
+  typedef const value_type&          const_reference;
+  typedef size_t                     size_type;
+  typedef ptrdiff_t                  difference_type;
+  typedef simple_alloc<Value, Alloc> allocator_type;
+
+  typedef _skiplist_iterator<Value> iterator;
+  typedef _skiplist_iterator<Value> const_iterator;
+
+ private:
+  typedef _skiplist_node<Value>     node_type;
+  typedef node_type*                node_ptr;
+  typedef simple_alloc<char, Alloc> byte_allocator;
+
+  // 每层的节点数是下一层的 1/4，20 层足够 2^40 个元素
+  enum { __MAX_HEIGHT = 20 };
+
+  node_ptr               __head;  // 哨兵节点，有 __MAX_HEIGHT 层，value 没有构造
+  std::atomic<size_type> __size;
+  Compare                __key_compare;
+  mutable epoch_domain   __epoch;
+
+ public:  // constructor, destructor
+  skiplist() : __size(0), __key_compare() {
+    __empty_init();
+  }
+
+  explicit skiplist(const Compare& comp, const allocator_type& a = allocator_type())
+      : byte_allocator(a), __size(0), __key_compare(comp) {
+    __empty_init();
+  }
+
+  skiplist(const skiplist&) = delete;
+  skiplist& operator=(const skiplist&) = delete;
+
+  // 调用者保证没有其他线程还在使用本对象
+  ~skiplist() {
+    __epoch.drain();
+    for (node_ptr x = node_type::ptr(__head->next()[0].load(std::memory_order_relaxed)); x != nullptr;) {
+      node_ptr next = node_type::ptr(x->next()[0].load(std::memory_order_relaxed));
+      __destroy_node(x);
+      x = next;
+    }
+    __put_node(__head);
+  }
+
+  allocator_type get_allocator() const {
+    return allocator_type(*static_cast<const byte_allocator*>(this));
+  }
+
+ public:  // iterators
+  const_iterator begin() const {
+    epoch_domain::guard g = __epoch.pin();
+    return const_iterator(__head->successor(), g);
+  }
+
+  const_iterator end() const {
+    return const_iterator();
+  }
+
+ public:  // capacity
+  // 并发修改时只是一个近似值
+  size_type size() const noexcept {
+    return __size.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+ public:  // modifiers
+  std::pair<iterator, bool> insert_unique(const value_type& v) {
+    return __insert_unique(v);
+  }
+
+  std::pair<iterator, bool> insert_unique(value_type&& v) {
+    return __insert_unique(std::move(v));
+  }
+
+  template <typename InputIterator>
+  void insert_unique(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      __insert_unique(*first);
+  }
+
+  size_type erase(const key_type& k) {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            preds[__MAX_HEIGHT];
+    node_ptr            succs[__MAX_HEIGHT];
+    if (!__find(k, preds, succs))
+      return 0;
+    node_ptr x = succs[0];
+    for (int i = x->height - 1; i > 0; --i)
+      x->next()[i].fetch_or(1, std::memory_order_acq_rel);
+    if (node_type::marked(x->next()[0].fetch_or(1, std::memory_order_acq_rel)))
+      return 0;  // 其他线程先删除了它
+    __size.fetch_sub(1, std::memory_order_relaxed);
+    __find(k, preds, succs);
+    __release_owner(x);
+    return 1;
+  }
+
+  // 逐个删除，可以与其他操作同时进行
+  void clear() {
+    for (;;) {
+      epoch_domain::guard g = __epoch.pin();
+      node_ptr            x = __head->successor();
+      if (x == nullptr)
+        return;
+      erase(KeyOfValue()(x->value));
+    }
+  }
+
+ public:  // observers
+  Compare key_comp() const {
+    return __key_compare;
+  }
+
+ public:  // set operations，只读，不写共享的内存
+  const_iterator find(const key_type& k) const {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            x = __lower_bound(k);
+    return const_iterator(x == nullptr || __key_compare(k, _key(x)) ? nullptr : x, g);
+  }
+
+  size_type count(const key_type& k) const {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            x = __lower_bound(k);
+    return x == nullptr || __key_compare(k, _key(x)) ? 0 : 1;
+  }
+
+  const_iterator lower_bound(const key_type& k) const {
+    epoch_domain::guard g = __epoch.pin();
+    return const_iterator(__lower_bound(k), g);
+  }
+
+  const_iterator upper_bound(const key_type& k) const {
+    epoch_domain::guard g = __epoch.pin();
+    return const_iterator(__upper_bound(k), g);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+ private:  // 节点的分配
+  static const key_type& _key(node_ptr x) {
+    return KeyOfValue()(x->value);
+  }
+
+  static size_t __node_bytes(int height) {
+    return sizeof(node_type) + height * sizeof(std::atomic<uintptr_t>);
+  }
+
+  // 只分配空间并初始化 next，不构造 value
+  node_ptr __get_node(int height) {
+    node_ptr x = reinterpret_cast<node_ptr>(byte_allocator::allocate(__node_bytes(height)));
+    x->height = height;
+    ::new (&x->owners) std::atomic<int>(2);
+    for (int i = 0; i < height; ++i)
+      ::new (&x->next()[i]) std::atomic<uintptr_t>(0);
+    return x;
+  }
+
+  void __put_node(node_ptr x) {
+    byte_allocator::deallocate(reinterpret_cast<char*>(x), __node_bytes(x->height));
+  }
+
+  template <typename... Args>
+  node_ptr __create_node(int height, Args&&... args) {
+    node_ptr x = __get_node(height);
+    try {
+      gd::construct(&x->value, std::forward<Args>(args)...);
+    } catch (...) {
+      __put_node(x);
+      throw;
+    }
+    return x;
+  }
+
+  void __destroy_node(node_ptr x) {
+    gd::destroy(&x->value);
+    __put_node(x);
+  }
+
+  static void __reclaim_node(void* ctx, void* p) {
+    static_cast<skiplist*>(ctx)->__destroy_node(static_cast<node_ptr>(p));
+  }
+
+  void __empty_init() {
+    __head = __get_node(__MAX_HEIGHT);
+  }
+
+  // 每个线程一个 xorshift 随机数，高度为 h 的概率是 (1/4)^(h-1) * 3/4
+  static int __random_height() {
+    static thread_local uint64_t state = 0;
+    if (state == 0)
+      state = (uint64_t)(uintptr_t)&state * 0x9E3779B97F4A7C15ull | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    int      h = 1;
+    uint64_t r = state;
+    while (h < __MAX_HEIGHT && (r & 3) == 0) {
+      ++h;
+      r >>= 2;
+    }
+    return h;
+  }
+
+ private:  // 跳表的操作，调用者已经进入临界区
+  // 找到每一层上 key 小于 k 的最后一个节点 preds 和它的后继 succs，沿途把有删除标记的节点摘下来
+  // 摘节点的 CAS 失败说明 pred 被删除或者有新节点插进来，从头开始；返回第 0 层上是否有 k
+  bool __find(const key_type& k, node_ptr* preds, node_ptr* succs) {
+  retry:
+    node_ptr pred = __head;
+    for (int level = __MAX_HEIGHT - 1; level >= 0; --level) {
+      node_ptr curr = node_type::ptr(pred->next()[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        uintptr_t succ = curr->next()[level].load(std::memory_order_acquire);
+        if (node_type::marked(succ)) {
+          uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+          if (!pred->next()[level].compare_exchange_strong(expected, succ & ~(uintptr_t)1,
+                                                           std::memory_order_acq_rel))
+            goto retry;
+          curr = node_type::ptr(succ);
+          continue;
+        }
+        if (!__key_compare(_key(curr), k))
+          break;
+        pred = curr;
+        curr = node_type::ptr(succ);
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    return succs[0] != nullptr && !__key_compare(k, _key(succs[0]));
+  }
+
+  // 第 0 层上第一个没有删除标记、key 不小于 k 的节点，只读
+  node_ptr __lower_bound(const key_type& k) const {
+    node_ptr pred = __head;
+    node_ptr curr = nullptr;
+    for (int level = __MAX_HEIGHT - 1; level >= 0; --level) {
+      curr = node_type::ptr(pred->next()[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        uintptr_t succ = curr->next()[level].load(std::memory_order_acquire);
+        if (!node_type::marked(succ) && !__key_compare(_key(curr), k))
+          break;
+        if (!node_type::marked(succ))
+          pred = curr;
+        curr = node_type::ptr(succ);
+      }
+    }
+    return curr;
+  }
+
+  // 第 0 层上第一个没有删除标记、key 大于 k 的节点，只读
+  node_ptr __upper_bound(const key_type& k) const {
+    node_ptr pred = __head;
+    node_ptr curr = nullptr;
+    for (int level = __MAX_HEIGHT - 1; level >= 0; --level) {
+      curr = node_type::ptr(pred->next()[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        uintptr_t succ = curr->next()[level].load(std::memory_order_acquire);
+        if (!node_type::marked(succ) && __key_compare(k, _key(curr)))
+          break;
+        if (!node_type::marked(succ))
+          pred = curr;
+        curr = node_type::ptr(succ);
+      }
+    }
+    return curr;
+  }
+
+  template <typename V>
+  std::pair<iterator, bool> __insert_unique(V&& v) {
+    epoch_domain::guard g = __epoch.pin();
+    node_ptr            preds[__MAX_HEIGHT];
+    node_ptr            succs[__MAX_HEIGHT];
+    const key_type*     k = &KeyOfValue()(v);
+    node_ptr            x = nullptr;
+    for (;;) {
+      if (__find(*k, preds, succs)) {
+        if (x != nullptr)
+          __destroy_node(x);  // 还没有发布，直接释放
+        return std::make_pair(iterator(succs[0], g), false);
+      }
+      if (x == nullptr) {
+        x = __create_node(__random_height(), std::forward<V>(v));
+        k = &_key(x);
+      }
+      for (int i = 0; i < x->height; ++i)
+        x->next()[i].store(reinterpret_cast<uintptr_t>(succs[i]), std::memory_order_relaxed);
+      uintptr_t expected = reinterpret_cast<uintptr_t>(succs[0]);
+      if (preds[0]->next()[0].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(x),
+                                                      std::memory_order_acq_rel))
+        break;
+    }
+    __size.fetch_add(1, std::memory_order_relaxed);
+
+    // 往上逐层链接，x 被删除（这一层有了标记）时停下
+    for (int i = 1; i < x->height; ++i) {
+      for (;;) {
+        uintptr_t next = x->next()[i].load(std::memory_order_acquire);
+        if (node_type::marked(next))
+          goto linked;
+        uintptr_t succ = reinterpret_cast<uintptr_t>(succs[i]);
+        if (next != succ && !x->next()[i].compare_exchange_strong(next, succ, std::memory_order_acq_rel))
+          continue;
+        uintptr_t expected = succ;
+        if (preds[i]->next()[i].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(x),
+                                                        std::memory_order_acq_rel))
+          break;
+        __find(*k, preds, succs);
+      }
+    }
+  linked:
+    iterator it(x, g);
+    __release_owner(x);
+    return std::make_pair(it, true);
+  }
+
+  // 插入者链接完、删除者打完标记后各调用一次，后到的一方把 x 从所有层摘下并回收
+  void __release_owner(node_ptr x) {
+    if (x->owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    node_ptr preds[__MAX_HEIGHT];
+    node_ptr succs[__MAX_HEIGHT];
+    __find(_key(x), preds, succs);
+    __epoch.retire(x, &skiplist::__reclaim_node, this);
+  }
+};
+
+}  // namespace gd
+
+#endif  // !__MY_SKIPLIST__H
@@ -0,0 +1,153 @@
+#ifndef __MY_SKIPLIST_SET__H
+#define __MY_SKIPLIST_SET__H
+
+#include <functional>
+#include <initializer_list>
+#include <utility>
+#include "my_set.h"  // for identity
+#include "my_skiplist.h"
+
+namespace gd {
+
+// 以无锁跳表为底层数据结构的 set，所有操作都可以在多个线程中同时调用，见 skiplist
+// 查找不加锁也不写共享的内存，插入和删除只用 CAS，互不阻塞
+// 迭代器是只读的前向迭代器，持有 epoch 临界区，遍历是弱一致的
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class skiplist_set {
+ public:
+  typedef Key     key_type;
+  typedef Key     value_type;
+  typedef Compare key_compare;
+  typedef Compare value_compare;
+
+ private:
+  typedef skiplist<key_type, value_type, identity<value_type>, key_compare, Alloc> __rep_type;
+
+  __rep_type __list;
+
+ public:
+  typedef typename __rep_type::const_pointer   pointer;
+  typedef typename __rep_type::const_pointer   const_pointer;
+  typedef typename __rep_type::const_reference reference;
+  typedef typename __rep_type::const_reference const_reference;
+  typedef typename __rep_type::const_iterator  iterator;
+  typedef typename __rep_type::const_iterator  const_iterator;
+  typedef typename __rep_type::size_type       size_type;
+  typedef typename __rep_type::difference_type difference_type;
+  typedef typename __rep_type::allocator_type  allocator_type;
+
+ public:  // constructor, destructor
+  skiplist_set() = default;
+
+  explicit skiplist_set(const Compare& comp, const allocator_type& a = allocator_type()) : __list(comp, a) {}
+
+  template <typename InputIterator>
+  skiplist_set(InputIterator first, InputIterator last) : __list() {
+    __list.insert_unique(first, last);
+  }
+
+  skiplist_set(std::initializer_list<value_type> il) : __list() {
+    __list.insert_unique(il.begin(), il.end());
+  }
+
+  allocator_type get_allocator() const {
+    return __list.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() const {
+    return __list.begin();
+  }
+
+  iterator end() const {
+    return __list.end();
+  }
+
+  const_iterator cbegin() const {
+    return __list.begin();
+  }
+
+  const_iterator cend() const {
+    return __list.end();
+  }
+
+ public:  // capacity
+  // 并发修改时只是一个近似值
+  size_type size() const noexcept {
+    return __list.size();
+  }
+
+  bool empty() const noexcept {
+    return __list.empty();
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return __list.insert_unique(value_type(std::forward<Args>(args)...));
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return __list.insert_unique(value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return __list.insert_unique(std::move(value));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    __list.insert_unique(first, last);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    __list.insert_unique(il.begin(), il.end());
+  }
+
+  size_type erase(const key_type& k) {
+    return __list.erase(k);
+  }
+
+  // 迭代器不会因为删除而失效，删除后仍然可以 ++
+  void erase(iterator pos) {
+    __list.erase(*pos);
+  }
+
+  void clear() {
+    __list.clear();
+  }
+
+ public:  // observers
+  key_compare key_comp() const {
+    return __list.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return __list.key_comp();
+  }
+
+ public:  // set operations
+  iterator find(const key_type& k) const {
+    return __list.find(k);
+  }
+
+  size_type count(const key_type& k) const {
+    return __list.count(k);
+  }
+
+  iterator lower_bound(const key_type& k) const {
+    return __list.lower_bound(k);
+  }
+
+  iterator upper_bound(const key_type& k) const {
+    return __list.upper_bound(k);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) const {
+    return __list.equal_range(k);
+  }
+};
+
+}  // namespace gd
+
+#endif  // !__MY_SKIPLIST_SET__H
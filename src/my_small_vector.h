@@ -0,0 +1,276 @@
+#ifndef __MY_SMALL_VECTOR_H
+#define __MY_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstring>  // for memcpy
+#include <type_traits>
+#include <utility>
+#include "my_alloc.h"
+#include "my_vector.h"
+
+namespace gd {
+
+// small_vector 内部的缓冲区
+template <size_t Bytes, size_t Align>
+struct __small_storage {
+  alignas(Align) unsigned char _buf[Bytes];
+  bool _buf_used;  // 缓冲区是否正在被 vector 使用
+};
+
+// 优先从 small_vector 内部缓冲区分配的配置器，缓冲区放不下或者已经在使用时交给 Alloc
+// 每个 small_vector 的缓冲区不同，所以配置器之间互不相等，也不传播
+template <typename Alloc, size_t Bytes, size_t Align>
+class __small_alloc : public Alloc {
+ public:
+  typedef __small_storage<Bytes, Align> storage;
+
+  __small_alloc(storage* s, const Alloc& a = Alloc()) : Alloc(a), _storage(s) {}
+
+  void* allocate(size_t n) {
+    if (_storage && n <= Bytes && !_storage->_buf_used) {
+      _storage->_buf_used = true;
+      return _storage->_buf;
+    }
+    return Alloc::allocate(n);
+  }
+
+  void deallocate(void* p, size_t n) {
+    if (_storage && p == _storage->_buf)
+      _storage->_buf_used = false;
+    else
+      Alloc::deallocate(p, n);
+  }
+
+  // 只有 Alloc 提供 reallocate 时才有，缓冲区中的数据放不下时搬到 Alloc 分配的内存中
+  template <typename A = Alloc>
+  auto reallocate(void* p, size_t old_sz, size_t new_sz)
+      -> decltype(std::declval<A&>().reallocate(p, old_sz, new_sz)) {
+    if (!_storage || p != _storage->_buf)
+      return Alloc::reallocate(p, old_sz, new_sz);
+    if (new_sz <= Bytes)
+      return p;
+    void* result = Alloc::allocate(new_sz);
+    memcpy(result, p, old_sz);
+    _storage->_buf_used = false;
+    return result;
+  }
+
+  // 拷贝出来的 vector 不能使用原来的缓冲区
+  __small_alloc select_on_container_copy_construction() const {
+    return __small_alloc(0, *this);
+  }
+
+  storage* buffer() const noexcept {
+    return _storage;
+  }
+
+ private:
+  storage* _storage;
+};
+
+template <typename Alloc, size_t Bytes, size_t Align>
+inline bool operator==(const __small_alloc<Alloc, Bytes, Align>& lhs, const __small_alloc<Alloc, Bytes, Align>& rhs) {
+  return lhs.buffer() == rhs.buffer();
+}
+
+template <typename Alloc, size_t Bytes, size_t Align>
+inline bool operator!=(const __small_alloc<Alloc, Bytes, Align>& lhs, const __small_alloc<Alloc, Bytes, Align>& rhs) {
+  return !(lhs == rhs);
+}
+
+// 元素不超过 N 个时保存在对象内部、不需要申请内存的 vector，超过 N 个之后和 vector 一样从 Alloc 申请内存
+// small_vector 就是一个使用 __small_alloc 的 vector，扩容、插入等操作都直接复用 vector 的实现，
+// 缓冲区作为第一个基类，保证在 vector 之前构造、在 vector 之后析构
+// vector 是私有基类：通过基类的移动和 swap 会把指向内部缓冲区的指针交给不拥有它的对象，所以只导出其余的接口
+template <typename T, size_t N, typename Alloc = alloc>
+class small_vector : private __small_storage<sizeof(T) * N, alignof(T)>,
+                     private vector<T, __small_alloc<Alloc, sizeof(T) * N, alignof(T)>> {
+  static_assert(N > 0, "small_vector needs at least one inline element");
+
+  typedef __small_storage<sizeof(T) * N, alignof(T)>   storage;
+  typedef __small_alloc<Alloc, sizeof(T) * N, alignof(T)> small_alloc;
+  typedef vector<T, small_alloc>                          base;
+
+ public:
+  typedef typename base::value_type      value_type;
+  typedef typename base::pointer         pointer;
+  typedef typename base::const_pointer   const_pointer;
+  typedef typename base::iterator        iterator;
+  typedef typename base::const_iterator  const_iterator;
+  typedef typename base::reference       reference;
+  typedef typename base::const_reference const_reference;
+  typedef typename base::size_type       size_type;
+  typedef typename base::difference_type difference_type;
+  typedef typename base::allocator_type  allocator_type;
+
+  using base::get_allocator;
+
+  using base::begin;
+  using base::cbegin;
+  using base::cend;
+  using base::end;
+
+  using base::capacity;
+  using base::empty;
+  using base::max_size;
+  using base::reserve;
+  using base::resize;
+  using base::shrink_to_fit;
+  using base::size;
+
+  using base::data;
+
+  using base::assign;
+  using base::clear;
+  using base::emplace;
+  using base::emplace_back;
+  using base::erase;
+  using base::insert;
+  using base::pop_back;
+  using base::push_back;
+
+  using base::operator[];
+  using base::at;
+  using base::back;
+  using base::front;
+
+ private:
+  bool __is_inline() const noexcept {
+    return this->_start == (pointer)storage::_buf;
+  }
+
+  // 重新使用内部缓冲区，调用前不能持有内存
+  void __reset_inline() noexcept {
+    storage::_buf_used = true;
+    this->_start = (pointer)storage::_buf;
+    this->_finish = this->_start;
+    this->_end_of_storage = this->_start + N;
+  }
+
+  // rhs 的内存来自 Alloc 并且两边的 Alloc 相等时直接接管，否则逐个移动元素
+  // 调用前本 small_vector 为空
+  void __move_from(small_vector& rhs) {
+    if (!rhs.__is_inline() && __alloc_traits<Alloc>::equal(this->get_allocator(), rhs.get_allocator())) {
+      allocator_type a = this->get_allocator();
+      a.deallocate(this->_start, this->capacity());
+      this->_start = rhs._start;
+      this->_finish = rhs._finish;
+      this->_end_of_storage = rhs._end_of_storage;
+      rhs.__reset_inline();
+    } else {
+      this->reserve(rhs.size());
+      this->_finish = gd::uninitialized_move_if_noexcept(rhs.begin(), rhs.end(), this->_start);
+    }
+  }
+
+ public:
+  small_vector() : storage(), base(small_alloc(this)) {
+    __reset_inline();
+  }
+
+  explicit small_vector(const Alloc& a) : storage(), base(small_alloc(this, a)) {
+    __reset_inline();
+  }
+
+  explicit small_vector(size_type n) : small_vector() {
+    this->resize(n);
+  }
+
+  small_vector(size_type n, const value_type& value) : small_vector() {
+    this->assign(n, value);
+  }
+
+  template <typename InputIterator, typename std::enable_if<std::is_pointer<InputIterator>::value, int>::type = 0>
+  small_vector(InputIterator first, InputIterator last) : small_vector() {
+    this->insert(this->end(), first, last);
+  }
+
+  small_vector(std::initializer_list<value_type> il) : small_vector() {
+    this->insert(this->end(), il);
+  }
+
+  small_vector(const small_vector& rhs) : small_vector(rhs.begin(), rhs.end()) {}
+
+  small_vector(small_vector&& rhs) : storage(), base(small_alloc(this, rhs.get_allocator())) {
+    __reset_inline();
+    __move_from(rhs);
+  }
+
+  small_vector& operator=(const small_vector& rhs) {
+    base::operator=(rhs);
+    return *this;
+  }
+
+  small_vector& operator=(small_vector&& rhs) {
+    if (this != &rhs) {
+      this->clear();
+      __move_from(rhs);
+    }
+    return *this;
+  }
+
+  small_vector& operator=(std::initializer_list<value_type> il) {
+    this->assign(il);
+    return *this;
+  }
+
+  // 两边都在 Alloc 分配的内存中时交换指针，否则通过移动交换
+  void swap(small_vector& rhs) {
+    if (this == &rhs)
+      return;
+    if (!__is_inline() && !rhs.__is_inline() &&
+        __alloc_traits<Alloc>::equal(this->get_allocator(), rhs.get_allocator())) {
+      std::swap(this->_start, rhs._start);
+      std::swap(this->_finish, rhs._finish);
+      std::swap(this->_end_of_storage, rhs._end_of_storage);
+    } else {
+      small_vector tmp(std::move(rhs));
+      rhs = std::move(*this);
+      *this = std::move(tmp);
+    }
+  }
+
+  // 内部缓冲区能容纳的元素个数
+  static constexpr size_type inline_capacity() noexcept {
+    return N;
+  }
+};
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator==(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator!=(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator<(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs) {
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator>(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator<=(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator>=(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename T, size_t N, typename Alloc>
+inline void swap(small_vector<T, N, Alloc>& lhs, small_vector<T, N, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_SMALL_VECTOR_H
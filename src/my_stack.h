@@ -1,6 +1,8 @@
 #ifndef __MY_STACK_H
 #define __MY_STACK_H
 
+#include <memory>       // for uses_allocator
+#include <type_traits>  // for enable_if
 #include "my_deque.h"
 
 namespace gd {
@@ -33,6 +35,23 @@ class stack {
 
   stack(stack&& rhs) : _c(std::move(rhs._c)) {}
 
+  // 以下构造函数用指定的配置器构造底层容器，仅当底层容器支持该配置器时可用
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  explicit stack(const Alloc& a) : _c(a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  stack(const Container& c, const Alloc& a) : _c(c, a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  stack(Container&& c, const Alloc& a) : _c(std::move(c), a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  stack(const stack& rhs, const Alloc& a) : _c(rhs._c, a) {}
+
+  template <typename Alloc, typename = typename std::enable_if<std::uses_allocator<Container, Alloc>::value>::type>
+  stack(stack&& rhs, const Alloc& a) : _c(std::move(rhs._c), a) {}
+
   stack& operator=(const stack& rhs) {
     _c = rhs._c;
     return *this;
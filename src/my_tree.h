@@ -1,6 +1,10 @@
 #ifndef __MY_TREE__H
 #define __MY_TREE__H
 
+#include <cstdint>  // for uintptr_t
+#include <system_error>
+#include <thread>
+#include <utility>
 #include "my_alloc.h"
 #include "my_iterator.h"
 
@@ -8,14 +12,49 @@ namespace gd {
 
 enum _rb_tree_color_type { _rb_tree_red = false, _rb_tree_black = true };
 
+// 标记输入区间已经按 key 升序排列，容器据此线性时间建树
+// sorted_unique 表示没有重复的 key，sorted_equivalent 表示可以有重复的 key
+struct sorted_unique_t {
+  explicit sorted_unique_t() = default;
+};
+
+struct sorted_equivalent_t {
+  explicit sorted_equivalent_t() = default;
+};
+
+const sorted_unique_t     sorted_unique = sorted_unique_t();
+const sorted_equivalent_t sorted_equivalent = sorted_equivalent_t();
+
 struct _rb_tree_node_base {
   typedef _rb_tree_color_type color_type;
   typedef _rb_tree_node_base* base_ptr;
 
-  color_type color;
-  base_ptr   parent;
-  base_ptr   left;
-  base_ptr   right;
+  // 节点至少按指针对齐，parent 的最低位总是 0，颜色就存放在这一位上，
+  // 省掉单独的 color 字段以及它带来的对齐填充，只能通过下面的访问函数读写
+  uintptr_t parent_and_color;
+  base_ptr  left;
+  base_ptr  right;
+
+  base_ptr parent() const {
+    return (base_ptr)(parent_and_color & ~(uintptr_t)1);
+  }
+
+  void set_parent(base_ptr p) {
+    parent_and_color = (uintptr_t)p | (parent_and_color & 1);
+  }
+
+  color_type color() const {
+    return (color_type)(parent_and_color & 1);
+  }
+
+  void set_color(color_type c) {
+    parent_and_color = (parent_and_color & ~(uintptr_t)1) | (uintptr_t)c;
+  }
+
+  // 新节点的内存没有初始化过，同时设置 parent 和颜色
+  void init(base_ptr p, color_type c) {
+    parent_and_color = (uintptr_t)p | (uintptr_t)c;
+  }
 
   static base_ptr minimum(base_ptr x) {
     while (x->left != 0)
@@ -30,13 +69,83 @@ struct _rb_tree_node_base {
   }
 };
 
-template <typename Value>
-struct _rb_tree_node : public _rb_tree_node_base {
+// rb_tree 的增强策略，作为 rb_tree 的最后一个模板参数，旋转、插入、删除改变树的形状时通过下面的回调
+// 维护节点上的附加信息；默认不做任何增强，回调都是空函数，节点也不增加任何字段
+struct _rb_tree_no_augment {
+  typedef _rb_tree_node_base node_base;
+  typedef std::false_type    tracks_size;
+
+  // 原来以 x 为根的子树旋转之后以 y 为根
+  static void rotate(_rb_tree_node_base*, _rb_tree_node_base*) {}
+  // x 刚刚链接到树中，还没有调整
+  static void insert(_rb_tree_node_base*, _rb_tree_node_base*) {}
+  // y 即将从它现在的位置上摘下
+  static void remove(_rb_tree_node_base*, _rb_tree_node_base*) {}
+  // y 取代了 z 的位置
+  static void replace(_rb_tree_node_base*, _rb_tree_node_base*) {}
+  // 左右子树都已经建好，重新计算 x 上的信息
+  static void update(_rb_tree_node_base*) {}
+  // 拷贝节点时复制附加信息
+  static void clone(_rb_tree_node_base*, const _rb_tree_node_base*) {}
+};
+
+// 额外记录以该节点为根的子树的大小
+struct _rb_tree_size_node_base : public _rb_tree_node_base {
+  size_t size;
+};
+
+// 顺序统计树：每个节点记录子树大小，rb_tree 据此提供 O(log n) 的 nth、rank 和区间计数，
+// 用法如 gd::set<int, std::less<int>, gd::alloc, gd::order_statistic>
+struct order_statistic {
+  typedef _rb_tree_size_node_base node_base;
+  typedef std::true_type          tracks_size;
+
+  static size_t size(const _rb_tree_node_base* x) {
+    return x ? static_cast<const _rb_tree_size_node_base*>(x)->size : 0;
+  }
+
+  static void set_size(_rb_tree_node_base* x, size_t n) {
+    static_cast<_rb_tree_size_node_base*>(x)->size = n;
+  }
+
+  static void rotate(_rb_tree_node_base* x, _rb_tree_node_base* y) {
+    set_size(y, size(x));
+    update(x);
+  }
+
+  // 从 x 到根节点路径上的每个子树都多了一个节点
+  static void insert(_rb_tree_node_base* x, _rb_tree_node_base* header) {
+    set_size(x, 1);
+    for (_rb_tree_node_base* p = x->parent(); p != header; p = p->parent())
+      ++static_cast<_rb_tree_size_node_base*>(p)->size;
+  }
+
+  static void remove(_rb_tree_node_base* y, _rb_tree_node_base* header) {
+    for (_rb_tree_node_base* p = y->parent(); p != header; p = p->parent())
+      --static_cast<_rb_tree_size_node_base*>(p)->size;
+  }
+
+  static void replace(_rb_tree_node_base* y, _rb_tree_node_base* z) {
+    set_size(y, size(z));
+  }
+
+  static void update(_rb_tree_node_base* x) {
+    set_size(x, size(x->left) + size(x->right) + 1);
+  }
+
+  static void clone(_rb_tree_node_base* x, const _rb_tree_node_base* from) {
+    set_size(x, size(from));
+  }
+};
+
+template <typename Value, typename Base = _rb_tree_node_base>
+struct _rb_tree_node : public Base {
   typedef _rb_tree_node* link_type;
   Value                  value_field;  // 为什么把值放在派生类当中呢？
 };
 
-template <typename Value, typename Ref, typename Ptr>
+// Node 为实际的节点类型，增强的节点在 value_field 之前有附加字段
+template <typename Value, typename Ref, typename Ptr, typename Node = _rb_tree_node<Value>>
 struct _rb_tree_iterator {
   typedef Value                      value_type;
   typedef Ref                        reference;
@@ -45,11 +154,11 @@ struct _rb_tree_iterator {
   typedef bidirectional_iterator_tag iterator_category;
 
   typedef _rb_tree_iterator                                    self;
-  typedef _rb_tree_iterator<Value, Value&, Value*>             iterator;
-  typedef _rb_tree_iterator<Value, const Value&, const Value*> const_iterator;
+  typedef _rb_tree_iterator<Value, Value&, Value*, Node>             iterator;
+  typedef _rb_tree_iterator<Value, const Value&, const Value*, Node> const_iterator;
 
   typedef _rb_tree_node_base::base_ptr base_ptr;
-  typedef _rb_tree_node<Value>*        link_type;
+  typedef Node*                        link_type;
 
   base_ptr node;  // iterator 所指节点
 
@@ -80,10 +189,10 @@ struct _rb_tree_iterator {
       // 找到右子树的最小值
       node = _rb_tree_node_base::minimum(node->right);
     } else {
-      base_ptr y = node->parent;
+      base_ptr y = node->parent();
       while (node == y->right) {  // 找到以当前节点所在子树为左子树的根节点
         node = y;
-        y = y->parent;
+        y = y->parent();
       }
       // 若当前节点为根节点，而根节点没有右子节点，
       // 则此时 node->right = y，而 node 刚好指向 end()
@@ -100,16 +209,16 @@ struct _rb_tree_iterator {
   }
 
   self& operator--() {
-    if (node->color == _rb_tree_red && node->parent->parent == node) {  // node 当前指向 header
-      node = node->right;                                               // 则让 node 指向最大值节点
+    if (node->color() == _rb_tree_red && node->parent()->parent() == node) {  // node 当前指向 header
+      node = node->right;                                                   // 则让 node 指向最大值节点
     } else if (node->left != nullptr) {
       // 找到左子树的最大值
       node = _rb_tree_node_base::maximum(node->left);
     } else {  // 没有左子树了
-      base_ptr y = node->parent;
+      base_ptr y = node->parent();
       while (node == y->left) {  // 找到以当前节点所在子树为右子树的节点
         node = y;
-        y = y->parent;
+        y = y->parent();
       }
       node = y;
       // 若 node 指向根节点且左子树为空，则 node 不变， 还是指向根节点
@@ -140,39 +249,174 @@ struct _rb_tree_iterator {
   }
 };
 
+// 节点句柄：从 rb_tree 中摘下（extract）的节点，可以再插入到另一个配置器相同的树中，全程不分配内存也不拷贝元素
+// 句柄持有节点时负责析构元素并用保存的配置器释放节点；只能移动，不能拷贝
+template <typename Value, typename Node, typename Alloc>
+class _rb_tree_node_handle_base {
+ public:
+  typedef simple_alloc<Value, Alloc> allocator_type;
+
+  _rb_tree_node_handle_base() noexcept : _node(nullptr), _alloc() {}
+
+  _rb_tree_node_handle_base(_rb_tree_node_handle_base&& rhs) noexcept : _node(rhs._node), _alloc(rhs._alloc) {
+    rhs._node = nullptr;
+  }
+
+  _rb_tree_node_handle_base& operator=(_rb_tree_node_handle_base&& rhs) noexcept {
+    if (this != &rhs) {
+      __reset();
+      _node = rhs._node;
+      _alloc = rhs._alloc;
+      rhs._node = nullptr;
+    }
+    return *this;
+  }
+
+  ~_rb_tree_node_handle_base() {
+    __reset();
+  }
+
+  bool empty() const noexcept {
+    return _node == nullptr;
+  }
+
+  explicit operator bool() const noexcept {
+    return _node != nullptr;
+  }
+
+  allocator_type get_allocator() const {
+    return _alloc;
+  }
+
+  void swap(_rb_tree_node_handle_base& rhs) noexcept {
+    std::swap(_node, rhs._node);
+    std::swap(_alloc, rhs._alloc);
+  }
+
+ protected:
+  template <typename, typename, typename, typename, typename, typename>
+  friend class rb_tree;
+
+  _rb_tree_node_handle_base(Node* p, const simple_alloc<Node, Alloc>& a) : _node(p), _alloc(a) {}
+
+  void __reset() noexcept {
+    if (_node) {
+      gd::destroy(&_node->value_field);
+      _alloc.deallocate(_node, 1);
+      _node = nullptr;
+    }
+  }
+
+  // 节点交给树之后句柄为空
+  Node* __release() noexcept {
+    Node* p = _node;
+    _node = nullptr;
+    return p;
+  }
+
+  Node*                     _node;
+  simple_alloc<Node, Alloc> _alloc;
+};
+
+// map 和 multimap 的节点句柄，可以在重新插入之前修改 key
+template <typename Key, typename T, typename Node, typename Alloc>
+class _rb_tree_map_node_handle : public _rb_tree_node_handle_base<std::pair<const Key, T>, Node, Alloc> {
+  typedef _rb_tree_node_handle_base<std::pair<const Key, T>, Node, Alloc> base;
+
+ public:
+  typedef Key key_type;
+  typedef T   mapped_type;
+
+  _rb_tree_map_node_handle() noexcept = default;
+  _rb_tree_map_node_handle(_rb_tree_map_node_handle&&) noexcept = default;
+  _rb_tree_map_node_handle& operator=(_rb_tree_map_node_handle&&) noexcept = default;
+
+  // 节点不在任何树中，改动 key 不会破坏树的顺序
+  key_type& key() const {
+    return const_cast<key_type&>(this->_node->value_field.first);
+  }
+
+  mapped_type& mapped() const {
+    return this->_node->value_field.second;
+  }
+
+ private:
+  template <typename, typename, typename, typename, typename, typename>
+  friend class rb_tree;
+
+  _rb_tree_map_node_handle(Node* p, const simple_alloc<Node, Alloc>& a) : base(p, a) {}
+};
+
+// set 和 multiset 的节点句柄
+template <typename Value, typename Node, typename Alloc>
+class _rb_tree_set_node_handle : public _rb_tree_node_handle_base<Value, Node, Alloc> {
+  typedef _rb_tree_node_handle_base<Value, Node, Alloc> base;
+
+ public:
+  typedef Value value_type;
+
+  _rb_tree_set_node_handle() noexcept = default;
+  _rb_tree_set_node_handle(_rb_tree_set_node_handle&&) noexcept = default;
+  _rb_tree_set_node_handle& operator=(_rb_tree_set_node_handle&&) noexcept = default;
+
+  value_type& value() const {
+    return this->_node->value_field;
+  }
+
+ private:
+  template <typename, typename, typename, typename, typename, typename>
+  friend class rb_tree;
+
+  _rb_tree_set_node_handle(Node* p, const simple_alloc<Node, Alloc>& a) : base(p, a) {}
+};
+
+// insert(node_type&&) 的返回值，插入失败时节点仍在 node 中
+template <typename Iterator, typename NodeHandle>
+struct _rb_tree_insert_return {
+  Iterator   position;
+  bool       inserted;
+  NodeHandle node;
+};
+
 // tree operate
-inline void _rb_tree_rotate_left(_rb_tree_node_base* x, _rb_tree_node_base*& root) {
+// 根节点保存在 header 的 parent 中，旋转或删除改变根节点时通过 header 更新
+// Augment 为增强策略，见 _rb_tree_no_augment
+template <typename Augment = _rb_tree_no_augment>
+inline void _rb_tree_rotate_left(_rb_tree_node_base* x, _rb_tree_node_base* header) {
   _rb_tree_node_base* y = x->right;
   x->right = y->left;
   if (y->left != nullptr)
-    y->left->parent = x;
-  y->parent = x->parent;
+    y->left->set_parent(x);
+  y->set_parent(x->parent());
 
-  if (x == root)
-    root = y;
-  else if (x == x->parent->left)
-    x->parent->left = y;
+  if (x == header->parent())
+    header->set_parent(y);
+  else if (x == x->parent()->left)
+    x->parent()->left = y;
   else
-    x->parent->right = y;
+    x->parent()->right = y;
   y->left = x;
-  x->parent = y;
+  x->set_parent(y);
+  Augment::rotate(x, y);
 }
 
-inline void _rb_tree_rotate_right(_rb_tree_node_base* x, _rb_tree_node_base*& root) {
+template <typename Augment = _rb_tree_no_augment>
+inline void _rb_tree_rotate_right(_rb_tree_node_base* x, _rb_tree_node_base* header) {
   _rb_tree_node_base* y = x->left;
   x->left = y->right;
   if (y->right != nullptr)
-    y->right->parent = x;
-  y->parent = x->parent;
+    y->right->set_parent(x);
+  y->set_parent(x->parent());
 
-  if (x == root)
-    root = y;
-  else if (x == x->parent->right)
-    x->parent->right = y;
+  if (x == header->parent())
+    header->set_parent(y);
+  else if (x == x->parent()->right)
+    x->parent()->right = y;
   else
-    x->parent->left = y;
+    x->parent()->left = y;
   y->right = x;
-  x->parent = y;
+  x->set_parent(y);
+  Augment::rotate(x, y);
 }
 
 /*
@@ -193,51 +437,64 @@ inline void _rb_tree_rotate_right(_rb_tree_node_base* x, _rb_tree_node_base*& ro
       2.2. 插入节点是父节点的左孩子：将父节点设为黑色，祖父节点设为红色，对祖父节点右旋，调整结束
     3. 叔节点不存在或为黑色，且插入节点的父节点为右孩子：(与 2 相同，左右互换即可)
 */
-inline void _rb_tree_rebalance_for_insert(_rb_tree_node_base* x, _rb_tree_node_base*& root) {
-  x->color = _rb_tree_red;                                 // 所有插入节点都为红色
-  while (x != root && x->parent->color == _rb_tree_red) {  // 循环直到父节点为黑色或当前节点为根节点为止
-    if (x->parent == x->parent->parent->left) {
-      _rb_tree_node_base* y = x->parent->parent->right;
-      if (y && y->color == _rb_tree_red) {  // 情况 1
-        x->parent->color = _rb_tree_black;
-        y->color = _rb_tree_black;
-        x->parent->parent->color = _rb_tree_red;
-        x = x->parent->parent;
+// x 为红色，以 x 为根的子树满足红黑树性质，沿 x 向上消除连续的红色节点，最后把根节点设为黑色
+// 返回根节点是否由红变黑，这时整棵树的黑高加一
+template <typename Augment = _rb_tree_no_augment>
+inline bool _rb_tree_fix_red(_rb_tree_node_base* x, _rb_tree_node_base* header) {
+  while (x != header->parent() && x->parent()->color() == _rb_tree_red) {  // 循环直到父节点为黑色或当前节点为根节点为止
+    if (x->parent() == x->parent()->parent()->left) {
+      _rb_tree_node_base* y = x->parent()->parent()->right;
+      if (y && y->color() == _rb_tree_red) {  // 情况 1
+        x->parent()->set_color(_rb_tree_black);
+        y->set_color(_rb_tree_black);
+        x->parent()->parent()->set_color(_rb_tree_red);
+        x = x->parent()->parent();
       } else {
-        if (x == x->parent->right) {  // 情况 2.1
-          x = x->parent;
-          _rb_tree_rotate_left(x, root);
+        if (x == x->parent()->right) {  // 情况 2.1
+          x = x->parent();
+          _rb_tree_rotate_left<Augment>(x, header);
         }
         // 情况 2.2
-        x->parent->color = _rb_tree_black;
-        x->parent->parent->color = _rb_tree_red;
-        _rb_tree_rotate_right(x->parent->parent, root);
+        x->parent()->set_color(_rb_tree_black);
+        x->parent()->parent()->set_color(_rb_tree_red);
+        _rb_tree_rotate_right<Augment>(x->parent()->parent(), header);
       }
     } else {
-      _rb_tree_node_base* y = x->parent->parent->left;
-      if (y && y->color == _rb_tree_red) {  // 情况 1
-        x->parent->color = _rb_tree_black;
-        y->color = _rb_tree_black;
-        x->parent->parent->color = _rb_tree_red;
-        x = x->parent->parent;
+      _rb_tree_node_base* y = x->parent()->parent()->left;
+      if (y && y->color() == _rb_tree_red) {  // 情况 1
+        x->parent()->set_color(_rb_tree_black);
+        y->set_color(_rb_tree_black);
+        x->parent()->parent()->set_color(_rb_tree_red);
+        x = x->parent()->parent();
       } else {
-        if (x == x->parent->left) {  // 情况 2.1
-          x = x->parent;
-          _rb_tree_rotate_right(x, root);
+        if (x == x->parent()->left) {  // 情况 2.1
+          x = x->parent();
+          _rb_tree_rotate_right<Augment>(x, header);
         }
         // 情况 2.2
-        x->parent->color = _rb_tree_black;
-        x->parent->parent->color = _rb_tree_red;
-        _rb_tree_rotate_left(x->parent->parent, root);
+        x->parent()->set_color(_rb_tree_black);
+        x->parent()->parent()->set_color(_rb_tree_red);
+        _rb_tree_rotate_left<Augment>(x->parent()->parent(), header);
       }
     }
   }
-  root->color = _rb_tree_black;  // 不要忘记根节点永远为黑色
+  _rb_tree_node_base* root = header->parent();
+  bool                grew = root->color() == _rb_tree_red;
+  root->set_color(_rb_tree_black);  // 不要忘记根节点永远为黑色
+  return grew;
+}
+
+template <typename Augment = _rb_tree_no_augment>
+inline void _rb_tree_rebalance_for_insert(_rb_tree_node_base* x, _rb_tree_node_base* header) {
+  Augment::insert(x, header);
+  x->set_color(_rb_tree_red);  // 所有插入节点都为红色
+  _rb_tree_fix_red<Augment>(x, header);
 }
 
-inline _rb_tree_node_base* _rb_tree_rebalance_for_remove(_rb_tree_node_base* z, _rb_tree_node_base*& root,
-                                                         _rb_tree_node_base*& leftmost,
-                                                         _rb_tree_node_base*& rightmost) {
+template <typename Augment = _rb_tree_no_augment>
+inline _rb_tree_node_base* _rb_tree_rebalance_for_remove(_rb_tree_node_base* z, _rb_tree_node_base* header) {
+  _rb_tree_node_base*& leftmost = header->left;
+  _rb_tree_node_base*& rightmost = header->right;
   _rb_tree_node_base* y = z;  // z 为待删除节点
   _rb_tree_node_base* x = nullptr;
   _rb_tree_node_base* x_parent = nullptr;
@@ -251,61 +508,65 @@ inline _rb_tree_node_base* _rb_tree_rebalance_for_remove(_rb_tree_node_base* z,
     x = y->left == nullptr ? y->right : y->left;
     // x 可能为空
   }
+  Augment::remove(y, header);  // y 是实际从原位置摘下的节点
 
   if (y != z) {  // 若 y != z，则 z 有两个孩子，此时，y 指向 z 的后继，x 指向 y 的右孩子
     // 用 y 代替 z 的位置，并用 x 顶替 y
 
     // 先将左边接上（1）
-    z->left->parent = y;
+    z->left->set_parent(y);
     y->left = z->left;
 
     // 若 y != z->right，则说明 z 的右孩子肯定有左孩子
     //（因为 y 指向 z 的后继，如果 z 的右孩子没有左孩子，则 z 的后继就是右孩子）
     if (y != z->right) {
       // 用 x 顶替 y
-      x_parent = y->parent;
+      x_parent = y->parent();
       if (x != nullptr)
-        x->parent = x_parent;
-      y->parent->left = x;
+        x->set_parent(x_parent);
+      y->parent()->left = x;
 
       // 再将右边接上（2）
       y->right = z->right;
-      z->right->parent = y;
+      z->right->set_parent(y);
     } else {
       x_parent = y;
     }
 
     // 最后将 y 与 z 的父节点链接起来（3）
-    if (root == z)
-      root = y;
-    else if (z->parent->left == z)
-      z->parent->left = y;
+    if (header->parent() == z)
+      header->set_parent(y);
+    else if (z->parent()->left == z)
+      z->parent()->left = y;
     else
-      z->parent->right = y;
-    y->parent = z->parent;
-    std::swap(y->color, z->color);
+      z->parent()->right = y;
+    y->set_parent(z->parent());
+    Augment::replace(y, z);
+    _rb_tree_color_type c = y->color();
+    y->set_color(z->color());
+    z->set_color(c);
     y = z;  // y 指向最终要删除的节点
   } else {
     // 若 y == z，直接用 x 代替 z
-    x_parent = y->parent;
+    x_parent = y->parent();
     if (x)
-      x->parent = x_parent;
-    if (root == z)
-      root = x;
-    else if (z->parent->left == z)
-      z->parent->left = x;
+      x->set_parent(x_parent);
+    if (header->parent() == z)
+      header->set_parent(x);
+    else if (z->parent()->left == z)
+      z->parent()->left = x;
     else
-      z->parent->right = x;
+      z->parent()->right = x;
 
     if (leftmost == z) {
       if (z->right == nullptr)
-        leftmost = z->parent;
+        leftmost = z->parent();
       else
         leftmost = _rb_tree_node_base::minimum(x);
     }
     if (rightmost == z) {
       if (z->left == nullptr)
-        rightmost = z->parent;
+        rightmost = z->parent();
       else
         rightmost = _rb_tree_node_base::maximum(x);
     }
@@ -334,76 +595,160 @@ inline _rb_tree_node_base* _rb_tree_rebalance_for_remove(_rb_tree_node_base* z,
 
     参考博客：https://www.jianshu.com/p/e136ec79235c
   */
-  if (y->color != _rb_tree_red) {
-    while (x != root && (x == nullptr || x->color == _rb_tree_black)) {  // 情况 2
-      if (x == x_parent->left) {                                         // 情况 2.1
+  if (y->color() != _rb_tree_red) {
+    while (x != header->parent() && (x == nullptr || x->color() == _rb_tree_black)) {  // 情况 2
+      if (x == x_parent->left) {                                                         // 情况 2.1
         _rb_tree_node_base* s = x_parent->right;
-        if (s->color == _rb_tree_red) {  // 情况 2.1.1
-          s->color = _rb_tree_black;
-          x_parent->color = _rb_tree_red;
-          _rb_tree_rotate_left(x_parent, root);
+        if (s->color() == _rb_tree_red) {  // 情况 2.1.1
+          s->set_color(_rb_tree_black);
+          x_parent->set_color(_rb_tree_red);
+          _rb_tree_rotate_left<Augment>(x_parent, header);
           s = x_parent->right;
         }
-        if ((s->left == nullptr || s->left->color == _rb_tree_black) &&
-            (s->right == nullptr || s->right->color == _rb_tree_black)) {  // 情况 2.1.2.1
-          s->color = _rb_tree_red;
+        if ((s->left == nullptr || s->left->color() == _rb_tree_black) &&
+            (s->right == nullptr || s->right->color() == _rb_tree_black)) {  // 情况 2.1.2.1
+          s->set_color(_rb_tree_red);
           x = x_parent;
-          x_parent = x_parent->parent;
+          x_parent = x_parent->parent();
         } else {
-          if (s->right == nullptr || s->right->color == _rb_tree_black) {  // 情况 2.1.2.2
+          if (s->right == nullptr || s->right->color() == _rb_tree_black) {  // 情况 2.1.2.2
             if (s->left)
-              s->left->color = _rb_tree_black;
-            s->color = _rb_tree_red;
-            _rb_tree_rotate_right(s, root);
+              s->left->set_color(_rb_tree_black);
+            s->set_color(_rb_tree_red);
+            _rb_tree_rotate_right<Augment>(s, header);
             s = x_parent->right;
           }
           // 情况 2.1.2.3
-          s->color = x_parent->color;
-          x_parent->color = _rb_tree_black;
+          s->set_color(x_parent->color());
+          x_parent->set_color(_rb_tree_black);
           if (s->right)
-            s->right->color = _rb_tree_black;
-          _rb_tree_rotate_left(x_parent, root);
+            s->right->set_color(_rb_tree_black);
+          _rb_tree_rotate_left<Augment>(x_parent, header);
           break;
         }
       } else {
         _rb_tree_node_base* s = x_parent->left;
-        if (s->color == _rb_tree_red) {  // 情况 2.1.1
-          s->color = _rb_tree_black;
-          x_parent->color = _rb_tree_red;
-          _rb_tree_rotate_right(x_parent, root);
+        if (s->color() == _rb_tree_red) {  // 情况 2.1.1
+          s->set_color(_rb_tree_black);
+          x_parent->set_color(_rb_tree_red);
+          _rb_tree_rotate_right<Augment>(x_parent, header);
           s = x_parent->left;
         }
-        if ((s->left == nullptr || s->left->color == _rb_tree_black) &&
-            (s->right == nullptr || s->right->color == _rb_tree_black)) {  // 情况 2.1.2.1
-          s->color = _rb_tree_red;
+        if ((s->left == nullptr || s->left->color() == _rb_tree_black) &&
+            (s->right == nullptr || s->right->color() == _rb_tree_black)) {  // 情况 2.1.2.1
+          s->set_color(_rb_tree_red);
           x = x_parent;
-          x_parent = x_parent->parent;
+          x_parent = x_parent->parent();
         } else {
-          if (s->left == nullptr || s->left->color == _rb_tree_black) {  // 情况 2.1.2.2
+          if (s->left == nullptr || s->left->color() == _rb_tree_black) {  // 情况 2.1.2.2
             if (s->right)
-              s->right->color = _rb_tree_black;
-            s->color = _rb_tree_red;
-            _rb_tree_rotate_left(s, root);
+              s->right->set_color(_rb_tree_black);
+            s->set_color(_rb_tree_red);
+            _rb_tree_rotate_left<Augment>(s, header);
             s = x_parent->left;
           }
           // 情况 2.1.2.3
-          s->color = x_parent->color;
-          x_parent->color = _rb_tree_black;
+          s->set_color(x_parent->color());
+          x_parent->set_color(_rb_tree_black);
           if (s->left)
-            s->left->color = _rb_tree_black;
-          _rb_tree_rotate_right(x_parent, root);
+            s->left->set_color(_rb_tree_black);
+          _rb_tree_rotate_right<Augment>(x_parent, header);
           break;
         }
       }
     }
     if (x)
-      x->color = _rb_tree_black;
+      x->set_color(_rb_tree_black);
   }
   return y;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc>
-class rb_tree {
+// 以 x 为根的子树的黑高：从 x 到空节点的路径上黑色节点的个数（包括 x），空树为 0
+inline size_t _rb_tree_black_height(const _rb_tree_node_base* x) {
+  size_t h = 0;
+  for (; x != nullptr; x = x->left)
+    h += x->color() == _rb_tree_black;
+  return h;
+}
+
+// 红色的根节点可以直接染黑，黑高加一
+inline void _rb_tree_blacken_root(_rb_tree_node_base* x, size_t& h) {
+  if (x != nullptr && x->color() == _rb_tree_red) {
+    x->set_color(_rb_tree_black);
+    ++h;
+  }
+}
+
+// join：l 中的节点都排在 k 前面，r 中的节点都排在 k 后面，把三者连成一棵红黑树，返回新的根节点
+// lh、rh 为 l、r 的黑高，h 返回新树的黑高；根节点的 parent 没有意义，由调用者设置
+// 黑高相同时 k 直接作为根节点，否则沿较高的树的右链（或左链）往下，找到黑高与较矮的树相同的黑色节点 c，
+// 用红色的 k 取代 c，c 和较矮的树作为 k 的孩子，之后就是插入一个红色节点后的调整，O(|lh - rh| + 1)
+template <typename Augment = _rb_tree_no_augment>
+inline _rb_tree_node_base* _rb_tree_join(_rb_tree_node_base* l, size_t lh, _rb_tree_node_base* k,
+                                         _rb_tree_node_base* r, size_t rh, size_t& h) {
+  _rb_tree_blacken_root(l, lh);
+  _rb_tree_blacken_root(r, rh);
+  if (lh == rh) {
+    k->init(nullptr, _rb_tree_black);
+    k->left = l;
+    k->right = r;
+    if (l)
+      l->set_parent(k);
+    if (r)
+      r->set_parent(k);
+    Augment::update(k);
+    h = lh + 1;
+    return k;
+  }
+
+  // 用一个临时的 header 挂住较高的树，旋转和插入调整就可以原样使用
+  bool                tall_left = lh > rh;
+  _rb_tree_node_base* tall = tall_left ? l : r;
+  _rb_tree_node_base* shorter = tall_left ? r : l;
+  size_t              th = tall_left ? lh : rh;
+  size_t              sh = tall_left ? rh : lh;
+  _rb_tree_node_base  header;
+  header.init(tall, _rb_tree_red);
+  header.left = nullptr;
+  header.right = nullptr;
+  tall->set_parent(&header);
+
+  h = th;
+  _rb_tree_node_base* p = &header;
+  _rb_tree_node_base* c = tall;
+  while (c != nullptr && !(c->color() == _rb_tree_black && th == sh)) {
+    th -= c->color() == _rb_tree_black;
+    p = c;
+    c = tall_left ? c->right : c->left;
+  }
+
+  k->init(p, _rb_tree_red);
+  if (tall_left) {
+    p->right = k;
+    k->left = c;
+    k->right = shorter;
+  } else {
+    p->left = k;
+    k->left = shorter;
+    k->right = c;
+  }
+  if (c)
+    c->set_parent(k);
+  if (shorter)
+    shorter->set_parent(k);
+  Augment::update(k);
+  for (_rb_tree_node_base* q = p; q != &header; q = q->parent())
+    Augment::update(q);
+
+  h += _rb_tree_fix_red<Augment>(k, &header);
+  return header.parent();
+}
+
+// 私有继承 node_allocator，Alloc 有状态时每棵树保存自己的配置器
+// Augment 为增强策略，默认不增强；为 order_statistic 时支持按排名访问
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc,
+          typename Augment = _rb_tree_no_augment>
+class rb_tree : private simple_alloc<_rb_tree_node<Value, typename Augment::node_base>, Alloc> {
  public:
   typedef Key               key_type;
   typedef Value             value_type;
@@ -415,13 +760,13 @@ class rb_tree {
   typedef ptrdiff_t         difference_type;
 
   typedef _rb_tree_node_base   base_type;
-  typedef _rb_tree_node<Value> node_type;
+  typedef _rb_tree_node<Value, typename Augment::node_base> node_type;
   typedef base_type*           base_ptr;
   typedef node_type*           link_type;
   typedef _rb_tree_color_type  color_type;
 
-  typedef _rb_tree_iterator<value_type, reference, pointer>             iterator;
-  typedef _rb_tree_iterator<value_type, const_reference, const_pointer> const_iterator;
+  typedef _rb_tree_iterator<value_type, reference, pointer, node_type>             iterator;
+  typedef _rb_tree_iterator<value_type, const_reference, const_pointer, node_type> const_iterator;
 
   typedef simple_alloc<Value, Alloc>     allocator_type;
   typedef simple_alloc<Value, Alloc>     data_allocator;
@@ -429,7 +774,7 @@ class rb_tree {
   typedef simple_alloc<node_type, Alloc> node_allocator;
 
   allocator_type get_allocator() const {
-    return allocator_type();
+    return _get_alloc();
   }
 
  protected:
@@ -437,6 +782,14 @@ class rb_tree {
   size_type _node_count;
   Compare   _key_compare;
 
+  node_allocator& _get_alloc() noexcept {
+    return *this;
+  }
+
+  const node_allocator& _get_alloc() const noexcept {
+    return *this;
+  }
+
   link_type _get_node() {
     return node_allocator::allocate(1);
   }
@@ -459,9 +812,10 @@ class rb_tree {
 
   link_type _clone_node(link_type x) {
     link_type tmp = _create_node(x->value_field);
-    tmp->color = x->color;
+    tmp->init(nullptr, x->color());
     tmp->left = nullptr;
     tmp->right = nullptr;
+    Augment::clone(tmp, x);
     return tmp;
   }
 
@@ -470,8 +824,13 @@ class rb_tree {
     _put_node(p);
   }
 
-  link_type& _root() const {
-    return (link_type&)_header->parent;
+  // 根节点是 header 的 parent
+  link_type _root() const {
+    return (link_type)_header->parent();
+  }
+
+  void _set_root(link_type x) {
+    _header->set_parent(x);
   }
 
   link_type& _leftmost() const {
@@ -490,8 +849,8 @@ class rb_tree {
     return (link_type&)(x->right);
   }
 
-  static link_type& _parent(link_type x) {
-    return (link_type&)(x->parent);
+  static link_type _parent(link_type x) {
+    return (link_type)x->parent();
   }
 
   static reference _value(link_type x) {
@@ -502,8 +861,8 @@ class rb_tree {
     return KeyOfValue()(_value(x));
   }
 
-  static color_type& _color(link_type x) {
-    return (color_type&)(x->color);
+  static color_type _color(link_type x) {
+    return x->color();
   }
 
   static link_type& _left(base_ptr x) {
@@ -514,8 +873,8 @@ class rb_tree {
     return (link_type&)(x->right);
   }
 
-  static link_type& _parent(base_ptr x) {
-    return (link_type&)(x->parent);
+  static link_type _parent(base_ptr x) {
+    return (link_type)x->parent();
   }
 
   static reference _value(base_ptr x) {
@@ -526,8 +885,8 @@ class rb_tree {
     return KeyOfValue()(_value(x));
   }
 
-  static color_type& _color(base_ptr x) {
-    return (color_type&)(x->color);
+  static color_type _color(base_ptr x) {
+    return x->color();
   }
 
   static link_type _minimum(link_type x) {
@@ -541,8 +900,7 @@ class rb_tree {
  private:  // helper functions
   void __empty_init() {
     _header = _get_node();  // _header 的 value_field 是没有初始化的
-    _color(_header) = _rb_tree_red;
-    _root() = nullptr;
+    _header->init(nullptr, _rb_tree_red);  // header 为红色，根节点为黑色，iterator 据此区分两者
     _leftmost() = _header;
     _rightmost() = _header;
     _node_count = 0;
@@ -555,7 +913,7 @@ class rb_tree {
       // 若 z 比 y 小，则插在 y 的左边
       _left(y) = z;
       if (y == _header) {  // 若 y 是 header，则令 z 为根节点
-        _root() = z;
+        _set_root(z);
         _rightmost() = z;
       } else if (y == _leftmost()) {
         _leftmost() = z;
@@ -566,10 +924,10 @@ class rb_tree {
         _rightmost() = z;
     }
 
-    _parent(z) = y;
+    z->init(y, _rb_tree_red);
     _left(z) = nullptr;
     _right(z) = nullptr;
-    _rb_tree_rebalance_for_insert(z, _header->parent);
+    _rb_tree_rebalance_for_insert<Augment>(z, _header);
     ++_node_count;
     return iterator(z);
   }
@@ -583,7 +941,7 @@ class rb_tree {
       // 若 z 比 y 小，则插在 y 的左边
       _left(y) = z;
       if (y == _header) {  // 若 y 是 header，则令 z 为根节点
-        _root() = z;
+        _set_root(z);
         _rightmost() = z;
       } else if (y == _leftmost()) {
         _leftmost() = z;
@@ -594,10 +952,10 @@ class rb_tree {
         _rightmost() = z;
     }
 
-    _parent(z) = y;
+    z->init(y, _rb_tree_red);
     _left(z) = nullptr;
     _right(z) = nullptr;
-    _rb_tree_rebalance_for_insert(z, _header->parent);
+    _rb_tree_rebalance_for_insert<Augment>(z, _header);
     ++_node_count;
     return iterator(z);
   }
@@ -630,25 +988,239 @@ class rb_tree {
       insert_equal(*first);
   }
 
+  // 以下几个函数寻找 key 为 k 的新节点的插入位置，返回 (x, y)，用于 __insert(x, y, z)：
+  // y 为插入节点的父节点，x 不为空时插在 y 的左边；
+  // 对于 unique 版本，y 为空表示 k 已经存在，x 指向已有的节点
+  std::pair<link_type, link_type> __get_insert_unique_pos(const key_type& k) {
+    link_type y = _header;
+    link_type x = _root();
+    bool      comp = true;
+    while (x != nullptr) {
+      y = x;
+      comp = _key_compare(k, _key(x));
+      x = comp ? _left(x) : _right(x);
+    }
+    iterator j = iterator(y);
+    if (comp) {
+      if (j == begin())
+        return std::make_pair(x, y);
+      --j;
+    }
+    if (_key_compare(_key(j.node), k))
+      return std::make_pair(x, y);
+    return std::make_pair((link_type)j.node, (link_type)0);
+  }
+
+  std::pair<link_type, link_type> __get_insert_equal_pos(const key_type& k) {
+    link_type y = _header;
+    link_type x = _root();
+    while (x != nullptr) {
+      y = x;
+      x = _key_compare(k, _key(x)) ? _left(x) : _right(x);
+    }
+    return std::make_pair(x, y);
+  }
+
+  // 先检查 k 是否刚好落在 pos 前面或者后面，是的话常数时间就能确定位置，否则退化为从根节点查找
+  std::pair<link_type, link_type> __get_insert_hint_unique_pos(iterator pos, const key_type& k) {
+    if (pos.node == _header) {  // end()
+      if (size() > 0) {
+        if (_key_compare(_key(_rightmost()), k))  // 比最大的还大，接在最右边
+          return std::make_pair((link_type)0, _rightmost());
+        if (!_key_compare(k, _key(_rightmost())))  // 和最大的相等
+          return std::make_pair(_rightmost(), (link_type)0);
+      }
+      return __get_insert_unique_pos(k);
+    }
+    if (_key_compare(k, _key(pos.node))) {  // k < *pos，看看是否 *(pos - 1) < k
+      if (pos.node == _leftmost())
+        return std::make_pair(_leftmost(), _leftmost());
+      iterator before = pos;
+      --before;
+      if (_key_compare(_key(before.node), k)) {
+        if (_right(before.node) == nullptr)
+          return std::make_pair((link_type)0, (link_type)before.node);
+        return std::make_pair((link_type)pos.node, (link_type)pos.node);
+      }
+      return __get_insert_unique_pos(k);
+    }
+    if (_key_compare(_key(pos.node), k)) {  // *pos < k，看看是否 k < *(pos + 1)
+      if (pos.node == _rightmost())
+        return std::make_pair((link_type)0, _rightmost());
+      iterator after = pos;
+      ++after;
+      if (_key_compare(k, _key(after.node))) {
+        if (_right(pos.node) == nullptr)
+          return std::make_pair((link_type)0, (link_type)pos.node);
+        return std::make_pair((link_type)after.node, (link_type)after.node);
+      }
+      return __get_insert_unique_pos(k);
+    }
+    return std::make_pair((link_type)pos.node, (link_type)0);  // 相等
+  }
+
+  std::pair<link_type, link_type> __get_insert_hint_equal_pos(iterator pos, const key_type& k) {
+    if (pos.node == _header) {  // end()
+      if (size() > 0 && !_key_compare(k, _key(_rightmost())))
+        return std::make_pair((link_type)0, _rightmost());
+      return __get_insert_equal_pos(k);
+    }
+    if (!_key_compare(_key(pos.node), k)) {  // k <= *pos，看看是否 *(pos - 1) <= k
+      if (pos.node == _leftmost())
+        return std::make_pair(_leftmost(), _leftmost());
+      iterator before = pos;
+      --before;
+      if (!_key_compare(k, _key(before.node))) {
+        if (_right(before.node) == nullptr)
+          return std::make_pair((link_type)0, (link_type)before.node);
+        return std::make_pair((link_type)pos.node, (link_type)pos.node);
+      }
+      return __get_insert_equal_pos(k);
+    }
+    // *pos < k，看看是否 k <= *(pos + 1)
+    if (pos.node == _rightmost())
+      return std::make_pair((link_type)0, _rightmost());
+    iterator after = pos;
+    ++after;
+    if (!_key_compare(_key(after.node), k)) {
+      if (_right(pos.node) == nullptr)
+        return std::make_pair((link_type)0, (link_type)pos.node);
+      return std::make_pair((link_type)after.node, (link_type)after.node);
+    }
+    return __get_insert_equal_pos(k);
+  }
+
+  template <typename V>
+  iterator __insert_unique_hint(iterator pos, V&& value) {
+    std::pair<link_type, link_type> res = __get_insert_hint_unique_pos(pos, KeyOfValue()(value));
+    if (res.second == nullptr)
+      return iterator(res.first);
+    return __insert(res.first, res.second, _create_node(std::forward<V>(value)));
+  }
+
+  // 检查 [first, last) 是否有序，unique 为 true 时不能有重复的 key
+  // 有序时返回 true，n 为元素个数，unique 为 true 时重复的 key 只算一个
+  template <typename ForwardIterator>
+  bool __count_sorted(ForwardIterator first, ForwardIterator last, bool unique, size_type& n) const {
+    n = 0;
+    if (first == last)
+      return true;
+    n = 1;
+    ForwardIterator prev = first;
+    for (++first; first != last; prev = first, ++first) {
+      if (_key_compare(KeyOfValue()(*first), KeyOfValue()(*prev)))
+        return false;
+      if (!unique || _key_compare(KeyOfValue()(*prev), KeyOfValue()(*first)))
+        ++n;
+    }
+    return true;
+  }
+
+  // 按中序从 first 开始取 n 个元素，建立一棵完全平衡的子树，左右子树的大小最多相差 1，
+  // 所以除了最底下一层（深度为 red_depth）以外各层都是满的，把最底下一层设为红色、其余设为黑色，
+  // 每条路径上的黑色节点数目就都相同；节点按 key 的顺序依次申请
+  // unique 为 true 时跳过与前一个元素相等的元素
+  template <typename ForwardIterator>
+  link_type __build_sorted(ForwardIterator& first, ForwardIterator last, size_type n, size_type depth,
+                           size_type red_depth, bool unique) {
+    if (n == 0)
+      return nullptr;
+    size_type nl = (n - 1) / 2;
+    link_type left = __build_sorted(first, last, nl, depth + 1, red_depth, unique);
+    link_type x;
+    try {
+      x = _create_node(*first);
+    } catch (...) {
+      __erase(left);
+      throw;
+    }
+    x->init(nullptr, depth == red_depth ? _rb_tree_red : _rb_tree_black);
+    x->left = left;
+    x->right = nullptr;
+    if (left)
+      left->set_parent(x);
+    ++first;
+    while (unique && first != last && !_key_compare(_key(x), KeyOfValue()(*first)))
+      ++first;
+
+    try {
+      x->right = __build_sorted(first, last, n - 1 - nl, depth + 1, red_depth, unique);
+    } catch (...) {
+      __erase(x);
+      throw;
+    }
+    if (x->right)
+      x->right->set_parent(x);
+    Augment::update(x);
+    return x;
+  }
+
+  template <typename InputIterator>
+  void __assign_sorted_dispatch(InputIterator first, InputIterator last, bool unique, input_iterator_tag) {
+    for (; first != last; ++first) {
+      if (unique)
+        insert_unique(*first);
+      else
+        insert_equal(*first);
+    }
+  }
+
+  // 需要遍历两次，先检查是否有序并计数，无序时退化为逐个插入
+  template <typename ForwardIterator>
+  void __assign_sorted_dispatch(ForwardIterator first, ForwardIterator last, bool unique, forward_iterator_tag) {
+    size_type n;
+    if (!__count_sorted(first, last, unique, n)) {
+      __assign_sorted_dispatch(first, last, unique, input_iterator_tag());
+      return;
+    }
+    if (n == 0)
+      return;
+    size_type red_depth = 0;
+    for (size_type m = n; m > 1; m >>= 1)
+      ++red_depth;
+    link_type root = __build_sorted(first, last, n, 0, red_depth, unique);
+    root->init(_header, _rb_tree_black);
+    _set_root(root);
+    _leftmost() = _minimum(root);
+    _rightmost() = _maximum(root);
+    _node_count = n;
+  }
+
+  // 红黑树的高度不超过 2log(n+1)，n 不会超过 size_type 的范围，下面的遍历用这么大的数组作栈就足够了
+  enum { __MAX_HEIGHT = 2 * 8 * sizeof(size_type) };
+
   // 将以 x 为根节点的树拷贝到 p 上
+  // 不递归，按先序拷贝，沿左链往下走，右孩子连同它在新树中的父节点一起压栈，
+  // 栈中的节点都是当前路径上某个节点的右孩子，所以栈的深度不超过树高
   link_type __copy(link_type x, link_type p) {
     link_type top = _clone_node(x);
-    top->parent = p;
+    top->set_parent(p);
 
     try {
-      if (x->right)  // 右子树递归拷贝
-        top->right = __copy(_right(x), top);
-      p = top;
-      x = _left(x);  // 左子树不递归？
-
-      while (x != 0) {
-        link_type y = _clone_node(x);
-        p->left = y;
-        y->parent = p;
-        if (x->right)
-          y->right = __copy(_right(x), y);
-        p = y;
-        x = _left(x);
+      link_type src_stack[__MAX_HEIGHT];
+      link_type dst_stack[__MAX_HEIGHT];
+      size_type depth = 0;
+      link_type dst = top;
+      for (;;) {
+        if (x->right != nullptr) {
+          src_stack[depth] = _right(x);
+          dst_stack[depth++] = dst;
+        }
+        link_type y;
+        if (x->left != nullptr) {
+          x = _left(x);
+          y = _clone_node(x);
+          dst->left = y;
+        } else if (depth != 0) {
+          x = src_stack[--depth];
+          dst = dst_stack[depth];
+          y = _clone_node(x);
+          dst->right = y;
+        } else {
+          break;
+        }
+        y->set_parent(dst);
+        dst = y;
       }
     } catch (...) {
       __erase(top);
@@ -658,14 +1230,36 @@ class rb_tree {
     return top;
   }
 
-  // 只删除，不平衡，仅供内部使用
-  void __erase(link_type x) {
-    while (x != nullptr) {
-      __erase(_right(x));  // 只递归一边，真的可以降低复杂度吗？
-      link_type y = _left(x);
-      destroy_node(x);
-      x = y;
+  // 只删除，不平衡，仅供内部使用，返回删除的节点个数
+  // 不递归，沿左链往下删，右子树压栈稍后再删，栈的深度不超过树高
+  size_type __erase(link_type x) {
+    link_type stack[__MAX_HEIGHT];
+    size_type depth = 0;
+    size_type n = 0;
+    for (;;) {
+      while (x != nullptr) {
+        if (x->right != nullptr)
+          stack[depth++] = _right(x);
+        link_type y = _left(x);
+        destroy_node(x);
+        ++n;
+        x = y;
+      }
+      if (depth == 0)
+        break;
+      x = stack[--depth];
     }
+    return n;
+  }
+
+  // 析构时所有节点（包括头节点）都要释放，元素不需要析构并且配置器手上只有本树的节点时，
+  // 不用遍历整棵树，由配置器一次整块释放
+  bool __deallocate_all(std::true_type) {
+    return std::is_trivially_destructible<value_type>::value && node_allocator::deallocate_all(_node_count + 1);
+  }
+
+  bool __deallocate_all(std::false_type) {
+    return false;
   }
 
  public:  // constructors, copy, destructors
@@ -673,17 +1267,25 @@ class rb_tree {
     __empty_init();
   }
 
-  rb_tree(const rb_tree& rhs) {
+  explicit rb_tree(const Compare& comp, const allocator_type& a = allocator_type())
+      : node_allocator(a), _key_compare(comp) {
     __empty_init();
-    if (rhs._root() != nullptr) {
-      _root() = __copy(rhs._root(), _header);
-      _leftmost() = _minimum(_root());
-      _rightmost() = _maximum(_root());
-    }
-    _node_count = rhs._node_count;
   }
 
-  rb_tree(rb_tree&& rhs) noexcept {
+  // 拷贝时配置器由 select_on_container_copy_construction() 决定
+  rb_tree(const rb_tree& rhs)
+      : node_allocator(rhs._get_alloc().select_on_container_copy_construction()), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  rb_tree(const rb_tree& rhs, const allocator_type& a) : node_allocator(a), _key_compare(rhs._key_compare) {
+    __empty_init();
+    __copy_from(rhs);
+  }
+
+  // 移动时配置器随节点一起转移
+  rb_tree(rb_tree&& rhs) noexcept : node_allocator(std::move(rhs._get_alloc())) {
     _header = rhs._header;
     _node_count = rhs._node_count;
     _key_compare = rhs._key_compare;
@@ -692,17 +1294,45 @@ class rb_tree {
     rhs._node_count = 0;
   }
 
+  rb_tree(rb_tree&& rhs, const allocator_type& a) : node_allocator(a), _key_compare(rhs._key_compare) {
+    if (_get_alloc() == rhs._get_alloc()) {
+      _header = rhs._header;
+      _node_count = rhs._node_count;
+      rhs._header = nullptr;
+      rhs._node_count = 0;
+    } else {
+      __empty_init();
+      try {
+        __move_elements(rhs);
+      } catch (...) {
+        clear();
+        _put_node(_header);
+        throw;
+      }
+    }
+  }
+
   rb_tree& operator=(const rb_tree& rhs) {
     if (this != &rhs) {
+      if (node_allocator::propagate_on_container_copy_assignment::value && _get_alloc() != rhs._get_alloc()) {
+        // 新的配置器不能释放旧的节点，先用旧的配置器全部释放掉，头节点也要换成新配置器分配的
+        clear();
+        _put_node(_header);
+        _header = nullptr;
+        gd::__alloc_on_copy(_get_alloc(), rhs._get_alloc());
+        __empty_init();
+      } else {
+        gd::__alloc_on_copy(_get_alloc(), rhs._get_alloc());
+      }
       clear();
       _node_count = 0;
       _key_compare = rhs._key_compare;
       if (rhs._root() == nullptr) {
-        _root() = nullptr;
+        _set_root(nullptr);
         _leftmost() = _header;
         _rightmost() = _header;
       } else {
-        _root() = __copy(rhs._root(), _header);
+        _set_root(__copy(rhs._root(), _header));
         _leftmost() = _minimum(_root());
         _rightmost() = _maximum(_root());
         _node_count = rhs._node_count;
@@ -712,21 +1342,55 @@ class rb_tree {
   }
 
   rb_tree& operator=(rb_tree&& rhs) {
-    if (this != &rhs) {
-      clear();
-      _header = rhs._header;
-      _node_count = rhs._node_count;
-      _key_compare = rhs._key_compare;
-      rhs._header = nullptr;
-      rhs._node_count = 0;
-    }
+    if (this != &rhs)
+      __move_assign(rhs, __alloc_move_steals<node_allocator>());
     return *this;
   }
 
   ~rb_tree() {
-    clear();
-    if (_header)
+    if (_header && !__deallocate_all(typename node_allocator::has_deallocate_all())) {
+      clear();
       _put_node(_header);
+    }
+  }
+
+ private:  // copy and move helpers
+  // 拷贝 rhs 的所有节点，调用前本树必须为空
+  void __copy_from(const rb_tree& rhs) {
+    if (rhs._root() != nullptr) {
+      _set_root(__copy(rhs._root(), _header));
+      _leftmost() = _minimum(_root());
+      _rightmost() = _maximum(_root());
+    }
+    _node_count = rhs._node_count;
+  }
+
+  // 配置器不相等时，rhs 的节点不能由本树释放，只能逐个移动元素，调用前本树必须为空
+  // rhs 已经有序，每个新节点都直接接在最右边
+  void __move_elements(rb_tree& rhs) {
+    for (iterator it = rhs.begin(); it != rhs.end(); ++it)
+      __insert(nullptr, _rightmost(), _create_node(std::move(*it)));
+  }
+
+  // 配置器会传播或者总是相等，节点直接交换过来，rhs 留下本树已经清空的头节点，
+  // 配置器传播时也要一起交换，这样头节点仍由分配它的配置器释放
+  void __move_assign(rb_tree& rhs, std::true_type) {
+    clear();
+    std::swap(_header, rhs._header);
+    std::swap(_node_count, rhs._node_count);
+    _key_compare = rhs._key_compare;
+    gd::__alloc_on_swap(_get_alloc(), rhs._get_alloc(),
+                    typename node_allocator::propagate_on_container_move_assignment());
+  }
+
+  void __move_assign(rb_tree& rhs, std::false_type) {
+    if (_get_alloc() == rhs._get_alloc()) {
+      __move_assign(rhs, std::true_type());
+    } else {
+      clear();
+      _key_compare = rhs._key_compare;
+      __move_elements(rhs);
+    }
   }
 
  public:  // iterator
@@ -792,38 +1456,16 @@ class rb_tree {
     return std::make_pair(j, false);
   }
 
+  // 需要先构造出节点才能拿到 key，key 已经存在时再释放掉；已经有完整的元素时用 insert_unique(pos, value)，
+  // key 存在时不会分配节点
   template <typename... Args>
-  iterator emplace_unique(iterator pos, Args... args) {
-    link_type p = _create_node(std::forward<Args>(args)...);
-
-    if (pos.node == _header->left) {                              // begin()
-      if (size() > 0 && _key_compare(_key(p), _key(pos.node))) {  // 若比最小的还小
-        return __insert((link_type)pos.node, (link_type)pos.node, p);
-      } else {
-        destroy_node(p);  // TODO(dong) 这里效率有待提高
-        return emplace_unique(std::forward<Args>(args)...).first;
-      }
-    } else if (pos.node == _header) {                   // end()
-      if (_key_compare(_key(_rightmost()), _key(p))) {  // 若比最大的还大
-        return __insert((link_type)0, _rightmost(), p);  // 这里参数 x 设为空，直接在 __insert() 中提前进入第一种情况
-      } else {
-        destroy_node(p);  // TODO(dong) 这里效率有待提高
-        return emplace_unique(std::forward<Args>(args)...).first;
-      }
-    } else {
-      iterator before = pos;
-      --before;
-      if (_key_compare(_key(before.node), _key(p)) && _key_compare(_key(p), _key(pos.node))) {
-        // 若 *(--pos) < p->value < *(pos)
-        if (_right(before.node) == nullptr)  // 插到右边
-          return __insert((link_type)0, (link_type)before.node, p);
-        else
-          return __insert((link_type)pos.node, (link_type)pos.node, p);
-      } else {
-        destroy_node(p);  // TODO(dong) 这里效率有待提高
-        return emplace_unique(std::forward<Args>(args)...).first;
-      }
-    }
+  iterator emplace_unique(iterator pos, Args&&... args) {
+    link_type                       z = _create_node(std::forward<Args>(args)...);
+    std::pair<link_type, link_type> res = __get_insert_hint_unique_pos(pos, _key(z));
+    if (res.second != nullptr)
+      return __insert(res.first, res.second, z);
+    destroy_node(z);
+    return iterator(res.first);
   }
 
   template <typename... Args>
@@ -840,37 +1482,10 @@ class rb_tree {
   }
 
   template <typename... Args>
-  iterator emplace_equal(iterator pos, Args... args) {
-    link_type p = _create_node(std::forward<Args>(args)...);
-
-    if (pos.node == _header->left) {                              // begin()
-      if (size() > 0 && _key_compare(_key(p), _key(pos.node))) {  // 若比最小的还小
-        return __insert((link_type)pos.node, (link_type)pos.node, p);
-      } else {
-        destroy_node(p);  // TODO(dong) 这里效率有待提高
-        return emplace_equal(std::forward<Args>(args)...);
-      }
-    } else if (pos.node == _header) {                   // end()
-      if (_key_compare(_key(_rightmost()), _key(p))) {  // 若比最大的还大
-        return __insert((link_type)0, _rightmost(), p);  // 这里参数 x 设为空，直接在 __insert() 中提前进入第一种情况
-      } else {
-        destroy_node(p);  // TODO(dong) 这里效率有待提高
-        return emplace_equal(std::forward<Args>(args)...);
-      }
-    } else {
-      iterator before = pos;
-      --before;
-      if (_key_compare(_key(before.node), _key(p)) && _key_compare(_key(p), _key(pos.node))) {
-        // 若 *(--pos) < p->value < *(pos)
-        if (_right(before.node) == nullptr)  // 插到右边
-          return __insert((link_type)0, (link_type)before.node, p);
-        else
-          return __insert((link_type)pos.node, (link_type)pos.node, p);
-      } else {
-        destroy_node(p);  // TODO(dong) 这里效率有待提高
-        return emplace_equal(std::forward<Args>(args)...);
-      }
-    }
+  iterator emplace_equal(iterator pos, Args&&... args) {
+    link_type                       z = _create_node(std::forward<Args>(args)...);
+    std::pair<link_type, link_type> res = __get_insert_hint_equal_pos(pos, _key(z));
+    return __insert(res.first, res.second, z);
   }
 
   std::pair<iterator, bool> insert_unique(const value_type& value) {
@@ -901,8 +1516,12 @@ class rb_tree {
     return std::make_pair(j, false);
   }
 
+  // key 已经存在时不分配节点
   std::pair<iterator, bool> insert_unique(value_type&& value) {
-    return emplace_unique(std::move(value));
+    std::pair<link_type, link_type> res = __get_insert_unique_pos(KeyOfValue()(value));
+    if (res.second == nullptr)
+      return std::make_pair(iterator(res.first), false);
+    return std::make_pair(__insert(res.first, res.second, _create_node(std::move(value))), true);
   }
 
   template <typename InputIterator>
@@ -910,12 +1529,29 @@ class rb_tree {
     __insert_unique_dispatch(first, last, iterator_category(first));
   }
 
+  // 清空后用有序区间 [first, last) 线性时间建立一棵平衡的树，重复的 key 只保留第一个
+  // 区间无序时退化为逐个 insert_unique
+  template <typename InputIterator>
+  void assign_sorted_unique(InputIterator first, InputIterator last) {
+    clear();
+    __assign_sorted_dispatch(first, last, true, iterator_category(first));
+  }
+
+  // 同上，保留重复的 key
+  template <typename InputIterator>
+  void assign_sorted_equal(InputIterator first, InputIterator last) {
+    clear();
+    __assign_sorted_dispatch(first, last, false, iterator_category(first));
+  }
+
+  // hint 正确时（例如按 key 递增的顺序在 end() 处插入）只需常数次比较，再加上均摊常数时间的调整
+  // key 已经存在时不分配节点
   iterator insert_unique(iterator pos, const value_type& value) {
-    return emplace_unique(pos, value);
+    return __insert_unique_hint(pos, value);
   }
 
-  iterator insert_unique(iterator pos, const value_type&& value) {
-    return emplace_unique(pos, std::move(value));
+  iterator insert_unique(iterator pos, value_type&& value) {
+    return __insert_unique_hint(pos, std::move(value));
   }
 
   iterator insert_equal(const value_type& value) {
@@ -942,13 +1578,13 @@ class rb_tree {
     return emplace_equal(pos, value);
   }
 
-  iterator insert_equal(iterator pos, const value_type&& value) {
+  iterator insert_equal(iterator pos, value_type&& value) {
     return emplace_equal(pos, std::move(value));
   }
 
   void erase(iterator pos) {
     link_type y =
-        static_cast<link_type>(_rb_tree_rebalance_for_remove(pos.node, _header->parent, _header->left, _header->right));
+        static_cast<link_type>(_rb_tree_rebalance_for_remove<Augment>(pos.node, _header));
     destroy_node(y);
     --_node_count;
   }
@@ -974,7 +1610,7 @@ class rb_tree {
     if (_node_count != 0) {
       __erase(_root());
       _leftmost() = _header;
-      _root() = nullptr;
+      _set_root(nullptr);
       _rightmost() = _header;
       _node_count = 0;
     }
@@ -984,85 +1620,610 @@ class rb_tree {
     std::swap(_header, rhs._header);
     std::swap(_node_count, rhs._node_count);
     std::swap(_key_compare, rhs._key_compare);
+    gd::__alloc_on_swap(_get_alloc(), rhs._get_alloc());
+  }
+
+ public:  // node handles
+  // 摘下 pos 处的节点交给句柄，不释放节点也不析构元素
+  template <typename NodeHandle>
+  NodeHandle extract(iterator pos) {
+    return NodeHandle(__unlink(pos), _get_alloc());
+  }
+
+  // 有多个相等的 key 时摘下第一个，没有时返回空的句柄
+  template <typename NodeHandle>
+  NodeHandle extract(const key_type& k) {
+    iterator it = find(k);
+    return it == end() ? NodeHandle(nullptr, _get_alloc()) : extract<NodeHandle>(it);
+  }
+
+  // 把句柄中的节点链接进树中；key 已经存在时不插入，节点留在句柄中，返回已有的元素
+  template <typename NodeHandle>
+  std::pair<iterator, bool> insert_node_unique(NodeHandle& nh) {
+    if (nh.empty())
+      return std::make_pair(end(), false);
+    std::pair<link_type, link_type> res = __get_insert_unique_pos(KeyOfValue()(nh._node->value_field));
+    if (res.second == nullptr)
+      return std::make_pair(iterator(res.first), false);
+    return std::make_pair(__insert(res.first, res.second, __adopt(nh)), true);
+  }
+
+  template <typename NodeHandle>
+  iterator insert_node_unique(iterator pos, NodeHandle& nh) {
+    if (nh.empty())
+      return end();
+    std::pair<link_type, link_type> res = __get_insert_hint_unique_pos(pos, KeyOfValue()(nh._node->value_field));
+    if (res.second == nullptr)
+      return iterator(res.first);
+    return __insert(res.first, res.second, __adopt(nh));
+  }
+
+  template <typename NodeHandle>
+  iterator insert_node_equal(NodeHandle& nh) {
+    if (nh.empty())
+      return end();
+    std::pair<link_type, link_type> res = __get_insert_equal_pos(KeyOfValue()(nh._node->value_field));
+    return __insert(res.first, res.second, __adopt(nh));
+  }
+
+  template <typename NodeHandle>
+  iterator insert_node_equal(iterator pos, NodeHandle& nh) {
+    if (nh.empty())
+      return end();
+    std::pair<link_type, link_type> res = __get_insert_hint_equal_pos(pos, KeyOfValue()(nh._node->value_field));
+    return __insert(res.first, res.second, __adopt(nh));
+  }
+
+  // 把 src 的节点逐个摘下链接到本树中，不分配节点也不拷贝元素，本树中已经存在的 key 留在 src 中
+  // src 按它自己的顺序遍历，与本树的顺序相同时上一个插入位置的后面就是下一个节点的位置，
+  // 用它作 hint，每个节点只需要常数次比较；两棵树的配置器不相等时节点不能混用，退化为移动元素
+  template <typename Compare2>
+  void merge_unique(rb_tree<Key, Value, KeyOfValue, Compare2, Alloc, Augment>& src) {
+    if ((const void*)&src == (const void*)this)
+      return;
+    if (!__same_alloc(src)) {
+      for (iterator it = src.begin(); it != src.end();) {
+        if (insert_unique(std::move(*it)).second)
+          src.erase(it++);
+        else
+          ++it;
+      }
+      return;
+    }
+    iterator hint = end();
+    for (iterator it = src.begin(); it != src.end();) {
+      iterator                        cur = it++;
+      std::pair<link_type, link_type> res = __get_insert_hint_unique_pos(hint, _key(cur.node));
+      if (res.second != nullptr)
+        hint = __hint_after(__insert(res.first, res.second, src.__unlink(cur)));
+    }
   }
 
- public:  // set operations
-  iterator find(const key_type& k) {
-    link_type y = _header;
+  // 同上，src 中的节点全部移过来，相等的元素排在本树已有的元素后面
+  template <typename Compare2>
+  void merge_equal(rb_tree<Key, Value, KeyOfValue, Compare2, Alloc, Augment>& src) {
+    if ((const void*)&src == (const void*)this)
+      return;
+    if (!__same_alloc(src)) {
+      for (iterator it = src.begin(); it != src.end(); src.erase(it++))
+        insert_equal(std::move(*it));
+      return;
+    }
+    // 带 hint 的插入会排在相等元素的前面，只有 k 严格小于 hint 时才能用它
+    iterator hint = end();
+    for (iterator it = src.begin(); it != src.end();) {
+      iterator                        cur = it++;
+      const key_type&                 k = _key(cur.node);
+      std::pair<link_type, link_type> res;
+      if (hint == end() || _key_compare(k, _key(hint.node)))
+        res = __get_insert_hint_equal_pos(hint, k);
+      else
+        res = __get_insert_equal_pos(k);
+      hint = __hint_after(__insert(res.first, res.second, src.__unlink(cur)));
+    }
+  }
+
+ private:
+  template <typename, typename, typename, typename, typename, typename>
+  friend class rb_tree;
+
+  // 把 pos 处的节点从树中摘下，节点的链接不再有效
+  link_type __unlink(iterator pos) {
+    link_type y = static_cast<link_type>(_rb_tree_rebalance_for_remove<Augment>(pos.node, _header));
+    --_node_count;
+    return y;
+  }
+
+  // 取出句柄中的节点；句柄的配置器与本树不相等时节点不能由本树释放，改为把元素移动到本树新分配的节点中
+  template <typename NodeHandle>
+  link_type __adopt(NodeHandle& nh) {
+    if (nh._alloc == _get_alloc())
+      return nh.__release();
+    link_type z = _create_node(std::move(nh._node->value_field));
+    nh.__reset();
+    return z;
+  }
+
+  // 下一个元素的 hint 是 pos 的后继；pos 为最右节点时直接返回 end()，不必沿右链爬回 header
+  iterator __hint_after(iterator pos) {
+    return pos.node == _rightmost() ? end() : ++pos;
+  }
+
+  template <typename Compare2>
+  bool __same_alloc(const rb_tree<Key, Value, KeyOfValue, Compare2, Alloc, Augment>& src) const {
+    return _get_alloc() == src._get_alloc();
+  }
+
+ public:  // join, split and set operations
+  // 把 rhs 的元素全部接到本树的后面，rhs 变为空；rhs 的元素都不能排在本树的元素前面
+  // rhs 最小的节点作为 join 的中间节点，配置器相等时 O(log n)，否则退化为逐个移动元素
+  void join(rb_tree& rhs) {
+    if (this == &rhs || rhs.empty())
+      return;
+    if (!__same_alloc(rhs)) {
+      __move_elements(rhs);
+      rhs.clear();
+      return;
+    }
+    size_type n = _node_count + rhs._node_count;
+    link_type k = rhs.__unlink(rhs.begin());
+    link_type r = rhs.__take_root();
+    link_type l = __take_root();
+    size_t    h;
+    __adopt_root(__join(l, _rb_tree_black_height(l), k, r, _rb_tree_black_height(r), h), n);
+  }
+
+  // 把 key 不小于 k 的元素切下来作为一棵新树返回，本树只留下 key 小于 k 的元素，O(log n)
+  // 新树使用本树的配置器；没有 order_statistic 时两边的元素个数需要数出来，额外花费 O(min(左边, 右边))
+  rb_tree split(const key_type& k) {
+    rb_tree right(_key_compare, get_allocator());
+    if (empty())
+      return right;
+    size_type nl = __count_less(k, typename Augment::tracks_size());
+    size_type n = _node_count;
+    link_type root = __take_root();
+    link_type l, r;
+    size_t    lh, rh;
+    __split(root, _rb_tree_black_height(root), k, false, l, lh, r, rh);
+    __adopt_root(l, nl);
+    right.__adopt_root(r, n - nl);
+    return right;
+  }
+
+  // 并行的集合运算，结果留在本树中，rhs 变为空，只用于没有重复 key 的树（set、map）
+  // 以 join 和 split 为基础：按本树的根节点把 rhs 切成两半，与本树的左右子树分别递归，再用根节点连接起来，
+  // 元素个数为 m、n（m <= n）时工作量为 O(m log(n / m + 1))，递归深度为 O(log n log m)；
+  // 子问题足够大时左半边交给新线程，最多同时使用 threads 个线程，为 0 时使用硬件的线程数
+  // 节点直接在两棵树之间转移，不再需要的节点在所有线程结束后才统一释放，所以配置器不必是线程安全的；
+  // 两棵树的配置器不相等时先把 rhs 的元素移动到本树配置器分配的节点中；Compare 不能抛出异常
+
+  // 并集，key 相同时保留本树的元素
+  void set_union(rb_tree& rhs, unsigned threads = 0) {
+    if (this != &rhs)
+      __set_operation(rhs, threads, &rb_tree::__union);
+  }
+
+  // 交集，保留本树的元素
+  void set_intersection(rb_tree& rhs, unsigned threads = 0) {
+    if (this != &rhs)
+      __set_operation(rhs, threads, &rb_tree::__intersection);
+  }
+
+  // 差集，去掉本树中 key 在 rhs 中出现的元素
+  void set_difference(rb_tree& rhs, unsigned threads = 0) {
+    if (this == &rhs)
+      clear();
+    else
+      __set_operation(rhs, threads, &rb_tree::__difference);
+  }
+
+ private:
+  // 子树的黑高不小于这个值（至少有 2^12 - 1 个节点）时才值得交给新线程
+  enum { __PARALLEL_HEIGHT = 12 };
+
+  // 待释放的子树，用根节点的 parent 串成链表
+  struct __garbage {
+    link_type head;
+    link_type tail;
+
+    void push(link_type x) {
+      if (x == nullptr)
+        return;
+      x->set_parent(nullptr);
+      if (tail)
+        tail->set_parent(x);
+      else
+        head = x;
+      tail = x;
+    }
+
+    // 只释放 x 这一个节点，它的孩子还在使用
+    void push_node(link_type x) {
+      x->left = nullptr;
+      x->right = nullptr;
+      push(x);
+    }
+
+    void splice(__garbage& rhs) {
+      if (rhs.head == nullptr)
+        return;
+      if (tail)
+        tail->set_parent(rhs.head);
+      else
+        head = rhs.head;
+      tail = rhs.tail;
+    }
+  };
+
+  typedef link_type (rb_tree::*__set_op)(link_type, size_t, link_type, size_t, size_t&, __garbage&, unsigned);
+
+  // 把整棵树从 header 上取下来，本树变为空树
+  link_type __take_root() {
     link_type x = _root();
+    _set_root(nullptr);
+    _leftmost() = _header;
+    _rightmost() = _header;
+    _node_count = 0;
+    return x;
+  }
 
-    while (x != nullptr) {
-      if (!_key_compare(_key(x), k)) {
-        // 若 x >= k，则往左走，此时，若 x == k，
-        // 则继续往左找，因为我们要找的是最靠前的 k（左子树比右子树靠前）
-        y = x;
-        x = _left(x);
-      } else {
-        x = _right(x);
-      }
+  // 以 x 为根的树挂到 header 上，调用前本树必须为空
+  void __adopt_root(link_type x, size_type n) {
+    _node_count = n;
+    if (x == nullptr)
+      return;
+    x->init(_header, _rb_tree_black);
+    _set_root(x);
+    _leftmost() = _minimum(x);
+    _rightmost() = _maximum(x);
+  }
+
+  link_type __join(link_type l, size_t lh, link_type k, link_type r, size_t rh, size_t& h) {
+    return static_cast<link_type>(_rb_tree_join<Augment>(l, lh, k, r, rh, h));
+  }
+
+  // 把以 x 为根、黑高为 xh 的子树按 k 分成 key 小于 k 的 l 和其余的 r，O(log n)
+  // exact 为 true 时（只用于没有重复 key 的树）与 k 相等的节点不放进 r，而是单独返回，没有时返回空
+  link_type __split(link_type x, size_t xh, const key_type& k, bool exact, link_type& l, size_t& lh, link_type& r,
+                    size_t& rh) {
+    if (x == nullptr) {
+      l = r = nullptr;
+      lh = rh = 0;
+      return nullptr;
     }
-    iterator j = iterator(y);
+    size_t    ch = xh - (x->color() == _rb_tree_black);
+    link_type xl = _left(x);
+    link_type xr = _right(x);
+    if (_key_compare(_key(x), k)) {  // x 和它的左子树都在 l 中
+      link_type m = __split(xr, ch, k, exact, l, lh, r, rh);
+      l = __join(xl, ch, x, l, lh, lh);
+      return m;
+    }
+    if (exact && !_key_compare(k, _key(x))) {
+      l = xl;
+      lh = ch;
+      r = xr;
+      rh = ch;
+      return x;
+    }
+    link_type m = __split(xl, ch, k, exact, l, lh, r, rh);
+    r = __join(r, rh, x, xr, ch, rh);
+    return m;
+  }
+
+  // 摘下以 x 为根的子树中最大的节点，其余节点组成 rest
+  link_type __split_last(link_type x, size_t xh, link_type& rest, size_t& rest_h) {
+    size_t ch = xh - (x->color() == _rb_tree_black);
+    if (x->right == nullptr) {
+      rest = _left(x);
+      rest_h = ch;
+      return x;
+    }
+    link_type last = __split_last(_right(x), ch, rest, rest_h);
+    rest = __join(_left(x), ch, x, rest, rest_h, rest_h);
+    return last;
+  }
 
-    // 如果 j == end() 或者 j 不等于 k，就没找到
-    return (j == end() || _key_compare(k, _key(j.node))) ? end() : j;
+  // 没有中间节点的 join，用 l 中最大的节点作中间节点
+  link_type __join2(link_type l, size_t lh, link_type r, size_t rh, size_t& h) {
+    if (l == nullptr) {
+      h = rh;
+      return r;
+    }
+    if (r == nullptr) {
+      h = lh;
+      return l;
+    }
+    link_type rest;
+    size_t    rest_h;
+    link_type k = __split_last(l, lh, rest, rest_h);
+    return __join(rest, rest_h, k, r, rh, h);
+  }
+
+  // 两个互不相干的子问题，足够大时 f1 交给新线程，两边各分到一半的线程；创建线程失败时就地执行
+  template <typename F1, typename F2>
+  void __fork(unsigned threads, size_t height, F1 f1, F2 f2, __garbage& g) {
+    if (threads < 2 || height < __PARALLEL_HEIGHT) {
+      f1(threads, g);
+      f2(threads, g);
+      return;
+    }
+    __garbage   g1 = {nullptr, nullptr};
+    unsigned    t1 = threads / 2;
+    std::thread worker;
+    try {
+      worker = std::thread([&] { f1(t1, g1); });
+    } catch (const std::system_error&) {
+      f1(1, g1);
+    }
+    f2(threads - t1, g);
+    if (worker.joinable())
+      worker.join();
+    g.splice(g1);
   }
 
-  const_iterator find(const key_type& k) const {
-    link_type y = _header;
-    link_type x = _root();
+  link_type __union(link_type t1, size_t h1, link_type t2, size_t h2, size_t& h, __garbage& g, unsigned threads) {
+    if (t1 == nullptr) {
+      h = h2;
+      return t2;
+    }
+    if (t2 == nullptr) {
+      h = h1;
+      return t1;
+    }
+    link_type l2, r2;
+    size_t    l2h, r2h;
+    link_type m = __split(t2, h2, _key(t1), true, l2, l2h, r2, r2h);
+    if (m)
+      g.push_node(m);
+    size_t    ch = h1 - (t1->color() == _rb_tree_black);
+    link_type t1l = _left(t1);
+    link_type t1r = _right(t1);
+    link_type l, r;
+    size_t    lh, rh;
+    __fork(
+        threads, h1, [&](unsigned t, __garbage& gg) { l = __union(t1l, ch, l2, l2h, lh, gg, t); },
+        [&](unsigned t, __garbage& gg) { r = __union(t1r, ch, r2, r2h, rh, gg, t); }, g);
+    return __join(l, lh, t1, r, rh, h);
+  }
+
+  link_type __intersection(link_type t1, size_t h1, link_type t2, size_t h2, size_t& h, __garbage& g,
+                           unsigned threads) {
+    if (t1 == nullptr || t2 == nullptr) {
+      g.push(t1);
+      g.push(t2);
+      h = 0;
+      return nullptr;
+    }
+    link_type l2, r2;
+    size_t    l2h, r2h;
+    link_type m = __split(t2, h2, _key(t1), true, l2, l2h, r2, r2h);
+    size_t    ch = h1 - (t1->color() == _rb_tree_black);
+    link_type t1l = _left(t1);
+    link_type t1r = _right(t1);
+    link_type l, r;
+    size_t    lh, rh;
+    __fork(
+        threads, h1, [&](unsigned t, __garbage& gg) { l = __intersection(t1l, ch, l2, l2h, lh, gg, t); },
+        [&](unsigned t, __garbage& gg) { r = __intersection(t1r, ch, r2, r2h, rh, gg, t); }, g);
+    if (m) {
+      g.push_node(m);
+      return __join(l, lh, t1, r, rh, h);
+    }
+    g.push_node(t1);
+    return __join2(l, lh, r, rh, h);
+  }
 
-    while (x != nullptr) {
-      if (!_key_compare(_key(x), k)) {
-        // 若 x >= k，则往左走，此时，若 x == k，
-        // 则继续往左找，因为我们要找的是最靠前的 k（左子树比右子树靠前）
-        y = x;
-        x = _left(x);
-      } else {
-        x = right(x);
-      }
+  link_type __difference(link_type t1, size_t h1, link_type t2, size_t h2, size_t& h, __garbage& g,
+                         unsigned threads) {
+    if (t1 == nullptr || t2 == nullptr) {
+      g.push(t2);
+      h = h1;
+      return t1;
+    }
+    link_type l1, r1;
+    size_t    l1h, r1h;
+    link_type m = __split(t1, h1, _key(t2), true, l1, l1h, r1, r1h);
+    if (m)
+      g.push_node(m);
+    size_t    ch = h2 - (t2->color() == _rb_tree_black);
+    link_type t2l = _left(t2);
+    link_type t2r = _right(t2);
+    g.push_node(t2);
+    link_type l, r;
+    size_t    lh, rh;
+    __fork(
+        threads, h2, [&](unsigned t, __garbage& gg) { l = __difference(l1, l1h, t2l, ch, lh, gg, t); },
+        [&](unsigned t, __garbage& gg) { r = __difference(r1, r1h, t2r, ch, rh, gg, t); }, g);
+    return __join2(l, lh, r, rh, h);
+  }
+
+  void __set_operation(rb_tree& rhs, unsigned threads, __set_op op) {
+    if (!__same_alloc(rhs)) {
+      rb_tree tmp(_key_compare, get_allocator());
+      tmp.__move_elements(rhs);
+      rhs.clear();
+      __set_operation(tmp, threads, op);
+      return;
     }
-    const_iterator j = const_iterator(y);
+    if (threads == 0)
+      threads = std::thread::hardware_concurrency();
+    size_type n = _node_count + rhs._node_count;
+    link_type t1 = __take_root();
+    link_type t2 = rhs.__take_root();
+    __garbage g = {nullptr, nullptr};
+    size_t    h;
+    link_type root = (this->*op)(t1, _rb_tree_black_height(t1), t2, _rb_tree_black_height(t2), h, g, threads);
+    for (link_type x = g.head; x != nullptr;) {
+      link_type next = _parent(x);
+      n -= __erase(x);
+      x = next;
+    }
+    __adopt_root(root, n);
+  }
 
-    // 如果 j == end() 或者 j 不等于 k，就没找到
-    return (j == end() || _key_compare(k, _key(j.node))) ? end() : j;
+  // key 小于 k 的元素个数
+  size_type __count_less(const key_type& k, std::true_type) const {
+    return __rank(k);
   }
 
+  // 从两端同时往 lower_bound(k) 走，先到达的一侧就是较短的一侧
+  size_type __count_less(const key_type& k, std::false_type) const {
+    const_iterator pos(__lower_bound(k));
+    const_iterator lo = begin();
+    const_iterator hi = end();
+    for (size_type n = 0;; ++n, ++lo, --hi) {
+      if (lo == pos)
+        return n;
+      if (hi == pos)
+        return _node_count - n;
+    }
+  }
+
+ public:  // set operations
+  // Compare 声明了 is_transparent 时（如 std::less<>），查找还接受任意能与 key 比较的类型 K，
+  // 例如用 const char* 在 key 为 std::string 的树中查找，不需要为每次查找构造一个 key_type
+  iterator find(const key_type& k) {
+    return iterator(__find(k));
+  }
+
+  const_iterator find(const key_type& k) const {
+    return const_iterator(__find(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& k) {
+    return iterator(__find(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& k) const {
+    return const_iterator(__find(k));
+  }
+
+  // 顺序统计树中用两次排名相减，不需要遍历相等的元素
   size_type count(const key_type& k) const {
-    auto p = equal_range(k);
-    // TODO(dong) 可能是由于在 my_map 中使用了 std::pair，这里的 distance 调用会与 std 中的 distance 出现歧义
-    size_type n = gd::distance(p.first, p.second);
-    return n;
+    return __count(k, typename Augment::tracks_size());
   }
 
-  iterator lower_bound(const key_type& k) {
-    link_type y = _header;
-    link_type x = _root();
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count(const K& k) const {
+    return __count(k, typename Augment::tracks_size());
+  }
 
-    while (x != nullptr) {
-      if (!_key_compare(_key(x), k))  // x >= k, 跟 find() 一样，找最靠前的
-        y = x, x = _left(x);
-      else
-        x = _right(x);
-    }
-    // 若没找到，则 y 会指向第一个比 k 大的节点
-    return iterator(y);
+  iterator lower_bound(const key_type& k) {
+    return iterator(__lower_bound(k));
   }
 
   const_iterator lower_bound(const key_type& k) const {
+    return const_iterator(__lower_bound(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& k) {
+    return iterator(__lower_bound(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& k) const {
+    return const_iterator(__lower_bound(k));
+  }
+
+  iterator upper_bound(const key_type& k) {
+    return iterator(__upper_bound(k));
+  }
+
+  const_iterator upper_bound(const key_type& k) const {
+    return const_iterator(__upper_bound(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& k) {
+    return iterator(__upper_bound(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& k) const {
+    return const_iterator(__upper_bound(k));
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return std::make_pair(lower_bound(k), upper_bound(k));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& k) {
+    return std::make_pair(iterator(__lower_bound(k)), iterator(__upper_bound(k)));
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+    return std::make_pair(const_iterator(__lower_bound(k)), const_iterator(__upper_bound(k)));
+  }
+
+ public:  // order statistics，只有 Augment 为 order_statistic 时可用
+  // 按中序排第 k 个（从 0 开始）的元素，k >= size() 时返回 end()
+  iterator nth(size_type k) {
+    return iterator(__nth(k));
+  }
+
+  const_iterator nth(size_type k) const {
+    return const_iterator(__nth(k));
+  }
+
+  // key 小于 k 的元素个数，也就是 lower_bound(k) 的下标
+  size_type rank(const key_type& k) const {
+    return __rank(k);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type rank(const K& k) const {
+    return __rank(k);
+  }
+
+  // key 在 [lo, hi) 中的元素个数
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    return __count_range(lo, hi);
+  }
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_type count_range(const K& lo, const K& hi) const {
+    return __count_range(lo, hi);
+  }
+
+ private:
+  template <typename K>
+  link_type __find(const K& k) const {
+    link_type j = __lower_bound(k);
+    // 如果 j == end() 或者 j 不等于 k，就没找到
+    return (j == _header || _key_compare(k, _key(j))) ? _header : j;
+  }
+
+  template <typename K>
+  link_type __lower_bound(const K& k) const {
     link_type y = _header;
     link_type x = _root();
 
     while (x != nullptr) {
-      if (!_key_compare(_key(x), k))  // x >= k, 跟 find() 一样，找最靠前的
-        y = x, x = _left(x);
-      else
+      if (!_key_compare(_key(x), k)) {
+        // 若 x >= k，则往左走，此时，若 x == k，
+        // 则继续往左找，因为我们要找的是最靠前的 k（左子树比右子树靠前）
+        y = x;
+        x = _left(x);
+      } else {
         x = _right(x);
+      }
     }
     // 若没找到，则 y 会指向第一个比 k 大的节点
-    return const_iterator(y);
+    return y;
   }
 
-  iterator upper_bound(const key_type& k) {
+  template <typename K>
+  link_type __upper_bound(const K& k) const {
     link_type y = _header;
     link_type x = _root();
 
@@ -1076,76 +2237,121 @@ class rb_tree {
       }
     }
     // 若没找到，y 会指向第一个比 k 大的节点
-    return iterator(y);
+    return y;
   }
 
-  const_iterator upper_bound(const key_type& k) const {
-    link_type y = _header;
+  link_type __nth(size_type k) const {
+    static_assert(Augment::tracks_size::value, "nth() requires order_statistic");
+    if (k >= _node_count)
+      return _header;
     link_type x = _root();
+    for (;;) {
+      size_type l = Augment::size(x->left);
+      if (k < l) {
+        x = _left(x);
+      } else if (k == l) {
+        return x;
+      } else {
+        k -= l + 1;
+        x = _right(x);
+      }
+    }
+  }
 
+  template <typename K>
+  size_type __rank(const K& k) const {
+    static_assert(Augment::tracks_size::value, "rank() requires order_statistic");
+    size_type r = 0;
+    link_type x = _root();
     while (x != nullptr) {
-      if (_key_compare(k, _key(x))) {  // k < x
-        y = x;
+      if (_key_compare(_key(x), k)) {  // x < k，x 和它的左子树都排在 k 前面
+        r += Augment::size(x->left) + 1;
+        x = _right(x);
+      } else {
+        x = _left(x);
+      }
+    }
+    return r;
+  }
+
+  // key 不大于 k 的元素个数，也就是 upper_bound(k) 的下标
+  template <typename K>
+  size_type __rank_upper(const K& k) const {
+    size_type r = 0;
+    link_type x = _root();
+    while (x != nullptr) {
+      if (_key_compare(k, _key(x))) {
         x = _left(x);
       } else {
-        // 若 k >= x，则继续往右找，因为要找到最靠后的（右子树更靠后）
+        r += Augment::size(x->left) + 1;
         x = _right(x);
       }
     }
-    // 若没找到，y 会指向第一个比 k 大的节点
-    return const_iterator(y);
+    return r;
   }
 
-  std::pair<iterator, iterator> equal_range(const key_type& k) {
-    return std::make_pair(lower_bound(k), upper_bound(k));
+  // 不直接比较 lo 和 hi，透明的比较器不一定支持两个 K 之间的比较
+  template <typename K>
+  size_type __count_range(const K& lo, const K& hi) const {
+    size_type l = __rank(lo);
+    size_type h = __rank(hi);
+    return h > l ? h - l : 0;
   }
 
-  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
-    return std::make_pair(lower_bound(k), upper_bound(k));
+  template <typename K>
+  size_type __count(const K& k, std::true_type) const {
+    return __rank_upper(k) - __rank(k);
+  }
+
+  template <typename K>
+  size_type __count(const K& k, std::false_type) const {
+    // TODO(dong) 可能是由于在 my_map 中使用了 std::pair，这里的 distance 调用会与 std 中的 distance 出现歧义
+    size_type n = gd::distance(const_iterator(__lower_bound(k)), const_iterator(__upper_bound(k)));
+    return n;
   }
 };
 
 // operators
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator==(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline bool operator==(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator!=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline bool operator!=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator<(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                      const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline bool operator<(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                      const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator>=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline bool operator>=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   return !(lhs < rhs);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator>(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                      const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline bool operator>(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                      const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   return rhs < lhs;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator<=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline bool operator<=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                       const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   return !(rhs < lhs);
 }
 
 // overload swap
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline void swap(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                 const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename Augment>
+inline void swap(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& lhs,
+                 const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& rhs) {
   lhs.swap(rhs);
 }
 
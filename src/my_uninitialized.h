@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <utility>
 #include "my_construct.h"
 #include "my_iterator.h"
 #include "type_traits.h"
@@ -25,6 +26,20 @@ inline ForwardIterator __uninitialized_copy_dispatch(InputIterator first, InputI
   return cur;
 }
 
+// 源和目标都是同一类型的指针时直接 memmove
+template <typename T>
+inline T* __uninitialized_copy_dispatch(const T* first, const T* last, T* dest, __true_type) {
+  ptrdiff_t n = last - first;
+  if (n > 0)
+    memmove(dest, first, sizeof(T) * n);
+  return dest + n;
+}
+
+template <typename T>
+inline T* __uninitialized_copy_dispatch(T* first, T* last, T* dest, __true_type) {
+  return __uninitialized_copy_dispatch((const T*)first, (const T*)last, dest, __true_type());
+}
+
 template <typename InputIterator, typename ForwardIterator, typename T>
 inline ForwardIterator __uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator dest, T*) {
   typedef typename __type_traits<T>::is_POD_type is_POD;
@@ -38,14 +53,33 @@ inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator las
 
 template <>
 inline char* uninitialized_copy(const char* first, const char* last, char* dest) {
-  memmove(dest, first, last - first);
-  return dest + (last - first);
+  ptrdiff_t n = last - first;
+  if (n > 0)
+    memmove(dest, first, n);
+  return dest + n;
 }
 
 template <>
 inline wchar_t* uninitialized_copy(const wchar_t* first, const wchar_t* last, wchar_t* dest) {
-  memmove(dest, first, sizeof(wchar_t) * (last - first));
-  return dest + (last - first);
+  ptrdiff_t n = last - first;
+  if (n > 0)
+    memmove(dest, first, sizeof(wchar_t) * n);
+  return dest + n;
+}
+
+// 移动构造不会抛出异常（或者不能拷贝）时移动，否则拷贝，与 std::move_if_noexcept 相同
+// 构造失败时析构已经构造的对象，源区间保持不变
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator dest) {
+  ForwardIterator cur = dest;
+  try {
+    for (; first != last; ++first, ++cur)
+      construct(&*cur, std::move_if_noexcept(*first));
+  } catch (...) {
+    gd::destroy(dest, cur);
+    throw;
+  }
+  return cur;
 }
 
 template <typename ForwardIterator, typename T>
@@ -73,7 +107,10 @@ inline void uninitialized_fill(ForwardIterator first, ForwardIterator last, cons
 
 template <typename ForwardIterator, typename Size, typename T>
 inline ForwardIterator __uninitialized_fill_n_dispatch(ForwardIterator i, Size n, const T& value, __true_type) {
-  return std::fill_n(i, n, value);
+  // 不直接用 std::fill_n，因为 gd 的迭代器类型标签与 std 不兼容
+  for (; n > 0; --n, ++i)
+    *i = value;
+  return i;
 }
 
 template <typename ForwardIterator, typename Size, typename T>
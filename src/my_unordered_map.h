@@ -0,0 +1,293 @@
+#ifndef __MY_UNORDERED_MAP__H
+#define __MY_UNORDERED_MAP__H
+
+#include <functional>
+#include <initializer_list>
+#include "exceptdef.h"
+#include "my_hashtable.h"
+#include "my_map.h"  // for select1st
+
+namespace gd {
+
+// 以开放寻址哈希表为底层数据结构的 map，元素无序，查找、插入、删除平均为常数时间
+// 元素直接存放在哈希表的 slot 数组中，扩容和 rehash 会使所有迭代器和元素的引用失效
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+          typename Alloc = alloc>
+class unordered_map {
+ public:
+  typedef Key                     key_type;
+  typedef T                       mapped_type;
+  typedef std::pair<const Key, T> value_type;
+  typedef Hash                    hasher;
+  typedef KeyEqual                key_equal;
+
+ private:
+  typedef hashtable<key_type, value_type, select1st<value_type>, hasher, key_equal, Alloc> __rep_type;
+  // 底层数据结构
+  __rep_type __ht;
+
+ public:
+  typedef typename __rep_type::pointer         pointer;
+  typedef typename __rep_type::const_pointer   const_pointer;
+  typedef typename __rep_type::reference       reference;
+  typedef typename __rep_type::const_reference const_reference;
+  typedef typename __rep_type::iterator        iterator;
+  typedef typename __rep_type::const_iterator  const_iterator;
+  typedef typename __rep_type::size_type       size_type;
+  typedef typename __rep_type::difference_type difference_type;
+  typedef typename __rep_type::allocator_type  allocator_type;
+
+ public:  // constructor, copy, destructor
+  unordered_map() = default;
+
+  explicit unordered_map(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+                         const allocator_type& a = allocator_type())
+      : __ht(n, hf, eql, a) {}
+
+  explicit unordered_map(const allocator_type& a) : __ht(0, hasher(), key_equal(), a) {}
+
+  template <typename InputIterator>
+  unordered_map(InputIterator first, InputIterator last) : __ht() {
+    __ht.insert_unique(first, last);
+  }
+
+  template <typename InputIterator>
+  unordered_map(InputIterator first, InputIterator last, const allocator_type& a) : __ht(0, hasher(), key_equal(), a) {
+    __ht.insert_unique(first, last);
+  }
+
+  unordered_map(std::initializer_list<value_type> il) : __ht(il.size()) {
+    __ht.insert_unique(il.begin(), il.end());
+  }
+
+  unordered_map(std::initializer_list<value_type> il, const allocator_type& a)
+      : __ht(il.size(), hasher(), key_equal(), a) {
+    __ht.insert_unique(il.begin(), il.end());
+  }
+
+  unordered_map(const unordered_map& rhs) : __ht(rhs.__ht) {}
+
+  unordered_map(unordered_map&& rhs) noexcept : __ht(std::move(rhs.__ht)) {}
+
+  unordered_map(const unordered_map& rhs, const allocator_type& a) : __ht(rhs.__ht, a) {}
+
+  unordered_map(unordered_map&& rhs, const allocator_type& a) : __ht(std::move(rhs.__ht), a) {}
+
+  unordered_map& operator=(const unordered_map& rhs) {
+    __ht = rhs.__ht;
+    return *this;
+  }
+
+  unordered_map& operator=(unordered_map&& rhs) {
+    __ht = std::move(rhs.__ht);
+    return *this;
+  }
+
+  unordered_map& operator=(std::initializer_list<value_type> il) {
+    __ht.clear();
+    __ht.insert_unique(il.begin(), il.end());
+    return *this;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __ht.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() noexcept {
+    return __ht.begin();
+  }
+
+  const_iterator begin() const noexcept {
+    return __ht.begin();
+  }
+
+  iterator end() noexcept {
+    return __ht.end();
+  }
+
+  const_iterator end() const noexcept {
+    return __ht.end();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return __ht.begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return __ht.end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __ht.empty();
+  }
+
+  size_type size() const noexcept {
+    return __ht.size();
+  }
+
+  size_type max_size() const noexcept {
+    return __ht.max_size();
+  }
+
+ public:  // element access
+  mapped_type& operator[](const key_type& k) {
+    return __ht.try_emplace(k).first->second;
+  }
+
+  mapped_type& operator[](key_type&& k) {
+    return __ht.try_emplace(std::move(k)).first->second;
+  }
+
+  mapped_type& at(const key_type& k) {
+    iterator it = __ht.find(k);
+    THROW_OUT_OF_RANGE_IF(it == end(), "unordered_map<Key, T>::at() key not found");
+    return it->second;
+  }
+
+  const mapped_type& at(const key_type& k) const {
+    const_iterator it = __ht.find(k);
+    THROW_OUT_OF_RANGE_IF(it == end(), "unordered_map<Key, T>::at() key not found");
+    return it->second;
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return __ht.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  // 哈希表用不上 hint
+  template <typename... Args>
+  iterator emplace_hint(const_iterator /* pos */, Args&&... args) {
+    return __ht.emplace_unique(std::forward<Args>(args)...).first;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args) {
+    return __ht.try_emplace(k, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args) {
+    return __ht.try_emplace(std::move(k), std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& v) {
+    return __ht.insert_unique(v);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& v) {
+    return __ht.insert_unique(std::move(v));
+  }
+
+  iterator insert(const_iterator /* pos */, const value_type& v) {
+    return __ht.insert_unique(v).first;
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    __ht.insert_unique(first, last);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    __ht.insert_unique(il.begin(), il.end());
+  }
+
+  // 删除不会移动其他元素，除 pos 外的迭代器仍然有效
+  void erase(const_iterator pos) {
+    __ht.erase(pos);
+  }
+
+  size_type erase(const key_type& k) {
+    return __ht.erase(k);
+  }
+
+  void erase(const_iterator first, const_iterator last) {
+    __ht.erase(first, last);
+  }
+
+  void clear() {
+    __ht.clear();
+  }
+
+  void swap(unordered_map& rhs) {
+    __ht.swap(rhs.__ht);
+  }
+
+ public:  // observers
+  hasher hash_function() const {
+    return __ht.hash_function();
+  }
+
+  key_equal key_eq() const {
+    return __ht.key_eq();
+  }
+
+ public:  // lookup
+  iterator find(const key_type& k) {
+    return __ht.find(k);
+  }
+
+  const_iterator find(const key_type& k) const {
+    return __ht.find(k);
+  }
+
+  size_type count(const key_type& k) const {
+    return __ht.count(k);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& k) {
+    return __ht.equal_range(k);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return __ht.equal_range(k);
+  }
+
+ public:  // hash policy
+  float load_factor() const noexcept {
+    return __ht.load_factor();
+  }
+
+  float max_load_factor() const noexcept {
+    return __ht.max_load_factor();
+  }
+
+  void rehash(size_type n) {
+    __ht.rehash(n);
+  }
+
+  void reserve(size_type n) {
+    __ht.reserve(n);
+  }
+
+ public:  // operators
+  bool operator==(const unordered_map& rhs) const {
+    return __ht == rhs.__ht;
+  }
+};
+
+// operators:
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Alloc>
+bool operator==(const unordered_map<Key, T, Hash, KeyEqual, Alloc>& lhs,
+                const unordered_map<Key, T, Hash, KeyEqual, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Alloc>
+bool operator!=(const unordered_map<Key, T, Hash, KeyEqual, Alloc>& lhs,
+                const unordered_map<Key, T, Hash, KeyEqual, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Alloc>
+void swap(unordered_map<Key, T, Hash, KeyEqual, Alloc>& lhs, unordered_map<Key, T, Hash, KeyEqual, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_UNORDERED_MAP__H
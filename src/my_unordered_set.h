@@ -0,0 +1,241 @@
+#ifndef __MY_UNORDERED_SET__H
+#define __MY_UNORDERED_SET__H
+
+#include <functional>
+#include <initializer_list>
+#include "my_hashtable.h"
+#include "my_set.h"  // for identity
+
+namespace gd {
+
+// 以开放寻址哈希表为底层数据结构的 set，元素无序，不能通过迭代器修改
+// 扩容和 rehash 会使所有迭代器和元素的引用失效
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, typename Alloc = alloc>
+class unordered_set {
+ public:
+  typedef Key      key_type;
+  typedef Key      value_type;
+  typedef Hash     hasher;
+  typedef KeyEqual key_equal;
+
+ private:
+  typedef hashtable<key_type, value_type, identity<value_type>, hasher, key_equal, Alloc> __rep_type;
+
+  __rep_type __ht;
+
+ public:
+  typedef typename __rep_type::const_pointer   pointer;
+  typedef typename __rep_type::const_pointer   const_pointer;
+  typedef typename __rep_type::const_reference reference;
+  typedef typename __rep_type::const_reference const_reference;
+  typedef typename __rep_type::const_iterator  iterator;
+  typedef typename __rep_type::const_iterator  const_iterator;
+  typedef typename __rep_type::size_type       size_type;
+  typedef typename __rep_type::difference_type difference_type;
+  typedef typename __rep_type::allocator_type  allocator_type;
+
+ public:  // constructor, copy, destructor
+  unordered_set() = default;
+
+  explicit unordered_set(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+                         const allocator_type& a = allocator_type())
+      : __ht(n, hf, eql, a) {}
+
+  explicit unordered_set(const allocator_type& a) : __ht(0, hasher(), key_equal(), a) {}
+
+  template <typename InputIterator>
+  unordered_set(InputIterator first, InputIterator last) : __ht() {
+    __ht.insert_unique(first, last);
+  }
+
+  template <typename InputIterator>
+  unordered_set(InputIterator first, InputIterator last, const allocator_type& a) : __ht(0, hasher(), key_equal(), a) {
+    __ht.insert_unique(first, last);
+  }
+
+  unordered_set(std::initializer_list<value_type> il) : __ht(il.size()) {
+    __ht.insert_unique(il.begin(), il.end());
+  }
+
+  unordered_set(std::initializer_list<value_type> il, const allocator_type& a)
+      : __ht(il.size(), hasher(), key_equal(), a) {
+    __ht.insert_unique(il.begin(), il.end());
+  }
+
+  unordered_set(const unordered_set& rhs) : __ht(rhs.__ht) {}
+
+  unordered_set(unordered_set&& rhs) noexcept : __ht(std::move(rhs.__ht)) {}
+
+  unordered_set(const unordered_set& rhs, const allocator_type& a) : __ht(rhs.__ht, a) {}
+
+  unordered_set(unordered_set&& rhs, const allocator_type& a) : __ht(std::move(rhs.__ht), a) {}
+
+  unordered_set& operator=(const unordered_set& rhs) {
+    __ht = rhs.__ht;
+    return *this;
+  }
+
+  unordered_set& operator=(unordered_set&& rhs) {
+    __ht = std::move(rhs.__ht);
+    return *this;
+  }
+
+  unordered_set& operator=(std::initializer_list<value_type> il) {
+    __ht.clear();
+    __ht.insert_unique(il.begin(), il.end());
+    return *this;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return __ht.get_allocator();
+  }
+
+ public:  // iterators
+  iterator begin() const noexcept {
+    return __ht.begin();
+  }
+
+  iterator end() const noexcept {
+    return __ht.end();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return __ht.begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return __ht.end();
+  }
+
+ public:  // capacity
+  bool empty() const noexcept {
+    return __ht.empty();
+  }
+
+  size_type size() const noexcept {
+    return __ht.size();
+  }
+
+  size_type max_size() const noexcept {
+    return __ht.max_size();
+  }
+
+ public:  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return __ht.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  // 哈希表用不上 hint
+  template <typename... Args>
+  iterator emplace_hint(const_iterator /* pos */, Args&&... args) {
+    return __ht.emplace_unique(std::forward<Args>(args)...).first;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return __ht.insert_unique(value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return __ht.insert_unique(std::move(value));
+  }
+
+  iterator insert(const_iterator /* pos */, const value_type& value) {
+    return __ht.insert_unique(value).first;
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    __ht.insert_unique(first, last);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    __ht.insert_unique(il.begin(), il.end());
+  }
+
+  // 删除不会移动其他元素，除 pos 外的迭代器仍然有效
+  void erase(const_iterator pos) {
+    __ht.erase(pos);
+  }
+
+  size_type erase(const key_type& k) {
+    return __ht.erase(k);
+  }
+
+  void erase(const_iterator first, const_iterator last) {
+    __ht.erase(first, last);
+  }
+
+  void swap(unordered_set& rhs) {
+    __ht.swap(rhs.__ht);
+  }
+
+  void clear() {
+    __ht.clear();
+  }
+
+ public:  // observers
+  hasher hash_function() const {
+    return __ht.hash_function();
+  }
+
+  key_equal key_eq() const {
+    return __ht.key_eq();
+  }
+
+ public:  // lookup
+  const_iterator find(const key_type& k) const {
+    return __ht.find(k);
+  }
+
+  size_type count(const key_type& k) const {
+    return __ht.count(k);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return __ht.equal_range(k);
+  }
+
+ public:  // hash policy
+  float load_factor() const noexcept {
+    return __ht.load_factor();
+  }
+
+  float max_load_factor() const noexcept {
+    return __ht.max_load_factor();
+  }
+
+  void rehash(size_type n) {
+    __ht.rehash(n);
+  }
+
+  void reserve(size_type n) {
+    __ht.reserve(n);
+  }
+
+ public:  // operators
+  bool operator==(const unordered_set& rhs) const {
+    return __ht == rhs.__ht;
+  }
+};
+
+// operators:
+
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc>
+bool operator==(const unordered_set<Key, Hash, KeyEqual, Alloc>& lhs, const unordered_set<Key, Hash, KeyEqual, Alloc>& rhs) {
+  return lhs.operator==(rhs);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc>
+bool operator!=(const unordered_set<Key, Hash, KeyEqual, Alloc>& lhs, const unordered_set<Key, Hash, KeyEqual, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc>
+void swap(unordered_set<Key, Hash, KeyEqual, Alloc>& lhs, unordered_set<Key, Hash, KeyEqual, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace gd
+
+#endif  // !__MY_UNORDERED_SET__H
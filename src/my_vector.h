@@ -2,15 +2,18 @@
 #define __MY_VECTOR_H
 
 #include <algorithm>
+#include <cstring>
 #include <initializer_list>
+#include <type_traits>
 #include "exceptdef.h"
 #include "my_alloc.h"
 #include "my_uninitialized.h"
 
 namespace gd {
 
+// 私有继承 data_allocator，Alloc 有状态时每个 vector 保存自己的配置器，无状态时利用空基类优化不占空间
 template <typename T, typename Alloc = alloc>
-class vector {
+class vector : private simple_alloc<T, Alloc> {
  public:
   typedef T                 value_type;
   typedef value_type *      pointer;
@@ -22,8 +25,9 @@ class vector {
   typedef size_t            size_type;
   typedef ptrdiff_t         difference_type;
 
- protected:
   typedef simple_alloc<value_type, Alloc> allocator_type;
+
+ protected:
   typedef simple_alloc<value_type, Alloc> data_allocator;
 
   iterator _start;           // 空间起点
@@ -31,6 +35,14 @@ class vector {
   iterator _end_of_storage;  // one past the 已分配空间
 
  private:  // helper functions
+  data_allocator &__get_alloc() noexcept {
+    return *this;
+  }
+
+  const data_allocator &__get_alloc() const noexcept {
+    return *this;
+  }
+
   void __alloc(size_type n) {
     try {
       // allocate 可能会抛出 bad_alloc
@@ -55,14 +67,14 @@ class vector {
 
   iterator __alloc_and_fill(size_type n, const value_type &value) {
     __alloc(n);
-    return uninitialized_fill_n(_start, n, value);
+    return gd::uninitialized_fill_n(_start, n, value);
   }
 
   template <typename InputIterator>
   iterator __range_alloc_and_fill(InputIterator first, InputIterator last) {
-    size_type n = distance(first, last);
+    size_type n = gd::distance(first, last);
     __alloc(n);
-    return uninitialized_copy(first, last, _start);
+    return gd::uninitialized_copy(first, last, _start);
   }
 
   template <typename InputIterator>
@@ -80,16 +92,16 @@ class vector {
 
   template <typename ForwardIterator>
   void __copy_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
-    size_type n = distance(first, last);
+    size_type n = gd::distance(first, last);
     if (n > capacity()) {
-      vector tmp(first, last);
+      vector tmp(first, last, get_allocator());
       swap(tmp);
     } else {
       if (n > size()) {
         ForwardIterator mid = first;
-        advance(mid, size());
+        gd::advance(mid, size());
         std::copy(first, mid, begin());
-        _finish = uninitialized_copy(mid, last, end());
+        _finish = gd::uninitialized_copy(mid, last, end());
       } else {
         auto it = std::copy(first, last, begin());
         erase(it, _finish);
@@ -108,101 +120,183 @@ class vector {
   template <typename ForwardIterator>
   void __copy_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
     if (first != last) {
-      size_type n = distance(first, last);
+      size_type n = gd::distance(first, last);
       if (static_cast<size_type>(_end_of_storage - _finish) >= n) {
         const size_type elem_after = _finish - pos;
         iterator        old_finish = _finish;
         if (elem_after > n) {
-          _finish = uninitialized_copy(_finish - n, _finish, _finish);
+          _finish = gd::uninitialized_copy(_finish - n, _finish, _finish);
           std::copy_backward(pos, old_finish - n, old_finish);
           std::copy(first, last, pos);
         } else {
           ForwardIterator mid = first;
-          advance(mid, elem_after);
-          _finish = uninitialized_copy(mid, last, _finish);
-          _finish = uninitialized_copy(pos, old_finish, _finish);
+          gd::advance(mid, elem_after);
+          _finish = gd::uninitialized_copy(mid, last, _finish);
+          _finish = gd::uninitialized_copy(pos, old_finish, _finish);
           std::copy(first, mid, pos);
         }
       } else {
-        iterator  old_start = _start;
-        iterator  old_finish = _finish;
-        size_type old_size = size();
-        size_type new_size = old_size + std::max(old_size, n);
-        __alloc(new_size);
+        size_type new_cap = size() + std::max(size(), n);
+        iterator  new_start = data_allocator::allocate(new_cap);
+        iterator  new_pos = new_start + (pos - _start);
         try {
-          _finish = uninitialized_copy(old_start, pos, _start);
-          _finish = uninitialized_copy(first, last, _finish);
-          _finish = uninitialized_copy(pos, old_finish, _finish);
+          gd::uninitialized_copy(first, last, new_pos);
         } catch (...) {
-          destroy(_start, _finish);
-          __dealloc(_start, new_size);
+          data_allocator::deallocate(new_start, new_cap);
           throw;
         }
-        destroy(old_start, old_finish);
-        __dealloc(old_start, old_size);
+        __realloc_finish(pos, new_start, new_cap, new_pos, n);
       }
     }
   }
 
+  // 把 [_start, pos) 搬到 new_start，[pos, _finish) 搬到 new_pos，之后旧空间中的元素视为已经析构
+  // 可平凡搬移的类型直接 memcpy，旧元素也不需要析构
+  void __relocate(iterator pos, iterator new_start, iterator new_pos, std::true_type) noexcept {
+    if (_start == _finish)  // 空 vector 的 _start 可能是空指针，不能交给 memcpy
+      return;
+    if (pos != _start)
+      memcpy((void *)new_start, (void *)_start, (pos - _start) * sizeof(value_type));
+    if (_finish != pos)
+      memcpy((void *)new_pos, (void *)pos, (_finish - pos) * sizeof(value_type));
+  }
+
+  // 移动构造不抛出异常时移动，否则拷贝，拷贝失败时旧空间中的元素保持不变
+  void __relocate(iterator pos, iterator new_start, iterator new_pos, std::false_type) {
+    iterator mid = uninitialized_move_if_noexcept(_start, pos, new_start);
+    try {
+      uninitialized_move_if_noexcept(pos, _finish, new_pos);
+    } catch (...) {
+      gd::destroy(new_start, mid);
+      throw;
+    }
+    gd::destroy(_start, _finish);
+  }
+
+  // 可平凡搬移的元素在末尾扩容时可以交给 Alloc::reallocate 整块搬移：realloc、mremap、arena 都可能原地扩展，
+  // 即使换了地址，mremap 也只是重新映射页表而不复制数据，扩容过程中不会同时持有新旧两块内存
+  typedef std::integral_constant<bool, __is_trivially_relocatable<value_type>::value &&
+                                           data_allocator::has_reallocate::value>
+      __use_reallocate;
+
+  void __reallocate(size_type new_cap, std::true_type) {
+    size_type sz = size();
+    _start = data_allocator::reallocate(_start, capacity(), new_cap);
+    _finish = _start + sz;
+    _end_of_storage = _start + new_cap;
+  }
+
+  void __reallocate(size_type, std::false_type) {}
+
+  // 扩容的最后一步：新元素 [new_pos, new_pos + n) 已经构造在新空间中，把旧元素搬过去，再换上新空间
+  // 先构造新元素再搬旧元素，新元素构造失败时旧元素还没有被移动过
+  void __realloc_finish(iterator pos, iterator new_start, size_type new_cap, iterator new_pos, size_type n) {
+    try {
+      __relocate(pos, new_start, new_pos + n, __is_trivially_relocatable<value_type>());
+    } catch (...) {
+      gd::destroy(new_pos, new_pos + n);
+      data_allocator::deallocate(new_start, new_cap);
+      throw;
+    }
+    size_type new_size = size() + n;
+    __dealloc(_start, capacity());
+    _start = new_start;
+    _finish = new_start + new_size;
+    _end_of_storage = new_start + new_cap;
+  }
+
  public:  // contructors, copy, and deconstructor
   vector() noexcept : _start(0), _finish(0), _end_of_storage(0) {}
 
+  explicit vector(const allocator_type &a) noexcept : data_allocator(a), _start(0), _finish(0), _end_of_storage(0) {}
+
   explicit vector(size_type n) {
     _finish = __alloc_and_fill(n, value_type());
   }
 
+  vector(size_type n, const allocator_type &a) : data_allocator(a) {
+    _finish = __alloc_and_fill(n, value_type());
+  }
+
   vector(size_type n, const value_type &value) {
     _finish = __alloc_and_fill(n, value);
   }
 
+  vector(size_type n, const value_type &value, const allocator_type &a) : data_allocator(a) {
+    _finish = __alloc_and_fill(n, value);
+  }
+
   template <typename InputIterator, typename std::enable_if<std::is_pointer<InputIterator>::value, int>::type = 0>
   vector(InputIterator first, InputIterator last) {
     _finish = __range_alloc_and_fill(first, last);
   }
 
+  template <typename InputIterator, typename std::enable_if<std::is_pointer<InputIterator>::value, int>::type = 0>
+  vector(InputIterator first, InputIterator last, const allocator_type &a) : data_allocator(a) {
+    _finish = __range_alloc_and_fill(first, last);
+  }
+
   vector(std::initializer_list<value_type> il) {
     _finish = __range_alloc_and_fill(il.begin(), il.end());
   }
 
-  vector(const vector &rhs) {
+  vector(std::initializer_list<value_type> il, const allocator_type &a) : data_allocator(a) {
+    _finish = __range_alloc_and_fill(il.begin(), il.end());
+  }
+
+  // 拷贝时配置器由 select_on_container_copy_construction() 决定
+  vector(const vector &rhs) : data_allocator(rhs.__get_alloc().select_on_container_copy_construction()) {
     _finish = __range_alloc_and_fill(rhs.begin(), rhs.end());
   }
 
-  vector(vector &&rhs) noexcept : _start(rhs._start), _finish(rhs._finish), _end_of_storage(rhs._end_of_storage) {
+  vector(const vector &rhs, const allocator_type &a) : data_allocator(a) {
+    _finish = __range_alloc_and_fill(rhs.begin(), rhs.end());
+  }
+
+  // 移动时配置器随内存一起转移
+  vector(vector &&rhs) noexcept
+      : data_allocator(std::move(rhs.__get_alloc())),
+        _start(rhs._start),
+        _finish(rhs._finish),
+        _end_of_storage(rhs._end_of_storage) {
     rhs._start = 0;
     rhs._finish = 0;
     rhs._end_of_storage = 0;
   }
 
+  vector(vector &&rhs, const allocator_type &a) : data_allocator(a), _start(0), _finish(0), _end_of_storage(0) {
+    if (__get_alloc() == rhs.__get_alloc())
+      __steal(rhs);
+    else
+      __move_elements(rhs);
+  }
+
   vector &operator=(const vector &rhs) {
     auto sz = rhs.size();
     if (&rhs != this) {
+      if (data_allocator::propagate_on_container_copy_assignment::value && __get_alloc() != rhs.__get_alloc()) {
+        // 新的配置器不能释放旧的内存，先用旧的配置器全部释放掉
+        __release();
+      }
+      gd::__alloc_on_copy(__get_alloc(), rhs.__get_alloc());
       if (capacity() < sz) {
-        vector tmp(rhs.begin(), rhs.end());
+        vector tmp(rhs.begin(), rhs.end(), get_allocator());
         swap(tmp);
       } else if (sz <= size()) {
         iterator i = std::copy(rhs.begin(), rhs.end(), begin());
-        destroy(i, _end_of_storage);
+        gd::destroy(i, _finish);
         _finish = _start + sz;
       } else {
         std::copy(rhs.begin(), rhs.begin() + size(), begin());
-        _finish = uninitialized_copy(rhs.begin() + size(), rhs.end(), end());
+        _finish = gd::uninitialized_copy(rhs.begin() + size(), rhs.end(), end());
       }
     }
     return *this;
   }
 
   vector &operator=(vector &&rhs) {
-    destroy(_start, _finish);
-    __dealloc(_start, _end_of_storage - _start);
-    _start = rhs._start;
-    _finish = rhs._finish;
-    _end_of_storage = rhs._end_of_storage;
-
-    rhs._start = 0;
-    rhs._finish = 0;
-    rhs._end_of_storage = 0;
-
+    if (&rhs != this)
+      __move_assign(rhs, __alloc_move_steals<data_allocator>());
     return *this;
   }
 
@@ -213,13 +307,13 @@ class vector {
 
   void assign(size_type n, const T &value) {
     if (n > capacity()) {
-      vector tmp(n, value);
+      vector tmp(n, value, get_allocator());
       swap(tmp);
     } else if (n <= size()) {
       erase(std::fill_n(begin(), n, value), end());
     } else {
       std::fill(begin(), end(), value);
-      _finish = uninitialized_fill_n(end(), n - size(), value);
+      _finish = gd::uninitialized_fill_n(end(), n - size(), value);
     }
   }
 
@@ -228,12 +322,64 @@ class vector {
   }
 
   ~vector() {
-    destroy(_start, _finish);
+    gd::destroy(_start, _finish);
     __dealloc(_start, _end_of_storage - _start);
   }
 
-  allocator_type get_allocator() {
-    return data_allocator();
+ private:  // move helpers
+  // 析构所有元素并释放内存
+  void __release() {
+    gd::destroy(_start, _finish);
+    __dealloc(_start, _end_of_storage - _start);
+    _start = 0;
+    _finish = 0;
+    _end_of_storage = 0;
+  }
+
+  // 直接接管 rhs 的内存，调用前本 vector 不能持有内存
+  void __steal(vector &rhs) noexcept {
+    _start = rhs._start;
+    _finish = rhs._finish;
+    _end_of_storage = rhs._end_of_storage;
+    rhs._start = 0;
+    rhs._finish = 0;
+    rhs._end_of_storage = 0;
+  }
+
+  // 配置器不相等时，rhs 的内存不能由本 vector 释放，只能用自己的配置器分配内存，再逐个移动元素
+  // 调用前本 vector 不能持有内存
+  void __move_elements(vector &rhs) {
+    __alloc(rhs.size());
+    _finish = _start;
+    try {
+      for (iterator it = rhs._start; it != rhs._finish; ++it, ++_finish)
+        construct(_finish, std::move(*it));
+    } catch (...) {
+      __release();
+      throw;
+    }
+  }
+
+  // 配置器会传播或者总是相等，直接接管 rhs 的内存
+  void __move_assign(vector &rhs, std::true_type) {
+    __release();
+    gd::__alloc_on_move(__get_alloc(), rhs.__get_alloc());
+    __steal(rhs);
+  }
+
+  void __move_assign(vector &rhs, std::false_type) {
+    if (__get_alloc() == rhs.__get_alloc()) {
+      __move_assign(rhs, std::true_type());
+    } else {
+      __release();
+      __move_elements(rhs);
+    }
+  }
+
+ public:
+
+  allocator_type get_allocator() const {
+    return __get_alloc();
   }
 
  public:  // iterators related
@@ -282,13 +428,12 @@ class vector {
 
   void reserve(size_type n) {
     if (capacity() < n) {
-      iterator  old_start = _start;
-      iterator  old_finish = _finish;
-      size_type old_size = size();
-      __alloc(n);
-      _finish = std::copy(old_start, old_finish, _start);
-      destroy(old_start, old_finish);
-      __dealloc(old_start, old_size);
+      if (__use_reallocate::value) {
+        __reallocate(n, __use_reallocate());
+      } else {
+        iterator new_start = data_allocator::allocate(n);
+        __realloc_finish(_finish, new_start, n, new_start + size(), 0);
+      }
     }
   }
 
@@ -297,6 +442,7 @@ class vector {
       std::swap(_start, rhs._start);
       std::swap(_finish, rhs._finish);
       std::swap(_end_of_storage, rhs._end_of_storage);
+      gd::__alloc_on_swap(__get_alloc(), rhs.__get_alloc());
     }
   }
 
@@ -312,7 +458,18 @@ class vector {
     }
   }
 
-  // void shrink_to_fit();
+  // 释放多余的容量，元素搬到大小正好的新空间
+  void shrink_to_fit() {
+    if (_finish == _end_of_storage)
+      return;
+    if (empty()) {
+      __release();
+      return;
+    }
+    size_type n = size();
+    iterator  new_start = data_allocator::allocate(n);
+    __realloc_finish(_finish, new_start, n, new_start + n, 0);
+  }
 
  public:  // data
   pointer data() noexcept {
@@ -353,34 +510,32 @@ class vector {
     size_type ret_offset = pos - _start;
 
     if (size() + n <= capacity()) {
-      size_type num_after = pos - _start;
+      size_type num_after = _finish - pos;
       iterator  old_finish = _finish;
       if (num_after > n) {
-        _finish = uninitialized_copy(_finish - n, _finish, _finish);
+        _finish = gd::uninitialized_copy(_finish - n, _finish, _finish);
         std::copy_backward(pos, old_finish - n, old_finish);
         std::fill(pos, pos + n, value);
       } else {
-        _finish = uninitialized_fill_n(_finish, n - num_after, value);
+        _finish = gd::uninitialized_fill_n(_finish, n - num_after, value);
         _finish = std::copy(pos, old_finish, _finish);
         std::fill(pos, old_finish, value);
       }
+    } else if (__use_reallocate::value && pos == _finish) {
+      value_type tmp(value);
+      __reallocate(size() + std::max(size(), n), __use_reallocate());
+      _finish = gd::uninitialized_fill_n(_finish, n, tmp);
     } else {
-      iterator  old_start = _start;
-      iterator  old_finish = _finish;
-      size_type old_size = size();
-      size_type new_size = old_size + std::max(old_size, n);
-      __alloc(new_size);
+      size_type new_cap = size() + std::max(size(), n);
+      iterator  new_start = data_allocator::allocate(new_cap);
+      iterator  new_pos = new_start + (pos - _start);
       try {
-        _finish = uninitialized_copy(old_start, pos, _start);
-        _finish = uninitialized_fill_n(_finish, n, value);
-        _finish = uninitialized_copy(pos, old_finish, _finish);
+        gd::uninitialized_fill_n(new_pos, n, value);
       } catch (...) {
-        destroy(_start, _finish);
-        __dealloc(_start, new_size);
+        data_allocator::deallocate(new_start, new_cap);
         throw;
       }
-      destroy(old_start, old_finish);
-      __dealloc(old_start, old_size);
+      __realloc_finish(pos, new_start, new_cap, new_pos, n);
     }
 
     // 返回插入的起点位置
@@ -406,7 +561,7 @@ class vector {
       construct(_finish, std::forward<Args>(args)...);
       ++_finish;
     } else {
-      __emplace_aux(_finish, std::forward<Args>(args)...);
+      __realloc_insert(_finish, std::forward<Args>(args)...);
     }
   }
 
@@ -446,14 +601,14 @@ class vector {
     if (pos + 1 != _finish)
       std::copy(pos_copy + 1, _finish, pos_copy);
     --_finish;
-    destroy(_finish);
+    gd::destroy(_finish);
     return pos_copy;
   }
 
   iterator erase(iterator first, iterator last) {
     size_type n = first - _start;
     iterator  i = std::copy(last, _finish, first);
-    destroy(i, _finish);
+    gd::destroy(i, _finish);
     _finish = _finish - (last - first);
     return _start + n;
   }
@@ -466,57 +621,49 @@ class vector {
   template <typename... Args>
   void __emplace_aux(iterator pos, Args &&... args) {
     if (_finish != _end_of_storage) {
-      construct(_finish, *(_finish - 1));
+      // 先构造出新元素，args 可能引用的是 vector 中的元素
+      value_type tmp(std::forward<Args>(args)...);
+      construct(_finish, std::move(*(_finish - 1)));
       ++_finish;
-      std::copy_backward(pos, _finish - 2, _finish - 1);
-      *pos = value_type(std::forward<Args>(args)...);
+      std::move_backward(pos, _finish - 2, _finish - 1);
+      *pos = std::move(tmp);
     } else {
-      iterator  old_start = _start;
-      iterator  old_finish = _finish;
-      size_type old_size = size();
-      size_type new_size = old_size + std::max(old_size, size_type(1));
-      __alloc(new_size);
-      try {
-        _finish = uninitialized_copy(old_start, pos, _start);
-        construct(_finish, std::forward<Args>(args)...);
-        ++_finish;
-        _finish = uninitialized_copy(pos, old_finish, _finish);
-      } catch (...) {
-        destroy(_start, _finish);
-        data_allocator::deallocate(_start, new_size);
-        throw;
-      }
-      destroy(old_start, old_finish);
-      __dealloc(old_start, old_size);
+      __realloc_insert(pos, std::forward<Args>(args)...);
+    }
+  }
+
+  // 空间不足时在 pos 处插入一个元素，新元素直接构造在新空间中
+  template <typename... Args>
+  void __realloc_insert(iterator pos, Args &&... args) {
+    size_type new_cap = size() + std::max(size(), size_type(1));
+    if (__use_reallocate::value && pos == _finish) {
+      // 先构造出新元素，args 可能引用 vector 中的元素
+      value_type tmp(std::forward<Args>(args)...);
+      __reallocate(new_cap, __use_reallocate());
+      construct(_finish, std::move(tmp));
+      ++_finish;
+      return;
+    }
+    iterator  new_start = data_allocator::allocate(new_cap);
+    iterator  new_pos = new_start + (pos - _start);
+    try {
+      construct(new_pos, std::forward<Args>(args)...);
+    } catch (...) {
+      data_allocator::deallocate(new_start, new_cap);
+      throw;
     }
+    __realloc_finish(pos, new_start, new_cap, new_pos, 1);
   }
 
   void __insert_aux(iterator pos, const value_type &value) {
     if (_finish != _end_of_storage) {
-      construct(_finish, *(_finish - 1));
+      value_type tmp(value);
+      construct(_finish, std::move(*(_finish - 1)));
       ++_finish;
-      std::copy_backward(pos, _finish - 2, _finish - 1);
-      *pos = value;
+      std::move_backward(pos, _finish - 2, _finish - 1);
+      *pos = std::move(tmp);
     } else {
-      iterator  old_start = _start;
-      iterator  old_finish = _finish;
-      size_type old_size = _end_of_storage - _start;
-
-      const size_type new_size = old_size != 0 ? 2 * old_size : 1;
-      __alloc(new_size);
-      try {
-        _finish = uninitialized_copy(old_start, pos, _start);
-        construct(_finish, value);
-        ++_finish;
-        _finish = uninitialized_copy(pos, old_finish, _finish);
-      } catch (...) {
-        destroy(_start, _finish);
-        data_allocator::deallocate(_start, new_size);
-        throw;
-      }
-      // 析构并释放原来的元素, 如果是初始状态，old_start 为空，则不可进行 deallocate
-      destroy(old_start, old_finish);
-      __dealloc(old_start, old_size);
+      __realloc_insert(pos, value);
     }
   }
 
@@ -1,6 +1,8 @@
 #ifndef __TYPE_TRAITS_H
 #define __TYPE_TRAITS_H
 
+#include <type_traits>
+
 namespace gd {
 
 template <typename T, T v>
@@ -12,174 +14,31 @@ typedef integral_constant<bool, true> __true_type;
 
 typedef integral_constant<bool, false> __false_type;
 
+// 由编译器内建的 type traits（std::is_trivially_*）判断，用户自定义的类型也能得到正确的结果，
+// 不再需要为每个类型单独特化
 template <typename T>
 struct __type_traits {
   // still don't know why this dummy member must be first T-T
   typedef __true_type this_dummy_member_must_be_first;
 
-  typedef __false_type has_trivial_default_constructor;
-  typedef __false_type has_trivial_copy_constructor;
-  typedef __false_type has_trivial_assignment_operator;
-  typedef __false_type has_trivial_destructor;
-  typedef __false_type is_POD_type;  // POD: Plain Old Data
-
-  // define the most conservative value (false type), then design specialized
-  // version for each scalar types
-};
-
-template <>
-struct __type_traits<bool> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<char> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<signed char> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<unsigned char> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<wchar_t> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<short> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<unsigned short> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<int> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
+  typedef integral_constant<bool, std::is_trivially_default_constructible<T>::value> has_trivial_default_constructor;
+  typedef integral_constant<bool, std::is_trivially_copy_constructible<T>::value>    has_trivial_copy_constructor;
+  typedef integral_constant<bool, std::is_trivially_copy_assignable<T>::value>       has_trivial_assignment_operator;
+  typedef integral_constant<bool, std::is_trivially_destructible<T>::value>          has_trivial_destructor;
 
-template <>
-struct __type_traits<unsigned int> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
+  // POD: Plain Old Data
+  // 这里只要求能按字节复制，并且拷贝构造可以用赋值代替，uninitialized_copy/fill 据此直接 memmove 或者赋值
+  typedef integral_constant<bool, std::is_trivially_copyable<T>::value &&
+                                      std::is_trivially_copy_constructible<T>::value &&
+                                      std::is_trivially_copy_assignable<T>::value>
+      is_POD_type;
 };
 
-template <>
-struct __type_traits<long> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<unsigned long> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<long long> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<unsigned long long> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<float> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<double> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <>
-struct __type_traits<long double> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-// partial specialization for native pointer
+// 可平凡搬移（trivially relocatable）：把对象逐字节复制到新地址、并且不再析构旧对象，等价于移动构造再析构
+// 平凡可复制的类型都满足。只持有 unique_ptr、堆指针之类的类型通常也满足，可以特化为 std::true_type，
+// 这样 vector 扩容时直接 memcpy。对象中保存了指向自身的指针的类型（例如某些实现的 std::string）不能特化
 template <typename T>
-struct __type_traits<T*> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
+struct __is_trivially_relocatable : std::is_trivially_copyable<T> {};
 
 }  // namespace gd
 #endif  // !__TYPE_TRAITS_H
\ No newline at end of file
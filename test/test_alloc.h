@@ -1,14 +1,23 @@
 #ifndef __TEST_ALLOC_H
 #define __TEST_ALLOC_H
 
+#include <chrono>
 #include <climits>
+#include <cstdint>
 #include <cstdio>
 #include <ctime>
 #include <iostream>
 #include <random>
+#include <string>
+#include <thread>
 #include <vector>
+#include "gtest/gtest.h"
 #include "my_alloc.h"
 #include "my_defalloc.h"
+#include "my_deque.h"
+#include "my_list.h"
+#include "my_map.h"
+#include "my_vector.h"
 #include "stack_alloc.h"
 #include "testdef.h"
 
@@ -81,6 +90,289 @@ int test() {
   return 0;
 }
 
+TEST(AllocTest, MultiThread) {
+  const int num_thread = 8;
+  const int num_elem = 20000;
+
+  // 每个线程各自使用 list 和 map，二者的节点都走二级配置器
+  std::vector<std::thread> threads;
+  std::vector<size_t>      sums(num_thread, 0);
+  for (int t = 0; t < num_thread; ++t) {
+    threads.emplace_back([t, &sums, num_elem]() {
+      for (int round = 0; round < 5; ++round) {
+        gd::list<int>      l;
+        gd::map<int, long> m;
+        for (int i = 0; i < num_elem; ++i) {
+          l.push_back(i);
+          m.insert({i, (long)i * t});
+        }
+        size_t sum = 0;
+        for (auto it = l.begin(); it != l.end(); ++it)
+          sum += *it;
+        sums[t] = sum + m.size();
+      }
+    });
+  }
+  for (auto& th : threads)
+    th.join();
+  for (int t = 0; t < num_thread; ++t)
+    ASSERT_EQ(sums[t], (size_t)num_elem * (num_elem - 1) / 2 + num_elem);
+}
+
+TEST(AllocTest, CrossThreadFree) {
+  // 一个线程分配，另一个线程释放，节点应通过中心池回到分配线程可用的 free list 中
+  const int          num_elem = 100000;
+  std::vector<void*> blocks(num_elem);
+
+  std::thread producer([&blocks, num_elem]() {
+    for (int i = 0; i < num_elem; ++i) {
+      blocks[i] = alloc::allocate(32);
+      *static_cast<int*>(blocks[i]) = i;
+    }
+  });
+  producer.join();
+
+  std::thread consumer([&blocks, num_elem]() {
+    for (int i = 0; i < num_elem; ++i) {
+      ASSERT_EQ(*static_cast<int*>(blocks[i]), i);
+      alloc::deallocate(blocks[i], 32);
+    }
+  });
+  consumer.join();
+
+  // 两个线程都退出后，所有节点都回到了中心池，再次分配不应出错
+  for (int i = 0; i < num_elem; ++i)
+    blocks[i] = alloc::allocate(32);
+  for (int i = 0; i < num_elem; ++i)
+    alloc::deallocate(blocks[i], 32);
+}
+
+TEST(AllocTest, Trim) {
+  const int          num_elem = 200000;
+  std::vector<void*> blocks(num_elem);
+
+  alloc::trim();
+  for (int i = 0; i < num_elem; ++i)
+    blocks[i] = alloc::allocate(48);
+  size_t peak = alloc::heap_bytes();
+
+  for (int i = 0; i < num_elem; ++i)
+    alloc::deallocate(blocks[i], 48);
+  // 全部释放后，这些区块所在的 chunk 都可以归还给系统
+  size_t released = alloc::trim();
+  ASSERT_GE(released, (size_t)num_elem * 48 / 2);
+  ASSERT_EQ(alloc::heap_bytes(), peak - released);
+
+  // 归还后内存池仍然可以正常使用
+  for (int i = 0; i < num_elem; ++i) {
+    blocks[i] = alloc::allocate(48);
+    *static_cast<int*>(blocks[i]) = i;
+  }
+  for (int i = 0; i < num_elem; ++i) {
+    ASSERT_EQ(*static_cast<int*>(blocks[i]), i);
+    alloc::deallocate(blocks[i], 48);
+  }
+}
+
+TEST(AllocTest, TrimThreshold) {
+  // 水位线策略：其他线程释放的大量区块在线程退出时归还中心池，超过水位线后自动归还给系统
+  alloc::trim();
+  size_t before = alloc::heap_bytes();
+  size_t old = alloc::set_trim_threshold(1 << 20);
+
+  std::thread worker([]() {
+    gd::list<int> l;
+    for (int i = 0; i < 500000; ++i)
+      l.push_back(i);
+  });
+  worker.join();
+
+  ASSERT_LT(alloc::heap_bytes(), before + (1 << 21));
+  alloc::set_trim_threshold(old);
+}
+
+TEST(AllocTest, SizeClass) {
+  // 128 bytes 以内按 8 bytes 等距，128 bytes 以上每个 2 的幂区间分 4 个 class
+  ASSERT_EQ(alloc::block_size(1), 8u);
+  ASSERT_EQ(alloc::block_size(128), 128u);
+  ASSERT_EQ(alloc::block_size(129), 160u);
+  ASSERT_EQ(alloc::block_size(200), 224u);
+  ASSERT_EQ(alloc::block_size(250), 256u);
+  ASSERT_EQ(alloc::block_size(257), 320u);
+  ASSERT_EQ(alloc::block_size(512), 512u);
+  ASSERT_EQ(alloc::block_size(513), 513u);
+  for (size_t n = 1; n <= 512; ++n) {
+    ASSERT_GE(alloc::block_size(n), n);
+    ASSERT_LE(alloc::block_size(n), n < 128 ? n + 7 : n + n / 4);
+  }
+}
+
+TEST(AllocTest, LargeNodeInPool) {
+  // 160~250 bytes 的 map 节点也由内存池分配，用一个独立的内存池统计
+  typedef __default_alloc_template<1> pool;
+  struct Record {
+    char data[160];
+  };
+  {
+    gd::map<std::string, Record, std::less<std::string>, pool> m;
+    for (int i = 0; i < 1000; ++i)
+      m[std::to_string(i)].data[0] = (char)i;
+    ASSERT_GE(pool::heap_bytes(), 1000 * sizeof(Record));
+    for (int i = 0; i < 1000; ++i)
+      ASSERT_EQ(m[std::to_string(i)].data[0], (char)i);
+  }
+  ASSERT_GT(pool::trim(), 0u);
+}
+
+TEST(AllocTest, Alignment) {
+  typedef pool_alloc<1024, 64> pool;
+  std::vector<std::pair<void*, size_t>> blocks;
+  for (size_t n = 1; n <= 2048; n += 37) {
+    void* p = pool::allocate(n);
+    ASSERT_EQ((size_t)p % 64, 0u);
+    memset(p, 0xff, n);
+    blocks.push_back({p, n});
+  }
+  void* p = pool::reallocate(blocks.back().first, blocks.back().second, 4096);
+  ASSERT_EQ((size_t)p % 64, 0u);
+  blocks.back() = {p, 4096};
+  for (auto& b : blocks)
+    pool::deallocate(b.first, b.second);
+}
+
+TEST(AllocTest, LargeReallocate) {
+  // 很大的区块扩容后数据不变，跨过 mmap 阈值的两个方向都要正确
+  size_t    sizes[] = {4096, 1 << 20, 3 << 20, 64 << 20, 2 << 20, 8192};
+  uint32_t* p = (uint32_t*)alloc::allocate(sizes[0]);
+  for (size_t i = 0; i < sizes[0] / 4; ++i)
+    p[i] = (uint32_t)i;
+  for (size_t k = 1; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+    p = (uint32_t*)alloc::reallocate(p, sizes[k - 1], sizes[k]);
+    size_t n = std::min(sizes[k - 1], sizes[k]) / 4;
+    ASSERT_EQ(p[0], 0u);
+    ASSERT_EQ(p[n - 1], (uint32_t)(n - 1));
+    for (size_t i = n; i < sizes[k] / 4; ++i)
+      p[i] = (uint32_t)i;
+  }
+  alloc::deallocate(p, sizes[5]);
+}
+
+// 带编号的配置器，用于检查容器是否按照传播特性选择配置器
+// 每个编号各自统计尚未归还的字节数，用错配置器释放时对应的计数就不会归零
+int tagged_live[128];
+
+template <bool Propagate>
+class tagged_alloc {
+ public:
+  typedef std::integral_constant<bool, Propagate> propagate_on_container_copy_assignment;
+  typedef std::integral_constant<bool, Propagate> propagate_on_container_move_assignment;
+  typedef std::integral_constant<bool, Propagate> propagate_on_container_swap;
+
+  tagged_alloc(int id) : id(id) {}
+
+  void* allocate(size_t n) {
+    tagged_live[id] += (int)n;
+    return ::operator new(n);
+  }
+
+  void deallocate(void* p, size_t n) {
+    tagged_live[id] -= (int)n;
+    ::operator delete(p);
+  }
+
+  // 拷贝构造出的容器使用新的编号
+  tagged_alloc select_on_container_copy_construction() const {
+    return tagged_alloc(id * 10);
+  }
+
+  bool operator==(const tagged_alloc& rhs) const {
+    return id == rhs.id;
+  }
+
+  int id;
+};
+
+template <bool Propagate>
+void check_propagation() {
+  typedef tagged_alloc<Propagate> A;
+  int                             expect = Propagate ? 2 : 1;
+  {
+    vector<int, A> v1({1, 2, 3}, A(1));
+    vector<int, A> v2({4, 5}, A(2));
+    vector<int, A> v3(v2);
+    ASSERT_EQ(v3.get_allocator().id, 20);
+    v1 = v2;
+    ASSERT_EQ(v1.get_allocator().id, expect);
+    ASSERT_EQ(v1.size(), 2u);
+    v3 = std::move(v2);
+    ASSERT_EQ(v3.get_allocator().id, Propagate ? 2 : 20);
+    ASSERT_EQ(v3.size(), 2u);
+    // 不传播时交换配置器不相等的容器是未定义行为
+    if (Propagate) {
+      v1.swap(v3);
+      ASSERT_EQ(v1.size(), 2u);
+    }
+
+    list<int, A> l1({1, 2, 3}, A(3));
+    list<int, A> l2({4, 5}, A(4));
+    l1 = std::move(l2);
+    ASSERT_EQ(l1.get_allocator().id, Propagate ? 4 : 3);
+    ASSERT_EQ(l1.size(), 2u);
+    list<int, A> l3(l1, A(5));
+    l3 = l1;
+    ASSERT_EQ(l3.get_allocator().id, Propagate ? l1.get_allocator().id : 5);
+
+    deque<int, A> d1({1, 2, 3}, A(6));
+    deque<int, A> d2(std::move(d1), A(7));
+    ASSERT_EQ(d2.get_allocator().id, 7);
+    ASSERT_EQ(d2.size(), 3u);
+    d1 = d2;
+    ASSERT_EQ(d1.get_allocator().id, Propagate ? 7 : 6);
+
+    map<int, int, std::less<int>, A> m1(A(8));
+    map<int, int, std::less<int>, A> m2(A(9));
+    for (int i = 0; i < 100; ++i)
+      m2[i] = i;
+    m1 = std::move(m2);
+    ASSERT_EQ(m1.get_allocator().id, Propagate ? 9 : 8);
+    ASSERT_EQ(m1.size(), 100u);
+    ASSERT_EQ(m1[99], 99);
+  }
+  for (int i = 0; i < 128; ++i)
+    ASSERT_EQ(tagged_live[i], 0) << "id " << i;
+}
+
+TEST(AllocTest, Propagation) {
+  check_propagation<true>();
+  check_propagation<false>();
+}
+
+#if PERFORMANCE_TEST
+TEST(AllocPerformTest, ThreadScaling) {
+  // 每个线程做相同数量的小区块分配/释放，线程数增加时总耗时应基本不变
+  const int num_elem = 1000000;
+  for (int num_thread = 1; num_thread <= 8; num_thread *= 2) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_thread; ++t) {
+      threads.emplace_back([num_elem]() {
+        gd::list<int> l;
+        for (int i = 0; i < num_elem; ++i)
+          l.push_back(i);
+        l.clear();
+      });
+    }
+    for (auto& th : threads)
+      th.join();
+
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    cout << "- threads: " << num_thread << ", list nodes per thread: " << num_elem << ", time cost: " << cost.count()
+         << endl;
+  }
+}
+#endif
+
 }  // namespace test_alloc
 }  // namespace gd
 
@@ -0,0 +1,232 @@
+#ifndef __TEST_ARENA_H
+#define __TEST_ARENA_H
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_arena.h"
+#include "my_deque.h"
+#include "my_list.h"
+#include "my_map.h"
+#include "my_set.h"
+#include "my_vector.h"
+#include "testdef.h"
+
+namespace gd {
+namespace test_arena {
+
+using testing::ElementsAre;
+
+TEST(ArenaTest, Allocate) {
+  arena a(256);
+  ASSERT_EQ(a.bytes_reserved(), 0u);
+
+  char* p1 = (char*)a.allocate(1, 1);
+  char* p2 = (char*)a.allocate(8, 8);
+  char* p3 = (char*)a.allocate(16, 16);
+  ASSERT_EQ((size_t)p2 % 8, 0u);
+  ASSERT_EQ((size_t)p3 % 16, 0u);
+  // 同一个内存块里连续分配
+  ASSERT_LT(p1, p2);
+  ASSERT_LT(p2, p3);
+  size_t reserved = a.bytes_reserved();
+  ASSERT_GE(reserved, 256u);
+
+  // 超过一个内存块的分配也能满足
+  char* big = (char*)a.allocate(10000, 64);
+  ASSERT_EQ((size_t)big % 64, 0u);
+  ASSERT_GE(a.bytes_reserved(), reserved + 10000);
+
+  a.release();
+  ASSERT_EQ(a.bytes_reserved(), 0u);
+}
+
+TEST(ArenaTest, Buffer) {
+  // 调用者提供的 buffer 用完之前不会向系统申请内存
+  alignas(16) char buf[1024];
+  arena            a(buf, sizeof(buf));
+  for (int i = 0; i < 16; ++i) {
+    void* p = a.allocate(32);
+    ASSERT_GE((char*)p, buf);
+    ASSERT_LT((char*)p, buf + sizeof(buf));
+  }
+  ASSERT_EQ(a.bytes_reserved(), 0u);
+  a.allocate(2048);
+  ASSERT_GT(a.bytes_reserved(), 0u);
+
+  // release 之后重新从 buffer 开始分配
+  a.release();
+  ASSERT_EQ(a.allocate(8), (void*)buf);
+}
+
+TEST(ArenaTest, Vector) {
+  arena       a;
+  arena_alloc aa(a);
+
+  vector<int, arena_alloc> v1(aa);
+  for (int i = 0; i < 1000; ++i)
+    v1.push_back(i);
+  ASSERT_EQ(v1.size(), 1000u);
+  ASSERT_EQ(v1.get_allocator().resource(), &a);
+
+  vector<int, arena_alloc> v2(v1);
+  ASSERT_EQ(v2.get_allocator().resource(), &a);
+  ASSERT_TRUE(v1 == v2);
+
+  vector<int, arena_alloc> v3({1, 2, 3}, aa);
+  v3 = v1;
+  ASSERT_TRUE(v3 == v1);
+  v3.assign(size_t(2000), 7);
+  ASSERT_EQ(v3.size(), 2000u);
+
+  vector<int, arena_alloc> v4(std::move(v1));
+  ASSERT_EQ(v4.size(), 1000u);
+  ASSERT_EQ(v4.get_allocator().resource(), &a);
+}
+
+TEST(ArenaTest, Reallocate) {
+  arena a;
+  char* p = (char*)a.allocate(16, 8);
+  memset(p, 'x', 16);
+  // 最近一次分配的区块原地扩展
+  ASSERT_EQ(a.reallocate(p, 16, 256, 8), (void*)p);
+  char* q = (char*)a.allocate(8, 8);
+  ASSERT_GE(q, p + 256);
+  // 不是最近一次分配的区块只能复制
+  char* r = (char*)a.reallocate(p, 256, 512, 8);
+  ASSERT_NE(r, p);
+  ASSERT_EQ(r[15], 'x');
+
+  // 只有一个 vector 在使用 arena 时，扩容都是原地进行的
+  arena                    b(1 << 16);
+  arena_alloc              ab(b);
+  vector<int, arena_alloc> v(ab);
+  v.push_back(0);
+  int* data = v.data();
+  for (int i = 1; i < 8000; ++i)
+    v.push_back(i);
+  ASSERT_EQ(v.data(), data);
+  ASSERT_EQ(v[7999], 7999);
+}
+
+TEST(ArenaTest, ListAndDeque) {
+  arena       a;
+  arena_alloc aa(a);
+
+  list<int, arena_alloc> l(aa);
+  for (int i = 0; i < 100; ++i)
+    l.push_back(100 - i);
+  l.sort();
+  ASSERT_EQ(l.front(), 1);
+  ASSERT_EQ(l.back(), 100);
+  l.sort(std::greater<int>());
+  ASSERT_EQ(l.front(), 100);
+
+  list<int, arena_alloc> l2({3, 1, 2}, aa);
+  l2 = std::move(l);
+  ASSERT_EQ(l2.size(), 100u);
+  ASSERT_EQ(l2.get_allocator().resource(), &a);
+
+  deque<int, arena_alloc> d(aa);
+  for (int i = 0; i < 1000; ++i) {
+    d.push_back(i);
+    d.push_front(-i);
+  }
+  ASSERT_EQ(d.size(), 2000u);
+  ASSERT_EQ(d.front(), -999);
+  ASSERT_EQ(d.back(), 999);
+  deque<int, arena_alloc> d2(d);
+  ASSERT_TRUE(d2 == d);
+  ASSERT_EQ(d2.get_allocator().resource(), &a);
+}
+
+TEST(ArenaTest, MapAndSet) {
+  arena       a;
+  arena_alloc aa(a);
+
+  map<std::string, int, std::less<std::string>, arena_alloc> m(aa);
+  for (int i = 0; i < 1000; ++i)
+    m[std::to_string(i)] = i;
+  ASSERT_EQ(m.size(), 1000u);
+  ASSERT_EQ(m["42"], 42);
+  ASSERT_EQ(m.get_allocator().resource(), &a);
+
+  map<std::string, int, std::less<std::string>, arena_alloc> m2(m);
+  ASSERT_EQ(m2.size(), 1000u);
+  m2.erase("42");
+  ASSERT_EQ(m2.size(), 999u);
+
+  set<int, std::less<int>, arena_alloc> s({5, 3, 1, 4, 2}, aa);
+  ASSERT_THAT(s, ElementsAre(1, 2, 3, 4, 5));
+  multiset<int, std::less<int>, arena_alloc> ms(aa);
+  ms.insert(1);
+  ms.insert(1);
+  ASSERT_EQ(ms.count(1), 2u);
+}
+
+TEST(ArenaTest, SeparateArenas) {
+  // 每个容器实例绑定自己的 arena，arena_alloc 不传播，赋值后元素仍在左边容器自己的 arena 中
+  arena a1;
+  arena a2;
+
+  vector<int, arena_alloc> v1({1, 2, 3}, arena_alloc(a1));
+  vector<int, arena_alloc> v2({4, 5}, arena_alloc(a2));
+  v1 = v2;
+  ASSERT_EQ(v1.get_allocator().resource(), &a1);
+  ASSERT_THAT(v1, ElementsAre(4, 5));
+
+  size_t reserved = a1.bytes_reserved();
+  v2.assign({6, 7, 8, 9});
+  v1 = std::move(v2);
+  ASSERT_EQ(v1.get_allocator().resource(), &a1);
+  ASSERT_THAT(v1, ElementsAre(6, 7, 8, 9));
+  ASSERT_GE(a1.bytes_reserved(), reserved);
+
+  arena_alloc                                aa1(a1);
+  arena_alloc                                aa2(a2);
+  map<int, int, std::less<int>, arena_alloc> m1(aa1);
+  map<int, int, std::less<int>, arena_alloc> m2(aa2);
+  for (int i = 0; i < 100; ++i)
+    m2[i] = i;
+  m1 = std::move(m2);
+  ASSERT_EQ(m1.size(), 100u);
+  ASSERT_EQ(m1.get_allocator().resource(), &a1);
+  ASSERT_EQ(m1[99], 99);
+}
+
+#if PERFORMANCE_TEST
+TEST(ArenaPerformTest, RequestScopedMap) {
+  // 模拟每个请求建立一个临时 map，请求结束后整个销毁
+  const int num_request = 1000;
+  const int num_elem = 1000;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < num_request; ++r) {
+    map<int, int> m;
+    for (int i = 0; i < num_elem; ++i)
+      m.insert({i * 7 % num_elem, i});
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map with alloc, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < num_request; ++r) {
+    arena                                          a;
+    arena_alloc                                    aa(a);
+    map<int, int, std::less<int>, arena_alloc> m(aa);
+    for (int i = 0; i < num_elem; ++i)
+      m.insert({i * 7 % num_elem, i});
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map with arena_alloc, time cost: " << cost.count() << std::endl;
+}
+#endif
+
+}  // namespace test_arena
+}  // namespace gd
+
+#endif  // !__TEST_ARENA_H
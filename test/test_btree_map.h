@@ -0,0 +1,321 @@
+#ifndef __TEST_BTREE_MAP__H
+#define __TEST_BTREE_MAP__H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_arena.h"
+#include "my_btree_map.h"
+#include "my_map.h"
+#include "my_set.h"  // for identity
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_btree_map {
+
+using testing::ElementsAre;
+
+typedef btree<int, int, identity<int>, std::less<int>> int_btree;
+
+template <typename Tree, typename Std>
+void check_same(const Tree& t, const Std& s) {
+  ASSERT_TRUE(t.__verify());
+  ASSERT_EQ(t.size(), s.size());
+  ASSERT_TRUE(std::equal(s.begin(), s.end(), t.begin()));
+}
+
+TEST(BtreeTest, RandomOps) {
+  std::mt19937       rng(1);
+  int_btree          u;
+  int_btree          m;
+  std::set<int>      su;
+  std::multiset<int> sm;
+
+  // 元素足够多时树有三层，覆盖叶节点和内部节点的分裂、借用、合并
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 20000; ++i) {
+      int x = (int)(rng() % 30000);
+      ASSERT_EQ(u.insert_unique(x).second, su.insert(x).second);
+      ASSERT_EQ(*m.insert_equal(x), x);
+      sm.insert(x);
+    }
+    check_same(u, su);
+    check_same(m, sm);
+    for (int i = 0; i < 15000; ++i) {
+      int x = (int)(rng() % 30000);
+      ASSERT_EQ(u.erase(x), su.erase(x));
+      auto it = m.find(x);
+      if (it != m.end()) {
+        // erase 返回下一个元素
+        auto next = m.erase(it);
+        sm.erase(sm.find(x));
+        auto snext = sm.lower_bound(x);
+        ASSERT_EQ(next == m.end(), snext == sm.end());
+        if (snext != sm.end()) {
+          ASSERT_EQ(*next, *snext);
+        }
+      }
+    }
+    check_same(u, su);
+    check_same(m, sm);
+  }
+
+  for (int x = -1; x <= 30000; x += 7) {
+    ASSERT_EQ(u.count(x), su.count(x));
+    ASSERT_EQ(m.count(x), sm.count(x));
+    auto lb = m.lower_bound(x);
+    ASSERT_EQ(lb == m.end() ? -1 : *lb, sm.lower_bound(x) == sm.end() ? -1 : *sm.lower_bound(x));
+  }
+
+  // 边遍历边删除
+  for (auto it = m.begin(); it != m.end();) {
+    if (*it % 3 == 0)
+      it = m.erase(it);
+    else
+      ++it;
+  }
+  for (auto it = sm.begin(); it != sm.end();) {
+    if (*it % 3 == 0)
+      it = sm.erase(it);
+    else
+      ++it;
+  }
+  check_same(m, sm);
+
+  // 反向遍历
+  auto it = m.end();
+  for (auto sit = sm.rbegin(); sit != sm.rend(); ++sit)
+    ASSERT_EQ(*--it, *sit);
+  ASSERT_TRUE(it == m.begin());
+
+  m.erase(m.begin(), m.end());
+  ASSERT_TRUE(m.__verify());
+  ASSERT_TRUE(m.empty());
+  ASSERT_TRUE(m.begin() == m.end());
+}
+
+TEST(BtreeTest, HintAndSorted) {
+  int_btree     t;
+  std::set<int> s;
+
+  // 顺序插入时 hint 为 end()，逆序插入时 hint 为 begin()
+  for (int i = 0; i < 5000; ++i)
+    t.insert_unique(t.end(), 2 * i);
+  for (int i = 0; i < 5000; ++i)
+    t.insert_unique(t.begin(), -2 * i - 2);
+  for (int i = 0; i < 5000; ++i) {
+    s.insert(2 * i);
+    s.insert(-2 * i - 2);
+  }
+  check_same(t, s);
+
+  // 错误的 hint 退化为普通插入
+  auto it = t.insert_unique(t.begin(), 1);
+  ASSERT_EQ(*it, 1);
+  ASSERT_EQ(*++it, 2);
+  ASSERT_EQ(*t.insert_unique(t.find(4), 4), 4);
+  s.insert(1);
+  check_same(t, s);
+
+  // 有序区间建树，无序的剩余部分逐个插入
+  vector<int> v;
+  for (int i = 0; i < 10000; ++i)
+    v.push_back(i / 2);
+  v.push_back(-1);
+  v.push_back(20000);
+  t.assign_sorted_unique(v.begin(), v.end());
+  std::set<int> s2;
+  for (size_t i = 0; i < v.size(); ++i)
+    s2.insert(v[i]);
+  check_same(t, s2);
+  t.assign_sorted_equal(v.begin(), v.end());
+  std::multiset<int> s3;
+  for (size_t i = 0; i < v.size(); ++i)
+    s3.insert(v[i]);
+  check_same(t, s3);
+}
+
+TEST(BtreeTest, CopyAndNontrivial) {
+  btree<int, std::pair<const int, nontrivial>, select1st<std::pair<const int, nontrivial>>, std::less<int>> t;
+  for (int i = 0; i < 3000; ++i)
+    t.try_emplace((i * 7919) % 3000, i, i);
+  ASSERT_TRUE(t.__verify());
+  ASSERT_EQ(t.size(), 3000u);
+
+  auto t2 = t;
+  ASSERT_TRUE(t2.__verify());
+  ASSERT_TRUE(t2 == t);
+  for (int i = 0; i < 3000; i += 2)
+    t.erase(i);
+  ASSERT_TRUE(t.__verify());
+  ASSERT_EQ(t.size(), 1500u);
+  ASSERT_EQ(t2.size(), 3000u);
+  ASSERT_FALSE(t == t2);
+
+  t = std::move(t2);
+  ASSERT_TRUE(t.__verify());
+  ASSERT_TRUE(t2.__verify());
+  ASSERT_EQ(t.size(), 3000u);
+  for (int i = 0; i < 3000; i += 100)
+    ASSERT_EQ(*t.find((i * 7919) % 3000)->second.i, i);
+  t.swap(t2);
+  ASSERT_TRUE(t.empty());
+  ASSERT_EQ(t2.size(), 3000u);
+}
+
+// 用 -1 构造时抛出异常
+struct throw_on_negative {
+  nontrivial v;
+
+  throw_on_negative(int i) : v(i) {
+    if (i < 0)
+      throw std::runtime_error("negative");
+  }
+};
+
+TEST(BtreeTest, ConstructThrows) {
+  // 顺序插入时叶节点按末尾或开头分裂，新元素放进分裂出的空节点后构造失败
+  btree<int, std::pair<const int, throw_on_negative>, select1st<std::pair<const int, throw_on_negative>>,
+        std::less<int>>
+      t;
+  ASSERT_THROW(t.try_emplace(0, -1), std::runtime_error);
+  ASSERT_TRUE(t.__verify());
+  ASSERT_TRUE(t.empty());
+  for (int i = 0; i < 2000; ++i) {
+    ASSERT_THROW(t.try_emplace(i, -1), std::runtime_error);
+    ASSERT_THROW(t.try_emplace(-i - 1, -1), std::runtime_error);
+    ASSERT_TRUE(t.__verify());
+    ASSERT_EQ(t.size(), (size_t)i);
+    t.try_emplace(i, i);
+  }
+  for (int i = 0; i < 2000; ++i)
+    ASSERT_EQ(*t.find(i)->second.v.i, i);
+}
+
+TEST(BtreeMapTest, Basic) {
+  btree_map<std::string, int> m({{"b", 2}, {"a", 1}, {"c", 3}});
+  ASSERT_EQ(m.size(), 3u);
+  ASSERT_EQ(m["a"], 1);
+  m["d"] = 4;
+  ASSERT_EQ(m.at("d"), 4);
+  ASSERT_THROW(m.at("x"), std::out_of_range);
+  ASSERT_FALSE(m.try_emplace("a", 10).second);
+  ASSERT_FALSE(m.insert({"b", 20}).second);
+  ASSERT_EQ(m["b"], 2);
+  ASSERT_EQ(m.erase("c"), 1u);
+  ASSERT_EQ(m.count("c"), 0u);
+
+  vector<std::string> keys;
+  for (auto& p : m)
+    keys.push_back(p.first);
+  ASSERT_THAT(keys, ElementsAre("a", "b", "d"));
+
+  // 与 map 的接口相同
+  map<int, int>       rm;
+  btree_map<int, int> bm;
+  for (int i = 0; i < 1000; ++i) {
+    rm[i * 37 % 1000] = i;
+    bm[i * 37 % 1000] = i;
+  }
+  ASSERT_TRUE(std::equal(rm.begin(), rm.end(), bm.begin()));
+  ASSERT_EQ(bm.lower_bound(500)->first, 500);
+  ASSERT_EQ(bm.upper_bound(500)->first, 501);
+  ASSERT_TRUE(bm.find(1000) == bm.end());
+
+  vector<std::pair<int, int>> sorted;
+  for (int i = 0; i < 1000; ++i)
+    sorted.push_back(std::make_pair(i, i * i));
+  btree_map<int, int> bm2(sorted_unique, sorted.begin(), sorted.end());
+  ASSERT_EQ(bm2.size(), 1000u);
+  ASSERT_EQ(bm2[999], 999 * 999);
+  ASSERT_TRUE(bm2 != bm);
+}
+
+// 配置器不相等时移动只能逐个搬移元素，元素放在左边容器自己的 arena 中
+TEST(BtreeMapTest, UnequalAllocators) {
+  typedef btree_map<int, int, std::less<int>, arena_alloc> arena_map;
+  arena     a1;
+  arena     a2;
+  arena_map m1{arena_alloc(a1)};
+  arena_map m2{arena_alloc(a2)};
+  for (int i = 0; i < 1000; ++i)
+    m2[i] = i * 2;
+  m1 = std::move(m2);
+  ASSERT_EQ(m1.get_allocator().resource(), &a1);
+  ASSERT_EQ(m1.size(), 1000u);
+  ASSERT_EQ(m1[999], 1998);
+
+  arena_map m3(std::move(m1), arena_alloc(a2));
+  ASSERT_EQ(m3.get_allocator().resource(), &a2);
+  ASSERT_EQ(m3.size(), 1000u);
+  ASSERT_EQ(m3.begin()->second, 0);
+
+  // 空容器之间的移动
+  arena_map m4{arena_alloc(a1)};
+  arena_map m5{arena_alloc(a2)};
+  m4 = std::move(m5);
+  ASSERT_TRUE(m4.empty());
+  m4[1] = 1;
+  ASSERT_EQ(m4.size(), 1u);
+}
+
+#if PERFORMANCE_TEST
+// 同样的随机 key，分别比较插入、随机查找、顺序遍历的时间
+template <typename Map>
+void btree_map_perform(const char* name, const vector<uint64_t>& keys, const vector<uint64_t>& queries) {
+  auto start = std::chrono::steady_clock::now();
+  Map  m;
+  for (size_t i = 0; i < keys.size(); ++i)
+    m.insert(std::make_pair(keys[i], (uint32_t)i));
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- " << name << " insert, time cost: " << cost.count() << std::endl;
+
+  uint64_t sum = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < queries.size(); ++i) {
+    auto it = m.lower_bound(queries[i]);
+    if (it != m.end())
+      sum += it->second;
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- " << name << " lower_bound, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (auto& p : m)
+    sum += p.second;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- " << name << " traverse, time cost: " << cost.count() << std::endl;
+  ASSERT_NE(sum, 0u);
+}
+
+TEST(BtreeMapPerformTest, Lookup) {
+  const int num_query = 1000000;
+  const int sizes[] = {1000, 1000000, 10000000};
+
+  for (int n : sizes) {
+    std::mt19937_64  rng(n);
+    vector<uint64_t> keys;
+    vector<uint64_t> queries;
+    for (int i = 0; i < n; ++i)
+      keys.push_back(rng());
+    for (int i = 0; i < num_query; ++i)
+      queries.push_back(keys[rng() % n]);
+    std::cout << "- " << n << " keys:" << std::endl;
+    btree_map_perform<map<uint64_t, uint32_t>>("map", keys, queries);
+    btree_map_perform<btree_map<uint64_t, uint32_t>>("btree_map", keys, queries);
+  }
+}
+#endif
+
+}  // namespace test_btree_map
+}  // namespace gd
+
+#endif  // !__TEST_BTREE_MAP__H
@@ -0,0 +1,34 @@
+#ifndef __TEST_BTREE_SET__H
+#define __TEST_BTREE_SET__H
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_btree_set.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_btree_set {
+
+using testing::ElementsAre;
+
+TEST(BtreeSetTest, Basic) {
+  btree_set<int> s({5, 3, 1, 4, 2, 3});
+  ASSERT_THAT(s, ElementsAre(1, 2, 3, 4, 5));
+  ASSERT_FALSE(s.insert(4).second);
+  ASSERT_EQ(*s.insert(s.end(), 6), 6);
+  auto it = s.erase(s.find(3));
+  ASSERT_EQ(*it, 4);
+  ASSERT_THAT(s, ElementsAre(1, 2, 4, 5, 6));
+  s.erase(s.begin(), s.find(4));
+  ASSERT_THAT(s, ElementsAre(4, 5, 6));
+
+  btree_set<int> s2(s);
+  ASSERT_TRUE(s2 == s);
+  s2.insert(0);
+  ASSERT_TRUE(s2 < s);
+}
+
+}  // namespace test_btree_set
+}  // namespace gd
+
+#endif  // !__TEST_BTREE_SET__H
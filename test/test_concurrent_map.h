@@ -0,0 +1,204 @@
+#ifndef __TEST_CONCURRENT_MAP__H
+#define __TEST_CONCURRENT_MAP__H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_concurrent_map.h"
+#include "my_map.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_concurrent_map {
+
+TEST(ConcurrentMapTest, Basic) {
+  concurrent_map<std::string, int> m = {{"b", 2}, {"a", 1}};
+  ASSERT_EQ(m.size(), 2u);
+  ASSERT_TRUE(m.insert({"c", 3}));
+  ASSERT_FALSE(m.insert({"a", 10}));
+  ASSERT_FALSE(m.insert_or_assign("a", 10));
+  ASSERT_EQ(m.at("a"), 10);
+  ASSERT_THROW(m.at("x"), std::out_of_range);
+
+  int v = 0;
+  ASSERT_TRUE(m.find("b", v));
+  ASSERT_EQ(v, 2);
+  ASSERT_FALSE(m.find("bb", v));
+  std::string key;
+  ASSERT_TRUE(m.visit_lower_bound("bb", [&](const std::pair<const std::string, int>& p) { key = p.first; }));
+  ASSERT_EQ(key, "c");
+  ASSERT_FALSE(m.visit_lower_bound("d", [&](const std::pair<const std::string, int>&) {}));
+
+  // 快照不随之后的修改改变
+  auto snap = m.snapshot();
+  ASSERT_EQ(m.erase("a"), 1u);
+  ASSERT_EQ(m.erase("a"), 0u);
+  ASSERT_EQ(m.count("a"), 0u);
+  ASSERT_EQ(snap.size(), 3u);
+  ASSERT_EQ(snap.at("a"), 10);
+
+  m.update([](persistent_map<std::string, int>& w) {
+    w["x"] = 1;
+    w["y"] = 2;
+    w.erase("b");
+  });
+  ASSERT_EQ(m.size(), 3u);
+  ASSERT_TRUE(m.visit("y", [](const std::pair<const std::string, int>& p) { ASSERT_EQ(p.second, 2); }));
+  m.clear();
+  ASSERT_TRUE(m.empty());
+}
+
+// update 中途抛出异常时，已经做的修改不会被之后的写者发布出去
+TEST(ConcurrentMapTest, UpdateThrows) {
+  concurrent_map<int, int> m = {{0, 0}};
+  auto                     bad_update = [](persistent_map<int, int>& w) {
+    w[1] = 1;
+    w.erase(0);
+    throw std::runtime_error("update");
+  };
+  ASSERT_THROW(m.update(bad_update), std::runtime_error);
+  ASSERT_EQ(m.count(1), 0u);
+  ASSERT_EQ(m.count(0), 1u);
+  ASSERT_TRUE(m.insert_or_assign(2, 2));
+  ASSERT_EQ(m.count(1), 0u);
+  ASSERT_EQ(m.count(0), 1u);
+  ASSERT_EQ(m.size(), 2u);
+  auto snap = m.snapshot();
+  ASSERT_EQ(snap.size(), 2u);
+  ASSERT_EQ(snap.at(2), 2);
+}
+
+// 读者与写者同时运行：读到的值总是正确的，update 中成对的修改总是同时可见
+TEST(ConcurrentMapTest, ReadersAndWriters) {
+  const int                num_key = 2000;
+  concurrent_map<int, int> m;
+  std::atomic<bool>        done(false);
+  std::atomic<int>         bad(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      while (!done) {
+        int k = (int)(rng() % num_key);
+        int v;
+        if (m.find(k, v))
+          bad += v != k * 2;
+        // 偶数 key 和它的下一个 key 总是一起插入、一起删除
+        auto snap = m.snapshot();
+        for (auto& p : snap)
+          bad += p.second != p.first * 2 || snap.count(p.first ^ 1) == 0;
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 2; ++t) {
+    writers.emplace_back([&, t] {
+      std::mt19937 rng(100 + t);
+      for (int i = 0; i < 5000; ++i) {
+        int k = (int)(rng() % num_key) & ~1;
+        m.update([k](persistent_map<int, int>& w) {
+          if (w.erase(k) == 0) {
+            w.insert(std::make_pair(k, k * 2));
+            w.insert(std::make_pair(k + 1, (k + 1) * 2));
+          } else {
+            w.erase(k + 1);
+          }
+        });
+      }
+    });
+  }
+  for (auto& w : writers)
+    w.join();
+  done = true;
+  for (auto& r : readers)
+    r.join();
+  ASSERT_EQ(bad.load(), 0);
+  ASSERT_EQ(m.size() % 2, 0u);
+}
+
+#if PERFORMANCE_TEST
+// 读多写少：多个读线程随机查找，一个写线程每隔 10us 修改一次，比较 shared_mutex 保护的 map 与 concurrent_map 的读吞吐
+TEST(ConcurrentMapPerformTest, ReadWriteMix) {
+  const int num_elem = 1000000;
+  const int num_read = 1000000;  // 每个读线程
+  const int num_reader = std::max(4u, std::thread::hardware_concurrency());
+
+  std::mt19937     rng(1);
+  vector<uint32_t> keys;
+  for (int i = 0; i < num_elem; ++i)
+    keys.push_back((uint32_t)rng());
+
+  map<uint32_t, uint32_t>            locked;
+  std::shared_mutex                  lock;
+  concurrent_map<uint32_t, uint32_t> cm;
+  cm.update([&](persistent_map<uint32_t, uint32_t>& w) {
+    for (int i = 0; i < num_elem; ++i)
+      w.insert(std::make_pair(keys[i], (uint32_t)i));
+  });
+  for (int i = 0; i < num_elem; ++i)
+    locked.insert(std::make_pair(keys[i], (uint32_t)i));
+
+  auto run = [&](const char* name, std::function<bool(uint32_t)> read, std::function<void(uint32_t)> write) {
+    std::atomic<bool>        done(false);
+    std::atomic<uint64_t>    found(0);
+    std::vector<std::thread> threads;
+    auto                     start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_reader; ++t) {
+      threads.emplace_back([&, t] {
+        std::mt19937 r(t);
+        uint64_t     n = 0;
+        for (int i = 0; i < num_read; ++i)
+          n += read(keys[r() % num_elem]);
+        found += n;
+      });
+    }
+    std::thread writer([&] {
+      std::mt19937 r(99);
+      while (!done) {
+        write(keys[r() % num_elem]);
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+      }
+    });
+    for (auto& t : threads)
+      t.join();
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    done = true;
+    writer.join();
+    std::cout << "- " << name << ", readers: " << num_reader << ", time cost: " << cost.count() << std::endl;
+    return found.load();
+  };
+
+  uint64_t a = run(
+      "shared_mutex map",
+      [&](uint32_t k) {
+        std::shared_lock<std::shared_mutex> g(lock);
+        return locked.count(k) != 0;
+      },
+      [&](uint32_t k) {
+        std::unique_lock<std::shared_mutex> g(lock);
+        locked[k] += 1;
+      });
+  uint64_t b = run(
+      "concurrent_map", [&](uint32_t k) { return cm.count(k) != 0; },
+      [&](uint32_t k) { cm.update([k](persistent_map<uint32_t, uint32_t>& w) { w[k] += 1; }); });
+  ASSERT_EQ(a, b);
+}
+#endif
+
+}  // namespace test_concurrent_map
+}  // namespace gd
+
+#endif  // !__TEST_CONCURRENT_MAP__H
@@ -7,6 +7,9 @@
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <random>
+#include <string>
+#include <type_traits>
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "my_alloc.h"
@@ -425,6 +428,56 @@ TEST_F(DequeTest, Operator) {
   ASSERT_TRUE(!(d2 == d4));
 }
 
+// 用户自定义的平凡可复制类型
+struct point {
+  int    x;
+  double y;
+
+  bool operator==(const point& rhs) const {
+    return x == rhs.x && y == rhs.y;
+  }
+};
+
+TEST(DequeTrivialTest, InsertAndErase) {
+  static_assert(std::is_same<__type_traits<point>::is_POD_type, __true_type>::value, "");
+  static_assert(std::is_same<__type_traits<point>::has_trivial_destructor, __true_type>::value, "");
+  static_assert(std::is_same<__type_traits<nontrivial>::is_POD_type, __false_type>::value, "");
+  static_assert(std::is_same<__type_traits<std::string>::has_trivial_destructor, __false_type>::value, "");
+
+  // 跨越多个缓冲区的插入和删除，与 std::deque 对比
+  std::deque<point> expect;
+  deque<point>      d;
+  std::mt19937      rng(42);
+  for (int i = 0; i < 2000; ++i) {
+    point  p = {i, i * 0.5};
+    size_t pos = d.empty() ? 0 : rng() % (d.size() + 1);
+    switch (rng() % 4) {
+      case 0:
+        d.insert(d.begin() + pos, p);
+        expect.insert(expect.begin() + pos, p);
+        break;
+      case 1:
+        d.insert(d.begin() + pos, size_t(100), p);
+        expect.insert(expect.begin() + pos, size_t(100), p);
+        break;
+      case 2:
+        if (!d.empty() && pos < d.size()) {
+          d.erase(d.begin() + pos);
+          expect.erase(expect.begin() + pos);
+        }
+        break;
+      default:
+        if (d.size() > 150 && pos + 150 <= d.size()) {
+          d.erase(d.begin() + pos, d.begin() + pos + 150);
+          expect.erase(expect.begin() + pos, expect.begin() + pos + 150);
+        }
+        break;
+    }
+  }
+  ASSERT_EQ(d.size(), expect.size());
+  ASSERT_TRUE(std::equal(expect.begin(), expect.end(), d.begin()));
+}
+
 #if PERFORMANCE_TEST
 TEST(DeqPerformTest, Performance) {
   std::deque<int> std_deq1;
@@ -438,6 +491,14 @@ TEST(DeqPerformTest, Performance) {
 
   PERFORM_TEST(std_deq2.push_back(8), 20000000);
   PERFORM_TEST(my_deq2.push_back(8), 20000000);
+
+  // 平凡可复制的类型在中间插入、删除时按缓冲区分段 memmove
+  std::deque<point> std_deq3(100000, point{1, 2});
+  gd::deque<point>  my_deq3(100000, point{1, 2});
+  PERFORM_TEST(std_deq3.insert(std_deq3.begin() + 30000, point{3, 4}), 100000);
+  PERFORM_TEST(my_deq3.insert(my_deq3.begin() + 30000, point{3, 4}), 100000);
+  PERFORM_TEST(std_deq3.erase(std_deq3.begin() + 30000), 100000);
+  PERFORM_TEST(my_deq3.erase(my_deq3.begin() + 30000), 100000);
 }
 #endif
 
@@ -0,0 +1,178 @@
+#ifndef __TEST_FLAT_MAP__H
+#define __TEST_FLAT_MAP__H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_arena.h"
+#include "my_flat_map.h"
+#include "my_map.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_flat_map {
+
+using testing::ElementsAre;
+
+TEST(FlatMapTest, Basic) {
+  flat_map<std::string, int> m({{"b", 2}, {"a", 1}, {"c", 3}, {"a", 10}});
+  ASSERT_EQ(m.size(), 3u);
+  // 重复的 key 保留第一个
+  ASSERT_EQ(m["a"], 1);
+  m["d"] = 4;
+  ASSERT_EQ(m.at("d"), 4);
+  ASSERT_THROW(m.at("x"), std::out_of_range);
+  ASSERT_FALSE(m.try_emplace("a", 10).second);
+  ASSERT_FALSE(m.insert({"b", 20}).second);
+  ASSERT_TRUE(m.emplace("e", 5).second);
+  ASSERT_EQ(m.erase("c"), 1u);
+  ASSERT_EQ(m.count("c"), 0u);
+  ASSERT_THAT(m.keys(), ElementsAre("a", "b", "d", "e"));
+  ASSERT_THAT(m.values(), ElementsAre(1, 2, 4, 5));
+
+  // 迭代器解引用得到 key 和 mapped 值的引用
+  for (auto p : m)
+    p.second *= 10;
+  m.find("a")->second = 7;
+  ASSERT_THAT(m.values(), ElementsAre(7, 20, 40, 50));
+  auto it = m.erase(m.find("b"));
+  ASSERT_EQ(it->first, "d");
+  ASSERT_EQ(m.end() - m.begin(), 3);
+
+  auto range = m.equal_range("d");
+  ASSERT_EQ(range.second - range.first, 1);
+  ASSERT_TRUE(m.lower_bound("f") == m.end());
+  ASSERT_EQ(m.upper_bound("a")->first, "d");
+}
+
+TEST(FlatMapTest, BulkAndHint) {
+  std::mt19937                rng(1);
+  map<int, int>               rm;
+  vector<std::pair<int, int>> input;
+  for (int i = 0; i < 5000; ++i) {
+    int k = (int)(rng() % 3000);
+    input.push_back(std::make_pair(k, i));
+    rm.insert(std::make_pair(k, i));
+  }
+
+  // 区间插入先排序去重再归并，结果与逐个插入 map 相同
+  flat_map<int, int> fm(input.begin(), input.end());
+  ASSERT_EQ(fm.size(), rm.size());
+  auto rit = rm.begin();
+  for (auto p : fm) {
+    ASSERT_EQ(p.first, rit->first);
+    ASSERT_EQ(p.second, rit->second);
+    ++rit;
+  }
+  fm.insert(rm.begin(), rm.end());
+  ASSERT_EQ(fm.size(), rm.size());
+  fm.insert({{-1, -1}, {5000, 5000}, {0, 12345}});
+  ASSERT_EQ(fm.size(), rm.size() + 2);
+  ASSERT_EQ(fm.begin()->first, -1);
+  ASSERT_EQ(fm.at(0), rm[0]);
+
+  rm.insert({{-1, -1}, {5000, 5000}});
+  for (int k = -2; k < 5002; ++k) {
+    ASSERT_EQ(fm.find(k) == fm.end(), rm.find(k) == rm.end());
+    ASSERT_EQ(fm.lower_bound(k) - fm.begin(), gd::distance(rm.begin(), rm.lower_bound(k)));
+    ASSERT_EQ(fm.upper_bound(k) - fm.begin(), gd::distance(rm.begin(), rm.upper_bound(k)));
+  }
+
+  // 有序输入直接追加，hint 正确时不需要查找
+  flat_map<int, int> sm(sorted_unique, rm.begin(), rm.end());
+  ASSERT_TRUE(sm == fm);
+  flat_map<int, int> hm;
+  for (int i = 0; i < 100; ++i)
+    hm.insert(hm.end(), std::make_pair(i, i));
+  hm.insert(hm.begin(), std::make_pair(50, 0));
+  ASSERT_EQ(hm.size(), 100u);
+  ASSERT_EQ(hm[50], 50);
+
+  // 删除一段
+  auto it = hm.erase(hm.find(10), hm.find(90));
+  ASSERT_EQ(it->first, 90);
+  ASSERT_EQ(hm.size(), 20u);
+
+  hm.shrink_to_fit();
+  ASSERT_EQ(hm.capacity(), 20u);
+  flat_map<int, int> hm2(hm);
+  ASSERT_TRUE(hm2 == hm);
+  hm2[0] = -1;
+  ASSERT_TRUE(hm2 < hm);
+  hm2.swap(hm);
+  ASSERT_EQ(hm[0], -1);
+}
+
+// 带状态的配置器没有默认构造函数，所有的临时空间都要用容器的配置器分配
+TEST(FlatMapTest, ArenaAllocator) {
+  arena                                           a;
+  flat_map<int, int, std::less<int>, arena_alloc> m{arena_alloc(a)};
+  vector<std::pair<int, int>>                     input;
+  for (int i = 0; i < 100; ++i)
+    input.push_back(std::make_pair(i * 7 % 100, i));
+  m.insert(input.begin(), input.end());
+  m.insert({{-1, -1}, {0, 0}});
+  ASSERT_EQ(m.size(), 101u);
+  ASSERT_EQ(m.begin()->first, -1);
+  ASSERT_EQ(m.get_allocator().resource(), &a);
+}
+
+#if PERFORMANCE_TEST
+// 同样的 key，比较随机查找的时间和占用的内存
+TEST(FlatMapPerformTest, Find) {
+  const int num_elem = 1000000;
+  const int num_query = 10000000;
+
+  std::mt19937_64  rng(1);
+  vector<uint64_t> keys;
+  vector<uint64_t> queries;
+  for (int i = 0; i < num_elem; ++i)
+    keys.push_back(rng());
+  for (int i = 0; i < num_query; ++i)
+    queries.push_back(keys[rng() % num_elem]);
+
+  map<uint64_t, uint32_t>               m;
+  vector<std::pair<uint64_t, uint32_t>> input;
+  for (int i = 0; i < num_elem; ++i) {
+    m.insert(std::make_pair(keys[i], (uint32_t)i));
+    input.push_back(std::make_pair(keys[i], (uint32_t)i));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  flat_map<uint64_t, uint32_t> fm(input.begin(), input.end());
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- flat_map build, time cost: " << cost.count() << std::endl;
+
+  uint64_t sum = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_query; ++i)
+    sum += m.find(queries[i])->second;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map find, time cost: " << cost.count() << std::endl;
+
+  uint64_t sum2 = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_query; ++i)
+    sum2 += fm.find(queries[i])->second;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- flat_map find, time cost: " << cost.count() << std::endl;
+  ASSERT_EQ(sum, sum2);
+
+  // map 每个元素一个节点：三个指针加上元素本身
+  fm.shrink_to_fit();
+  std::cout << "- map memory: " << m.size() * (sizeof(_rb_tree_node<std::pair<const uint64_t, uint32_t>>))
+            << " bytes, flat_map memory: " << fm.capacity() * (sizeof(uint64_t) + sizeof(uint32_t)) << " bytes"
+            << std::endl;
+}
+#endif
+
+}  // namespace test_flat_map
+}  // namespace gd
+
+#endif  // !__TEST_FLAT_MAP__H
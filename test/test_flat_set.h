@@ -0,0 +1,44 @@
+#ifndef __TEST_FLAT_SET__H
+#define __TEST_FLAT_SET__H
+
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_flat_set.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_flat_set {
+
+using testing::ElementsAre;
+
+TEST(FlatSetTest, Basic) {
+  flat_set<int> s({5, 3, 1, 4, 2, 3});
+  ASSERT_THAT(s, ElementsAre(1, 2, 3, 4, 5));
+  ASSERT_FALSE(s.insert(4).second);
+  ASSERT_EQ(*s.insert(s.end(), 6), 6);
+  ASSERT_EQ(*s.insert(s.begin(), 0), 0);
+  auto it = s.erase(s.find(3));
+  ASSERT_EQ(*it, 4);
+  s.insert({9, 7, 8, 7, 0});
+  ASSERT_THAT(s, ElementsAre(0, 1, 2, 4, 5, 6, 7, 8, 9));
+  s.erase(s.begin(), s.find(4));
+  ASSERT_THAT(s, ElementsAre(4, 5, 6, 7, 8, 9));
+  ASSERT_EQ(*s.lower_bound(3), 4);
+  ASSERT_EQ(*s.upper_bound(4), 5);
+  ASSERT_EQ(s.count(10), 0u);
+
+  // 有序部分直接追加，之后无序的 "a" 与已有元素归并去重
+  std::string           words[] = {"a", "b", "b", "c", "a"};
+  flat_set<std::string> s2(sorted_unique, words, words + 5);
+  ASSERT_THAT(s2, ElementsAre("a", "b", "c"));
+  flat_set<std::string> s3(s2);
+  ASSERT_TRUE(s3 == s2);
+  s3.emplace("0");
+  ASSERT_TRUE(s3 < s2);
+}
+
+}  // namespace test_flat_set
+}  // namespace gd
+
+#endif  // !__TEST_FLAT_SET__H
@@ -0,0 +1,157 @@
+#ifndef __TEST_FROZEN_SET__H
+#define __TEST_FROZEN_SET__H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_arena.h"
+#include "my_flat_set.h"
+#include "my_frozen_set.h"
+#include "my_set.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_frozen_set {
+
+using testing::ElementsAre;
+
+TEST(FrozenSetTest, Basic) {
+  frozen_set<std::string> fs({"d", "b", "a", "c", "b"});
+  ASSERT_EQ(fs.size(), 4u);
+  ASSERT_THAT(fs, ElementsAre("a", "b", "c", "d"));
+  ASSERT_EQ(*fs.lower_bound("bb"), "c");
+  ASSERT_EQ(*fs.upper_bound("b"), "c");
+  ASSERT_TRUE(fs.lower_bound("e") == fs.end());
+  ASSERT_EQ(fs.count("a"), 1u);
+  ASSERT_TRUE(fs.find("x") == fs.end());
+  ASSERT_EQ(*--fs.end(), "d");
+
+  frozen_set<std::string> fs2(fs);
+  ASSERT_TRUE(fs2 == fs);
+  frozen_set<std::string> fs3(std::move(fs2));
+  ASSERT_TRUE(fs2.empty());
+  ASSERT_TRUE(fs2.begin() == fs2.end());
+  fs2 = fs3;
+  fs3 = frozen_set<std::string>({"a"});
+  ASSERT_TRUE(fs3 < fs2);
+  fs3.swap(fs2);
+  ASSERT_EQ(fs3.size(), 4u);
+}
+
+TEST(FrozenSetTest, ArenaAllocator) {
+  arena                                        a;
+  int                                          input[] = {5, 3, 9, 1, 3, 7};
+  frozen_set<int, std::less<int>, arena_alloc> fs(input, input + 6, std::less<int>(), arena_alloc(a));
+  ASSERT_THAT(fs, ElementsAre(1, 3, 5, 7, 9));
+  ASSERT_EQ(fs.get_allocator().resource(), &a);
+}
+
+// 各种大小的完全二叉树，查找和遍历的结果与 set 相同
+TEST(FrozenSetTest, MatchesSet) {
+  std::mt19937 rng(1);
+  for (int n = 0; n < 130; ++n) {
+    set<int> s;
+    while ((int)s.size() < n)
+      s.insert((int)(rng() % 1000) * 2);
+    frozen_set<int> fs = freeze(s);
+    ASSERT_EQ(fs.size(), s.size());
+    ASSERT_TRUE(std::equal(fs.begin(), fs.end(), s.begin()));
+
+    // 反向遍历
+    auto sit = s.end();
+    for (auto it = fs.end(); it != fs.begin();)
+      ASSERT_EQ(*--it, *--sit);
+
+    for (int k = -1; k < 2001; ++k) {
+      auto lb = s.lower_bound(k);
+      auto ub = s.upper_bound(k);
+      auto flb = fs.lower_bound(k);
+      auto fub = fs.upper_bound(k);
+      ASSERT_EQ(flb == fs.end(), lb == s.end());
+      ASSERT_EQ(fub == fs.end(), ub == s.end());
+      if (lb != s.end()) {
+        ASSERT_EQ(*flb, *lb);
+      }
+      if (ub != s.end()) {
+        ASSERT_EQ(*fub, *ub);
+      }
+      ASSERT_EQ(fs.count(k), s.count(k));
+    }
+  }
+
+  // 有序的输入直接建立，无序的输入排序后建立
+  vector<int> sorted;
+  for (int i = 0; i < 10000; ++i)
+    sorted.push_back(i * 3);
+  frozen_set<int> a(sorted_unique, sorted.begin(), sorted.end());
+  std::shuffle(sorted.begin(), sorted.end(), rng);
+  frozen_set<int> b(sorted_unique, sorted.begin(), sorted.end());
+  ASSERT_TRUE(a == b);
+  ASSERT_EQ(*a.lower_bound(3001), 3003);
+}
+
+#if PERFORMANCE_TEST
+// 同样的元素，比较随机 lower_bound 的时间：红黑树、有序数组上的二分查找、Eytzinger 布局
+TEST(FrozenSetPerformTest, LowerBound) {
+  const int num_query = 5000000;
+  const int sizes[] = {1000, 1000000, 10000000};
+
+  for (int num_elem : sizes) {
+    std::mt19937     rng(1);
+    set<uint32_t>    s;
+    vector<uint32_t> queries;
+    while ((int)s.size() < num_elem)
+      s.insert((uint32_t)rng());
+    for (int i = 0; i < num_query; ++i)
+      queries.push_back((uint32_t)rng());
+    std::cout << "- elements: " << num_elem << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    frozen_set<uint32_t> fs = freeze(s);
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- freeze, time cost: " << cost.count() << std::endl;
+    flat_set<uint32_t> flat(sorted_unique, s.begin(), s.end());
+
+    uint64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_query; ++i) {
+      auto it = s.lower_bound(queries[i]);
+      sum += it == s.end() ? 0 : *it;
+    }
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- set lower_bound, time cost: " << cost.count() << std::endl;
+
+    uint64_t sum2 = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_query; ++i) {
+      auto it = flat.lower_bound(queries[i]);
+      sum2 += it == flat.end() ? 0 : *it;
+    }
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- flat_set lower_bound, time cost: " << cost.count() << std::endl;
+
+    uint64_t sum3 = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_query; ++i) {
+      auto it = fs.lower_bound(queries[i]);
+      sum3 += it == fs.end() ? 0 : *it;
+    }
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- frozen_set lower_bound, time cost: " << cost.count() << std::endl;
+    ASSERT_EQ(sum, sum2);
+    ASSERT_EQ(sum, sum3);
+  }
+}
+#endif
+
+}  // namespace test_frozen_set
+}  // namespace gd
+
+#endif  // !__TEST_FROZEN_SET__H
@@ -1,11 +1,25 @@
 #include "test_alloc.h"
+#include "test_arena.h"
+#include "test_btree_map.h"
+#include "test_btree_set.h"
+#include "test_concurrent_map.h"
 #include "test_deque.h"
+#include "test_flat_map.h"
+#include "test_flat_set.h"
+#include "test_frozen_set.h"
 #include "test_list.h"
 #include "test_map.h"
+#include "test_node_pool.h"
+#include "test_persistent_map.h"
 #include "test_queue.h"
 #include "test_set.h"
+#include "test_skiplist_map.h"
+#include "test_skiplist_set.h"
+#include "test_small_vector.h"
 #include "test_stack.h"
 #include "test_tree.h"
+#include "test_unordered_map.h"
+#include "test_unordered_set.h"
 #include "test_vector.h"
 
 int main(int argc, char **argv) {
@@ -1,10 +1,17 @@
 #ifndef __TEST_MAP__H
 #define __TEST_MAP__H
 
+#include <chrono>
+#include <iostream>
 #include <map>
+#include <random>
+#include <string>
+#include <string_view>
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "my_arena.h"
 #include "my_map.h"
+#include "my_node_pool.h"
 #include "my_vector.h"
 #include "test_helper.h"
 
@@ -202,6 +209,426 @@ TEST_F(MapTest, Operator) {
   ASSERT_TRUE(mm != tmp2);
 }
 
+TEST(MapSortedTest, Construct) {
+  vector<std::pair<int, int>> in;
+  for (int i = 0; i < 100; ++i)
+    in.push_back({i / 3, i});
+
+  map<int, int> m(sorted_unique, in.begin(), in.end());
+  ASSERT_EQ(m.size(), 34u);
+  ASSERT_EQ(m[5], 15);  // 重复的 key 只保留第一个
+  multimap<int, int> mm(sorted_equivalent, in.begin(), in.end());
+  ASSERT_EQ(mm.size(), 100u);
+  ASSERT_EQ(mm.count(5), 3u);
+
+  in.push_back({0, -1});  // 无序
+  m.assign_sorted(in.begin(), in.end());
+  ASSERT_EQ(m.size(), 34u);
+  ASSERT_EQ(m[0], 0);
+  mm.assign_sorted(in.begin(), in.end());
+  ASSERT_EQ(mm.size(), 101u);
+  ASSERT_EQ(mm.count(0), 4u);
+}
+
+TEST(MapHintTest, Insert) {
+  map<int, int> m;
+  for (int i = 0; i < 100; ++i)
+    m.insert(m.end(), {i * 2, i});
+  // hint 指向插入位置的后一个元素
+  for (int i = 0; i < 100; ++i)
+    m.emplace_hint(m.find(i * 2), i * 2 - 1, -i);
+  ASSERT_EQ(m.size(), 200u);
+  ASSERT_EQ(m[-1], 0);
+  ASSERT_EQ(m[197], -99);
+  ASSERT_EQ(m.insert(m.begin(), {10, 42})->second, 5);
+
+  multimap<int, int> mm;
+  for (int i = 0; i < 100; ++i)
+    mm.insert(mm.end(), {i / 10, i});
+  ASSERT_EQ(mm.count(3), 10u);
+  ASSERT_EQ(mm.lower_bound(3)->second, 30);
+}
+
+TEST(MapRankTest, Leaderboard) {
+  // 按分数排名，分数相同时按名字
+  map<std::pair<int, std::string>, int, std::less<std::pair<int, std::string>>, alloc, order_statistic> board;
+  board[{90, "a"}] = 1;
+  board[{75, "b"}] = 2;
+  board[{90, "c"}] = 3;
+  board[{60, "d"}] = 4;
+  ASSERT_EQ(board.nth(0)->second, 4);
+  ASSERT_EQ(board.nth(3)->second, 3);
+  ASSERT_TRUE(board.nth(4) == board.end());
+  ASSERT_EQ(board.rank({90, ""}), 2u);
+  ASSERT_EQ(board.count_range({70, ""}, {91, ""}), 3u);
+  board.erase({75, "b"});
+  ASSERT_EQ(board.rank({90, "c"}), 2u);
+  ASSERT_EQ(board.nth(1)->first.second, "a");
+
+  multimap<int, int, std::less<int>, alloc, order_statistic> mm;
+  for (int i = 0; i < 100; ++i)
+    mm.insert({i % 10, i});
+  ASSERT_EQ(mm.count(3), 10u);
+  ASSERT_EQ(mm.rank(3), 30u);
+  ASSERT_EQ(mm.nth(35)->first, 3);
+  ASSERT_EQ(mm.count_range(2, 5), 30u);
+}
+
+// 只记录构造次数的 key，用来确认透明查找没有构造 key_type
+struct counted_name {
+  static int  constructed;
+  std::string name;
+
+  explicit counted_name(const char* s) : name(s) {
+    ++constructed;
+  }
+  counted_name(const counted_name& rhs) : name(rhs.name) {
+    ++constructed;
+  }
+};
+
+int counted_name::constructed = 0;
+
+struct name_less {
+  typedef void is_transparent;
+
+  bool operator()(const counted_name& lhs, const counted_name& rhs) const {
+    return lhs.name < rhs.name;
+  }
+  bool operator()(const counted_name& lhs, std::string_view rhs) const {
+    return lhs.name < rhs;
+  }
+  bool operator()(std::string_view lhs, const counted_name& rhs) const {
+    return lhs < rhs.name;
+  }
+};
+
+TEST(MapTransparentTest, Lookup) {
+  map<counted_name, int, name_less, alloc, order_statistic> m;
+  const char* names[] = {"get", "head", "post", "put"};
+  for (int i = 0; i < 4; ++i)
+    m.emplace(counted_name(names[i]), i);
+
+  counted_name::constructed = 0;
+  std::string_view method("post");
+  ASSERT_EQ(m.find(method)->second, 2);
+  ASSERT_TRUE(m.find(std::string_view("delete")) == m.end());
+  ASSERT_EQ(m.count(std::string_view("get")), 1u);
+  ASSERT_EQ(m.lower_bound(std::string_view("h"))->second, 1);
+  ASSERT_EQ(m.upper_bound(std::string_view("post"))->second, 3);
+  auto range = m.equal_range(std::string_view("head"));
+  ASSERT_EQ(gd::distance(range.first, range.second), 1u);
+  ASSERT_EQ(m.rank(std::string_view("p")), 2u);
+  ASSERT_EQ(m.count_range(std::string_view("h"), std::string_view("q")), 3u);
+  const auto& cm = m;
+  ASSERT_EQ(cm.find(std::string_view("put"))->second, 3);
+  ASSERT_EQ(counted_name::constructed, 0);
+
+  // std::less<> 可以直接用 const char* 查找 std::string
+  multimap<std::string, int, std::less<>> mm = {{"a", 1}, {"b", 2}, {"b", 3}};
+  ASSERT_EQ(mm.count("b"), 2u);
+  ASSERT_EQ(mm.lower_bound("b")->second, 2);
+  ASSERT_TRUE(mm.upper_bound("b") == mm.end());
+}
+
+TEST(MapNodeTest, ExtractAndMerge) {
+  map<int, std::string> m = {{1, "a"}, {2, "b"}, {3, "c"}};
+  const std::string*    addr = &m.find(2)->second;
+
+  // 摘下来改掉 key 再插回去，元素还在原来的节点中
+  auto nh = m.extract(2);
+  ASSERT_FALSE(nh.empty());
+  ASSERT_EQ(m.size(), 2u);
+  nh.key() = 4;
+  nh.mapped() += "!";
+  auto res = m.insert(std::move(nh));
+  ASSERT_TRUE(res.inserted);
+  ASSERT_TRUE(res.node.empty());
+  ASSERT_EQ(res.position->first, 4);
+  ASSERT_EQ(&res.position->second, addr);
+  ASSERT_TRUE(m.extract(10).empty());
+
+  // key 重复时插入失败，节点还给调用者
+  map<int, std::string> m2 = {{4, "x"}};
+  res = m2.insert(m.extract(m.find(4)));
+  ASSERT_FALSE(res.inserted);
+  ASSERT_EQ(res.position->second, "x");
+  ASSERT_EQ(res.node.mapped(), "b!");
+  auto it = m2.insert(m2.end(), std::move(res.node));
+  ASSERT_EQ(it->second, "x");
+  ASSERT_FALSE(res.node.empty());
+  m.insert(m.begin(), std::move(res.node));
+  ASSERT_EQ(&m[4], addr);
+  m2.extract(4);
+  ASSERT_EQ(m2.size(), 0u);
+
+  // 合并：重复的 key 留在 src 中，比较器可以不同
+  map<int, std::string, std::greater<int>> src = {{0, "z"}, {1, "y"}, {5, "w"}};
+  m.merge(src);
+  ASSERT_EQ(m.size(), 5u);
+  ASSERT_EQ(src.size(), 1u);
+  ASSERT_EQ(src.begin()->second, "y");
+  ASSERT_EQ(m[0], "z");
+
+  multimap<int, std::string> mm = {{1, "p"}, {1, "q"}};
+  mm.merge(m);
+  ASSERT_TRUE(m.empty());
+  ASSERT_EQ(mm.size(), 7u);
+  ASSERT_EQ(mm.count(1), 3u);
+  ASSERT_EQ(mm.lower_bound(1)->second, "p");  // 原有的元素在前面
+  ASSERT_EQ(&mm.find(4)->second, addr);
+  m.merge(mm);
+  ASSERT_EQ(m.size(), 5u);
+  ASSERT_EQ(mm.size(), 2u);
+  mm.insert(m.extract(m.begin()));
+  ASSERT_EQ(mm.count(0), 1u);
+  mm.merge(mm);
+  ASSERT_EQ(mm.size(), 3u);
+}
+
+TEST(MapNodeTest, AugmentAndAlloc) {
+  // 顺序统计树中移动的节点也要更新子树大小
+  typedef map<int, int, std::less<int>, alloc, order_statistic> rank_map;
+  rank_map a, b;
+  for (int i = 0; i < 100; ++i)
+    (i % 3 ? a : b)[i] = i;
+  for (int i = 0; i < 20; ++i)
+    b.insert(a.extract(a.nth(0)));
+  a.merge(b);
+  ASSERT_TRUE(b.empty());
+  ASSERT_EQ(a.size(), 100u);
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(a.nth(i)->first, i);
+  ASSERT_EQ(a.count_range(10, 20), 10u);
+
+  // 相等的元素按 std::multimap::merge 的顺序排列
+  std::mt19937            rng(5);
+  multimap<int, int>      x, y;
+  std::multimap<int, int> sx, sy;
+  for (int i = 0; i < 2000; ++i) {
+    int k = (int)(rng() % 300);
+    (i % 2 ? x : y).insert({k, i});
+    (i % 2 ? sx : sy).insert({k, i});
+  }
+  x.merge(y);
+  sx.merge(sy);
+  ASSERT_TRUE(y.empty());
+  ASSERT_TRUE(std::equal(sx.begin(), sx.end(), x.begin()));
+
+  // 不同的池之间不能直接转移节点，退化为移动元素；共享同一个池时直接链接
+  typedef map<int, nontrivial, std::less<int>, node_pool_alloc<>> pool_map;
+  pool_map p1, p2;
+  for (int i = 0; i < 50; ++i) {
+    p1.emplace(i, i);
+    p2.emplace(i + 25, i + 25);
+  }
+  p1.merge(p2);
+  ASSERT_EQ(p1.size(), 75u);
+  ASSERT_EQ(p2.size(), 25u);
+  ASSERT_EQ(*p1[60].i, 60);
+  p2.insert(p1.extract(0));
+  ASSERT_EQ(*p2[0].i, 0);
+
+  pool_map p3(std::less<int>(), p1.get_allocator());
+  size_t   live = p1.get_allocator().resource()->live();
+  p3.merge(p1);
+  ASSERT_TRUE(p1.empty());
+  ASSERT_EQ(p3.size(), 74u);
+  ASSERT_EQ(p1.get_allocator().resource()->live(), live);
+  {
+    auto nh = p3.extract(1);  // 句柄析构时释放节点
+  }
+  ASSERT_EQ(p3.size(), 73u);
+
+  // 配置器没有默认构造函数时，key 不存在也能返回空句柄，句柄带着树的配置器
+  arena                                      ar;
+  map<int, int, std::less<int>, arena_alloc> am{arena_alloc(ar)};
+  am[1] = 1;
+  auto empty_nh = am.extract(2);
+  ASSERT_TRUE(empty_nh.empty());
+  ASSERT_EQ(empty_nh.get_allocator().resource(), &ar);
+  empty_nh = am.extract(1);
+  ASSERT_EQ(empty_nh.key(), 1);
+  ASSERT_TRUE(am.empty());
+  ASSERT_TRUE(am.insert(std::move(empty_nh)).inserted);
+  ASSERT_EQ(am[1], 1);
+}
+
+#if PERFORMANCE_TEST
+TEST(MapPerformTest, Rank) {
+  const int num_elem = 1000000;
+  const int num_query = 200;
+
+  map<int, int>                                         m;
+  map<int, int, std::less<int>, alloc, order_statistic> om;
+  for (int i = 0; i < num_elem; ++i) {
+    m.insert(m.end(), {i, i});
+    om.insert(om.end(), {i, i});
+  }
+
+  std::mt19937 rng(9);
+  size_t       sum = 0;
+  auto         start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_query; ++i)
+    sum += gd::distance(m.begin(), m.lower_bound(rng() % num_elem));
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map distance(begin, lower_bound) x" << num_query << ", time cost: " << cost.count() << std::endl;
+
+  rng.seed(9);
+  size_t osum = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_query; ++i)
+    osum += om.rank(rng() % num_elem);
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- order_statistic map rank x" << num_query << ", time cost: " << cost.count() << std::endl;
+  ASSERT_EQ(sum, osum);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_elem; ++i)
+    om.erase(i);
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- order_statistic map erase, time cost: " << cost.count() << std::endl;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_elem; ++i)
+    m.erase(i);
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map erase, time cost: " << cost.count() << std::endl;
+}
+
+TEST(MapPerformTest, SortedConstruct) {
+  const int                   num_elem = 2000000;
+  vector<std::pair<int, int>> in;
+  for (int i = 0; i < num_elem; ++i)
+    in.push_back({i, i});
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    map<int, int> m(in.begin(), in.end());
+    ASSERT_EQ(m.size(), (size_t)num_elem);
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map(first, last), time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  {
+    map<int, int> m(sorted_unique, in.begin(), in.end());
+    ASSERT_EQ(m.size(), (size_t)num_elem);
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map(sorted_unique, first, last), time cost: " << cost.count() << std::endl;
+}
+
+TEST(MapPerformTest, HintedInsert) {
+  // 按时间顺序写入，key 递增，每个 key 平均重复写入一次
+  const int num_elem = 2000000;
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    map<int, int> m;
+    for (int i = 0; i < num_elem; ++i)
+      m.insert({i / 2, i});
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map insert(v), time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  {
+    map<int, int> m;
+    for (int i = 0; i < num_elem; ++i)
+      m.insert(m.end(), {i / 2, i});
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map insert(end(), v), time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  {
+    std::map<int, int> m;
+    for (int i = 0; i < num_elem; ++i)
+      m.insert(m.end(), {i / 2, i});
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- std::map insert(end(), v), time cost: " << cost.count() << std::endl;
+}
+
+TEST(MapPerformTest, TransparentFind) {
+  // 超过短字符串优化长度的 key，用 string_view 查找时非透明的比较器每次都要构造一个 std::string
+  const int num_elem = 100000;
+  const int num_query = 2000000;
+
+  vector<std::string>      names;
+  vector<std::string_view> queries;
+  for (int i = 0; i < num_elem; ++i)
+    names.push_back("x-request-header-" + std::to_string(i));
+  std::mt19937 rng(3);
+  for (int i = 0; i < num_query; ++i)
+    queries.push_back(names[rng() % num_elem]);
+  map<std::string, int>              m;
+  map<std::string, int, std::less<>> tm;
+  for (int i = 0; i < num_elem; ++i) {
+    m.insert({names[i], i});
+    tm.insert({names[i], i});
+  }
+
+  long long sum = 0;
+  auto      start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_query; ++i)
+    sum += m.find(std::string(queries[i]))->second;
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map find(std::string(sv)), time cost: " << cost.count() << std::endl;
+
+  long long tsum = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_query; ++i)
+    tsum += tm.find(queries[i])->second;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map<std::less<>> find(sv), time cost: " << cost.count() << std::endl;
+  ASSERT_EQ(sum, tsum);
+}
+
+TEST(MapPerformTest, MoveEntries) {
+  // 在两个 map 之间来回移动全部元素：erase + insert 每次都要释放、分配节点并拷贝元素
+  const int num_elem = 1000000;
+  const int rounds = 4;
+
+  map<int, std::string> a, b;
+  for (int i = 0; i < num_elem; ++i)
+    a.insert(a.end(), {i, "value-longer-than-sso-" + std::to_string(i)});
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    map<int, std::string>& from = r % 2 ? b : a;
+    map<int, std::string>& to = r % 2 ? a : b;
+    for (auto it = from.begin(); it != from.end();) {
+      to.insert(to.end(), *it);
+      from.erase(it++);
+    }
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map erase + insert, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    map<int, std::string>& from = r % 2 ? b : a;
+    map<int, std::string>& to = r % 2 ? a : b;
+    for (auto it = from.begin(); it != from.end();)
+      to.insert(to.end(), from.extract(it++));
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map extract + insert, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    map<int, std::string>& from = r % 2 ? b : a;
+    map<int, std::string>& to = r % 2 ? a : b;
+    to.merge(from);
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map merge, time cost: " << cost.count() << std::endl;
+  ASSERT_EQ(a.size(), (size_t)num_elem);
+  ASSERT_TRUE(b.empty());
+}
+#endif
+
 }  // namespace test_map
 }  // namespace gd
 
@@ -0,0 +1,199 @@
+#ifndef __TEST_NODE_POOL_H
+#define __TEST_NODE_POOL_H
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_list.h"
+#include "my_map.h"
+#include "my_node_pool.h"
+#include "my_set.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_node_pool {
+
+using testing::ElementsAre;
+
+typedef node_pool_alloc<> pool_alloc;
+
+TEST(NodePoolTest, Pool) {
+  node_pool<> pool;
+  ASSERT_EQ(pool.slab_count(), 0u);
+
+  // 节点从同一块 slab 中依次切出
+  char* p1 = (char*)pool.allocate(40);
+  char* p2 = (char*)pool.allocate(40);
+  char* p3 = (char*)pool.allocate(40);
+  ASSERT_EQ(p2, p1 + 40);
+  ASSERT_EQ(p3, p2 + 40);
+  ASSERT_EQ((size_t)p1 % alignof(std::max_align_t), 0u);
+  ASSERT_EQ(pool.live(), 3u);
+  ASSERT_EQ(pool.slab_count(), 1u);
+
+  // 释放的节点优先重用
+  pool.deallocate(p2, 40);
+  ASSERT_EQ(pool.allocate(40), (void*)p2);
+
+  // 其他大小的分配直接交给底层配置器，不计入池中
+  void* other = pool.allocate(100);
+  ASSERT_EQ(pool.live(), 3u);
+  pool.deallocate(other, 100);
+
+  // 一块 slab 用完后申请更大的一块
+  vector<void*> v;
+  for (int i = 0; i < 1000; ++i)
+    v.push_back(pool.allocate(40));
+  ASSERT_EQ(pool.live(), 1003u);
+  ASSERT_GT(pool.slab_count(), 1u);
+
+  // 所有节点都归还后整块释放 slab
+  for (size_t i = 0; i < v.size(); ++i)
+    pool.deallocate(v[i], 40);
+  pool.deallocate(p1, 40);
+  pool.deallocate(p2, 40);
+  ASSERT_GT(pool.slab_count(), 1u);
+  pool.deallocate(p3, 40);
+  ASSERT_EQ(pool.live(), 0u);
+  ASSERT_EQ(pool.slab_count(), 0u);
+}
+
+TEST(NodePoolTest, ListAndMap) {
+  list<int, pool_alloc> l;
+  for (int i = 0; i < 1000; ++i)
+    l.push_back(1000 - i);
+  l.sort();
+  ASSERT_EQ(l.size(), 1000u);
+  ASSERT_EQ(l.front(), 1);
+  ASSERT_EQ(l.back(), 1000);
+  // 头节点也由池分配
+  ASSERT_EQ(l.get_allocator().resource()->live(), 1001u);
+  l.remove_if([](int x) { return x % 2 == 0; });
+  ASSERT_EQ(l.get_allocator().resource()->live(), 501u);
+
+  map<std::string, int, std::less<std::string>, pool_alloc> m;
+  for (int i = 0; i < 1000; ++i)
+    m[std::to_string(i)] = i;
+  ASSERT_EQ(m["42"], 42);
+  node_pool<>* pool = m.get_allocator().resource();
+  size_t       slabs = pool->slab_count();
+  // clear 之后的节点放回自由链表，重新插入不再申请 slab
+  m.clear();
+  ASSERT_EQ(pool->live(), 1u);
+  for (int i = 0; i < 1000; ++i)
+    m[std::to_string(i)] = -i;
+  ASSERT_EQ(pool->slab_count(), slabs);
+  ASSERT_EQ(m["999"], -999);
+
+  multiset<int, std::less<int>, pool_alloc> ms({3, 1, 2, 3, 1});
+  ASSERT_THAT(ms, ElementsAre(1, 1, 2, 3, 3));
+  ms.erase(1);
+  ASSERT_THAT(ms, ElementsAre(2, 3, 3));
+}
+
+TEST(NodePoolTest, CopyMoveSwap) {
+  set<int, std::less<int>, pool_alloc> s1({5, 3, 1, 4, 2});
+
+  // 拷贝构造的容器使用自己的池
+  set<int, std::less<int>, pool_alloc> s2(s1);
+  ASSERT_TRUE(s2 == s1);
+  ASSERT_NE(s2.get_allocator().resource(), s1.get_allocator().resource());
+
+  // 拷贝赋值不传播配置器
+  set<int, std::less<int>, pool_alloc> s3({7});
+  node_pool<>*                         p3 = s3.get_allocator().resource();
+  s3 = s1;
+  ASSERT_TRUE(s3 == s1);
+  ASSERT_EQ(s3.get_allocator().resource(), p3);
+  ASSERT_EQ(p3->live(), 6u);
+
+  // 移动和交换时池随节点一起转移
+  node_pool<>*                         p1 = s1.get_allocator().resource();
+  set<int, std::less<int>, pool_alloc> s4(std::move(s1));
+  ASSERT_EQ(s4.get_allocator().resource(), p1);
+  ASSERT_THAT(s4, ElementsAre(1, 2, 3, 4, 5));
+  s3 = std::move(s4);
+  ASSERT_EQ(s3.get_allocator().resource(), p1);
+  ASSERT_THAT(s3, ElementsAre(1, 2, 3, 4, 5));
+  s2.insert(6);
+  node_pool<>* p2 = s2.get_allocator().resource();
+  s2.swap(s3);
+  ASSERT_EQ(s2.get_allocator().resource(), p1);
+  ASSERT_EQ(s3.get_allocator().resource(), p2);
+  ASSERT_THAT(s3, ElementsAre(1, 2, 3, 4, 5, 6));
+
+  list<nontrivial, pool_alloc> l1;
+  for (int i = 0; i < 100; ++i)
+    l1.emplace_back(i, i);
+  list<nontrivial, pool_alloc> l2(l1);
+  list<nontrivial, pool_alloc> l3(std::move(l2));
+  l1 = std::move(l3);
+  ASSERT_EQ(l1.size(), 100u);
+  ASSERT_EQ(*l1.back().i, 99);
+}
+
+#if PERFORMANCE_TEST
+// 多个容器交替插入时，默认配置器分配的节点在内存中交错分布，每个容器的池则把自己的节点放在一起
+template <typename Alloc>
+void node_pool_perform(const char* name, const vector<int>& keys) {
+  const int num_map = 8;
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    vector<map<int, int, std::less<int>, Alloc>*> maps;
+    vector<list<int, Alloc>*>                     lists;
+    for (int i = 0; i < num_map; ++i) {
+      maps.push_back(new map<int, int, std::less<int>, Alloc>());
+      lists.push_back(new list<int, Alloc>());
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+      maps[i % num_map]->insert({keys[i], (int)i});
+      lists[i % num_map]->push_back(keys[i]);
+    }
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- " << name << " insert, time cost: " << cost.count() << std::endl;
+
+    long long sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 10; ++round)
+      for (int i = 0; i < num_map; ++i) {
+        for (auto& p : *maps[i])
+          sum += p.second;
+        for (int x : *lists[i])
+          sum += x;
+      }
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- " << name << " traverse, time cost: " << cost.count() << std::endl;
+    ASSERT_NE(sum, 0);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_map; ++i) {
+      delete maps[i];
+      delete lists[i];
+    }
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- " << name << " destroy, time cost: " << cost.count() << std::endl;
+  }
+}
+
+TEST(NodePoolPerformTest, TraverseAndDestroy) {
+  const int num_elem = 1000000;
+
+  std::mt19937 rng(1);
+  vector<int>  keys;
+  for (int i = 0; i < num_elem; ++i)
+    keys.push_back((int)rng());
+  node_pool_perform<alloc>("alloc", keys);
+  node_pool_perform<pool_alloc>("node_pool_alloc", keys);
+}
+#endif
+
+}  // namespace test_node_pool
+}  // namespace gd
+
+#endif  // !__TEST_NODE_POOL_H
@@ -0,0 +1,214 @@
+#ifndef __TEST_PERSISTENT_MAP__H
+#define __TEST_PERSISTENT_MAP__H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_map.h"
+#include "my_node_pool.h"
+#include "my_persistent_map.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_persistent_map {
+
+template <typename Map, typename StdMap>
+bool same_content(const Map& m, const StdMap& expect) {
+  if (m.size() != expect.size())
+    return false;
+  auto it = expect.begin();
+  for (auto& p : m) {
+    if (p.first != it->first || p.second != it->second)
+      return false;
+    ++it;
+  }
+  return true;
+}
+
+TEST(PersistentMapTest, Basic) {
+  persistent_map<std::string, int> m = {{"b", 2}, {"a", 1}, {"c", 3}};
+  ASSERT_EQ(m.size(), 3u);
+  ASSERT_FALSE(m.insert({"a", 10}).second);
+  ASSERT_EQ(m.at("a"), 1);
+  ASSERT_THROW(m.at("x"), std::out_of_range);
+  m["d"] = 4;
+  m["a"] = 5;
+  ASSERT_EQ(m.insert_or_assign("b", 20).first->second, 20);
+  ASSERT_TRUE(m.emplace("e", 6).second);
+  ASSERT_EQ(m.erase("c"), 1u);
+  ASSERT_EQ(m.erase("c"), 0u);
+  ASSERT_EQ(m.count("c"), 0u);
+
+  std::map<std::string, int> expect = {{"a", 5}, {"b", 20}, {"d", 4}, {"e", 6}};
+  ASSERT_TRUE(same_content(m, expect));
+  ASSERT_EQ(m.lower_bound("c")->first, "d");
+  ASSERT_EQ(m.upper_bound("d")->first, "e");
+  ASSERT_TRUE(m.upper_bound("e") == m.end());
+  ASSERT_EQ((--m.end())->first, "e");
+  auto range = m.equal_range("b");
+  ASSERT_EQ(range.first->first, "b");
+  ASSERT_EQ(range.second->first, "d");
+
+  // 反向遍历
+  auto eit = expect.end();
+  for (auto it = m.end(); it != m.begin();)
+    ASSERT_EQ((--it)->first, (--eit)->first);
+
+  // 快照在原对象修改后保持不变
+  auto snap = m.snapshot();
+  ASSERT_TRUE(snap.shares_with(m));
+  m.erase("a");
+  m["b"] = 0;
+  ASSERT_FALSE(snap.shares_with(m));
+  ASSERT_TRUE(same_content(snap, expect));
+  ASSERT_EQ(m.size(), 3u);
+  ASSERT_EQ(m.at("b"), 0);
+  ASSERT_TRUE(snap != m);
+  m = snap;
+  ASSERT_TRUE(snap == m);
+  m.clear();
+  ASSERT_TRUE(m.empty());
+  ASSERT_TRUE(m.begin() == m.end());
+  ASSERT_EQ(snap.size(), 4u);
+}
+
+// 随机修改的同时不断留下快照，每个快照都与当时的 std::map 相同，全部析构后节点都被释放
+TEST(PersistentMapTest, Snapshots) {
+  typedef persistent_map<int, int, std::less<int>, node_pool_alloc<>> pmap;
+  std::mt19937 rng(1);
+  pmap         m;
+  {
+    std::map<int, int>              expect;
+    std::vector<pmap>               snaps;
+    std::vector<std::map<int, int>> expects;
+    for (int i = 0; i < 20000; ++i) {
+      int k = (int)(rng() % 2000);
+      switch (rng() % 4) {
+        case 0:
+          ASSERT_EQ(m.erase(k), expect.erase(k));
+          break;
+        case 1:
+          m[k] = i;
+          expect[k] = i;
+          break;
+        default:
+          ASSERT_EQ(m.insert(std::make_pair(k, i)).second, expect.insert(std::make_pair(k, i)).second);
+          break;
+      }
+      if (i % 1000 == 0) {
+        snaps.push_back(m);
+        expects.push_back(expect);
+      }
+    }
+    ASSERT_TRUE(same_content(m, expect));
+    for (size_t i = 0; i < snaps.size(); ++i)
+      ASSERT_TRUE(same_content(snaps[i], expects[i]));
+    for (int k = -1; k < 2001; ++k) {
+      auto lb = m.lower_bound(k);
+      auto elb = expect.lower_bound(k);
+      ASSERT_EQ(lb == m.end(), elb == expect.end());
+      if (elb != expect.end()) {
+        ASSERT_EQ(lb->first, elb->first);
+      }
+    }
+  }
+  size_t live = m.get_allocator().resource()->live();
+  ASSERT_EQ(live, m.size());
+  m.clear();
+  ASSERT_EQ(m.get_allocator().resource()->live(), 0u);
+}
+
+// 读线程遍历快照的同时写线程继续修改
+TEST(PersistentMapTest, ConcurrentReader) {
+  persistent_map<int, std::string> m;
+  for (int i = 0; i < 10000; ++i)
+    m[i] = std::to_string(i);
+
+  // 快照在写线程中取得，之后交给读线程
+  persistent_map<int, std::string> snap = m.snapshot();
+  std::atomic<bool>                done(false);
+  std::atomic<int>                 bad(0);
+  std::thread                      reader([&] {
+    while (!done) {
+      int n = 0;
+      for (auto& p : snap)
+        bad += p.second != std::to_string(n++);
+      bad += n != 10000;
+    }
+  });
+  for (int i = 0; i < 20000; ++i) {
+    m.erase(i);
+    m[i + 10000] = "x";
+  }
+  done = true;
+  reader.join();
+  ASSERT_EQ(bad.load(), 0);
+  ASSERT_EQ(m.size(), 10000u);
+  ASSERT_EQ(m.begin()->first, 20000);
+}
+
+#if PERFORMANCE_TEST
+// 给读者一份一致的快照：map 只能整体拷贝，persistent_map 只是共享根节点
+TEST(PersistentMapPerformTest, Snapshot) {
+  const int num_elem = 2000000;
+  const int num_update = 1000000;
+
+  std::mt19937                       rng(1);
+  vector<uint32_t>                   keys;
+  map<uint32_t, uint32_t>            m;
+  persistent_map<uint32_t, uint32_t> pm;
+  for (int i = 0; i < num_elem; ++i)
+    keys.push_back((uint32_t)rng());
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_elem; ++i)
+    m.insert(std::make_pair(keys[i], (uint32_t)i));
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map insert, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_elem; ++i)
+    pm.insert(std::make_pair(keys[i], (uint32_t)i));
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- persistent_map insert, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  map<uint32_t, uint32_t> copy(m);
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map copy, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  persistent_map<uint32_t, uint32_t> snap = pm.snapshot();
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- persistent_map snapshot, time cost: " << cost.count() << std::endl;
+
+  // 持有快照时的修改要复制路径
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_update; ++i)
+    m[keys[rng() % num_elem]] = i;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- map update, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_update; ++i)
+    pm[keys[rng() % num_elem]] = i;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- persistent_map update with snapshot, time cost: " << cost.count() << std::endl;
+  ASSERT_EQ(snap.size(), copy.size());
+  ASSERT_EQ(pm.size(), m.size());
+}
+#endif
+
+}  // namespace test_persistent_map
+}  // namespace gd
+
+#endif  // !__TEST_PERSISTENT_MAP__H
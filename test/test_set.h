@@ -1,12 +1,24 @@
 #ifndef __TEST_SET__H
 #define __TEST_SET__H
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <random>
 #include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "my_map.h"
+#include "my_node_pool.h"
 #include "my_set.h"
 #include "my_vector.h"
 #include "test_helper.h"
+#include "test_tree.h"  // for check_rb
 
 namespace gd {
 namespace test_set {
@@ -172,6 +184,231 @@ TEST_F(SetTest, Operator) {
   ASSERT_TRUE(my_ms != tmp2);
 }
 
+TEST(SetSortedTest, Construct) {
+  vector<int> in = {1, 1, 2, 3, 5, 8, 13};
+  set<int>    s1(sorted_unique, in.begin(), in.end());
+  ASSERT_THAT(s1, testing::ElementsAre(1, 2, 3, 5, 8, 13));
+  multiset<int> s2(sorted_equivalent, in.begin(), in.end());
+  ASSERT_EQ(s2.size(), in.size());
+
+  in[0] = 21;  // 无序
+  s1.assign_sorted(in.begin(), in.end());
+  ASSERT_THAT(s1, testing::ElementsAre(1, 2, 3, 5, 8, 13, 21));
+  s2.assign_sorted(in.begin(), in.end());
+  ASSERT_THAT(s2, testing::ElementsAre(1, 2, 3, 5, 8, 13, 21));
+}
+
+TEST(SetNodeTest, ExtractAndMerge) {
+  set<std::string> s = {"a", "b", "c"};
+  const std::string* addr = &*s.find("b");
+  auto               nh = s.extract("b");
+  nh.value() = "d";
+  auto res = s.insert(std::move(nh));
+  ASSERT_TRUE(res.inserted);
+  ASSERT_EQ(&*res.position, addr);
+  ASSERT_THAT(s, testing::ElementsAre("a", "c", "d"));
+
+  res = s.insert(s.extract(s.begin()));
+  ASSERT_TRUE(res.inserted);
+  nh = s.extract(s.find("a"));
+  auto it = s.insert(s.end(), std::move(nh));
+  ASSERT_EQ(*it, "a");
+
+  multiset<std::string> ms = {"a", "a", "e"};
+  s.merge(ms);
+  ASSERT_THAT(s, testing::ElementsAre("a", "c", "d", "e"));
+  ASSERT_THAT(ms, testing::ElementsAre("a", "a"));
+  ms.merge(s);
+  ASSERT_TRUE(s.empty());
+  ASSERT_THAT(ms, testing::ElementsAre("a", "a", "a", "c", "d", "e"));
+  ASSERT_EQ(&*ms.find("d"), addr);
+  ms.insert(ms.begin(), ms.extract("e"));
+  ASSERT_EQ(ms.count("e"), 1u);
+}
+
+TEST(SetTransparentTest, Lookup) {
+  set<std::string, std::less<>> s = {"accept", "content-length", "host"};
+  ASSERT_EQ(*s.find("host"), "host");
+  ASSERT_TRUE(s.find(std::string_view("cookie")) == s.end());
+  ASSERT_EQ(s.count("accept"), 1u);
+  ASSERT_EQ(*s.lower_bound("b"), "content-length");
+  ASSERT_TRUE(s.upper_bound("host") == s.end());
+
+  multiset<std::string, std::less<>> ms = {"a", "b", "b", "c"};
+  ASSERT_EQ(ms.count(std::string_view("b")), 2u);
+  auto range = ms.equal_range("b");
+  ASSERT_EQ(gd::distance(range.first, range.second), 2u);
+}
+
+// 用 test_tree 中的 check_rb 检查红黑树的性质和 parent 指针，另外要求根节点为黑色
+template <typename Set>
+void check_set_rb(const Set& s) {
+  _rb_tree_node_base* header = s.end().node;
+  _rb_tree_node_base* root = header->parent();
+  EXPECT_TRUE(root == nullptr || root->color() == _rb_tree_black);
+  test_tree::check_rb(root, header);
+}
+
+TEST(SetJoinTest, SplitAndJoin) {
+  typedef set<int, std::less<int>, alloc, order_statistic> rank_set;
+  for (int n = 0; n < 200; n += 7) {
+    for (int k = -1; k <= n; k += 3) {
+      rank_set s;
+      set<int>  t;
+      for (int i = 0; i < n; ++i) {
+        s.insert(i);
+        t.insert(i);
+      }
+      rank_set r = s.split(k);
+      set<int> u = t.split(k);
+      check_set_rb(s);
+      check_set_rb(r);
+      check_set_rb(t);
+      check_set_rb(u);
+      int mid = std::min(std::max(k, 0), n);
+      ASSERT_EQ((int)s.size(), mid);
+      ASSERT_EQ((int)r.size(), n - mid);
+      ASSERT_EQ(t.size(), s.size());
+      ASSERT_EQ(u.size(), r.size());
+      for (int i = 0; i < (int)r.size(); ++i)
+        ASSERT_EQ(*r.nth(i), mid + i);
+      ASSERT_TRUE(std::equal(s.begin(), s.end(), t.begin()));
+
+      // 连接回去，两边大小悬殊时也保持平衡
+      s.join(r);
+      t.join(u);
+      ASSERT_TRUE(r.empty() && u.empty());
+      check_set_rb(s);
+      check_set_rb(t);
+      ASSERT_EQ((int)s.size(), n);
+      ASSERT_EQ((int)t.size(), n);
+      for (int i = 0; i < n; ++i)
+        ASSERT_EQ(s.rank(i), (size_t)i);
+      ASSERT_TRUE(std::equal(s.begin(), s.end(), t.begin()));
+    }
+  }
+
+  // 配置器不同时逐个移动元素
+  set<int, std::less<int>, node_pool_alloc<>> a, b;
+  for (int i = 1; i <= 5; ++i)
+    (i <= 3 ? a : b).insert(i);
+  a.join(b);
+  ASSERT_THAT(a, testing::ElementsAre(1, 2, 3, 4, 5));
+  ASSERT_TRUE(b.empty());
+}
+
+TEST(SetJoinTest, SetOperations) {
+  typedef set<int, std::less<int>, alloc, order_statistic> rank_set;
+  std::mt19937 rng(1);
+  const int    sizes[][2] = {{0, 0}, {0, 50}, {50, 0}, {1, 1000}, {1000, 1}, {300, 300}, {20000, 5000}, {40000, 40000}};
+  for (auto size : sizes) {
+    for (unsigned threads : {1u, 4u}) {
+      std::set<int> x, y;
+      while ((int)x.size() < size[0])
+        x.insert((int)(rng() % 100000));
+      while ((int)y.size() < size[1])
+        y.insert((int)(rng() % 100000));
+      std::vector<int> u, i, d;
+      std::set_union(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(u));
+      std::set_intersection(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(i));
+      std::set_difference(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(d));
+      std::vector<int> xv(x.begin(), x.end()), yv(y.begin(), y.end());
+      const int *      xb = xv.data(), *xe = xb + xv.size(), *yb = yv.data(), *ye = yb + yv.size();
+
+      rank_set a(xb, xe), b(yb, ye);
+      a.set_union(b, threads);
+      ASSERT_TRUE(b.empty());
+      check_set_rb(a);
+      ASSERT_EQ(a.size(), u.size());
+      ASSERT_TRUE(std::equal(u.begin(), u.end(), a.begin()));
+      for (size_t k = 0; k < u.size(); k += 97)
+        ASSERT_EQ(*a.nth(k), u[k]);
+
+      set<int> c(xb, xe), e(yb, ye);
+      c.set_intersection(e, threads);
+      ASSERT_TRUE(e.empty());
+      check_set_rb(c);
+      ASSERT_EQ(c.size(), i.size());
+      ASSERT_TRUE(std::equal(i.begin(), i.end(), c.begin()));
+
+      rank_set f(xb, xe), g(yb, ye);
+      f.set_difference(g, threads);
+      ASSERT_TRUE(g.empty());
+      check_set_rb(f);
+      ASSERT_EQ(f.size(), d.size());
+      ASSERT_TRUE(std::equal(d.begin(), d.end(), f.begin()));
+      for (size_t k = 0; k < d.size(); k += 97)
+        ASSERT_EQ(f.rank(d[k]), k);
+    }
+  }
+
+  // 并集中 key 相同的元素保留本容器的，和自己做运算
+  map<int, int> m1 = {{1, 1}, {2, 2}}, m2 = {{2, 20}, {3, 30}};
+  m1.set_union(m2);
+  ASSERT_EQ(m1[2], 2);
+  ASSERT_EQ(m1.size(), 3u);
+  m1.set_intersection(m1);
+  ASSERT_EQ(m1.size(), 3u);
+  m1.set_difference(m1);
+  ASSERT_TRUE(m1.empty());
+}
+
+#if PERFORMANCE_TEST
+// 两个各有 num_elem 个随机 key 的集合，逐个插入、删除与基于 join 的集合运算比较
+TEST(SetJoinPerformTest, SetOperations) {
+  const int    num_elem = 2000000;
+  std::mt19937 rng(1);
+  vector<int>  x, y;
+  for (int i = 0; i < num_elem; ++i) {
+    x.push_back((int)(rng() % (num_elem * 4)));
+    y.push_back((int)(rng() % (num_elem * 4)));
+  }
+  set<int> base_a(x.begin(), x.end()), base_b(y.begin(), y.end());
+  unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+
+  set<int> a(base_a), b(base_b);
+  auto     start = std::chrono::steady_clock::now();
+  a.insert(b.begin(), b.end());
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- insert union, time cost: " << cost.count() << std::endl;
+  size_t union_size = a.size();
+
+  a = base_a;
+  start = std::chrono::steady_clock::now();
+  for (int v : base_b)
+    a.erase(v);
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- erase difference, time cost: " << cost.count() << std::endl;
+  size_t diff_size = a.size();
+
+  for (unsigned t : {1u, threads}) {
+    a = base_a;
+    b = base_b;
+    start = std::chrono::steady_clock::now();
+    a.set_union(b, t);
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- set_union, threads: " << t << ", time cost: " << cost.count() << std::endl;
+    ASSERT_EQ(a.size(), union_size);
+
+    a = base_a;
+    b = base_b;
+    start = std::chrono::steady_clock::now();
+    a.set_difference(b, t);
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- set_difference, threads: " << t << ", time cost: " << cost.count() << std::endl;
+    ASSERT_EQ(a.size(), diff_size);
+
+    a = base_a;
+    b = base_b;
+    start = std::chrono::steady_clock::now();
+    a.set_intersection(b, t);
+    cost = std::chrono::steady_clock::now() - start;
+    std::cout << "- set_intersection, threads: " << t << ", time cost: " << cost.count() << std::endl;
+    ASSERT_EQ(a.size(), base_a.size() + base_b.size() - union_size);
+  }
+}
+#endif
+
 }  // namespace test_set
 }  // namespace gd
 
@@ -0,0 +1,68 @@
+#ifndef __TEST_SKIPLIST_MAP__H
+#define __TEST_SKIPLIST_MAP__H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_skiplist_map.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_skiplist_map {
+
+TEST(SkiplistMapTest, Basic) {
+  skiplist_map<std::string, int> m = {{"b", 2}, {"a", 1}, {"c", 3}};
+  ASSERT_EQ(m.size(), 3u);
+  ASSERT_FALSE(m.insert({"a", 10}).second);
+  ASSERT_EQ(m.at("a"), 1);
+  ASSERT_THROW(m.at("x"), std::out_of_range);
+  ASSERT_TRUE(m.emplace("e", 5).second);
+  ASSERT_EQ(m.find("e")->second, 5);
+  ASSERT_EQ(m.lower_bound("d")->first, "e");
+  ASSERT_EQ(m.upper_bound("b")->first, "c");
+  ASSERT_TRUE(m.upper_bound("e") == m.end());
+  ASSERT_EQ(m.erase("b"), 1u);
+  ASSERT_EQ(m.count("b"), 0u);
+
+  std::string keys;
+  int         sum = 0;
+  for (auto& p : m) {
+    keys += p.first;
+    sum += p.second;
+  }
+  ASSERT_EQ(keys, "ace");
+  ASSERT_EQ(sum, 9);
+  m.clear();
+  ASSERT_TRUE(m.empty());
+}
+
+// 多个线程争抢插入同一批 key，每个 key 只有一个线程成功，之后看到的都是成功者的值
+TEST(SkiplistMapTest, ConcurrentInsert) {
+  const int                num_key = 5000;
+  skiplist_map<int, int>   m;
+  std::atomic<int>         won(0);
+  std::atomic<int>         bad(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int k = 0; k < num_key; ++k) {
+        auto res = m.insert(std::make_pair(k, t));
+        won += res.second;
+        bad += res.first->first != k || m.at(k) != res.first->second;
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  ASSERT_EQ(bad.load(), 0);
+  ASSERT_EQ(won.load(), num_key);
+  ASSERT_EQ(m.size(), (size_t)num_key);
+}
+
+}  // namespace test_skiplist_map
+}  // namespace gd
+
+#endif  // !__TEST_SKIPLIST_MAP__H
@@ -0,0 +1,181 @@
+#ifndef __TEST_SKIPLIST_SET__H
+#define __TEST_SKIPLIST_SET__H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_set.h"
+#include "my_skiplist_set.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_skiplist_set {
+
+TEST(SkiplistSetTest, Basic) {
+  skiplist_set<int> s = {5, 1, 3, 9, 7, 3};
+  ASSERT_EQ(s.size(), 5u);
+  ASSERT_FALSE(s.insert(5).second);
+  auto res = s.emplace(4);
+  ASSERT_TRUE(res.second);
+  ASSERT_EQ(*res.first, 4);
+  ASSERT_EQ(s.count(4), 1u);
+  ASSERT_EQ(s.count(2), 0u);
+  ASSERT_TRUE(s.find(2) == s.end());
+  ASSERT_EQ(*s.find(9), 9);
+
+  int expect[] = {1, 3, 4, 5, 7, 9};
+  ASSERT_EQ(s.size(), 6u);
+  ASSERT_TRUE(std::equal(s.begin(), s.end(), expect));
+  ASSERT_EQ(*s.lower_bound(6), 7);
+  ASSERT_EQ(*s.lower_bound(7), 7);
+  ASSERT_EQ(*s.upper_bound(7), 9);
+  ASSERT_TRUE(s.upper_bound(9) == s.end());
+  auto range = s.equal_range(5);
+  ASSERT_EQ(*range.first, 5);
+  ASSERT_EQ(*range.second, 7);
+
+  // 指向被删除元素的迭代器仍然可以前进
+  auto it = s.find(4);
+  s.erase(it);
+  ASSERT_EQ(*++it, 5);
+  ASSERT_EQ(s.erase(4), 0u);
+  ASSERT_EQ(s.erase(1), 1u);
+  ASSERT_EQ(*s.begin(), 3);
+  ASSERT_EQ(s.size(), 4u);
+  s.clear();
+  ASSERT_TRUE(s.empty());
+  ASSERT_TRUE(s.begin() == s.end());
+
+  skiplist_set<std::string, std::greater<std::string>> g;
+  g.insert({"a", "c", "b"});
+  ASSERT_EQ(*g.begin(), "c");
+  ASSERT_EQ(*g.lower_bound("bb"), "b");
+}
+
+// 多个线程同时插入和删除各自的 key，同时有线程遍历，最后的内容与预期相同
+TEST(SkiplistSetTest, ConcurrentInsertErase) {
+  const int         num_thread = 4;
+  const int         num_key = 20000;
+  skiplist_set<int> s;
+  std::atomic<bool> done(false);
+  std::atomic<int>  bad(0);
+  std::thread       reader([&] {
+    while (!done) {
+      int prev = -1;
+      for (auto it = s.begin(); it != s.end(); ++it) {
+        bad += *it <= prev;
+        prev = *it;
+      }
+      auto lb = s.lower_bound(num_key / 2);
+      bad += lb != s.end() && *lb < num_key / 2;
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < num_thread; ++t) {
+    writers.emplace_back([&, t] {
+      // 线程 t 负责 key % num_thread == t 的 key，先全部插入，再删除其中 3 的倍数，同时与其他线程争抢公共的 key
+      std::mt19937 rng(t);
+      for (int k = t; k < num_key; k += num_thread)
+        bad += !s.insert(k).second;
+      for (int i = 0; i < 2000; ++i) {
+        int k = num_key + (int)(rng() % 100);
+        if (rng() % 2)
+          s.insert(k);
+        else
+          s.erase(k);
+      }
+      for (int k = t; k < num_key; k += num_thread)
+        if (k % 3 == 0)
+          bad += s.erase(k) != 1;
+    });
+  }
+  for (auto& w : writers)
+    w.join();
+  done = true;
+  reader.join();
+  ASSERT_EQ(bad.load(), 0);
+
+  for (int k = num_key; k < num_key + 100; ++k)
+    s.erase(k);
+  std::vector<int> expect;
+  for (int k = 0; k < num_key; ++k)
+    if (k % 3 != 0)
+      expect.push_back(k);
+  ASSERT_EQ(s.size(), expect.size());
+  ASSERT_TRUE(std::equal(s.begin(), s.end(), expect.data()));
+  for (int k = -1; k <= num_key; ++k) {
+    auto lb = s.lower_bound(k);
+    auto ub = s.upper_bound(k);
+    int  next = k + 1;
+    while (next % 3 == 0)
+      ++next;
+    if (k < 0 || k % 3 == 0 || k == num_key) {
+      ASSERT_TRUE(lb == ub);
+    } else {
+      ASSERT_EQ(*lb, k);
+    }
+    if (next < num_key) {
+      ASSERT_EQ(*ub, next);
+    } else {
+      ASSERT_TRUE(ub == s.end());
+    }
+  }
+}
+
+#if PERFORMANCE_TEST
+// 多个线程同时插入随机的 key，比较 mutex 保护的 set 与 skiplist_set
+TEST(SkiplistSetPerformTest, ConcurrentInsert) {
+  const int num_elem = 1000000;
+  const int max_thread = std::max(4u, std::thread::hardware_concurrency());
+
+  std::mt19937     rng(1);
+  vector<uint32_t> keys;
+  for (int i = 0; i < num_elem; ++i)
+    keys.push_back((uint32_t)rng());
+
+  for (int num_thread = 1; num_thread <= max_thread; num_thread *= 2) {
+    auto run = [&](const char* name, std::function<void(uint32_t)> insert) {
+      std::vector<std::thread> threads;
+      auto                     start = std::chrono::steady_clock::now();
+      for (int t = 0; t < num_thread; ++t) {
+        threads.emplace_back([&, t] {
+          for (int i = t; i < num_elem; i += num_thread)
+            insert(keys[i]);
+        });
+      }
+      for (auto& t : threads)
+        t.join();
+      std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+      std::cout << "- " << name << ", threads: " << num_thread << ", time cost: " << cost.count() << std::endl;
+    };
+
+    set<uint32_t>          locked;
+    std::mutex             lock;
+    skiplist_set<uint32_t> s;
+    run("mutex set insert", [&](uint32_t k) {
+      std::lock_guard<std::mutex> g(lock);
+      locked.insert(k);
+    });
+    run("skiplist_set insert", [&](uint32_t k) { s.insert(k); });
+    ASSERT_EQ(s.size(), locked.size());
+  }
+}
+#endif
+
+}  // namespace test_skiplist_set
+}  // namespace gd
+
+#endif  // !__TEST_SKIPLIST_SET__H
@@ -0,0 +1,147 @@
+#ifndef __TEST_SMALL_VECTOR_H
+#define __TEST_SMALL_VECTOR_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_alloc.h"
+#include "my_small_vector.h"
+#include "my_vector.h"
+#include "testdef.h"
+
+namespace gd {
+namespace test_small_vector {
+
+using testing::ElementsAre;
+
+// 统计向系统申请内存的次数
+struct counting_alloc {
+  static long allocs;
+
+  static void* allocate(size_t n) {
+    ++allocs;
+    return alloc::allocate(n);
+  }
+
+  static void deallocate(void* p, size_t n) {
+    alloc::deallocate(p, n);
+  }
+};
+
+long counting_alloc::allocs = 0;
+
+TEST(SmallVectorTest, Inline) {
+  counting_alloc::allocs = 0;
+  small_vector<int, 4, counting_alloc> v;
+  ASSERT_EQ(v.capacity(), 4u);
+  ASSERT_EQ(v.inline_capacity(), 4u);
+  for (int i = 0; i < 4; ++i)
+    v.push_back(i);
+  v.insert(v.begin(), 9);
+  v.erase(v.begin());
+  ASSERT_EQ(counting_alloc::allocs, 1);
+  ASSERT_THAT(v, ElementsAre(0, 1, 2, 3));
+
+  counting_alloc::allocs = 0;
+  small_vector<int, 4, counting_alloc> v2{5, 6, 7};
+  v2.emplace(v2.begin() + 1, 8);
+  v2.pop_back();
+  ASSERT_EQ(counting_alloc::allocs, 0);
+  ASSERT_THAT(v2, ElementsAre(5, 8, 6));
+
+  // 超过 N 个之后转移到 Alloc 分配的内存中
+  for (int i = 0; i < 100; ++i)
+    v2.push_back(i);
+  ASSERT_GT(counting_alloc::allocs, 0);
+  ASSERT_EQ(v2.size(), 103u);
+  ASSERT_EQ(v2[2], 6);
+  ASSERT_EQ(v2.back(), 99);
+}
+
+TEST(SmallVectorTest, CopyAndMove) {
+  typedef small_vector<std::string, 2> svec;
+  svec inl{"a", "b"};
+  svec heap{"x", "y", "z"};
+
+  svec c1(inl);
+  svec c2(heap);
+  ASSERT_THAT(c1, ElementsAre("a", "b"));
+  ASSERT_THAT(c2, ElementsAre("x", "y", "z"));
+  c1 = heap;
+  c2 = inl;
+  ASSERT_THAT(c1, ElementsAre("x", "y", "z"));
+  ASSERT_THAT(c2, ElementsAre("a", "b"));
+
+  // 内存来自 Alloc 时直接接管
+  const std::string* data = heap.data();
+  svec m1(std::move(heap));
+  ASSERT_EQ(m1.data(), data);
+  ASSERT_TRUE(heap.empty());
+  ASSERT_EQ(heap.capacity(), 2u);
+  svec m2(std::move(inl));
+  ASSERT_THAT(m2, ElementsAre("a", "b"));
+
+  m2 = std::move(m1);
+  ASSERT_EQ(m2.data(), data);
+  m1 = svec{"q"};
+  ASSERT_THAT(m1, ElementsAre("q"));
+
+  swap(m1, m2);
+  ASSERT_THAT(m1, ElementsAre("x", "y", "z"));
+  ASSERT_THAT(m2, ElementsAre("q"));
+  m2.swap(c2);
+  ASSERT_THAT(m2, ElementsAre("a", "b"));
+  ASSERT_THAT(c2, ElementsAre("q"));
+  c1.swap(m1);
+  ASSERT_THAT(c1, ElementsAre("x", "y", "z"));
+
+  // 拷贝不使用原来的缓冲区
+  svec c3(m2);
+  ASSERT_NE(c3.data(), m2.data());
+  ASSERT_TRUE(c3 == m2);
+  c3.push_back("c");
+  ASSERT_TRUE(c3 != m2);
+  ASSERT_TRUE(m2 < c3);
+
+  // vector 是私有基类，不能通过 vector 的引用移动或交换而偷走内部缓冲区
+  typedef vector<std::string, __small_alloc<alloc, sizeof(std::string) * 2, alignof(std::string)>> base_vec;
+  static_assert(!std::is_convertible<svec&, base_vec&>::value, "small_vector must not slice to vector");
+}
+
+#if PERFORMANCE_TEST
+TEST(SmallVectorPerformTest, ShortSequences) {
+  // 大量只有几个元素的序列
+  const int num_seq = 5000000;
+  const int len = 5;
+
+  counting_alloc::allocs = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_seq; ++i) {
+    vector<int, counting_alloc> v;
+    for (int j = 0; j < len; ++j)
+      v.push_back(j);
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- vector, allocations per sequence: " << (double)counting_alloc::allocs / num_seq
+            << ", time cost: " << cost.count() << std::endl;
+
+  counting_alloc::allocs = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_seq; ++i) {
+    small_vector<int, 8, counting_alloc> v;
+    for (int j = 0; j < len; ++j)
+      v.push_back(j);
+  }
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- small_vector, allocations per sequence: " << (double)counting_alloc::allocs / num_seq
+            << ", time cost: " << cost.count() << std::endl;
+}
+#endif
+
+}  // namespace test_small_vector
+}  // namespace gd
+
+#endif  // !__TEST_SMALL_VECTOR_H
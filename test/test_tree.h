@@ -2,9 +2,14 @@
 #define __TEST_TREE__H
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
 #include <set>
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "my_node_pool.h"
 #include "my_tree.h"
 #include "my_vector.h"
 #include "test_helper.h"
@@ -158,6 +163,288 @@ TEST_F(RbTreeTest, Operator) {
   ASSERT_TRUE(u_tree < tmp1);
 }
 
+// 检查红黑树的性质，返回以 x 为根的子树的黑高，同时检查 parent 指针
+int check_rb(_rb_tree_node_base* x, _rb_tree_node_base* parent) {
+  if (x == nullptr)
+    return 1;
+  EXPECT_EQ(x->parent(), parent);
+  if (x->color() == _rb_tree_red) {
+    EXPECT_TRUE(x->left == nullptr || x->left->color() == _rb_tree_black);
+    EXPECT_TRUE(x->right == nullptr || x->right->color() == _rb_tree_black);
+  }
+  int lh = check_rb(x->left, x);
+  int rh = check_rb(x->right, x);
+  EXPECT_EQ(lh, rh);
+  return lh + (x->color() == _rb_tree_black ? 1 : 0);
+}
+
+TEST(RbTreeNodeTest, PackedColor) {
+  // 颜色存放在 parent 的最低位，节点只有三个指针
+  static_assert(sizeof(_rb_tree_node_base) == 3 * sizeof(void*), "color should be packed into parent");
+  static_assert(sizeof(_rb_tree_node<uint64_t>) == 4 * sizeof(void*), "no padding in rb_tree node");
+
+  rb_tree<int, int, identity<int>, std::less<int>> t;
+  std::mt19937                                     rng(3);
+  for (int i = 0; i < 20000; ++i) {
+    if (rng() % 3)
+      t.insert_unique(rng() % 10000);
+    else
+      t.erase((int)(rng() % 10000));
+  }
+  _rb_tree_node_base* header = t.end().node;
+  _rb_tree_node_base* root = header->parent();
+  ASSERT_EQ(header->color(), _rb_tree_red);
+  ASSERT_EQ(root->color(), _rb_tree_black);
+  check_rb(root, header);
+  ASSERT_TRUE(std::is_sorted(t.begin(), t.end()));
+  ASSERT_EQ(*--t.end(), *std::max_element(t.begin(), t.end()));
+}
+
+TEST(RbTreeNodeTest, AssignSorted) {
+  typedef rb_tree<int, int, identity<int>, std::less<int>> tree;
+  for (int n = 0; n < 300; ++n) {
+    vector<int> in;
+    for (int i = 0; i < n; ++i)
+      in.push_back(i / 2);  // 每个 key 出现两次
+
+    tree t1;
+    t1.assign_sorted_unique(in.begin(), in.end());
+    ASSERT_EQ(t1.size(), (size_t)(n + 1) / 2);
+    tree t2;
+    t2.assign_sorted_equal(in.begin(), in.end());
+    ASSERT_EQ(t2.size(), (size_t)n);
+    ASSERT_TRUE(std::equal(t2.begin(), t2.end(), in.begin()));
+    if (n != 0) {
+      check_rb(t1.end().node->parent(), t1.end().node);
+      check_rb(t2.end().node->parent(), t2.end().node);
+      ASSERT_EQ(*t1.begin(), 0);
+      ASSERT_EQ(*--t2.end(), (n - 1) / 2);
+    }
+    // 建好的树可以继续插入和删除
+    t1.insert_unique(-1);
+    t1.erase(0);
+    check_rb(t1.end().node->parent(), t1.end().node);
+  }
+
+  // 无序的输入退化为逐个插入
+  vector<int> in = {3, 1, 2, 3, 0};
+  tree        t;
+  t.insert_unique(42);
+  t.assign_sorted_unique(in.begin(), in.end());
+  ASSERT_THAT(t, testing::ElementsAre(0, 1, 2, 3));
+  t.assign_sorted_equal(in.begin(), in.end());
+  ASSERT_THAT(t, testing::ElementsAre(0, 1, 2, 3, 3));
+}
+
+// 检查顺序统计树中每个节点记录的子树大小，返回以 x 为根的子树的大小
+size_t check_size(_rb_tree_node_base* x) {
+  if (x == nullptr)
+    return 0;
+  size_t n = check_size(x->left) + check_size(x->right) + 1;
+  EXPECT_EQ(order_statistic::size(x), n);
+  return n;
+}
+
+TEST(RbTreeNodeTest, OrderStatistic) {
+  typedef rb_tree<int, int, identity<int>, std::less<int>, alloc, order_statistic> tree;
+  tree                                                                             t;
+  std::multiset<int>                                                               sms;
+  std::mt19937                                                                     rng(17);
+  for (int i = 0; i < 20000; ++i) {
+    int v = rng() % 1000;
+    switch (rng() % 4) {
+      case 0:
+        t.insert_equal(v);
+        sms.insert(v);
+        break;
+      case 1:
+        t.insert_equal(t.lower_bound(v), v);
+        sms.insert(v);
+        break;
+      case 2:
+        ASSERT_EQ(t.erase(v), sms.erase(v));
+        break;
+      default:
+        if (!t.empty()) {
+          auto it = t.nth(rng() % t.size());
+          sms.erase(sms.find(*it));
+          t.erase(it);
+        }
+    }
+  }
+  check_rb(t.end().node->parent(), t.end().node);
+  ASSERT_EQ(check_size(t.end().node->parent()), sms.size());
+
+  vector<int> sorted;
+  for (int v : sms)
+    sorted.push_back(v);
+  for (size_t k = 0; k < sorted.size(); ++k)
+    ASSERT_EQ(*t.nth(k), sorted[k]);
+  ASSERT_TRUE(t.nth(t.size()) == t.end());
+  for (int v = -1; v <= 1000; ++v) {
+    size_t lo = std::lower_bound(sorted.begin(), sorted.end(), v) - sorted.begin();
+    size_t hi = std::upper_bound(sorted.begin(), sorted.end(), v) - sorted.begin();
+    ASSERT_EQ(t.rank(v), lo);
+    ASSERT_EQ(t.count(v), hi - lo);
+    ASSERT_EQ(t.count_range(v, v + 10), (size_t)(std::lower_bound(sorted.begin(), sorted.end(), v + 10) -
+                                                 sorted.begin()) - lo);
+  }
+  ASSERT_EQ(t.count_range(10, 5), 0u);
+
+  // 拷贝和线性建树也要维护子树大小
+  tree t2(t);
+  ASSERT_EQ(check_size(t2.end().node->parent()), t.size());
+  tree t3;
+  t3.assign_sorted_equal(sorted.begin(), sorted.end());
+  ASSERT_EQ(check_size(t3.end().node->parent()), sorted.size());
+  ASSERT_EQ(*t3.nth(sorted.size() / 2), sorted[sorted.size() / 2]);
+}
+
+// 统计当前从配置器申请的字节数
+struct byte_counting_alloc {
+  static size_t bytes;
+
+  static void* allocate(size_t n) {
+    bytes += n;
+    return alloc::allocate(n);
+  }
+
+  static void deallocate(void* p, size_t n) {
+    bytes -= n;
+    alloc::deallocate(p, n);
+  }
+};
+
+size_t byte_counting_alloc::bytes = 0;
+
+TEST(RbTreeNodeTest, Hint) {
+  typedef rb_tree<int, int, identity<int>, std::less<int>, byte_counting_alloc> tree;
+  tree                                                                          t;
+  std::set<int>                                                                 ss;
+  std::multiset<int>                                                            sms;
+  tree                                                                          mt;
+  std::mt19937                                                                  rng(11);
+  for (int i = 0; i < 5000; ++i) {
+    int v = rng() % 2000;
+    // hint 有时正确，有时错误，结果都要正确
+    tree::iterator hint = rng() % 2 ? t.lower_bound(v) : t.begin();
+    if (rng() % 3 == 0)
+      hint = t.end();
+    auto it = t.insert_unique(hint, v);
+    ASSERT_EQ(*it, v);
+    ss.insert(v);
+
+    tree::iterator mhint = rng() % 2 ? mt.upper_bound(v) : mt.end();
+    ASSERT_EQ(*mt.emplace_equal(mhint, v), v);
+    sms.insert(v);
+  }
+  ASSERT_EQ(t.size(), ss.size());
+  ASSERT_TRUE(std::equal(t.begin(), t.end(), ss.begin()));
+  ASSERT_EQ(mt.size(), sms.size());
+  ASSERT_TRUE(std::equal(mt.begin(), mt.end(), sms.begin()));
+  check_rb(t.end().node->parent(), t.end().node);
+  check_rb(mt.end().node->parent(), mt.end().node);
+
+  // 按递增顺序在 end() 插入，重复的 key 不分配节点
+  tree t2;
+  for (int i = 0; i < 1000; ++i)
+    t2.insert_unique(t2.end(), i);
+  check_rb(t2.end().node->parent(), t2.end().node);
+  size_t bytes = byte_counting_alloc::bytes;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(*t2.insert_unique(t2.end(), 999), 999);
+    ASSERT_EQ(*t2.insert_unique(t2.find(i), i), i);
+    ASSERT_FALSE(t2.insert_unique(int(i)).second);
+  }
+  ASSERT_EQ(byte_counting_alloc::bytes, bytes);
+  ASSERT_EQ(t2.size(), 1000u);
+}
+
+TEST(RbTreeNodeTest, CopyAndDestroy) {
+  typedef rb_tree<int, int, identity<int>, std::less<int>, byte_counting_alloc> tree;
+  size_t                                                                        bytes = byte_counting_alloc::bytes;
+  {
+    tree         t;
+    std::mt19937 rng(13);
+    for (int i = 0; i < 10000; ++i)
+      t.insert_equal(rng() % 3000);
+    tree t2(t);
+    ASSERT_EQ(t2.size(), t.size());
+    ASSERT_TRUE(std::equal(t.begin(), t.end(), t2.begin()));
+    check_rb(t2.end().node->parent(), t2.end().node);
+    // 反向遍历也要正确，parent 指针都已经连好
+    tree::iterator it = t.end();
+    tree::iterator it2 = t2.end();
+    while (it2 != t2.begin())
+      ASSERT_EQ(*--it2, *--it);
+    t2.clear();
+    ASSERT_TRUE(t2.empty());
+  }
+  ASSERT_EQ(byte_counting_alloc::bytes, bytes);
+
+  // 池中只有一棵树的节点时析构整块释放，多棵树共享同一个池时只能逐个释放
+  typedef rb_tree<int, int, identity<int>, std::less<int>, node_pool_alloc<>> pool_tree;
+  pool_tree* t1 = new pool_tree();
+  for (int i = 0; i < 1000; ++i)
+    t1->insert_unique(i);
+  pool_tree* t2 = new pool_tree(std::less<int>(), t1->get_allocator());
+  for (int i = 0; i < 1000; ++i)
+    t2->insert_unique(-i);
+  node_pool<>* pool = t1->get_allocator().resource();
+  ASSERT_EQ(t2->get_allocator().resource(), pool);
+  ASSERT_EQ(pool->live(), 2002u);
+  delete t1;
+  ASSERT_EQ(pool->live(), 1001u);
+  ASSERT_EQ(*t2->begin(), -999);
+  pool_tree::allocator_type a = t2->get_allocator();  // 保留一份配置器，池在 t2 析构后仍然存在
+  delete t2;
+  ASSERT_EQ(pool->live(), 0u);
+  ASSERT_EQ(pool->slab_count(), 0u);
+}
+
+#if PERFORMANCE_TEST
+TEST(RbTreePerformTest, NodeMemory) {
+  const int num_elem = 5000000;
+
+  byte_counting_alloc::bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  {
+    rb_tree<uint64_t, uint64_t, identity<uint64_t>, std::less<uint64_t>, byte_counting_alloc> t;
+    std::mt19937_64                                                                        rng(5);
+    for (int i = 0; i < num_elem; ++i)
+      t.insert_unique(rng());
+    std::cout << "- rb_tree<uint64_t> bytes per node: " << (double)byte_counting_alloc::bytes / (t.size() + 1)
+              << std::endl;
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- rb_tree<uint64_t> insert " << num_elem << " elements, time cost: " << cost.count() << std::endl;
+}
+
+template <typename Alloc>
+void destroy_perform(const char* name, int num_elem) {
+  typedef rb_tree<int, int, identity<int>, std::less<int>, Alloc> tree;
+  tree*                                                           t = new tree();
+  std::mt19937                                                    rng(5);
+  for (int i = 0; i < num_elem; ++i)
+    t->insert_equal((int)rng());
+
+  auto start = std::chrono::steady_clock::now();
+  tree t2(*t);
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- " << name << " copy " << num_elem << " elements, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  delete t;
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- " << name << " destroy " << num_elem << " elements, time cost: " << cost.count() << std::endl;
+}
+
+TEST(RbTreePerformTest, Destroy) {
+  destroy_perform<alloc>("alloc", 10000000);
+  destroy_perform<node_pool_alloc<>>("node_pool_alloc", 10000000);
+}
+#endif
+
 }  // namespace test_tree
 }  // namespace gd
 
@@ -0,0 +1,213 @@
+#ifndef __TEST_UNORDERED_MAP__H
+#define __TEST_UNORDERED_MAP__H
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_arena.h"
+#include "my_map.h"
+#include "my_unordered_map.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_unordered_map {
+
+// 所有 key 的哈希值都相同，每次查找都要探测多个组
+struct bad_hash {
+  size_t operator()(int) const {
+    return 42;
+  }
+};
+
+TEST(UnorderedMapTest, Basic) {
+  unordered_map<int, std::string> m;
+  ASSERT_TRUE(m.empty());
+  ASSERT_TRUE(m.begin() == m.end());
+  ASSERT_TRUE(m.find(1) == m.end());
+  ASSERT_EQ(m.erase(1), 0u);
+
+  ASSERT_TRUE(m.insert({1, "one"}).second);
+  ASSERT_FALSE(m.insert({1, "uno"}).second);
+  ASSERT_TRUE(m.emplace(2, "two").second);
+  m[3] = "three";
+  ASSERT_EQ(m.size(), 3u);
+  ASSERT_EQ(m[1], "one");
+  ASSERT_EQ(m.at(2), "two");
+  ASSERT_THROW(m.at(4), std::out_of_range);
+  ASSERT_EQ(m.count(3), 1u);
+  ASSERT_EQ(m.count(4), 0u);
+
+  auto range = m.equal_range(2);
+  ASSERT_EQ(range.first->second, "two");
+  ASSERT_TRUE(++range.first == range.second);
+
+  ASSERT_EQ(m.erase(2), 1u);
+  ASSERT_TRUE(m.find(2) == m.end());
+  m.erase(m.find(1));
+  ASSERT_EQ(m.size(), 1u);
+  ASSERT_EQ(m.begin()->first, 3);
+  m.clear();
+  ASSERT_TRUE(m.empty());
+  ASSERT_TRUE(m.begin() == m.end());
+}
+
+TEST(UnorderedMapTest, CompareWithStd) {
+  // 随机插入、删除、查找，结果与 std::unordered_map 一致
+  unordered_map<int, int>      m;
+  std::unordered_map<int, int> sm;
+  std::mt19937                 rng(7);
+  for (int i = 0; i < 200000; ++i) {
+    int k = rng() % 5000;
+    switch (rng() % 4) {
+      case 0:
+      case 1:
+        ASSERT_EQ(m.insert({k, i}).second, sm.insert({k, i}).second);
+        break;
+      case 2:
+        ASSERT_EQ(m.erase(k), sm.erase(k));
+        break;
+      default:
+        ASSERT_EQ(m.find(k) == m.end(), sm.find(k) == sm.end());
+        if (m.find(k) != m.end()) {
+          ASSERT_EQ(m.find(k)->second, sm.find(k)->second);
+        }
+    }
+  }
+  ASSERT_EQ(m.size(), sm.size());
+  size_t n = 0;
+  for (auto& p : m) {
+    ASSERT_EQ(sm.at(p.first), p.second);
+    ++n;
+  }
+  ASSERT_EQ(n, sm.size());
+}
+
+TEST(UnorderedMapTest, Collision) {
+  unordered_map<int, int, bad_hash> m;
+  for (int i = 0; i < 100; ++i)
+    m[i] = i * i;
+  for (int i = 0; i < 100; i += 2)
+    m.erase(i);
+  ASSERT_EQ(m.size(), 50u);
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(m.count(i), (size_t)(i % 2));
+  for (int i = 0; i < 100; i += 2)
+    m[i] = i;
+  ASSERT_EQ(m.size(), 100u);
+  ASSERT_EQ(m[99], 99 * 99);
+}
+
+// 参数引用表中的元素时，跨过每一次扩容插入的新元素都是正确的
+TEST(UnorderedMapTest, InsertAliasingElement) {
+  unordered_map<std::string, std::string> m;
+  const std::string                       value(100, 'v');
+  m.try_emplace("0", value);
+  for (int i = 1; i < 1000; ++i) {
+    float lf = m.load_factor();
+    ASSERT_TRUE(m.try_emplace(std::to_string(i), m.begin()->second).second);
+    ASSERT_FALSE(m.insert(*m.begin()).second);
+    if (m.load_factor() < lf) {  // 刚刚扩容
+      ASSERT_EQ(m[std::to_string(i)], value);
+    }
+  }
+  ASSERT_EQ(m.size(), 1000u);
+  for (auto& p : m)
+    ASSERT_EQ(p.second, value);
+}
+
+TEST(UnorderedMapTest, CopyAndMove) {
+  unordered_map<std::string, nontrivial> m1;
+  for (int i = 0; i < 100; ++i)
+    m1.emplace(std::to_string(i), nontrivial(i, i));
+
+  unordered_map<std::string, nontrivial> m2(m1);
+  ASSERT_TRUE(m1 == m2);
+  m2.erase("7");
+  ASSERT_TRUE(m1 != m2);
+
+  unordered_map<std::string, nontrivial> m3(std::move(m2));
+  ASSERT_TRUE(m2.empty());
+  ASSERT_EQ(m3.size(), 99u);
+  m2 = m3;
+  ASSERT_TRUE(m2 == m3);
+  m1 = std::move(m3);
+  ASSERT_TRUE(m1 == m2);
+  m1.swap(m3);
+  ASSERT_TRUE(m1.empty());
+  ASSERT_EQ(*m3["42"].i, 42);
+
+  m3.reserve(1000);
+  ASSERT_GE(m3.load_factor(), 0.0f);
+  ASSERT_LE(m3.load_factor(), m3.max_load_factor());
+  ASSERT_TRUE(m3 == m2);
+  m3.rehash(0);
+  ASSERT_TRUE(m3 == m2);
+}
+
+TEST(UnorderedMapTest, Arena) {
+  // 配置器带有状态时也能正常工作，整块内存从 arena 中分配
+  arena                                                                        a;
+  arena_alloc                                                                  aa(a);
+  unordered_map<int, int, std::hash<int>, std::equal_to<int>, arena_alloc> m(aa);
+  for (int i = 0; i < 1000; ++i)
+    m[i] = i;
+  ASSERT_EQ(m.size(), 1000u);
+  ASSERT_EQ(m.get_allocator().resource(), &a);
+  ASSERT_GT(a.bytes_reserved(), 0u);
+
+  unordered_map<int, int, std::hash<int>, std::equal_to<int>, arena_alloc> m2(m);
+  ASSERT_TRUE(m2 == m);
+  ASSERT_EQ(m2.get_allocator().resource(), &a);
+}
+
+#if PERFORMANCE_TEST
+TEST(UnorderedMapPerformTest, Find) {
+  const int num_elem = 1000000;
+  const int num_find = 10000000;
+
+  std::mt19937     rng(1);
+  vector<unsigned> keys;
+  for (int i = 0; i < num_elem; ++i)
+    keys.push_back(rng());
+
+  map<unsigned, unsigned>                m;
+  std::unordered_map<unsigned, unsigned> sm;
+  unordered_map<unsigned, unsigned>      um;
+  for (int i = 0; i < num_elem; ++i) {
+    m.insert({keys[i], i});
+    sm.insert({keys[i], i});
+    um.insert({keys[i], i});
+  }
+
+  size_t found = 0;
+  auto   start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_find; ++i)
+    found += m.find(keys[i % num_elem]) != m.end();
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- gd::map find, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_find; ++i)
+    found += sm.find(keys[i % num_elem]) != sm.end();
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- std::unordered_map find, time cost: " << cost.count() << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_find; ++i)
+    found += um.find(keys[i % num_elem]) != um.end();
+  cost = std::chrono::steady_clock::now() - start;
+  std::cout << "- gd::unordered_map find, time cost: " << cost.count() << std::endl;
+  ASSERT_EQ(found, (size_t)num_find * 3);
+}
+#endif
+
+}  // namespace test_unordered_map
+}  // namespace gd
+
+#endif  // !__TEST_UNORDERED_MAP__H
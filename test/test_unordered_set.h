@@ -0,0 +1,63 @@
+#ifndef __TEST_UNORDERED_SET__H
+#define __TEST_UNORDERED_SET__H
+
+#include <algorithm>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "my_unordered_set.h"
+#include "my_vector.h"
+#include "test_helper.h"
+
+namespace gd {
+namespace test_unordered_set {
+
+using testing::UnorderedElementsAre;
+
+TEST(UnorderedSetTest, Basic) {
+  unordered_set<int> s({5, 3, 1, 4, 2, 3});
+  ASSERT_EQ(s.size(), 5u);
+  ASSERT_THAT(s, UnorderedElementsAre(1, 2, 3, 4, 5));
+  ASSERT_FALSE(s.insert(4).second);
+  ASSERT_TRUE(s.insert(6).second);
+  ASSERT_EQ(*s.find(6), 6);
+  ASSERT_EQ(s.erase(1), 1u);
+  s.erase(s.find(2));
+  ASSERT_THAT(s, UnorderedElementsAre(3, 4, 5, 6));
+
+  // 删除不影响其他元素的迭代器
+  vector<int> v;
+  for (auto it = s.begin(); it != s.end();) {
+    if (*it % 2)
+      s.erase(it++);
+    else
+      v.push_back(*it++);
+  }
+  std::sort(v.begin(), v.end());
+  ASSERT_EQ(v.size(), 2u);
+  ASSERT_EQ(v[0], 4);
+  ASSERT_EQ(v[1], 6);
+  ASSERT_THAT(s, UnorderedElementsAre(4, 6));
+}
+
+TEST(UnorderedSetTest, Grow) {
+  unordered_set<std::string> s;
+  for (int i = 0; i < 10000; ++i)
+    s.insert(std::to_string(i));
+  ASSERT_EQ(s.size(), 10000u);
+  ASSERT_LE(s.load_factor(), s.max_load_factor());
+  for (int i = 0; i < 10000; i += 3)
+    ASSERT_EQ(s.erase(std::to_string(i)), 1u);
+  for (int i = 0; i < 10000; ++i)
+    ASSERT_EQ(s.count(std::to_string(i)), i % 3 ? 1u : 0u);
+
+  unordered_set<std::string> s2(s.begin(), s.end());
+  ASSERT_TRUE(s2 == s);
+  s2.insert("x");
+  ASSERT_TRUE(s2 != s);
+}
+
+}  // namespace test_unordered_set
+}  // namespace gd
+
+#endif  // !__TEST_UNORDERED_SET__H
@@ -6,6 +6,9 @@
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include "my_list.h"
 #include "gmock/gmock.h"
@@ -349,6 +352,130 @@ TEST_F(VectorTest, Operator) {
   ASSERT_TRUE(!(v2 == v4));
 }
 
+// 统计拷贝构造和移动构造的次数，NoexceptMove 决定移动构造是否声明为 noexcept
+template <bool NoexceptMove>
+struct counted {
+  static int copies;
+  static int moves;
+
+  int v;
+
+  counted(int v = 0) : v(v) {}
+  counted(const counted& rhs) : v(rhs.v) {
+    ++copies;
+  }
+  counted(counted&& rhs) noexcept(NoexceptMove) : v(rhs.v) {
+    ++moves;
+  }
+  counted& operator=(const counted&) = default;
+  counted& operator=(counted&&) = default;
+
+  static void reset() {
+    copies = 0;
+    moves = 0;
+  }
+};
+
+template <bool NoexceptMove>
+int counted<NoexceptMove>::copies = 0;
+template <bool NoexceptMove>
+int counted<NoexceptMove>::moves = 0;
+
+// 持有智能指针，可以直接 memcpy 搬移
+struct relocatable {
+  counted<true>        c;
+  std::shared_ptr<int> p;
+
+  relocatable(int v) : c(v), p(new int(v)) {}
+};
+
+}  // namespace test_vector
+
+template <>
+struct __is_trivially_relocatable<test_vector::relocatable> : std::true_type {};
+
+namespace test_vector {
+
+TEST(VecGrowthTest, MoveOnGrowth) {
+  // 移动构造是 noexcept 时扩容只移动，不拷贝
+  typedef counted<true> nothrow_move;
+  vector<nothrow_move>  v1;
+  for (int i = 0; i < 1000; ++i)
+    v1.emplace_back(i);
+  nothrow_move::reset();
+  v1.reserve(5000);
+  v1.emplace(v1.begin(), -1);
+  ASSERT_EQ(nothrow_move::copies, 0);
+  ASSERT_GE(nothrow_move::moves, 1000);
+  ASSERT_EQ(v1.front().v, -1);
+  ASSERT_EQ(v1.back().v, 999);
+
+  // 移动构造可能抛出异常时扩容拷贝，以保证扩容失败时原来的元素不变
+  typedef counted<false> throw_move;
+  vector<throw_move>     v2;
+  for (int i = 0; i < 1000; ++i)
+    v2.emplace_back(i);
+  throw_move::reset();
+  v2.reserve(5000);
+  ASSERT_EQ(throw_move::copies, 1000);
+  ASSERT_EQ(throw_move::moves, 0);
+
+  // 可平凡搬移的类型直接 memcpy，既不拷贝也不移动
+  vector<relocatable> v3;
+  for (int i = 0; i < 1000; ++i)
+    v3.emplace_back(i);
+  nothrow_move::reset();
+  v3.insert(v3.begin() + 500, size_t(600), relocatable(-1));
+  ASSERT_EQ(nothrow_move::moves, 0);
+  ASSERT_EQ(v3.size(), 1600u);
+  ASSERT_EQ(*v3[499].p, 499);
+  ASSERT_EQ(v3[1099].c.v, -1);
+  ASSERT_EQ(*v3[1100].p, 500);
+  ASSERT_EQ(*v3.back().p, 999);
+}
+
+TEST(VecGrowthTest, Reallocate) {
+  // 平凡可复制的大 vector 在末尾扩容时使用 reallocate，跨过 mmap 阈值之后由 mremap 扩展
+  vector<uint64_t> v;
+  for (uint64_t i = 0; i < (1 << 21); ++i)
+    v.push_back(i * 3);
+  ASSERT_EQ(v.size(), size_t(1) << 21);
+  ASSERT_EQ(v[12345], 12345u * 3);
+  v.reserve(size_t(1) << 23);
+  v.resize(size_t(3) << 21, 7);
+  ASSERT_EQ(v[(1 << 21) - 1], ((1u << 21) - 1) * 3);
+  ASSERT_EQ(v[1 << 21], 7u);
+  ASSERT_EQ(v.back(), 7u);
+
+  // 用 vector 自己的元素扩容
+  vector<double> d(4, 1.5);
+  for (int i = 0; i < 100; ++i)
+    d.push_back(d[0]);
+  ASSERT_EQ(d.size(), 104u);
+  ASSERT_EQ(d.back(), 1.5);
+}
+
+TEST(VecGrowthTest, GrowthFailure) {
+  // 插入的元素构造失败时，原来的元素不变
+  struct thrower {
+    std::string s;
+    thrower(const std::string& s) : s(s) {}
+    thrower(const thrower& rhs) : s(rhs.s) {
+      if (rhs.s == "bad")
+        throw std::runtime_error("copy");
+    }
+  };
+  vector<thrower> v;
+  v.emplace_back("a");
+  v.emplace_back("b");
+  ASSERT_EQ(v.capacity(), 2u);
+  thrower bad("bad");
+  ASSERT_THROW(v.push_back(bad), std::runtime_error);
+  ASSERT_EQ(v.size(), 2u);
+  ASSERT_EQ(v[0].s, "a");
+  ASSERT_EQ(v[1].s, "b");
+}
+
 #if PERFORMANCE_TEST
 TEST(VecPerformTest, Performance) {
   std::vector<int> std_vec1;
@@ -362,6 +489,26 @@ TEST(VecPerformTest, Performance) {
 
   PERFORM_TEST(std_vec2.push_back(8), 10000000);
   PERFORM_TEST(my_vec2.push_back(8), 10000000);
+
+  // 扩容时移动而不是拷贝 std::string
+  std::string              s(64, 'x');
+  std::vector<std::string> std_vec3;
+  gd::vector<std::string>  my_vec3;
+  PERFORM_TEST(std_vec3.push_back(s), 10000000);
+  PERFORM_TEST(my_vec3.push_back(s), 10000000);
+}
+
+TEST(VecPerformTest, LargeGrowth) {
+  // 大块平凡可复制数据的扩容，gd::vector 通过 mremap 扩展而不复制数据
+  const long n = 1L << 25;
+  {
+    std::vector<uint64_t> std_vec;
+    PERFORM_TEST(std_vec.push_back(1), n);
+  }
+  {
+    gd::vector<uint64_t> my_vec;
+    PERFORM_TEST(my_vec.push_back(1), n);
+  }
 }
 #endif
 